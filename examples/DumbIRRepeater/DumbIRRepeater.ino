@@ -107,24 +107,20 @@ void loop() {
   if (irrecv.decode(&results)) {  // We have captured something.
     // The capture has stopped at this point.
 
-    // Convert the results into an array suitable for sendRaw().
-    // resultToRawArray() allocates the memory we need for the array.
-    uint16_t *raw_array = resultToRawArray(&results);
-    // Find out how many elements are in the array.
-    uint16_t length = getCorrectedRawLength(&results);
+    // Get the results in a form suitable for sendRaw().
+    // resultToRawIterator() doesn't need to allocate any memory.
+    IRrawIterator raw = resultToRawIterator(&results);
     // Send it out via the IR LED circuit.
-    irsend.sendRaw(raw_array, length, kFrequency);
+    irsend.sendRaw(&raw, kFrequency);
     // Resume capturing IR messages. It was not restarted until after we sent
     // the message so we didn't capture our own message.
     irrecv.resume();
-    // Deallocate the memory allocated by resultToRawArray().
-    delete [] raw_array;
 
     // Display a crude timestamp & notification.
     uint32_t now = millis();
     Serial.printf(
         "%06u.%03u: A message that was %d entries long was retransmitted.\n",
-        now / 1000, now % 1000, length);
+        now / 1000, now % 1000, raw.length());
   }
   yield();  // Or delay(milliseconds); This ensures the ESP doesn't WDT reset.
 }
@@ -1,11 +1,15 @@
 /*
  * IRremoteESP8266: IRGCTCPServer - send Global Cache-formatted codes via TCP.
  * An IR emitter must be connected to GPIO pin 4.
- * Version 0.2  May, 2017
+ * Version 0.3  Oct, 2019
  * Copyright 2016 Hisham Khalifa, http://www.hishamkhalifa.com
- * Copyright 2017 David Conran
+ * Copyright 2017, 2019 David Conran
  *
- * Example command - Samsung TV power toggle: 38000,1,1,170,170,20,63,20,63,20,63,20,20,20,20,20,20,20,20,20,20,20,63,20,63,20,63,20,20,20,20,20,20,20,20,20,20,20,20,20,63,20,20,20,20,20,20,20,20,20,20,20,20,20,63,20,20,20,63,20,63,20,63,20,63,20,63,20,63,20,1798\r\n
+ * It talks (a subset of) the Global Cache iTach (IP2IR) TCP API, so most apps
+ * & software that can drive an iTach can use it. Several clients can be
+ * connected at once, & each can pipeline its commands. The sendir's are sent
+ * in the order they arrive, & each client gets its "completeir" reply when its
+ * message has been sent. A "stopir" cuts short any message being sent.
  * For more codes, visit: https://irdb.globalcache.com/
  *
  * How to use this program:
@@ -23,10 +27,14 @@
  *     Start a new CMD window, then type:
  *       telnet <esp8266deviceIPaddress> 4998
  *
- *   5) Enter a Global Cache-formatted code, starting at the frequency,
- *      and then a return/enter at the end. No spaces. e.g.:
+ *   5) Enter an iTach command, and then a return/enter at the end. No spaces.
+ *      e.g. A Samsung TV power toggle:
  *
- *   38000,1,1,170,170,20,63,20,63,20,63,20,20,20,20,20,20,20,20,20,20,20,63,20,63,20,63,20,20,20,20,20,20,20,20,20,20,20,20,20,63,20,20,20,20,20,20,20,20,20,20,20,20,20,63,20,20,20,63,20,63,20,63,20,63,20,63,20,63,20,1798
+ *   sendir,1:1,1,38000,1,1,170,170,20,63,20,63,20,63,20,20,20,20,20,20,20,20,20,20,20,63,20,63,20,63,20,20,20,20,20,20,20,20,20,20,20,20,20,63,20,20,20,20,20,20,20,20,20,20,20,20,20,63,20,20,20,63,20,63,20,63,20,63,20,63,20,63,20,1798
+ *
+ *      It should reply with: completeir,1:1,1
+ *      The other commands it understands are: stopir,1:1  getdevices  &
+ *      getversion
  *
  *   To exit the 'telnet' command:
  *     press <control> + <]> at the same time, then press 'q', and then <return>.
@@ -35,6 +43,9 @@
  *
  * This program will display the ESP's IP address on the serial console, or you
  * can check your wifi router for it's address.
+ *
+ * Note: The tools/gc_server program runs the same server on a Linux/OSX host,
+ *       without any IR hardware, for testing & benchmarking clients.
  */
 
 #include <Arduino.h>
@@ -45,6 +56,7 @@
 #include <WiFi.h>
 #endif  // ESP32
 #include <IRremoteESP8266.h>
+#include <IRGCServer.h>
 #include <IRsend.h>
 #include <WiFiClient.h>
 #include <WiFiServer.h>
@@ -52,54 +64,22 @@
 const char* kSsid = "...";  // Put your WIFI SSID here.
 const char* kPassword = "...";  // Put your WIFI Password here.
 
-WiFiServer server(4998);  // Uses port 4998.
-WiFiClient client;
+WiFiServer server(kGcServerPort);  // Uses port 4998.
+// The connected clients, indexed by their IRGCServer connection nr.
+WiFiClient clients[kGcServerConnections];
+bool in_use[kGcServerConnections] = {false};
 
-uint16_t *code_array;
 #define IR_LED 4  // ESP8266 GPIO pin to use. Recommended: 4 (D2).
 
 IRsend irsend(IR_LED);  // Set the GPIO to be used to sending the message.
 
-void sendGCString(String str) {
-  int16_t index;
-  uint16_t count;
-
-  // Find out how many items there are in the string.
-  index = -1;
-  count = 1;
-  do {
-    index = str.indexOf(',', index + 1);
-    count++;
-  } while (index != -1);
-
-  // Now we know how many there are, allocate the memory to store them all.
-  code_array = reinterpret_cast<uint16_t*>(malloc(count * sizeof(uint16_t)));
-  // Check we malloc'ed successfully.
-  if (code_array == NULL) {  // malloc failed, so give up.
-    Serial.printf("\nCan't allocate %d bytes. (%d bytes free)\n",
-                  count * sizeof(uint16_t), ESP.getFreeHeap());
-    Serial.println("Giving up & forcing a reboot.");
-    ESP.restart();  // Reboot.
-    delay(500);  // Wait for the restart to happen.
-    return;  // Should never get here, but just in case.
-  }
-
-  // Now convert the strings to integers and place them in code_array.
-  count = 0;
-  uint16_t start_from = 0;
-  do {
-    index = str.indexOf(',', start_from);
-    code_array[count] = str.substring(start_from, index).toInt();
-    start_from = index + 1;
-    count++;
-  } while (index != -1);
-
-#if SEND_GLOBALCACHE
-  irsend.sendGC(code_array, count);  // All done. Send it.
-#endif  // SEND_GLOBALCACHE
-  free(code_array);  // Free up the memory allocated.
+// Send a reply back to the client it is for.
+void sendReply(const uint8_t connection, const char *reply) {
+  if (clients[connection].connected()) clients[connection].print(reply);
 }
 
+IRGCServer gc(&irsend, sendReply);
+
 void setup() {
   // initialize serial:
   Serial.begin(115200);
@@ -119,18 +99,32 @@ void setup() {
 }
 
 void loop() {
-  while (!client)
-    client = server.available();
-
-  while (!client.connected()) {
-    delay(900);
-    client = server.available();
+  // Any new clients?
+  WiFiClient client = server.available();
+  if (client) {
+    uint8_t connection = gc.connect();
+    if (connection == kGcServerNoConnection) {
+      client.stop();  // Too many already.
+    } else {
+      clients[connection] = client;
+      in_use[connection] = true;
+    }
   }
-
-  if (client.available()) {
-    String ir_code_str = client.readStringUntil('\r');  // Exclusive of \r
-    client.readStringUntil('\n');  // Skip new line as well
-    client.flush();
-    sendGCString(ir_code_str);
+  for (uint8_t connection = 0; connection < kGcServerConnections;
+       connection++) {
+    if (!in_use[connection]) continue;
+    if (!clients[connection].connected()) {  // Gone away.
+      gc.disconnect(connection);
+      clients[connection].stop();
+      in_use[connection] = false;
+      continue;
+    }
+    // Hand over what it has sent, until the server wants it to wait.
+    while (clients[connection].available()) {
+      char c = clients[connection].peek();
+      if (!gc.receive(connection, &c, 1)) break;
+      clients[connection].read();
+    }
   }
+  gc.handle();  // Send the next message (or the next copy of it).
 }
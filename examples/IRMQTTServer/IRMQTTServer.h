@@ -147,23 +147,8 @@ const uint16_t kMinUnknownSize = 2 * 10;
 
 // ------------------------ Advanced Usage Only --------------------------------
 
-#define KEY_PROTOCOL "protocol"
-#define KEY_MODEL "model"
-#define KEY_POWER "power"
-#define KEY_MODE "mode"
-#define KEY_TEMP "temp"
-#define KEY_FANSPEED "fanspeed"
-#define KEY_SWINGV "swingv"
-#define KEY_SWINGH "swingh"
-#define KEY_QUIET "quiet"
-#define KEY_TURBO "turbo"
-#define KEY_LIGHT "light"
-#define KEY_BEEP "beep"
-#define KEY_ECONO "econo"
-#define KEY_SLEEP "sleep"
-#define KEY_FILTER "filter"
-#define KEY_CLEAN "clean"
-#define KEY_CELSIUS "use_celsius"
+// The climate keys (KEY_PROTOCOL, KEY_POWER etc.) come from IRac.h, so they
+// always match what IRac::stateToJson() publishes.
 #define KEY_JSON "json"
 #define KEY_RESEND "resend"
 
@@ -2733,35 +2733,19 @@ bool sendFloat(const String topic, const float_t temp, const bool retain) {
 #if MQTT_CLIMATE_JSON
 void sendJsonState(const stdAc::state_t state, const String topic,
                    const bool retain, const bool ha_mode) {
-  DynamicJsonBuffer jsonBuffer;
-  JsonObject& json = jsonBuffer.createObject();
-  json[KEY_PROTOCOL] = typeToString(state.protocol);
-  json[KEY_MODEL] = state.model;
-  json[KEY_POWER] = IRac::boolToString(state.power);
-  json[KEY_MODE] = IRac::opmodeToString(state.mode);
+  stdAc::state_t reported = state;
   // Home Assistant wants mode to be off if power is also off & vice-versa.
   if (ha_mode && (state.mode == stdAc::opmode_t::kOff || !state.power)) {
-    json[KEY_MODE] = IRac::opmodeToString(stdAc::opmode_t::kOff);
-    json[KEY_POWER] = IRac::boolToString(false);
-  }
-  json[KEY_CELSIUS] = IRac::boolToString(state.celsius);
-  json[KEY_TEMP] = state.degrees;
-  json[KEY_FANSPEED] = IRac::fanspeedToString(state.fanspeed);
-  json[KEY_SWINGV] = IRac::swingvToString(state.swingv);
-  json[KEY_SWINGH] = IRac::swinghToString(state.swingh);
-  json[KEY_QUIET] = IRac::boolToString(state.quiet);
-  json[KEY_TURBO] = IRac::boolToString(state.turbo);
-  json[KEY_ECONO] = IRac::boolToString(state.econo);
-  json[KEY_LIGHT] = IRac::boolToString(state.light);
-  json[KEY_FILTER] = IRac::boolToString(state.filter);
-  json[KEY_CLEAN] = IRac::boolToString(state.clean);
-  json[KEY_BEEP] = IRac::boolToString(state.beep);
-  json[KEY_SLEEP] = state.sleep;
-
-  String payload = "";
-  payload.reserve(200);
-  json.printTo(payload);
-  sendString(topic, payload, retain);
+    reported.mode = stdAc::opmode_t::kOff;
+    reported.power = false;
+  }
+  // Written straight into a fixed buffer. No String or JsonBuffer needed.
+  char payload[kAcStateJsonSize];
+  IRac::stateToJson(reported, payload, sizeof(payload));
+#if MQTT_ENABLE
+  mqttSentCounter++;
+  mqtt_client.publish(topic.c_str(), payload, retain);
+#endif  // MQTT_ENABLE
 }
 
 stdAc::state_t jsonToState(const stdAc::state_t current, const String str) {
@@ -5,15 +5,22 @@
  * This program will try to capture incoming IR messages and tries to
  * intelligently replay them back.
  * It uses the advanced detection features of the library, and the custom
- * sending routines. Thus it will try to use the correct frequencies,
- * duty cycles, and repeats as it thinks is required.
- * Anything it doesn't understand, it will try to replay back as best it can,
- * but at 38kHz.
+ * sending routines. Thus it will try to use the correct frequencies, duty
+ * cycles, and repeats as it thinks is required.
+ * If kMode is set to kRepeaterStream, it instead forwards each message as it
+ * arrives, a fraction of a millisecond behind the original, so the repeated
+ * message ends almost as soon as the original does. Each message is then
+ * decoded, so it can be reported. If it falls behind (e.g. something else in
+ * loop() took too long), it goes back to decoding & sending afresh.
+ * Anything it doesn't understand, or is forwarded as it arrives, it will try to
+ * replay back as best it can, but at 38kHz.
  * Note:
  *   That might NOT be the frequency of the incoming message, so some not
  *   recogised messages that are replayed may not work. The frequency & duty
  *   cycle of unknown incoming messages is lost at the point of the Hardware IR
  *   demodulator. The ESP can't see it.
+ *   When forwarding messages as they arrive, keep the IR detector out of sight
+ *   of the IR LED, or it will capture its own output.
  *
  *                               W A R N I N G
  *   This code is just for educational/example use only. No help will be given
@@ -44,6 +51,8 @@
  *     for your first time. e.g. ESP-12 etc.
  *
  * Changes:
+ *   Version 1.1: Oct, 2019
+ *     - Forward messages as they arrive, via IRrepeater.
  *   Version 1.0: June, 2019
  *     - Initial version.
  */
@@ -52,6 +61,7 @@
 #include <IRsend.h>
 #include <IRrecv.h>
 #include <IRremoteESP8266.h>
+#include <IRrepeater.h>
 #include <IRutils.h>
 
 // ==================== start of TUNEABLE PARAMETERS ====================
@@ -77,12 +87,19 @@ const uint8_t kTimeout = 50;  // Milli-Seconds
 // kFrequency is the modulation frequency all UNKNOWN messages will be sent at.
 const uint16_t kFrequency = 38000;  // in Hz. e.g. 38kHz.
 
+// kMode is how messages are repeated.
+//   kRepeaterDecode: Wait for each to end, decode it, & send it afresh.
+//   kRepeaterStream: Forward them as they arrive. (Lowest latency)
+const repeater_mode_t kMode = kRepeaterDecode;
+
 // ==================== end of TUNEABLE PARAMETERS ====================
 
 // The IR transmitter.
 IRsend irsend(kIrLedPin);
 // The IR receiver.
 IRrecv irrecv(kRecvPin, kCaptureBufferSize, kTimeout, false);
+// Repeats what the receiver captures via the transmitter.
+IRrepeater repeater(&irrecv, &irsend, kMode);
 // Somewhere to store the captured message.
 decode_results results;
 
@@ -90,6 +107,7 @@ decode_results results;
 void setup() {
   irrecv.enableIRIn();  // Start up the IR receiver.
   irsend.begin();       // Start up the IR sender.
+  repeater.setFrequency(kFrequency);
 
   Serial.begin(kBaudRate, SERIAL_8N1);
   while (!Serial)  // Wait for the serial connection to be establised.
@@ -105,39 +123,19 @@ void setup() {
 
 // The repeating section of the code
 void loop() {
-  // Check if an IR message has been received.
-  if (irrecv.decode(&results)) {  // We have captured something.
-    // The capture has stopped at this point.
-    decode_type_t protocol = results.decode_type;
-    uint16_t size = results.bits;
-    bool success = true;
-    // Is it a protocol we don't understand?
-    if (protocol == decode_type_t::UNKNOWN) {  // Yes.
-      // Convert the results into an array suitable for sendRaw().
-      // resultToRawArray() allocates the memory we need for the array.
-      uint16_t *raw_array = resultToRawArray(&results);
-      // Find out how many elements are in the array.
-      size = getCorrectedRawLength(&results);
-      // Send it out via the IR LED circuit.
-      irsend.sendRaw(raw_array, size, kFrequency);
-      // Deallocate the memory allocated by resultToRawArray().
-      delete [] raw_array;
-    } else if (hasACState(protocol)) {  // Does the message require a state[]?
-      // It does, so send with bytes instead.
-      success = irsend.send(protocol, results.state, size / 8);
-    } else {  // Anything else must be a simple message protocol. ie. <= 64 bits
-      success = irsend.send(protocol, results.value, size);
-    }
-    // Resume capturing IR messages. It was not restarted until after we sent
-    // the message so we didn't capture our own message.
-    irrecv.resume();
-
+  // Forward/repeat anything that has been (or is being) received.
+  if (repeater.handle(&results)) {  // A message has been repeated in full.
     // Display a crude timestamp & notification.
     uint32_t now = millis();
+    repeater_stats_t stats = repeater.getStats();
     Serial.printf(
-        "%06u.%03u: A %d-bit %s message was %ssuccessfully retransmitted.\n",
-        now / 1000, now % 1000, size, typeToString(protocol).c_str(),
-        success ? "" : "un");
+        "%06u.%03u: A %d-bit %s message was retransmitted. (%u streamed, "
+        "%u re-encoded, %u replayed, %u late. Max delay: %uus)\n",
+        now / 1000, now % 1000, results.bits,
+        typeToString(results.decode_type).c_str(), stats.streamed,
+        stats.reencoded, stats.replayed, stats.late, stats.max_delay);
   }
-  yield();  // Or delay(milliseconds); This ensures the ESP doesn't WDT reset.
+  // Don't hang around while a message is being forwarded.
+  if (!repeater.streaming())
+    yield();  // Or delay(milliseconds); This ensures the ESP doesn't WDT reset.
 }
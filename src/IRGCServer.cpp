@@ -0,0 +1,419 @@
+// Copyright 2019 David Conran
+//
+// A Global Cache iTach (IP2IR) compatible command server.
+//
+// Any number of clients (up to kGcServerConnections) can send commands at the
+// same time, and pipeline them. Each line is parsed as it arrives, straight
+// into the connection's preallocated buffer. Nothing is allocated. Complete
+// sendir commands are sent, first come first served, by handle(), one copy
+// at a time, so a stopir can cut a long repeat short.
+//
+// Supported commands:
+//   sendir,<module>:<connector>,<id>,<freq>,<repeat>,<offset>,<on>,<off>,...
+//     Replies "completeir,<module>:<connector>,<id>" once it has been sent.
+//   stopir,<module>:<connector>
+//     Stops the sendir being sent, & drops any waiting. Replies
+//     "stopir,<module>:<connector>" to it, & to the clients of those dropped.
+//   getdevices
+//   getversion
+// Errors are replied as "ERR_<module>:<connector>,<code>". See kGcErr*.
+// There is only the one IR LED, so the only address is "1:1".
+// Lines may end with '\r' and/or '\n'. Replies end with '\r'.
+//
+// Ref:
+//   https://www.globalcache.com/files/docs/API-iTach.pdf
+
+#include "IRGCServer.h"
+#ifndef UNIT_TEST
+#include <Arduino.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include "IRremoteESP8266.h"
+#include "IRsend.h"
+#include "IRutils.h"
+
+// The replies to the commands that don't do anything.
+static const char kGcDevicesReply[] = "device,0,0 ETHERNET\rdevice,1,1 IR\r"
+                                      "endlistdevices\r";
+static const char kGcVersionReply[] = "IRremoteESP8266 v"
+                                      _IRREMOTEESP8266_VERSION_ "\r";
+
+// Copy a string to the end of a reply.
+// Returns: Where the reply now ends. i.e. Where to append the next string.
+static char *append(char *dst, const char *src) {
+  while (*src) *dst++ = *src++;
+  *dst = '\0';
+  return dst;
+}
+
+// Create a server.
+//
+// Args:
+//   irsend: A pointer to the IRsend object to send with.
+//           If it has a backend set, messages are played in the background.
+//           Otherwise, they are sent synchronously. See IRsendBackend.
+//   reply: The function that writes a reply back to a client.
+IRGCServer::IRGCServer(IRsend *irsend, gc_reply_t reply)
+    : _irsend(irsend), _reply(reply), _first(0), _depth(0), _emitted(0) {
+  for (uint8_t i = 0; i < kGcServerConnections; i++) {
+    _connections[i].used = false;
+    _connections[i].queued = false;
+  }
+  resetStats();
+}
+
+// Start a new client connection.
+//
+// Returns:
+//   The connection nr. to use for it, or kGcServerNoConnection if there are
+//   already too many.
+uint8_t IRGCServer::connect(void) {
+  for (uint8_t i = 0; i < kGcServerConnections; i++) {
+    gc_connection_t *conn = &_connections[i];
+    if (conn->used) continue;
+    conn->used = true;
+    conn->queued = false;
+    resetLine(conn);
+    return i;
+  }
+  _stats.refused++;
+  return kGcServerNoConnection;
+}
+
+// A client has gone. Its sendir (if any) is dropped, even part way through.
+//
+// Args:
+//   connection: The connection nr. connect() returned for it.
+void IRGCServer::disconnect(const uint8_t connection) {
+  if (connection >= kGcServerConnections) return;
+  gc_connection_t *conn = &_connections[connection];
+  if (conn->queued) {
+    // Take it out of the queue, keeping the rest in order.
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < _depth; i++) {
+      const uint8_t queued = _queue[(_first + i) % kGcServerConnections];
+      if (queued == connection) {
+        if (i == 0) _emitted = 0;  // The next one starts from scratch.
+        continue;
+      }
+      _queue[(_first + kept++) % kGcServerConnections] = queued;
+    }
+    _depth = kept;
+    conn->queued = false;
+  }
+  conn->used = false;
+}
+
+// Get ready to parse a new line.
+void IRGCServer::resetLine(gc_connection_t *conn) {
+  conn->error = kGcErrNone;
+  conn->field = 0;
+  conn->number = 0;
+  conn->digits = false;
+  conn->length = 0;
+  conn->command[0] = '\0';
+  conn->address[0] = '\0';
+  conn->count = 0;
+}
+
+// The error for a bad value in a sendir field.
+static uint8_t fieldError(const uint16_t field) {
+  switch (field) {
+    case 2: return kGcErrId;
+    case 3: return kGcErrFrequency;
+    case 4: return kGcErrRepeat;
+    case 5: return kGcErrOffset;
+    default: return kGcErrPulseData;
+  }
+}
+
+// Parse some of the data a client sent. It doesn't have to be whole lines.
+// A client can only have one sendir waiting to be sent. The data from the
+// start of its next sendir onwards is left until then. i.e. The caller should
+// keep it, and offer it again later. Everything else is always taken.
+//
+// Args:
+//   connection: The connection nr. connect() returned for the client.
+//   data: The data it sent.
+//   length: The nr. of bytes of data.
+// Returns:
+//   The nr. of bytes taken.
+uint16_t IRGCServer::receive(const uint8_t connection, const char *data,
+                             const uint16_t length) {
+  if (connection >= kGcServerConnections || !_connections[connection].used)
+    return length;  // Not a client we know. Throw it away.
+  gc_connection_t *conn = &_connections[connection];
+  for (uint16_t i = 0; i < length; i++) {
+    const char c = data[i];
+    if (c == '\r' || c == '\n') {
+      // Ignore blank lines. e.g. The '\n' of a "\r\n".
+      if (conn->field || conn->length || conn->error) {
+        endField(conn);
+        endLine(connection);
+      }
+      continue;
+    }
+    if (conn->error) continue;  // Ignore the rest of a bad line.
+    if (c == ',') {
+      // Is it another sendir while the last is still waiting? Then wait too.
+      if (conn->field == 0 && conn->queued && !strcmp(conn->command, "sendir"))
+        return i;
+      endField(conn);
+      conn->field++;
+    } else if (conn->field >= 2) {  // A number.
+      if (c < '0' || c > '9') {
+        conn->error = fieldError(conn->field);
+        continue;
+      }
+      conn->number = conn->number * 10 + (c - '0');
+      conn->digits = true;
+      if (conn->number > UINT16_MAX) conn->error = fieldError(conn->field);
+    } else {  // The command or the address.
+      char *text = conn->field ? conn->address : conn->command;
+      if (conn->length + 1 >= kGcServerTextSize) {
+        conn->error = conn->field ? kGcErrSyntax : kGcErrCommand;
+        conn->address[0] = '\0';
+        continue;
+      }
+      text[conn->length++] = c;
+      text[conn->length] = '\0';
+    }
+  }
+  return length;
+}
+
+// Check & store the field just parsed.
+void IRGCServer::endField(gc_connection_t *conn) {
+  const bool sendir = !strcmp(conn->command, "sendir");
+  if (conn->error) return;
+  switch (conn->field) {
+    case 0:
+      if (!sendir && strcmp(conn->command, "stopir") &&
+          strcmp(conn->command, "getdevices") &&
+          strcmp(conn->command, "getversion"))
+        conn->error = kGcErrCommand;
+      break;
+    case 1: {
+      // Expect <module>:<connector>. We only have "1:1".
+      const char *colon = strchr(conn->address, ':');
+      const size_t digits = strspn(conn->address, "0123456789");
+      if (colon == NULL || digits == 0 || conn->address + digits != colon ||
+          colon[1] == '\0' ||
+          strspn(colon + 1, "0123456789") != strlen(colon + 1)) {
+        conn->error = kGcErrSyntax;
+        conn->address[0] = '\0';
+      } else if (strtoul(conn->address, NULL, 10) != 1) {
+        conn->error = kGcErrModule;
+      } else if (strtoul(colon + 1, NULL, 10) != 1) {
+        conn->error = kGcErrConnector;
+      }
+      break;
+    }
+    default:
+      if (!sendir) {
+        conn->error = kGcErrSyntax;
+      } else if (!conn->digits || (conn->field > 5 && conn->number == 0)) {
+        conn->error = fieldError(conn->field);
+      } else if (conn->field == 2) {
+        conn->id = conn->number;
+      } else if (conn->count >= kGcServerMaxValues) {
+        conn->error = kGcErrTooLong;
+      } else {
+        conn->values[conn->count++] = conn->number;
+      }
+  }
+  conn->number = 0;
+  conn->digits = false;
+  conn->length = 0;
+}
+
+// Act on a complete line.
+void IRGCServer::endLine(const uint8_t connection) {
+  gc_connection_t *conn = &_connections[connection];
+  _stats.commands++;
+  if (!conn->error) {
+    if (!strcmp(conn->command, "sendir")) {
+      // The fields before the values are the command, address & id.
+      const uint16_t pulses = conn->count - kGlobalCacheStartIndex;
+      if (conn->count < kGlobalCacheStartIndex)
+        conn->error = kGcErrSyntax;
+      else if (conn->values[kGlobalCacheFreqIndex] < kGcServerMinFrequency)
+        conn->error = kGcErrFrequency;
+      else if (conn->values[kGlobalCacheRptIndex] == 0 ||
+               conn->values[kGlobalCacheRptIndex] > kGlobalCacheMaxRepeat)
+        conn->error = kGcErrRepeat;
+      else if (pulses == 0)
+        conn->error = kGcErrPulseCount;
+      else if (pulses & 1)
+        conn->error = kGcErrUneven;
+      // Repeats must start with an <on>, inside the message.
+      else if (!(conn->values[kGlobalCacheRptStartIndex] & 1) ||
+               conn->values[kGlobalCacheRptStartIndex] > pulses)
+        conn->error = kGcErrOffset;
+      else
+        enqueue(connection);
+    } else if (!strcmp(conn->command, "stopir")) {
+      if (conn->field != 1) {
+        conn->error = kGcErrSyntax;
+      } else {
+        stop(connection);
+        char line[kGcServerTextSize + 8];
+        append(append(append(line, "stopir,"), conn->address), "\r");
+        reply(connection, line);
+      }
+    } else if (conn->field) {
+      conn->error = kGcErrSyntax;
+    } else if (!strcmp(conn->command, "getdevices")) {
+      reply(connection, kGcDevicesReply);
+    } else {
+      reply(connection, kGcVersionReply);
+    }
+  }
+  if (conn->error) replyError(connection, conn->error);
+  resetLine(conn);
+}
+
+// Send a reply to a client, if it is still connected.
+void IRGCServer::reply(const uint8_t connection, const char *reply) {
+  if (_reply != NULL && _connections[connection].used)
+    _reply(connection, reply);
+}
+
+// Reply with an error. e.g. "ERR_1:1,001"
+void IRGCServer::replyError(const uint8_t connection, const uint8_t error) {
+  const char *address = _connections[connection].address;
+  char line[kGcServerTextSize + 10];
+  char *end = append(append(line, "ERR_"), address[0] ? address : "0:0");
+  *end++ = ',';
+  *end++ = '0' + error / 100;
+  *end++ = '0' + (error / 10) % 10;
+  *end++ = '0' + error % 10;
+  append(end, "\r");
+  _stats.errors++;
+  reply(connection, line);
+}
+
+// Put a client's complete sendir at the back of the queue.
+void IRGCServer::enqueue(const uint8_t connection) {
+  gc_connection_t *conn = &_connections[connection];
+  conn->queued = true;
+  conn->queued_count = conn->count;
+  conn->queued_id = conn->id;
+  append(conn->queued_address, conn->address);
+  _queue[(_first + _depth) % kGcServerConnections] = connection;
+  _depth++;
+  if (_depth > _stats.max_depth) _stats.max_depth = _depth;
+}
+
+// Take the first sendir off the queue.
+void IRGCServer::dequeue(void) {
+  _connections[_queue[_first]].queued = false;
+  _first = (_first + 1) % kGcServerConnections;
+  _depth--;
+  _emitted = 0;
+}
+
+// Stop sending, & drop every sendir that is waiting.
+// The other clients they belonged to are told, as they won't get completeir's.
+//
+// Args:
+//   connection: The connection the stopir came from.
+void IRGCServer::stop(const uint8_t connection) {
+  while (_depth) {
+    const uint8_t queued = _queue[_first];
+    dequeue();
+    _stats.stopped++;
+    if (queued == connection) continue;  // It gets the reply to the stopir.
+    char line[kGcServerTextSize + 8];
+    append(append(append(line, "stopir,"), _connections[queued].queued_address),
+           "\r");
+    reply(queued, line);
+  }
+}
+
+// Send one copy of a sendir.
+//
+// Args:
+//   conn: The connection the sendir is from.
+//   copy: Which copy. The first is all of it, the repeats start at the offset.
+void IRGCServer::emit(gc_connection_t *conn, const uint16_t copy) {
+  const uint16_t hz = conn->values[kGlobalCacheFreqIndex];
+  uint16_t *buf = conn->values;
+  uint16_t length = conn->queued_count;
+  // sendGC() only does whole messages. For a repeat, temporarily put a
+  // header in front of the offset. It is odd, so the <on>'s stay <on>'s.
+  if (copy) {
+    const uint16_t shift = conn->values[kGlobalCacheRptStartIndex] - 1;
+    buf += shift;
+    length -= shift;
+  }
+  uint16_t saved[kGlobalCacheStartIndex];
+  memcpy(saved, buf, sizeof(saved));
+  buf[kGlobalCacheFreqIndex] = hz;
+  buf[kGlobalCacheRptIndex] = 1;
+  buf[kGlobalCacheRptStartIndex] = 1;
+  bool played = false;
+  // With a backend, render it & let it play in the background.
+  if (_irsend->getBackend() != NULL &&
+      _irsend->beginRender(_buffer, kGcServerMaxValues)) {
+    _irsend->sendGC(buf, length);
+    played = _irsend->endRender();
+  }
+  if (!played) _irsend->sendGC(buf, length);  // The blocking way.
+  memcpy(buf, saved, sizeof(saved));
+}
+
+// Do any queued work. Call this often. e.g. Every time through loop().
+// Each call sends at most one copy of the first sendir waiting.
+//
+// Returns:
+//   true if something was sent or finished, false if there was nothing we
+//   could do yet.
+bool IRGCServer::handle(void) {
+  if (_depth == 0 || _irsend->busy()) return false;
+  const uint8_t connection = _queue[_first];
+  gc_connection_t *conn = &_connections[connection];
+  const uint16_t copies = conn->values[kGlobalCacheRptIndex];
+  if (_emitted < copies) {
+    emit(conn, _emitted++);
+    // More copies to send, or acknowledge it once it has been played.
+    if (_emitted < copies || _irsend->busy()) return true;
+  }
+  char line[kGcServerTextSize + 18];
+  char *end = append(append(append(line, "completeir,"), conn->queued_address),
+                     ",");
+  end += uint64ToString(conn->queued_id, end, 6);
+  append(end, "\r");
+  dequeue();
+  _stats.sent++;
+  reply(connection, line);
+  return true;
+}
+
+// Returns: true if there is nothing waiting to be sent, or being played.
+bool IRGCServer::idle(void) { return _depth == 0 && !_irsend->busy(); }
+
+// Returns: Nr. of sendir's waiting. Including the one being sent.
+uint8_t IRGCServer::depth(void) { return _depth; }
+
+// Returns: Nr. of clients connected.
+uint8_t IRGCServer::connections(void) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < kGcServerConnections; i++)
+    if (_connections[i].used) count++;
+  return count;
+}
+
+// Returns: The server's counters.
+gc_server_stats_t IRGCServer::getStats(void) { return _stats; }
+
+// Reset the server's counters.
+void IRGCServer::resetStats(void) {
+  _stats.commands = 0;
+  _stats.sent = 0;
+  _stats.stopped = 0;
+  _stats.errors = 0;
+  _stats.refused = 0;
+  _stats.max_depth = _depth;
+}
@@ -0,0 +1,115 @@
+#ifndef IRGCSERVER_H_
+#define IRGCSERVER_H_
+
+// Copyright 2019 David Conran
+
+#define __STDC_LIMIT_MACROS
+#include <stdint.h>
+#include "IRremoteESP8266.h"
+#include "IRsend.h"
+
+// Constants
+const uint16_t kGcServerPort = 4998;  // The port a Global Cache iTach uses.
+const uint8_t kGcServerConnections = 4;  // Max. nr. of clients at once.
+// Max. nr. of values in a sendir, after the id. i.e. The frequency, repeat &
+// offset, plus up to 254 on/off pairs.
+const uint16_t kGcServerMaxValues = 511;
+const uint8_t kGcServerTextSize = 12;  // Max. command & address length + 1.
+const uint8_t kGcServerNoConnection = UINT8_MAX;  // connect() failed.
+// Lowest sendir frequency accepted. (Hz)
+const uint16_t kGcServerMinFrequency = 15000;
+
+// iTach error codes. Replied as: ERR_<module>:<connector>,<code>
+const uint8_t kGcErrNone = 0;
+const uint8_t kGcErrCommand = 1;     // Invalid command. Command not found.
+const uint8_t kGcErrModule = 2;      // Invalid module address.
+const uint8_t kGcErrConnector = 3;   // Invalid connector address.
+const uint8_t kGcErrId = 4;          // Invalid ID value.
+const uint8_t kGcErrFrequency = 5;   // Invalid frequency value.
+const uint8_t kGcErrRepeat = 6;      // Invalid repeat value.
+const uint8_t kGcErrOffset = 7;      // Invalid offset value.
+const uint8_t kGcErrPulseCount = 8;  // Invalid pulse count.
+const uint8_t kGcErrPulseData = 9;   // Invalid pulse data.
+const uint8_t kGcErrUneven = 10;     // Uneven amount of <on|off> statements.
+const uint8_t kGcErrSyntax = 17;     // Bad command syntax.
+const uint8_t kGcErrTooLong = 20;    // Above designated IR <on|off> pair limit.
+
+// Called with each reply for a client. It is a complete line, including the
+// trailing '\r'.
+// Args:
+//   connection: The connection nr. connect() returned for the client.
+//   reply: The NUL terminated reply.
+typedef void (*gc_reply_t)(const uint8_t connection, const char *reply);
+
+// The state of one client's connection, & the sendir it has waiting.
+typedef struct {
+  bool used;
+  bool queued;      // Is the sendir in values[] waiting to be sent?
+  uint8_t error;    // The first error in the line being parsed. kGcErr*.
+  uint16_t field;   // Which comma separated field of the line we are in.
+  uint32_t number;  // The value of the numeric field being parsed.
+  bool digits;      // Has the numeric field got any digits?
+  uint8_t length;   // Nr. of characters in the text field being parsed.
+  char command[kGcServerTextSize];
+  char address[kGcServerTextSize];  // e.g. "1:1"
+  uint16_t id;
+  uint16_t count;   // Nr. of values[] parsed.
+  uint16_t values[kGcServerMaxValues];  // In sendGC() order.
+  // The queued sendir's nr. of values, id & address. (For its completeir.)
+  uint16_t queued_count;
+  uint16_t queued_id;
+  char queued_address[kGcServerTextSize];
+} gc_connection_t;
+
+typedef struct {
+  uint32_t commands;   // Nr. of command lines processed.
+  uint32_t sent;       // Nr. of sendir's sent in full. i.e. completeir's.
+  uint32_t stopped;    // Nr. of sendir's cut short, or dropped, by stopir.
+  uint32_t errors;     // Nr. of ERR replies.
+  uint32_t refused;    // Nr. of connections refused, as there were too many.
+  uint8_t max_depth;   // High water mark of sendir's waiting.
+} gc_server_stats_t;
+
+// Class
+// A Global Cache iTach (IP2IR) compatible command server, for one IR LED.
+// It knows nothing about the network. The sketch accepts the connections,
+// hands over whatever the clients send, and writes back the replies.
+class IRGCServer {
+ public:
+  explicit IRGCServer(IRsend *irsend, gc_reply_t reply);
+  uint8_t connect(void);
+  void disconnect(const uint8_t connection);
+  uint16_t receive(const uint8_t connection, const char *data,
+                   const uint16_t length);
+  bool handle(void);
+  bool idle(void);
+  uint8_t depth(void);
+  uint8_t connections(void);
+  gc_server_stats_t getStats(void);
+  void resetStats(void);
+#ifndef UNIT_TEST
+
+ private:
+#endif
+  IRsend *_irsend;
+  gc_reply_t _reply;
+  gc_connection_t _connections[kGcServerConnections];
+  // The FIFO of connections with a sendir waiting. The first is being sent.
+  uint8_t _queue[kGcServerConnections];
+  uint8_t _first;
+  uint8_t _depth;
+  uint16_t _emitted;  // Nr. of copies of the first sendir sent so far.
+  uint16_t _buffer[kGcServerMaxValues];  // Where a backend's copy is rendered.
+  gc_server_stats_t _stats;
+  void resetLine(gc_connection_t *conn);
+  void endField(gc_connection_t *conn);
+  void endLine(const uint8_t connection);
+  void reply(const uint8_t connection, const char *reply);
+  void replyError(const uint8_t connection, const uint8_t error);
+  void enqueue(const uint8_t connection);
+  void dequeue(void);
+  void stop(const uint8_t connection);
+  void emit(gc_connection_t *conn, const uint16_t copy);
+};
+
+#endif  // IRGCSERVER_H_
@@ -9,6 +9,8 @@
 #include <Arduino.h>
 #endif
 #include <string.h>
+#include <algorithm>
+#include <new>
 #ifndef ARDUINO
 #include <string>
 #endif
@@ -37,7 +39,149 @@
 #include "ir_Vestel.h"
 #include "ir_Whirlpool.h"
 
-IRac::IRac(uint8_t pin) { _pin = pin; }
+#ifndef ARDUINO
+// Host (i.e. Unit test) stand-ins for the Arduino flash string routines.
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define strlen_P strlen
+#define memcpy_P memcpy
+#endif  // ARDUINO
+
+IRac::IRac(uint8_t pin) {
+  _pin = pin;
+  _pool_enabled = false;
+  _pool_clock = 0;
+  for (uint8_t i = 0; i < kAcPoolSize; i++) {
+    _pool[i].protocol = decode_type_t::UNKNOWN;
+    _pool[i].ac = NULL;
+  }
+}
+
+IRac::~IRac(void) { clearPool(); }
+
+// A/C object pool -------------------
+//
+// Normally sendAc() creates (and begin()s) a vendor object on the stack for
+// every message. With the pool enabled, the object for each A/C unit is
+// created once, on first use, and kept. A unit is identified by its
+// (target, protocol, model), where `target` is the caller's id for it, so
+// several units of the same model can be pooled independently. Later messages
+// to the same unit reuse its object, and toggle settings are handled against
+// the last state sent to that unit.
+// Up to kAcPoolSize objects are kept. The least recently used one is deleted
+// when room is needed for another.
+//
+// Note:
+//   Every setting is still applied to the object for each message, not just
+//   the ones that changed. Each vendor object also keeps its own IRsend, as
+//   the vendor classes own one. i.e. The pool saves the construction, not
+//   the transmission, of a message.
+//   A pooled object keeps any setting that a later message doesn't apply.
+//   e.g. A clock set by one message is sent again in later ones that have a
+//   clock of -1, where a new object would send its default instead.
+
+// Enable (or disable) keeping vendor A/C objects between sendAc() calls.
+// Disabling it deletes any objects kept so far.
+void IRac::enablePool(const bool enable) {
+  _pool_enabled = enable;
+  if (!enable) clearPool();
+}
+
+// Returns: true if the A/C object pool is in use.
+bool IRac::isPoolEnabled(void) { return _pool_enabled; }
+
+// Delete all the A/C objects kept in the pool.
+void IRac::clearPool(void) {
+  for (uint8_t i = 0; i < kAcPoolSize; i++) freePooled(&_pool[i]);
+}
+
+// Delete the object kept in a pool entry, and mark the entry as free.
+void IRac::freePooled(ac_pool_entry_t *entry) {
+  if (entry->ac != NULL) entry->destroy(entry->ac);
+  entry->ac = NULL;
+  entry->protocol = decode_type_t::UNKNOWN;
+  entry->has_last = false;
+}
+
+// Find the pool entry for an A/C unit.
+// Args:
+//   protocol: The type of A/C protocol.
+//   model: The specific model of the A/C.
+//   target: The caller's id for the unit.
+// Returns: A ptr to the entry, or NULL if there isn't one.
+ac_pool_entry_t *IRac::findPooled(const decode_type_t protocol,
+                                  const int16_t model, const uint16_t target) {
+  if (protocol == decode_type_t::UNKNOWN) return NULL;
+  for (uint8_t i = 0; i < kAcPoolSize; i++)
+    if (_pool[i].protocol == protocol && _pool[i].model == model &&
+        _pool[i].target == target) {
+      _pool[i].used = ++_pool_clock;
+      return &_pool[i];
+    }
+  return NULL;
+}
+
+template <class AC>
+static void destroyAc(void *ac) { delete static_cast<AC *>(ac); }
+
+// Get the pooled object for an A/C unit, creating it if needed.
+// Args:
+//   protocol: The type of A/C protocol.
+//   model: The specific model of the A/C.
+//   target: The caller's id for the unit.
+//   begin: Call the new object's begin()?
+// Returns:
+//   A ptr to the object, or NULL if it couldn't be created.
+template <class AC>
+AC *IRac::pooledAc(const decode_type_t protocol, const int16_t model,
+                   const uint16_t target, const bool begin) {
+  ac_pool_entry_t *entry = findPooled(protocol, model, target);
+  if (entry != NULL) return static_cast<AC *>(entry->ac);
+  // Use a free entry, otherwise the least recently used one.
+  entry = &_pool[0];
+  for (uint8_t i = 0; i < kAcPoolSize; i++) {
+    if (_pool[i].protocol == decode_type_t::UNKNOWN) {
+      entry = &_pool[i];
+      break;
+    }
+    if (_pool[i].used < entry->used) entry = &_pool[i];
+  }
+  freePooled(entry);
+  AC *ac = new AC(_pin);
+  if (ac == NULL) return NULL;
+  if (begin) ac->begin();
+  entry->protocol = protocol;
+  entry->model = model;
+  entry->target = target;
+  entry->ac = ac;
+  entry->destroy = destroyAc<AC>;
+  entry->used = ++_pool_clock;
+  return ac;
+}
+
+// Apply some settings to the vendor object for an A/C, and send them.
+// Uses the pooled object if the pool is enabled, otherwise a temporary one.
+// Args:
+//   protocol: The type of A/C protocol.
+//   model: The specific model of the A/C.
+//   target: The caller's id for the unit.
+//   begin: Does a new object need begin() called?
+//   apply: A function (e.g. a lambda) that is passed the AC * to use.
+template <class AC, typename F>
+void IRac::withAc(const decode_type_t protocol, const int16_t model,
+                  const uint16_t target, const bool begin, F apply) {
+  if (_pool_enabled) {
+    AC *ac = pooledAc<AC>(protocol, model, target, begin);
+    if (ac != NULL) {
+      apply(ac);
+      return;
+    }
+  }
+  AC ac(_pin);
+  if (begin) ac.begin();
+  apply(&ac);
+}
 
 // Is the given protocol supported by the IRac class?
 bool IRac::isProtocolSupported(const decode_type_t protocol) {
@@ -259,7 +403,10 @@ void IRac::daikin2(IRDaikin2 *ac,
   ac->setPurify(filter);
   ac->setMold(clean);
   ac->setBeep(beep);
-  if (sleep > 0) ac->enableSleepTimer(sleep);
+  if (sleep > 0)
+    ac->enableSleepTimer(sleep);
+  else
+    ac->disableSleepTimer();
   if (clock >= 0) ac->setCurrentTime(clock);
   ac->send();
 }
@@ -928,6 +1075,8 @@ stdAc::state_t IRac::handleToggles(const stdAc::state_t desired,
 //   beep:    Control if the unit beeps upon receiving commands.
 //   sleep:   Nr. of mins of sleep mode, or use sleep mode. (< 0 means off.)
 //   clock:   Nr. of mins past midnight to set the clock to. (< 0 means off.)
+//   target:  The caller's id for the unit. Only used by the pool to tell
+//            several units of the same model apart. See enablePool().
 // Returns:
 //   boolean: True, if accepted/converted/attempted. False, if unsupported.
 bool IRac::sendAc(const decode_type_t vendor, const int16_t model,
@@ -937,7 +1086,8 @@ bool IRac::sendAc(const decode_type_t vendor, const int16_t model,
                   const stdAc::swingv_t swingv, const stdAc::swingh_t swingh,
                   const bool quiet, const bool turbo, const bool econo,
                   const bool light, const bool filter, const bool clean,
-                  const bool beep, const int16_t sleep, const int16_t clock) {
+                  const bool beep, const int16_t sleep, const int16_t clock,
+                  const uint16_t target) {
   // Convert the temperature to Celsius.
   float degC;
   if (celsius)
@@ -951,258 +1101,216 @@ bool IRac::sendAc(const decode_type_t vendor, const int16_t model,
   switch (vendor) {
 #if SEND_ARGO
     case ARGO:
-    {
-      IRArgoAC ac(_pin);
-      argo(&ac, on, mode, degC, fan, swingv, turbo, sleep);
+      withAc<IRArgoAC>(vendor, model, target, false, [&](IRArgoAC *ac) {
+        argo(ac, on, mode, degC, fan, swingv, turbo, sleep);
+      });
       break;
-    }
 #endif  // SEND_DAIKIN
 #if SEND_COOLIX
     case COOLIX:
-    {
-      IRCoolixAC ac(_pin);
-      coolix(&ac, on, mode, degC, fan, swingv, swingh,
-             quiet, turbo, econo, clean);
+      withAc<IRCoolixAC>(vendor, model, target, false, [&](IRCoolixAC *ac) {
+        coolix(ac, on, mode, degC, fan, swingv, swingh,
+               quiet, turbo, econo, clean);
+      });
       break;
-    }
 #endif  // SEND_DAIKIN
 #if SEND_DAIKIN
     case DAIKIN:
-    {
-      IRDaikinESP ac(_pin);
-      daikin(&ac, on, mode, degC, fan, swingv, swingh,
-             quiet, turbo, econo, clean);
+      withAc<IRDaikinESP>(vendor, model, target, false, [&](IRDaikinESP *ac) {
+        daikin(ac, on, mode, degC, fan, swingv, swingh,
+               quiet, turbo, econo, clean);
+      });
       break;
-    }
 #endif  // SEND_DAIKIN
 #if SEND_DAIKIN160
     case DAIKIN160:
-    {
-      IRDaikin160 ac(_pin);
-      daikin160(&ac, on, mode, degC, fan, swingv);
+      withAc<IRDaikin160>(vendor, model, target, false, [&](IRDaikin160 *ac) {
+        daikin160(ac, on, mode, degC, fan, swingv);
+      });
       break;
-    }
 #endif  // SEND_DAIKIN160
 #if SEND_DAIKIN2
     case DAIKIN2:
-    {
-      IRDaikin2 ac(_pin);
-      daikin2(&ac, on, mode, degC, fan, swingv, swingh, quiet, turbo,
-              light, econo, filter, clean, beep, sleep, clock);
+      withAc<IRDaikin2>(vendor, model, target, false, [&](IRDaikin2 *ac) {
+        daikin2(ac, on, mode, degC, fan, swingv, swingh, quiet, turbo,
+                light, econo, filter, clean, beep, sleep, clock);
+      });
       break;
-    }
 #endif  // SEND_DAIKIN216
 #if SEND_DAIKIN216
     case DAIKIN216:
-    {
-      IRDaikin216 ac(_pin);
-      daikin216(&ac, on, mode, degC, fan, swingv, swingh, quiet, turbo);
+      withAc<IRDaikin216>(vendor, model, target, false, [&](IRDaikin216 *ac) {
+        daikin216(ac, on, mode, degC, fan, swingv, swingh, quiet, turbo);
+      });
       break;
-    }
 #endif  // SEND_DAIKIN216
 #if SEND_ELECTRA_AC
     case ELECTRA_AC:
-    {
-      IRElectraAc ac(_pin);
-      ac.begin();
-      electra(&ac, on, mode, degC, fan, swingv, swingh);
+      withAc<IRElectraAc>(vendor, model, target, true, [&](IRElectraAc *ac) {
+        electra(ac, on, mode, degC, fan, swingv, swingh);
+      });
       break;
-    }
 #endif  // SEND_ELECTRA_AC
 #if SEND_FUJITSU_AC
     case FUJITSU_AC:
-    {
-      IRFujitsuAC ac(_pin);
-      ac.begin();
-      fujitsu(&ac, (fujitsu_ac_remote_model_t)model, on, mode, degC, fan,
-              swingv, swingh, quiet, turbo, econo);
+      withAc<IRFujitsuAC>(vendor, model, target, true, [&](IRFujitsuAC *ac) {
+        fujitsu(ac, (fujitsu_ac_remote_model_t)model, on, mode, degC, fan,
+                swingv, swingh, quiet, turbo, econo);
+      });
       break;
-    }
 #endif  // SEND_FUJITSU_AC
 #if SEND_GOODWEATHER
     case GOODWEATHER:
-    {
-      IRGoodweatherAc ac(_pin);
-      ac.begin();
-      goodweather(&ac, on, mode, degC, fan, swingv, turbo, light, sleep);
+      withAc<IRGoodweatherAc>(
+          vendor, model, target, true, [&](IRGoodweatherAc *ac) {
+        goodweather(ac, on, mode, degC, fan, swingv, turbo, light, sleep);
+      });
       break;
-    }
 #endif  // SEND_GOODWEATHER
 #if SEND_GREE
     case GREE:
-    {
-      IRGreeAC ac(_pin);
-      ac.begin();
-      gree(&ac, on, mode, degC, fan, swingv, light, turbo, clean, sleep);
+      withAc<IRGreeAC>(vendor, model, target, true, [&](IRGreeAC *ac) {
+        gree(ac, on, mode, degC, fan, swingv, light, turbo, clean, sleep);
+      });
       break;
-    }
 #endif  // SEND_GREE
 #if SEND_HAIER_AC
     case HAIER_AC:
-    {
-      IRHaierAC ac(_pin);
-      ac.begin();
-      haier(&ac, on, mode, degC, fan, swingv, filter, sleep, clock);
+      withAc<IRHaierAC>(vendor, model, target, true, [&](IRHaierAC *ac) {
+        haier(ac, on, mode, degC, fan, swingv, filter, sleep, clock);
+      });
       break;
-    }
 #endif  // SEND_HAIER_AC
 #if SEND_HAIER_AC_YRW02
     case HAIER_AC_YRW02:
-    {
-      IRHaierACYRW02 ac(_pin);
-      ac.begin();
-      haierYrwo2(&ac, on, mode, degC, fan, swingv, turbo, filter, sleep);
+      withAc<IRHaierACYRW02>(
+          vendor, model, target, true, [&](IRHaierACYRW02 *ac) {
+        haierYrwo2(ac, on, mode, degC, fan, swingv, turbo, filter, sleep);
+      });
       break;
-    }
 #endif  // SEND_HAIER_AC_YRW02
 #if SEND_HITACHI_AC
     case HITACHI_AC:
-    {
-      IRHitachiAc ac(_pin);
-      ac.begin();
-      hitachi(&ac, on, mode, degC, fan, swingv, swingh);
+      withAc<IRHitachiAc>(vendor, model, target, true, [&](IRHitachiAc *ac) {
+        hitachi(ac, on, mode, degC, fan, swingv, swingh);
+      });
       break;
-    }
 #endif  // SEND_HITACHI_AC
 #if SEND_KELVINATOR
     case KELVINATOR:
-    {
-      IRKelvinatorAC ac(_pin);
-      ac.begin();
-      kelvinator(&ac, on, mode, degC, fan, swingv, swingh, quiet, turbo,
-                 light, filter, clean);
+      withAc<IRKelvinatorAC>(
+          vendor, model, target, true, [&](IRKelvinatorAC *ac) {
+        kelvinator(ac, on, mode, degC, fan, swingv, swingh, quiet, turbo,
+                   light, filter, clean);
+      });
       break;
-    }
 #endif  // SEND_KELVINATOR
 #if SEND_MIDEA
     case MIDEA:
-    {
-      IRMideaAC ac(_pin);
-      ac.begin();
-      midea(&ac, on, mode, degC, fan, sleep);
+      withAc<IRMideaAC>(vendor, model, target, true, [&](IRMideaAC *ac) {
+        midea(ac, on, mode, degC, fan, sleep);
+      });
       break;
-    }
 #endif  // SEND_MIDEA
 #if SEND_MITSUBISHI_AC
     case MITSUBISHI_AC:
-    {
-      IRMitsubishiAC ac(_pin);
-      ac.begin();
-      mitsubishi(&ac, on, mode, degC, fan, swingv, quiet, clock);
+      withAc<IRMitsubishiAC>(
+          vendor, model, target, true, [&](IRMitsubishiAC *ac) {
+        mitsubishi(ac, on, mode, degC, fan, swingv, quiet, clock);
+      });
       break;
-    }
 #endif  // SEND_MITSUBISHI_AC
 #if SEND_MITSUBISHIHEAVY
     case MITSUBISHI_HEAVY_88:
-    {
-      IRMitsubishiHeavy88Ac ac(_pin);
-      ac.begin();
-      mitsubishiHeavy88(&ac, on, mode, degC, fan, swingv, swingh,
-                        turbo, econo, clean);
+      withAc<IRMitsubishiHeavy88Ac>(
+          vendor, model, target, true, [&](IRMitsubishiHeavy88Ac *ac) {
+        mitsubishiHeavy88(ac, on, mode, degC, fan, swingv, swingh,
+                          turbo, econo, clean);
+      });
       break;
-    }
     case MITSUBISHI_HEAVY_152:
-    {
-      IRMitsubishiHeavy152Ac ac(_pin);
-      ac.begin();
-      mitsubishiHeavy152(&ac, on, mode, degC, fan, swingv, swingh,
-                         quiet, turbo, econo, filter, clean, sleep);
+      withAc<IRMitsubishiHeavy152Ac>(
+          vendor, model, target, true, [&](IRMitsubishiHeavy152Ac *ac) {
+        mitsubishiHeavy152(ac, on, mode, degC, fan, swingv, swingh,
+                           quiet, turbo, econo, filter, clean, sleep);
+      });
       break;
-    }
 #endif  // SEND_MITSUBISHIHEAVY
 #if SEND_NEOCLIMA
     case NEOCLIMA:
-    {
-      IRNeoclimaAc ac(_pin);
-      ac.begin();
-      neoclima(&ac, on, mode, degC, fan, swingv, swingh, turbo, light, filter,
-               sleep);
+      withAc<IRNeoclimaAc>(vendor, model, target, true, [&](IRNeoclimaAc *ac) {
+        neoclima(ac, on, mode, degC, fan, swingv, swingh, turbo, light, filter,
+                 sleep);
+      });
       break;
-    }
 #endif  // SEND_NEOCLIMA
 #if SEND_PANASONIC_AC
     case PANASONIC_AC:
-    {
-      IRPanasonicAc ac(_pin);
-      ac.begin();
-      panasonic(&ac, (panasonic_ac_remote_model_t)model, on, mode, degC, fan,
-                swingv, swingh, quiet, turbo, clock);
+      withAc<IRPanasonicAc>(
+          vendor, model, target, true, [&](IRPanasonicAc *ac) {
+        panasonic(ac, (panasonic_ac_remote_model_t)model, on, mode, degC, fan,
+                  swingv, swingh, quiet, turbo, clock);
+      });
       break;
-    }
 #endif  // SEND_PANASONIC_AC
 #if SEND_SAMSUNG_AC
     case SAMSUNG_AC:
-    {
-      IRSamsungAc ac(_pin);
-      ac.begin();
-      samsung(&ac, on, mode, degC, fan, swingv, quiet, turbo, clean, beep);
+      withAc<IRSamsungAc>(vendor, model, target, true, [&](IRSamsungAc *ac) {
+        samsung(ac, on, mode, degC, fan, swingv, quiet, turbo, clean, beep);
+      });
       break;
-    }
 #endif  // SEND_SAMSUNG_AC
 #if SEND_SHARP_AC
     case SHARP_AC:
-    {
-      IRSharpAc ac(_pin);
-      ac.begin();
-      sharp(&ac, on, mode, degC, fan);
+      withAc<IRSharpAc>(vendor, model, target, true, [&](IRSharpAc *ac) {
+        sharp(ac, on, mode, degC, fan);
+      });
       break;
-    }
 #endif  // SEND_SHARP_AC
 #if SEND_TCL112AC
     case TCL112AC:
-    {
-      IRTcl112Ac ac(_pin);
-      ac.begin();
-      tcl112(&ac, on, mode, degC, fan, swingv, swingh, turbo, light, econo,
-             filter);
+      withAc<IRTcl112Ac>(vendor, model, target, true, [&](IRTcl112Ac *ac) {
+        tcl112(ac, on, mode, degC, fan, swingv, swingh, turbo, light, econo,
+               filter);
+      });
       break;
-    }
 #endif  // SEND_TCL112AC
 #if SEND_TECO
     case TECO:
-    {
-      IRTecoAc ac(_pin);
-      ac.begin();
-      teco(&ac, on, mode, degC, fan, swingv, sleep);
+      withAc<IRTecoAc>(vendor, model, target, true, [&](IRTecoAc *ac) {
+        teco(ac, on, mode, degC, fan, swingv, sleep);
+      });
       break;
-    }
 #endif  // SEND_TECO
 #if SEND_TOSHIBA_AC
     case TOSHIBA_AC:
-    {
-      IRToshibaAC ac(_pin);
-      ac.begin();
-      toshiba(&ac, on, mode, degC, fan);
+      withAc<IRToshibaAC>(vendor, model, target, true, [&](IRToshibaAC *ac) {
+        toshiba(ac, on, mode, degC, fan);
+      });
       break;
-    }
 #endif  // SEND_TOSHIBA_AC
 #if SEND_TROTEC
     case TROTEC:
-    {
-      IRTrotecESP ac(_pin);
-      ac.begin();
-      trotec(&ac, on, mode, degC, fan, sleep);
+      withAc<IRTrotecESP>(vendor, model, target, true, [&](IRTrotecESP *ac) {
+        trotec(ac, on, mode, degC, fan, sleep);
+      });
       break;
-    }
 #endif  // SEND_TROTEC
 #if SEND_VESTEL_AC
     case VESTEL_AC:
-    {
-      IRVestelAc ac(_pin);
-      ac.begin();
-      vestel(&ac, on, mode, degC, fan, swingv, turbo, filter, sleep, clock);
+      withAc<IRVestelAc>(vendor, model, target, true, [&](IRVestelAc *ac) {
+        vestel(ac, on, mode, degC, fan, swingv, turbo, filter, sleep, clock);
+      });
       break;
-    }
 #endif  // SEND_VESTEL_AC
 #if SEND_WHIRLPOOL_AC
     case WHIRLPOOL_AC:
-    {
-      IRWhirlpoolAc ac(_pin);
-      ac.begin();
-      whirlpool(&ac, (whirlpool_ac_remote_model_t)model, on, mode, degC, fan,
-                swingv, turbo, light, sleep, clock);
+      withAc<IRWhirlpoolAc>(
+          vendor, model, target, true, [&](IRWhirlpoolAc *ac) {
+        whirlpool(ac, (whirlpool_ac_remote_model_t)model, on, mode, degC, fan,
+                  swingv, turbo, light, sleep, clock);
+      });
       break;
-    }
 #endif  // SEND_WHIRLPOOL_AC
     default:
       return false;  // Fail, didn't match anything.
@@ -1214,16 +1322,80 @@ bool IRac::sendAc(const decode_type_t vendor, const int16_t model,
 // Args:
 //   desired: The state_t structure describing the desired new a/c state.
 //   prev:    Ptr to the previous state_t structure.
+//   target:  The caller's id for the unit. e.g. A zone number.
 //
 // Returns:
 //   boolean: True, if accepted/converted/attempted. False, if unsupported.
-bool IRac::sendAc(const stdAc::state_t desired, const stdAc::state_t *prev) {
+//
+// Note:
+//   With the pool enabled, a NULL `prev` means the last state sent to that
+//   unit (i.e. the same target, protocol & model), if any, is used as the
+//   previous state. Units with different targets never share one.
+bool IRac::sendAc(const stdAc::state_t desired, const stdAc::state_t *prev,
+                  const uint16_t target) {
+  if (_pool_enabled && prev == NULL) {
+    ac_pool_entry_t *entry = findPooled(desired.protocol, desired.model,
+                                        target);
+    if (entry != NULL && entry->has_last) prev = &entry->last;
+  }
   stdAc::state_t final = this->handleToggles(desired, prev);
-  return this->sendAc(final.protocol, final.model, final.power, final.mode,
-                      final.degrees, final.celsius, final.fanspeed,
-                      final.swingv, final.swingh, final.quiet, final.turbo,
-                      final.econo, final.light, final.filter, final.clean,
-                      final.beep, final.sleep, final.clock);
+  bool success = this->sendAc(final.protocol, final.model, final.power,
+                              final.mode, final.degrees, final.celsius,
+                              final.fanspeed, final.swingv, final.swingh,
+                              final.quiet, final.turbo, final.econo,
+                              final.light, final.filter, final.clean,
+                              final.beep, final.sleep, final.clock, target);
+  if (success && _pool_enabled) {
+    ac_pool_entry_t *entry = findPooled(desired.protocol, desired.model,
+                                        target);
+    if (entry != NULL) {
+      entry->last = desired;
+      entry->has_last = true;
+    }
+  }
+  return success;
+}
+
+// Send a batch of A/C state changes, for (possibly) many A/C units.
+// Args:
+//   updates: The updates to make, in the order they were requested.
+//   count:   Nr. of entries in `updates`.
+//   results: An array of at least `count` entries. Each is set to what
+//            happened to the corresponding update.
+// Returns:
+//   The nr. of messages successfully sent.
+//
+// Note:
+//   Only the last update for each target is sent. Earlier ones are dropped,
+//   and reported as duplicates if cmpStates() says they are the same as the
+//   one that replaced them, or as superseded if not.
+//   The rest are sent in the order given. Each is sent as per
+//   sendAc(state, NULL, target). i.e. If the pool is enabled, toggles are
+//   worked out against the last state sent to that target's A/C.
+uint16_t IRac::sendBatch(const ac_update_t updates[], const uint16_t count,
+                         ac_batch_status_t results[]) {
+  if (updates == NULL || results == NULL) return 0;
+  // Drop the updates that a later one replaces.
+  for (uint16_t i = 0; i < count; i++) {
+    results[i] = kAcBatchPending;
+    for (uint16_t j = i + 1; j < count; j++)
+      if (updates[j].target == updates[i].target) {
+        results[i] = cmpStates(updates[i].state, updates[j].state) ?
+            kAcBatchSuperseded : kAcBatchDuplicate;
+        break;
+      }
+  }
+  uint16_t sent = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    if (results[i] != kAcBatchPending) continue;
+    if (sendAc(updates[i].state, NULL, updates[i].target)) {
+      results[i] = kAcBatchSent;
+      sent++;
+    } else {
+      results[i] = kAcBatchFailed;
+    }
+  }
+  return sent;
 }
 
 // Compare two AirCon states.
@@ -1379,88 +1551,597 @@ bool IRac::strToBool(const char *str, const bool def) {
     return def;
 }
 
+// The names of the common settings. Indexed by the setting + 1, so the -1 (i.e.
+// kOff) values can be included.
+static const char kOnStr[] PROGMEM = "on";
+static const char kOffStr[] PROGMEM = "off";
+static const char kUnknownSettingStr[] PROGMEM = "unknown";
+static const char kOpmodeNames[][9] PROGMEM = {
+    "off", "auto", "cool", "heat", "dry", "fan_only"};
+static const char kFanspeedNames[][8] PROGMEM = {
+    "", "auto", "min", "low", "medium", "high", "max"};
+static const char kSwingvNames[][8] PROGMEM = {
+    "off", "auto", "highest", "high", "middle", "low", "lowest"};
+static const char kSwinghNames[][9] PROGMEM = {
+    "off", "auto", "leftmax", "left", "middle", "right", "rightmax"};
+
+// Look up a setting's name in one of the name tables above.
+// Returns: A ptr to the name, in flash (PROGMEM).
+template <size_t N, size_t Width>
+static const char *settingName(const char (&names)[N][Width],
+                               const int value) {
+  const int index = value + 1;
+  if (index < 0 || index >= static_cast<int>(N) ||
+      !pgm_read_byte(names[index]))  // The table is in flash.
+    return kUnknownSettingStr;
+  return names[index];
+}
+
+static String flashToString(const char *name) {
+#ifdef ARDUINO
+  return FPSTR(name);
+#else
+  return name;
+#endif  // ARDUINO
+}
+
 String IRac::boolToString(const bool value) {
-  return value ? F("on") : F("off");
+  return flashToString(value ? kOnStr : kOffStr);
 }
 
 String IRac::opmodeToString(const stdAc::opmode_t mode) {
-  switch (mode) {
-    case stdAc::opmode_t::kOff:
-      return F("off");
-    case stdAc::opmode_t::kAuto:
-      return F("auto");
-    case stdAc::opmode_t::kCool:
-      return F("cool");
-    case stdAc::opmode_t::kHeat:
-      return F("heat");
-    case stdAc::opmode_t::kDry:
-      return F("dry");
-    case stdAc::opmode_t::kFan:
-      return F("fan_only");
-    default:
-      return F("unknown");
-  }
+  return flashToString(settingName(kOpmodeNames, (int)mode));
 }
 
 String IRac::fanspeedToString(const stdAc::fanspeed_t speed) {
-  switch (speed) {
-    case stdAc::fanspeed_t::kAuto:
-      return F("auto");
-    case stdAc::fanspeed_t::kMax:
-      return F("max");
-    case stdAc::fanspeed_t::kHigh:
-      return F("high");
-    case stdAc::fanspeed_t::kMedium:
-      return F("medium");
-    case stdAc::fanspeed_t::kLow:
-      return F("low");
-    case stdAc::fanspeed_t::kMin:
-      return F("min");
-    default:
-      return F("unknown");
-  }
+  return flashToString(settingName(kFanspeedNames, (int)speed));
 }
 
 String IRac::swingvToString(const stdAc::swingv_t swingv) {
-  switch (swingv) {
-    case stdAc::swingv_t::kOff:
-      return F("off");
-    case stdAc::swingv_t::kAuto:
-      return F("auto");
-    case stdAc::swingv_t::kHighest:
-      return F("highest");
-    case stdAc::swingv_t::kHigh:
-      return F("high");
-    case stdAc::swingv_t::kMiddle:
-      return F("middle");
-    case stdAc::swingv_t::kLow:
-      return F("low");
-    case stdAc::swingv_t::kLowest:
-      return F("lowest");
-    default:
-      return F("unknown");
-  }
+  return flashToString(settingName(kSwingvNames, (int)swingv));
 }
 
 String IRac::swinghToString(const stdAc::swingh_t swingh) {
-  switch (swingh) {
-    case stdAc::swingh_t::kOff:
-      return F("off");
-    case stdAc::swingh_t::kAuto:
-      return F("auto");
-    case stdAc::swingh_t::kLeftMax:
-      return F("leftmax");
-    case stdAc::swingh_t::kLeft:
-      return F("left");
-    case stdAc::swingh_t::kMiddle:
-      return F("middle");
-    case stdAc::swingh_t::kRight:
-      return F("right");
-    case stdAc::swingh_t::kRightMax:
-      return F("rightmax");
+  return flashToString(settingName(kSwinghNames, (int)swingh));
+}
+
+// Serialisation -------------------
+//
+// A common A/C state (& optionally the vendor's own raw state) can be written
+// out as a few packed bytes, or as a JSON object, without using the heap.
+//
+// Note:
+//   Only the common (stdAc::state_t) settings get fields/keys of their own.
+//   Settings that only one vendor has (e.g. A Daikin's comfort mode) don't.
+//   They are only kept as part of the raw state, as is. To get at them, pass
+//   the raw state to the vendor class's setRaw(), then use its getters or
+//   toString().
+//
+// The packed form (all multi-byte values are little endian):
+//   Byte  0:     Format version. (kAcPackedStateVersion)
+//   Byte  1:     Protocol. 0xFF for UNKNOWN.
+//   Bytes 2-3:   Model.
+//   Byte  4:     Flags. Bit 0 power, 1 celsius, 2 quiet, 3 turbo, 4 econo,
+//                5 light, 6 filter, 7 clean.
+//   Byte  5:     Bit 0 beep, Bits 1-3 mode + 1, Bits 4-6 fan speed.
+//   Byte  6:     Bits 0-3 vertical swing + 1, Bits 4-7 horizontal swing + 1.
+//   Bytes 7-8:   Temperature, in tenths of a degree.
+//   Bytes 9-10:  Sleep.
+//   Bytes 11-12: Clock.
+//   Byte  13:    Length of the raw (vendor) state that follows. 0 if none.
+//   Bytes 14-:   The raw state, if any.
+
+static void packInt16(uint8_t *buf, const int16_t value) {
+  buf[0] = (uint16_t)value & 0xFF;
+  buf[1] = (uint16_t)value >> 8;
+}
+
+static int16_t unpackInt16(const uint8_t *buf) {
+  return (int16_t)(buf[0] | (buf[1] << 8));
+}
+
+// A temperature in tenths of a degree. (Rounded)
+static int16_t tenthsOfDegrees(const float degrees) {
+  return (int16_t)(degrees * 10 + (degrees < 0 ? -0.5 : 0.5));
+}
+
+// Pack a common A/C state into a few bytes.
+//
+// Args:
+//   state: The state to pack.
+//   buf: Where to store the packed state.
+//   size: The size of `buf`. It needs to be kAcPackedStateSize + rawlen.
+//   raw: The vendor's own raw state to include, if any. e.g. From getRaw().
+//   rawlen: The length of `raw`. Max. is kStateSizeMax.
+// Returns:
+//   The nr. of bytes used. 0 if it didn't fit, or `raw` is too long.
+uint16_t IRac::packState(const stdAc::state_t state, uint8_t *buf,
+                         const uint16_t size, const uint8_t *raw,
+                         const uint16_t rawlen) {
+  const uint16_t length = kAcPackedStateSize + (raw != NULL ? rawlen : 0);
+  if (buf == NULL || size < length ||
+      length - kAcPackedStateSize > kStateSizeMax)
+    return 0;
+  buf[0] = kAcPackedStateVersion;
+  buf[1] = (state.protocol >= 0 && state.protocol <= kLastDecodeType) ?
+      state.protocol : 0xFF;
+  packInt16(buf + 2, state.model);
+  buf[4] = state.power | state.celsius << 1 | state.quiet << 2 |
+      state.turbo << 3 | state.econo << 4 | state.light << 5 |
+      state.filter << 6 | state.clean << 7;
+  buf[5] = state.beep | (((int)state.mode + 1) & 0x7) << 1 |
+      ((int)state.fanspeed & 0x7) << 4;
+  buf[6] = (((int)state.swingv + 1) & 0xF) |
+      (((int)state.swingh + 1) & 0xF) << 4;
+  packInt16(buf + 7, tenthsOfDegrees(state.degrees));
+  packInt16(buf + 9, state.sleep);
+  packInt16(buf + 11, state.clock);
+  buf[13] = length - kAcPackedStateSize;
+  if (buf[13]) memcpy(buf + kAcPackedStateSize, raw, buf[13]);
+  return length;
+}
+
+// Unpack a state packed by packState().
+//
+// Args:
+//   buf: The packed state.
+//   size: Nr. of bytes in `buf`.
+//   result: Where to store the common A/C state.
+//   raw: Where to store any raw (vendor) state. It needs room for
+//     kStateSizeMax bytes. NULL if you don't want it.
+//   rawlen: Where to store the length of the raw state. NULL if not wanted.
+// Returns:
+//   A boolean indicating if it was a valid packed state.
+bool IRac::unpackState(const uint8_t *buf, const uint16_t size,
+                       stdAc::state_t *result, uint8_t *raw,
+                       uint16_t *rawlen) {
+  if (buf == NULL || result == NULL || size < kAcPackedStateSize) return false;
+  const uint8_t length = buf[13];
+  if (buf[0] != kAcPackedStateVersion || length > kStateSizeMax ||
+      size < kAcPackedStateSize + length)
+    return false;
+  if (buf[1] > kLastDecodeType && buf[1] != 0xFF) return false;
+  const int mode = ((buf[5] >> 1) & 0x7) - 1;
+  const int fanspeed = (buf[5] >> 4) & 0x7;
+  const int swingv = (buf[6] & 0xF) - 1;
+  const int swingh = (buf[6] >> 4) - 1;
+  if (mode > (int)stdAc::opmode_t::kFan ||
+      fanspeed > (int)stdAc::fanspeed_t::kMax ||
+      swingv > (int)stdAc::swingv_t::kLowest ||
+      swingh > (int)stdAc::swingh_t::kRightMax)
+    return false;
+  result->protocol = (buf[1] == 0xFF) ? decode_type_t::UNKNOWN
+                                      : (decode_type_t)buf[1];
+  result->model = unpackInt16(buf + 2);
+  result->power = buf[4] & 1;
+  result->celsius = buf[4] >> 1 & 1;
+  result->quiet = buf[4] >> 2 & 1;
+  result->turbo = buf[4] >> 3 & 1;
+  result->econo = buf[4] >> 4 & 1;
+  result->light = buf[4] >> 5 & 1;
+  result->filter = buf[4] >> 6 & 1;
+  result->clean = buf[4] >> 7 & 1;
+  result->beep = buf[5] & 1;
+  result->mode = (stdAc::opmode_t)mode;
+  result->fanspeed = (stdAc::fanspeed_t)fanspeed;
+  result->swingv = (stdAc::swingv_t)swingv;
+  result->swingh = (stdAc::swingh_t)swingh;
+  result->degrees = unpackInt16(buf + 7) / 10.0;
+  result->sleep = unpackInt16(buf + 9);
+  result->clock = unpackInt16(buf + 11);
+  if (raw != NULL) memcpy(raw, buf + kAcPackedStateSize, length);
+  if (rawlen != NULL) *rawlen = length;
+  return true;
+}
+
+// A JSON object being written into a fixed size buffer. Like snprintf(), the
+// full length is counted, even once the buffer is full.
+typedef struct {
+  char *buf;    // NULL if we are only counting.
+  size_t size;  // The size of buf, incl. the terminating NUL.
+  size_t len;   // Nr. of chars written so far. Incl. any that didn't fit.
+} json_writer_t;
+
+static void jsonCopy(json_writer_t *json, const char *text,
+                     const size_t length) {
+  if (json->buf != NULL && json->len + 1 < json->size) {
+    size_t count = std::min(length, json->size - 1 - json->len);
+    memcpy(json->buf + json->len, text, count);
+    json->buf[json->len + count] = '\0';
+  }
+  json->len += length;
+}
+
+// Write a flash (PROGMEM) string.
+static void jsonFlash(json_writer_t *json, const char *ptext) {
+  char chunk[16];  // Flash has to be copied to RAM first.
+  const size_t length = strlen_P(ptext);
+  for (size_t done = 0; done < length; done += sizeof(chunk)) {
+    size_t count = std::min(length - done, sizeof(chunk));
+    memcpy_P(chunk, ptext + done, count);
+    jsonCopy(json, chunk, count);
+  }
+}
+
+// Start the next member of the object. i.e. `"key":`
+static void jsonKey(json_writer_t *json, const char *key) {
+  jsonCopy(json, json->len ? "," : "{", 1);
+  jsonCopy(json, "\"", 1);
+  jsonFlash(json, key);
+  jsonCopy(json, "\":", 2);
+}
+
+// Write a member with a (flash) string value. None need any escaping.
+static void jsonName(json_writer_t *json, const char *key, const char *name) {
+  jsonKey(json, key);
+  jsonCopy(json, "\"", 1);
+  jsonFlash(json, name);
+  jsonCopy(json, "\"", 1);
+}
+
+// Write a member with an integer value, with `decimals` of it after the point.
+// e.g. 215 with 1 decimal is written as 21.5 (but 210 as just 21).
+static void jsonInt(json_writer_t *json, const char *key, const int32_t value,
+                    const uint8_t decimals = 0) {
+  jsonKey(json, key);
+  if (value < 0) jsonCopy(json, "-", 1);
+  const uint32_t magnitude = (value < 0) ? -(int64_t)value : value;
+  uint32_t scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+  char digits[kUint64StringSize];
+  jsonCopy(json, digits,
+           uint64ToString(magnitude / scale, digits, sizeof(digits)));
+  if (magnitude % scale) {
+    jsonCopy(json, ".", 1);
+    for (scale /= 10; scale; scale /= 10) {
+      const char digit = '0' + (magnitude / scale) % 10;
+      jsonCopy(json, &digit, 1);
+    }
+  }
+}
+
+// Write a common A/C state as a JSON object. It uses the KEY_* names (& the
+// same values) that IRMQTTServer's climate topics do. e.g.
+//   {"protocol":"DAIKIN","model":-1,"power":"on","mode":"cool",...
+//
+// Args:
+//   state: The state to write.
+//   buf: Where to write it. NULL to only find out how long it is.
+//   size: The size of `buf`, incl. the terminating NUL.
+//   raw: The vendor's own raw state to include (in hex, as "raw"), if any.
+//   rawlen: The length of `raw`.
+// Returns:
+//   The length of the full JSON text, excl. the NUL. Like snprintf(), if it is
+//   >= `size`, it was cut short. kAcStateJsonSize is always enough, if there
+//   is no raw state. A raw state needs another 9 + 2 * rawlen chars.
+size_t IRac::stateToJson(const stdAc::state_t state, char *buf,
+                         const size_t size, const uint8_t *raw,
+                         const uint16_t rawlen) {
+  json_writer_t json;
+  json.buf = buf;
+  json.size = size;
+  json.len = 0;
+  if (buf != NULL && size) buf[0] = '\0';
+  jsonName(&json, PSTR(KEY_PROTOCOL), typeToName(state.protocol));
+  jsonInt(&json, PSTR(KEY_MODEL), state.model);
+  jsonName(&json, PSTR(KEY_POWER), state.power ? kOnStr : kOffStr);
+  jsonName(&json, PSTR(KEY_MODE), settingName(kOpmodeNames, (int)state.mode));
+  jsonName(&json, PSTR(KEY_CELSIUS), state.celsius ? kOnStr : kOffStr);
+  jsonInt(&json, PSTR(KEY_TEMP), tenthsOfDegrees(state.degrees), 1);
+  jsonName(&json, PSTR(KEY_FANSPEED),
+           settingName(kFanspeedNames, (int)state.fanspeed));
+  jsonName(&json, PSTR(KEY_SWINGV),
+           settingName(kSwingvNames, (int)state.swingv));
+  jsonName(&json, PSTR(KEY_SWINGH),
+           settingName(kSwinghNames, (int)state.swingh));
+  jsonName(&json, PSTR(KEY_QUIET), state.quiet ? kOnStr : kOffStr);
+  jsonName(&json, PSTR(KEY_TURBO), state.turbo ? kOnStr : kOffStr);
+  jsonName(&json, PSTR(KEY_ECONO), state.econo ? kOnStr : kOffStr);
+  jsonName(&json, PSTR(KEY_LIGHT), state.light ? kOnStr : kOffStr);
+  jsonName(&json, PSTR(KEY_FILTER), state.filter ? kOnStr : kOffStr);
+  jsonName(&json, PSTR(KEY_CLEAN), state.clean ? kOnStr : kOffStr);
+  jsonName(&json, PSTR(KEY_BEEP), state.beep ? kOnStr : kOffStr);
+  jsonInt(&json, PSTR(KEY_SLEEP), state.sleep);
+  if (raw != NULL && rawlen) {
+    jsonKey(&json, PSTR(KEY_RAW));
+    jsonCopy(&json, "\"", 1);
+    for (uint16_t i = 0; i < rawlen; i++) {
+      const char hex[2] = {"0123456789ABCDEF"[raw[i] >> 4],
+                           "0123456789ABCDEF"[raw[i] & 0xF]};
+      jsonCopy(&json, hex, 2);
+    }
+    jsonCopy(&json, "\"", 1);
+  }
+  jsonCopy(&json, "}", 1);
+  return json.len;
+}
+
+IRAcDecoder::IRAcDecoder(void) : _protocol(decode_type_t::UNKNOWN),
+                                 _destroy(NULL) {}
+
+IRAcDecoder::~IRAcDecoder(void) { release(); }
+
+// Destroy the kept vendor A/C object, if there is one.
+void IRAcDecoder::release(void) {
+  if (_protocol != decode_type_t::UNKNOWN) _destroy(_storage.raw);
+  _protocol = decode_type_t::UNKNOWN;
+}
+
+template <class AC>
+static void destroyInPlace(void *ac) { static_cast<AC *>(ac)->~AC(); }
+
+// Put a kept vendor A/C object back how it was when it was created.
+template <class AC>
+static void resetAc(AC *ac) { ac->stateReset(); }
+
+template <>
+void resetAc<IRFujitsuAC>(IRFujitsuAC *ac) {
+  ac->setModel(ARRAH2E);  // The constructor's default.
+  ac->stateReset();
+}
+
+// Get a freshly reset vendor A/C object for a protocol. The kept one is used
+// if it is for the same protocol, otherwise it is replaced.
+// Args:
+//   protocol: The type of A/C protocol the object is for.
+// Returns:
+//   A ptr to the object.
+template <class AC>
+AC *IRAcDecoder::acFor(const decode_type_t protocol) {
+  static_assert(sizeof(AC) <= sizeof(_storage.raw),
+                "kAcDecoderSize is too small for an A/C class.");
+  AC *ac = reinterpret_cast<AC *>(_storage.raw);
+  if (_protocol == protocol) {
+    resetAc(ac);  // Forget the previous message.
+  } else {
+    release();
+    ac = new (_storage.raw) AC(kGpioUnused);
+    _protocol = protocol;
+    _destroy = destroyInPlace<AC>;
+  }
+  return ac;
+}
+
+// Convert a valid IR A/C remote message that we understand enough into a
+// Common A/C state.
+//
+// Args:
+//   decode: A PTR to a successful raw IR decode object.
+//   result: A PTR to a state structure to store the result in.
+// Returns:
+//   A boolean indicating success or failure.
+bool IRAcDecoder::decodeToState(const decode_results *decode,
+                                stdAc::state_t *result) {
+  if (decode == NULL || result == NULL) return false;  // Safety check.
+  switch (decode->decode_type) {
+#if DECODE_ARGO
+    case decode_type_t::ARGO: {
+      IRArgoAC *ac = acFor<IRArgoAC>(decode_type_t::ARGO);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_ARGO
+#if DECODE_COOLIX
+    case decode_type_t::COOLIX: {
+      IRCoolixAC *ac = acFor<IRCoolixAC>(decode_type_t::COOLIX);
+      ac->setRaw(decode->value);  // Uses value instead of state.
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_COOLIX
+#if DECODE_DAIKIN
+    case decode_type_t::DAIKIN: {
+      IRDaikinESP *ac = acFor<IRDaikinESP>(decode_type_t::DAIKIN);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_DAIKIN
+#if DECODE_DAIKIN160
+    case decode_type_t::DAIKIN160: {
+      IRDaikin160 *ac = acFor<IRDaikin160>(decode_type_t::DAIKIN160);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_DAIKIN160
+#if DECODE_DAIKIN2
+    case decode_type_t::DAIKIN2: {
+      IRDaikin2 *ac = acFor<IRDaikin2>(decode_type_t::DAIKIN2);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_DAIKIN2
+#if DECODE_DAIKIN216
+    case decode_type_t::DAIKIN216: {
+      IRDaikin216 *ac = acFor<IRDaikin216>(decode_type_t::DAIKIN216);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_DAIKIN216
+#if DECODE_ELECTRA_AC
+    case decode_type_t::ELECTRA_AC: {
+      IRElectraAc *ac = acFor<IRElectraAc>(decode_type_t::ELECTRA_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_ELECTRA_AC
+#if DECODE_FUJITSU_AC
+    case decode_type_t::FUJITSU_AC: {
+      IRFujitsuAC *ac = acFor<IRFujitsuAC>(decode_type_t::FUJITSU_AC);
+      ac->setRaw(decode->state, decode->bits / 8);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_FUJITSU_AC
+#if DECODE_GOODWEATHER
+    case decode_type_t::GOODWEATHER: {
+      IRGoodweatherAc *ac = acFor<IRGoodweatherAc>(decode_type_t::GOODWEATHER);
+      ac->setRaw(decode->value);  // Uses value instead of state.
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_GOODWEATHER
+#if DECODE_GREE
+    case decode_type_t::GREE: {
+      IRGreeAC *ac = acFor<IRGreeAC>(decode_type_t::GREE);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_GREE
+#if DECODE_HAIER_AC
+    case decode_type_t::HAIER_AC: {
+      IRHaierAC *ac = acFor<IRHaierAC>(decode_type_t::HAIER_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_HAIER_AC
+#if DECODE_HAIER_AC_YRW02
+    case decode_type_t::HAIER_AC_YRW02: {
+      IRHaierACYRW02 *ac = acFor<IRHaierACYRW02>(decode_type_t::HAIER_AC_YRW02);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_HAIER_AC_YRW02
+#if (DECODE_HITACHI_AC || DECODE_HITACHI_AC2)
+    case decode_type_t::HITACHI_AC: {
+      IRHitachiAc *ac = acFor<IRHitachiAc>(decode_type_t::HITACHI_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // (DECODE_HITACHI_AC || DECODE_HITACHI_AC2)
+#if DECODE_KELVINATOR
+    case decode_type_t::KELVINATOR: {
+      IRKelvinatorAC *ac = acFor<IRKelvinatorAC>(decode_type_t::KELVINATOR);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_KELVINATOR
+#if DECODE_MIDEA
+    case decode_type_t::MIDEA: {
+      IRMideaAC *ac = acFor<IRMideaAC>(decode_type_t::MIDEA);
+      ac->setRaw(decode->value);  // Uses value instead of state.
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_MIDEA
+#if DECODE_MITSUBISHI_AC
+    case decode_type_t::MITSUBISHI_AC: {
+      IRMitsubishiAC *ac = acFor<IRMitsubishiAC>(decode_type_t::MITSUBISHI_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_MITSUBISHI_AC
+#if DECODE_MITSUBISHIHEAVY
+    case decode_type_t::MITSUBISHI_HEAVY_88: {
+      IRMitsubishiHeavy88Ac *ac =
+          acFor<IRMitsubishiHeavy88Ac>(decode_type_t::MITSUBISHI_HEAVY_88);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+    case decode_type_t::MITSUBISHI_HEAVY_152: {
+      IRMitsubishiHeavy152Ac *ac =
+          acFor<IRMitsubishiHeavy152Ac>(decode_type_t::MITSUBISHI_HEAVY_152);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_MITSUBISHIHEAVY
+#if DECODE_NEOCLIMA
+    case decode_type_t::NEOCLIMA: {
+      IRNeoclimaAc *ac = acFor<IRNeoclimaAc>(decode_type_t::NEOCLIMA);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_NEOCLIMA
+#if DECODE_PANASONIC_AC
+    case decode_type_t::PANASONIC_AC: {
+      IRPanasonicAc *ac = acFor<IRPanasonicAc>(decode_type_t::PANASONIC_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_PANASONIC_AC
+#if DECODE_SAMSUNG_AC
+    case decode_type_t::SAMSUNG_AC: {
+      IRSamsungAc *ac = acFor<IRSamsungAc>(decode_type_t::SAMSUNG_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_SAMSUNG_AC
+#if DECODE_SHARP_AC
+    case decode_type_t::SHARP_AC: {
+      IRSharpAc *ac = acFor<IRSharpAc>(decode_type_t::SHARP_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_SHARP_AC
+#if DECODE_TCL112AC
+    case decode_type_t::TCL112AC: {
+      IRTcl112Ac *ac = acFor<IRTcl112Ac>(decode_type_t::TCL112AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_TCL112AC
+#if DECODE_TECO
+    case decode_type_t::TECO: {
+      IRTecoAc *ac = acFor<IRTecoAc>(decode_type_t::TECO);
+      ac->setRaw(decode->value);  // Uses value instead of state.
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_TECO
+#if DECODE_TOSHIBA_AC
+    case decode_type_t::TOSHIBA_AC: {
+      IRToshibaAC *ac = acFor<IRToshibaAC>(decode_type_t::TOSHIBA_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_TOSHIBA_AC
+#if DECODE_TROTEC
+    case decode_type_t::TROTEC: {
+      IRTrotecESP *ac = acFor<IRTrotecESP>(decode_type_t::TROTEC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_TROTEC
+#if DECODE_VESTEL_AC
+    case decode_type_t::VESTEL_AC: {
+      IRVestelAc *ac = acFor<IRVestelAc>(decode_type_t::VESTEL_AC);
+      ac->setRaw(decode->value);  // Uses value instead of state.
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_VESTEL_AC
+#if DECODE_WHIRLPOOL_AC
+    case decode_type_t::WHIRLPOOL_AC: {
+      IRWhirlpoolAc *ac = acFor<IRWhirlpoolAc>(decode_type_t::WHIRLPOOL_AC);
+      ac->setRaw(decode->state);
+      *result = ac->toCommon();
+      break;
+    }
+#endif  // DECODE_WHIRLPOOL_AC
     default:
-      return F("unknown");
+      return false;
   }
+  return true;
 }
 
 namespace IRAcUtils {
@@ -1675,6 +2356,7 @@ namespace IRAcUtils {
 
   // Convert a valid IR A/C remote message that we understand enough into a
   // Common A/C state.
+  // Note: Use an IRAcDecoder instead if you are converting a lot of messages.
   //
   // Args:
   //   decode: A PTR to a successful raw IR decode object.
@@ -1682,233 +2364,7 @@ namespace IRAcUtils {
   // Returns:
   //   A boolean indicating success or failure.
   bool decodeToState(const decode_results *decode, stdAc::state_t *result) {
-    if (decode == NULL || result == NULL) return false;  // Safety check.
-    switch (decode->decode_type) {
-#if DECODE_ARGO
-      case decode_type_t::ARGO: {
-        IRArgoAC ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_ARGO
-#if DECODE_COOLIX
-      case decode_type_t::COOLIX: {
-        IRCoolixAC ac(kGpioUnused);
-        ac.setRaw(decode->value);  // Uses value instead of state.
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_COOLIX
-#if DECODE_DAIKIN
-      case decode_type_t::DAIKIN: {
-        IRDaikinESP ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_DAIKIN
-#if DECODE_DAIKIN160
-      case decode_type_t::DAIKIN160: {
-        IRDaikin160 ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_DAIKIN160
-#if DECODE_DAIKIN2
-      case decode_type_t::DAIKIN2: {
-        IRDaikin2 ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_DAIKIN2
-#if DECODE_DAIKIN216
-      case decode_type_t::DAIKIN216: {
-        IRDaikin216 ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_DAIKIN216
-#if DECODE_ELECTRA_AC
-      case decode_type_t::ELECTRA_AC: {
-        IRElectraAc ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_ELECTRA_AC
-#if DECODE_FUJITSU_AC
-      case decode_type_t::FUJITSU_AC: {
-        IRFujitsuAC ac(kGpioUnused);
-        ac.setRaw(decode->state, decode->bits / 8);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_FUJITSU_AC
-#if DECODE_GOODWEATHER
-      case decode_type_t::GOODWEATHER: {
-        IRGoodweatherAc ac(kGpioUnused);
-        ac.setRaw(decode->value);  // Uses value instead of state.
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_GOODWEATHER
-#if DECODE_GREE
-      case decode_type_t::GREE: {
-        IRGreeAC ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_GREE
-#if DECODE_HAIER_AC
-      case decode_type_t::HAIER_AC: {
-        IRHaierAC ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_HAIER_AC
-#if DECODE_HAIER_AC_YRW02
-      case decode_type_t::HAIER_AC_YRW02: {
-        IRHaierACYRW02 ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_HAIER_AC_YRW02
-#if (DECODE_HITACHI_AC || DECODE_HITACHI_AC2)
-      case decode_type_t::HITACHI_AC: {
-        IRHitachiAc ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // (DECODE_HITACHI_AC || DECODE_HITACHI_AC2)
-#if DECODE_KELVINATOR
-      case decode_type_t::KELVINATOR: {
-        IRKelvinatorAC ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_KELVINATOR
-#if DECODE_MIDEA
-      case decode_type_t::MIDEA: {
-        IRMideaAC ac(kGpioUnused);
-        ac.setRaw(decode->value);  // Uses value instead of state.
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_MIDEA
-#if DECODE_MITSUBISHI_AC
-      case decode_type_t::MITSUBISHI_AC: {
-        IRMitsubishiAC ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_MITSUBISHI_AC
-#if DECODE_MITSUBISHIHEAVY
-      case decode_type_t::MITSUBISHI_HEAVY_88: {
-        IRMitsubishiHeavy88Ac ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-      case decode_type_t::MITSUBISHI_HEAVY_152: {
-        IRMitsubishiHeavy152Ac ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_MITSUBISHIHEAVY
-#if DECODE_NEOCLIMA
-      case decode_type_t::NEOCLIMA: {
-        IRNeoclimaAc ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_NEOCLIMA
-#if DECODE_PANASONIC_AC
-      case decode_type_t::PANASONIC_AC: {
-        IRPanasonicAc ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_PANASONIC_AC
-#if DECODE_SAMSUNG_AC
-      case decode_type_t::SAMSUNG_AC: {
-        IRSamsungAc ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_SAMSUNG_AC
-#if DECODE_SHARP_AC
-      case decode_type_t::SHARP_AC: {
-        IRSharpAc ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_SHARP_AC
-#if DECODE_TCL112AC
-      case decode_type_t::TCL112AC: {
-        IRTcl112Ac ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_TCL112AC
-#if DECODE_TECO
-      case decode_type_t::TECO: {
-        IRTecoAc ac(kGpioUnused);
-        ac.setRaw(decode->value);  // Uses value instead of state.
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_TECO
-#if DECODE_TOSHIBA_AC
-      case decode_type_t::TOSHIBA_AC: {
-        IRToshibaAC ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_TOSHIBA_AC
-#if DECODE_TROTEC
-      case decode_type_t::TROTEC: {
-        IRTrotecESP ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_TROTEC
-#if DECODE_VESTEL_AC
-      case decode_type_t::VESTEL_AC: {
-        IRVestelAc ac(kGpioUnused);
-        ac.setRaw(decode->value);  // Uses value instead of state.
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_VESTEL_AC
-#if DECODE_WHIRLPOOL_AC
-      case decode_type_t::WHIRLPOOL_AC: {
-        IRWhirlpoolAc ac(kGpioUnused);
-        ac.setRaw(decode->state);
-        *result = ac.toCommon();
-        break;
-      }
-#endif  // DECODE_WHIRLPOOL_AC
-      default:
-        return false;
-    }
-    return true;
+    IRAcDecoder decoder;
+    return decoder.decodeToState(decode, result);
   }
 }  // namespace IRAcUtils
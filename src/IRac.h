@@ -6,6 +6,7 @@
 #ifndef UNIT_TEST
 #include <Arduino.h>
 #endif
+#include <stddef.h>
 #include "IRremoteESP8266.h"
 #include "ir_Argo.h"
 #include "ir_Coolix.h"
@@ -33,11 +34,87 @@
 
 // Constants
 const int8_t kGpioUnused = -1;
+const uint8_t kAcPoolSize = 4;  // Max. nr. of A/C objects an IRac will keep.
+const uint16_t kAcDefaultTarget = 0;  // The A/C unit if none is given.
+// Packed A/C states. See IRac::packState().
+const uint8_t kAcPackedStateVersion = 1;
+const uint8_t kAcPackedStateSize = 14;  // Excl. any raw (vendor) state.
+// Max. length of a common A/C state as JSON, incl. the NUL. (No raw state.)
+const uint16_t kAcStateJsonSize = 320;
+// The JSON keys IRac::stateToJson() uses. IRMQTTServer uses the same ones for
+// its climate topics. Macros, so they can be joined to other string literals.
+#define KEY_PROTOCOL "protocol"
+#define KEY_MODEL "model"
+#define KEY_POWER "power"
+#define KEY_MODE "mode"
+#define KEY_TEMP "temp"
+#define KEY_FANSPEED "fanspeed"
+#define KEY_SWINGV "swingv"
+#define KEY_SWINGH "swingh"
+#define KEY_QUIET "quiet"
+#define KEY_TURBO "turbo"
+#define KEY_LIGHT "light"
+#define KEY_BEEP "beep"
+#define KEY_ECONO "econo"
+#define KEY_SLEEP "sleep"
+#define KEY_FILTER "filter"
+#define KEY_CLEAN "clean"
+#define KEY_CELSIUS "use_celsius"
+#define KEY_RAW "raw"
+
+// The size of the largest of the given types.
+template <typename T>
+constexpr size_t maxSizeOf(void) { return sizeof(T); }
+template <typename T, typename U, typename... Rest>
+constexpr size_t maxSizeOf(void) {
+  return sizeof(T) > maxSizeOf<U, Rest...>() ? sizeof(T)
+                                             : maxSizeOf<U, Rest...>();
+}
+
+// Room for any of the vendor A/C objects that IRAcDecoder can use.
+const size_t kAcDecoderSize = maxSizeOf<
+    IRArgoAC, IRCoolixAC, IRDaikinESP, IRDaikin160, IRDaikin2, IRDaikin216,
+    IRElectraAc, IRFujitsuAC, IRGoodweatherAc, IRGreeAC, IRHaierAC,
+    IRHaierACYRW02, IRHitachiAc, IRKelvinatorAC, IRMideaAC, IRMitsubishiAC,
+    IRMitsubishiHeavy88Ac, IRMitsubishiHeavy152Ac, IRNeoclimaAc, IRPanasonicAc,
+    IRSamsungAc, IRSharpAc, IRTcl112Ac, IRTecoAc, IRToshibaAC, IRTrotecESP,
+    IRVestelAc, IRWhirlpoolAc>();
+
+// A vendor A/C object (e.g. An IRDaikinESP) kept by IRac for reuse.
+typedef struct {
+  decode_type_t protocol;   // UNKNOWN if the entry is free.
+  int16_t model;
+  uint16_t target;          // Caller's id for the unit. See IRac::sendAc().
+  void *ac;                 // The object itself.
+  void (*destroy)(void *);  // How to delete it.
+  stdAc::state_t last;      // The last state sent with it.
+  bool has_last;            // Is `last` valid?
+  uint32_t used;            // When it was last used. (for eviction)
+} ac_pool_entry_t;
+
+// A requested change of state for one of several A/C units. See sendBatch().
+typedef struct {
+  uint16_t target;       // Caller's id for the unit. e.g. A zone number.
+  stdAc::state_t state;  // The desired state of the unit.
+} ac_update_t;
+
+// What sendBatch() did with each update.
+typedef enum {
+  kAcBatchPending = 0,  // Not processed yet. (Only seen internally.)
+  kAcBatchSent,         // Sent successfully.
+  kAcBatchFailed,       // Sending failed. e.g. Unsupported protocol.
+  kAcBatchSuperseded,   // Dropped. A later update changes the same target.
+  kAcBatchDuplicate,    // Dropped. A later update repeats it for the target.
+} ac_batch_status_t;
 
 // Class
 class IRac {
  public:
   explicit IRac(uint8_t pin);
+  ~IRac(void);
+  void enablePool(const bool enable = true);
+  bool isPoolEnabled(void);
+  void clearPool(void);
   static bool isProtocolSupported(const decode_type_t protocol);
   bool sendAc(const decode_type_t vendor, const int16_t model,
               const bool power, const stdAc::opmode_t mode, const float degrees,
@@ -46,8 +123,12 @@ class IRac {
               const bool quiet, const bool turbo, const bool econo,
               const bool light, const bool filter, const bool clean,
               const bool beep, const int16_t sleep = -1,
-              const int16_t clock = -1);
-  bool sendAc(const stdAc::state_t desired, const stdAc::state_t *prev = NULL);
+              const int16_t clock = -1,
+              const uint16_t target = kAcDefaultTarget);
+  bool sendAc(const stdAc::state_t desired, const stdAc::state_t *prev = NULL,
+              const uint16_t target = kAcDefaultTarget);
+  uint16_t sendBatch(const ac_update_t updates[], const uint16_t count,
+                     ac_batch_status_t results[]);
   static bool cmpStates(const stdAc::state_t a, const stdAc::state_t b);
   static bool strToBool(const char *str, const bool def = false);
   static int16_t strToModel(const char *str, const int16_t def = -1);
@@ -65,11 +146,35 @@ class IRac {
   static String fanspeedToString(const stdAc::fanspeed_t speed);
   static String swingvToString(const stdAc::swingv_t swingv);
   static String swinghToString(const stdAc::swingh_t swingh);
+  static uint16_t packState(const stdAc::state_t state, uint8_t *buf,
+                            const uint16_t size, const uint8_t *raw = NULL,
+                            const uint16_t rawlen = 0);
+  static bool unpackState(const uint8_t *buf, const uint16_t size,
+                          stdAc::state_t *result, uint8_t *raw = NULL,
+                          uint16_t *rawlen = NULL);
+  static size_t stateToJson(const stdAc::state_t state, char *buf,
+                            const size_t size, const uint8_t *raw = NULL,
+                            const uint16_t rawlen = 0);
 #ifndef UNIT_TEST
 
  private:
 #endif
   uint8_t _pin;
+  bool _pool_enabled;
+  ac_pool_entry_t _pool[kAcPoolSize];
+  uint32_t _pool_clock;
+  IRac(const IRac &);  // Not copyable. The pool owns its objects.
+  IRac &operator=(const IRac &);
+  void freePooled(ac_pool_entry_t *entry);
+  ac_pool_entry_t *findPooled(const decode_type_t protocol,
+                              const int16_t model,
+                              const uint16_t target = kAcDefaultTarget);
+  template <class AC>
+  AC *pooledAc(const decode_type_t protocol, const int16_t model,
+               const uint16_t target, const bool begin);
+  template <class AC, typename F>
+  void withAc(const decode_type_t protocol, const int16_t model,
+              const uint16_t target, const bool begin, F apply);
 #if SEND_ARGO
   void argo(IRArgoAC *ac,
             const bool on, const stdAc::opmode_t mode, const float degrees,
@@ -271,6 +376,38 @@ static stdAc::state_t handleToggles(const stdAc::state_t desired,
                                     const stdAc::state_t *prev = NULL);
 };  // IRac class
 
+// Converts received A/C messages into common A/C states.
+// It keeps the vendor A/C object it last needed (in place, not on the heap),
+// so a run of messages from the same type of A/C only resets it, rather than
+// building a new one (and the IRsend inside it) for every message.
+// Note:
+//   It doesn't decode from the state alone. The conversion is each vendor
+//   class's toCommon(), & every vendor class owns an IRsend. So the kept object
+//   still contains one (on kGpioUnused), & it takes as much room as the
+//   largest vendor class. The IRsend is never begin()'ed or sent with.
+class IRAcDecoder {
+ public:
+  IRAcDecoder(void);
+  ~IRAcDecoder(void);
+  bool decodeToState(const decode_results *decode, stdAc::state_t *result);
+#ifndef UNIT_TEST
+
+ private:
+#endif
+  decode_type_t _protocol;    // Who the kept object is for. UNKNOWN if none.
+  void (*_destroy)(void *);   // How to destroy it.
+  union {
+    uint64_t align;           // Aligned suitably for any of the objects.
+    void *ptr;
+    uint8_t raw[kAcDecoderSize];
+  } _storage;                 // The kept object.
+  IRAcDecoder(const IRAcDecoder &);  // Not copyable. It owns its object.
+  IRAcDecoder &operator=(const IRAcDecoder &);
+  void release(void);
+  template <class AC>
+  AC *acFor(const decode_type_t protocol);
+};
+
 namespace IRAcUtils {
   String resultAcToString(const decode_results * const results);
   bool decodeToState(const decode_results *decode, stdAc::state_t *result);
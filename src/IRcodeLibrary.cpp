@@ -0,0 +1,508 @@
+// Copyright 2019 David Conran
+//
+// A compact, binary library of stored IR codes. See IRcodeLibrary.h for the
+// format.
+
+#include "IRcodeLibrary.h"
+#ifndef UNIT_TEST
+#include <Arduino.h>
+#endif
+#include <string.h>
+#include <algorithm>
+#include "IRremoteESP8266.h"
+#include "IRsend.h"
+
+// Offsets of the fields in the header & in an index entry.
+const uint8_t kCodeLibMagic[4] = {'I', 'R', 'C', 'L'};
+const uint8_t kCodeLibVersionOffset = 4;
+const uint8_t kCodeLibCountOffset = 6;
+const uint8_t kCodeLibDataSizeOffset = 8;
+const uint8_t kCodeLibIdOffset = 0;
+const uint8_t kCodeLibNameOffset = 2;
+const uint8_t kCodeLibFreqOffset = kCodeLibNameOffset + kCodeLibNameSize;
+const uint8_t kCodeLibIntroOffset = kCodeLibFreqOffset + 4;
+const uint8_t kCodeLibLengthOffset = kCodeLibIntroOffset + 2;
+const uint8_t kCodeLibRepeatsOffset = kCodeLibLengthOffset + 2;
+const uint8_t kCodeLibDataOffset = kCodeLibRepeatsOffset + 2;
+const uint8_t kCodeLibDataLenOffset = kCodeLibDataOffset + 4;
+static_assert(kCodeLibDataLenOffset + 4 == kCodeLibEntrySize,
+              "kCodeLibEntrySize doesn't match the index entry layout.");
+
+static uint16_t get16(const uint8_t *ptr) {
+  return ptr[0] | (ptr[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *ptr) {
+  return get16(ptr) | ((uint32_t)get16(ptr + 2) << 16);
+}
+
+static void put16(uint8_t *ptr, const uint16_t value) {
+  ptr[0] = value;
+  ptr[1] = value >> 8;
+}
+
+static void put32(uint8_t *ptr, const uint32_t value) {
+  put16(ptr, value);
+  put16(ptr + 2, value >> 16);
+}
+
+// Calculate the period for a given frequency. (T = 1/f)
+// The same as IRsend::calcUSecPeriod(hz, false), which sendGC() & sendPronto()
+// use to convert their carrier cycle counts to uSeconds.
+static uint32_t cyclePeriod(uint32_t hz) {
+  if (hz == 0) hz = 1;  // Avoid Zero hz. Divide by Zero is nasty.
+  return std::max((uint32_t)1, (uint32_t)((1000000UL + hz / 2) / hz));
+}
+
+// Decode an index entry.
+static void parseEntry(const uint8_t *raw, ir_code_entry_t *entry) {
+  entry->id = get16(raw + kCodeLibIdOffset);
+  memcpy(entry->name, raw + kCodeLibNameOffset, kCodeLibNameSize);
+  entry->name[kCodeLibNameSize - 1] = '\0';
+  entry->frequency = get32(raw + kCodeLibFreqOffset);
+  entry->intro = get16(raw + kCodeLibIntroOffset);
+  entry->length = get16(raw + kCodeLibLengthOffset);
+  entry->repeats = get16(raw + kCodeLibRepeatsOffset);
+  entry->offset = get32(raw + kCodeLibDataOffset);
+  entry->size = get32(raw + kCodeLibDataLenOffset);
+}
+
+// Reads a code's durations back, a chunk at a time, straight from the source.
+// It can be copied to remember (& later return to) where it is up to.
+class IRcodeDecoder {
+ public:
+  IRcodeDecoder(IRcodeSource *source, const uint32_t start,
+                const uint32_t size)
+      : _source(source), _pos(start), _end(start + size), _buf_pos(0),
+        _buf_len(0), _index(0) {
+    _prev[0] = 0;
+    _prev[1] = 0;
+  }
+
+  // Get the next duration.
+  // Returns: true if there was one, false if we ran out or the data is bad.
+  bool next(uint32_t *usecs) {
+    uint64_t zigzag = 0;
+    uint8_t byte;
+    for (uint8_t shift = 0; ; shift += 7) {
+      if (shift > 63 || !nextByte(&byte)) return false;
+      zigzag |= (uint64_t)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) break;
+    }
+    int64_t value = _prev[_index & 1] +
+        (int64_t)((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+    if (value < 0 || value > UINT32_MAX) return false;
+    _prev[_index & 1] = value;
+    _index++;
+    *usecs = value;
+    return true;
+  }
+
+ private:
+  IRcodeSource *_source;
+  uint32_t _pos;  // Where the next chunk comes from.
+  uint32_t _end;
+  uint8_t _buf[kCodeLibChunkSize];
+  uint8_t _buf_pos;
+  uint8_t _buf_len;
+  uint32_t _prev[2];  // The previous mark & space.
+  uint16_t _index;
+
+  bool nextByte(uint8_t *byte) {
+    if (_buf_pos >= _buf_len) {  // Read the next chunk.
+      if (_pos >= _end) return false;
+      _buf_len = std::min(_end - _pos, (uint32_t)kCodeLibChunkSize);
+      if (!_source->read(_pos, _buf, _buf_len)) return false;
+      _pos += _buf_len;
+      _buf_pos = 0;
+    }
+    *byte = _buf[_buf_pos++];
+    return true;
+  }
+};
+
+// Send one duration of a code.
+static void sendDuration(IRsend *irsend, const uint16_t index,
+                         uint32_t usecs) {
+  if (index & 1) {
+    irsend->space(usecs);
+  } else {
+    for (; usecs > UINT16_MAX; usecs -= UINT16_MAX) irsend->mark(UINT16_MAX);
+    irsend->mark(usecs);
+  }
+}
+
+// IRcodeMemory ----------------------------------------------------------------
+
+// A library held in memory.
+// Args:
+//   data: Ptr to the start of the library. May be in flash (PROGMEM).
+//   size: Nr. of bytes of it that can be read.
+IRcodeMemory::IRcodeMemory(const uint8_t *data, const uint32_t size)
+    : _data(data), _size(size) {}
+
+bool IRcodeMemory::read(const uint32_t offset, uint8_t *buf,
+                        const uint16_t len) {
+  if (_data == NULL || offset > _size || len > _size - offset) return false;
+#ifdef ARDUINO
+  memcpy_P(buf, _data + offset, len);
+#else  // ARDUINO
+  memcpy(buf, _data + offset, len);
+#endif  // ARDUINO
+  return true;
+}
+
+// IRcodeLibrary ---------------------------------------------------------------
+
+// Args:
+//   source: Where the library is stored.
+IRcodeLibrary::IRcodeLibrary(IRcodeSource *source)
+    : _source(source), _valid(false), _count(0), _names(0), _data(0),
+      _data_size(0) {}
+
+// Check the library is one we understand. Must be called before using it.
+// Returns: true if it is okay, false if not.
+bool IRcodeLibrary::begin(void) {
+  uint8_t header[kCodeLibHeaderSize];
+  _valid = false;
+  if (_source == NULL || !_source->read(0, header, kCodeLibHeaderSize) ||
+      memcmp(header, kCodeLibMagic, sizeof(kCodeLibMagic)) ||
+      header[kCodeLibVersionOffset] != kCodeLibVersion)
+    return false;
+  _count = get16(header + kCodeLibCountOffset);
+  _data_size = get32(header + kCodeLibDataSizeOffset);
+  _names = kCodeLibHeaderSize + (uint32_t)_count * kCodeLibEntrySize;
+  _data = _names + _count * 2;
+  // Make sure it is all there, by reading the last byte.
+  uint8_t last;
+  if (_data_size && !_source->read(_data + _data_size - 1, &last, 1))
+    return false;
+  _valid = true;
+  return true;
+}
+
+// Returns: The nr. of codes in the library.
+uint16_t IRcodeLibrary::count(void) { return _valid ? _count : 0; }
+
+// Get the details of a code by its position in the library.
+// Args:
+//   nr: Position of the code. The codes are in order of id.
+//   entry: Ptr to where to put the details.
+// Returns: true if successful, false if not.
+bool IRcodeLibrary::getEntry(const uint16_t nr, ir_code_entry_t *entry) {
+  uint8_t raw[kCodeLibEntrySize];
+  if (!_valid || nr >= _count || entry == NULL ||
+      !_source->read(kCodeLibHeaderSize + (uint32_t)nr * kCodeLibEntrySize,
+                     raw, kCodeLibEntrySize))
+    return false;
+  parseEntry(raw, entry);
+  // Sanity check it, so sending it can't wander off.
+  return entry->intro <= entry->length && entry->offset <= _data_size &&
+      entry->size <= _data_size - entry->offset;
+}
+
+// Find a code by its id.
+// Args:
+//   id: The id of the code.
+//   entry: Ptr to where to put the details of the code.
+// Returns: true if found, false if not.
+bool IRcodeLibrary::findId(const uint16_t id, ir_code_entry_t *entry) {
+  if (entry == NULL) return false;
+  uint16_t low = 0;
+  uint16_t high = count();
+  while (low < high) {  // Binary search the index.
+    uint16_t mid = low + (high - low) / 2;
+    if (!getEntry(mid, entry)) return false;
+    if (entry->id == id) return true;
+    if (entry->id < id)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return false;
+}
+
+// Find a code by its name. Case sensitive.
+// Args:
+//   name: The name of the code.
+//   entry: Ptr to where to put the details of the code.
+// Returns: true if found, false if not.
+bool IRcodeLibrary::findName(const char *name, ir_code_entry_t *entry) {
+  if (name == NULL || entry == NULL) return false;
+  uint16_t low = 0;
+  uint16_t high = count();
+  while (low < high) {  // Binary search the name index.
+    uint16_t mid = low + (high - low) / 2;
+    uint8_t nr[2];
+    if (!_source->read(_names + mid * 2, nr, 2) ||
+        !getEntry(get16(nr), entry)) return false;
+    int cmp = strncmp(name, entry->name, kCodeLibNameSize);
+    if (!cmp) return true;
+    if (cmp > 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return false;
+}
+
+// Send a code from the library.
+// Args:
+//   irsend: Ptr to the IRsend object to send it with.
+//   entry: The details of the code. e.g. From findId() or findName().
+// Returns: true if it was sent, false if not.
+//
+// Note:
+//   The code is read a few bytes at a time as it is sent. No heap is used.
+//   Sends exactly the same as sendRaw(), sendGC() or sendPronto() would have
+//   with the code it was built from.
+bool IRcodeLibrary::send(IRsend *irsend, const ir_code_entry_t *entry) {
+  if (!_valid || irsend == NULL || entry == NULL) return false;
+  IRcodeDecoder decoder(_source, _data + entry->offset, entry->size);
+  uint32_t usecs;
+  irsend->enableIROut(entry->frequency);
+  for (uint16_t i = 0; i < entry->intro; i++) {
+    if (!decoder.next(&usecs)) return false;
+    sendDuration(irsend, i, usecs);
+  }
+  const IRcodeDecoder repeat_start = decoder;
+  for (uint16_t r = 0; r < entry->repeats; r++) {
+    decoder = repeat_start;
+    for (uint16_t i = entry->intro; i < entry->length; i++) {
+      if (!decoder.next(&usecs)) return false;
+      sendDuration(irsend, i, usecs);
+    }
+  }
+  // No need to turn the LED off. mark() always leaves it off.
+  return true;
+}
+
+// Send a code from the library, given its id.
+// Returns: true if it was sent, false if not. e.g. It wasn't found.
+bool IRcodeLibrary::sendId(IRsend *irsend, const uint16_t id) {
+  ir_code_entry_t entry;
+  return findId(id, &entry) && send(irsend, &entry);
+}
+
+// Send a code from the library, given its name.
+// Returns: true if it was sent, false if not. e.g. It wasn't found.
+bool IRcodeLibrary::sendName(IRsend *irsend, const char *name) {
+  ir_code_entry_t entry;
+  return findName(name, &entry) && send(irsend, &entry);
+}
+
+// Get the durations of a code. i.e. Without the intro/repeat expansion.
+// Args:
+//   entry: The details of the code.
+//   durations: Where to put the durations. In uSeconds.
+//   size: Nr. of entries `durations` can hold. Must be >= entry->length.
+// Returns: true if successful, false if not.
+bool IRcodeLibrary::getDurations(const ir_code_entry_t *entry,
+                                 uint32_t durations[], const uint16_t size) {
+  if (!_valid || entry == NULL || durations == NULL || size < entry->length)
+    return false;
+  IRcodeDecoder decoder(_source, _data + entry->offset, entry->size);
+  for (uint16_t i = 0; i < entry->length; i++)
+    if (!decoder.next(&durations[i])) return false;
+  return true;
+}
+
+// IRcodeLibraryBuilder --------------------------------------------------------
+
+// Args:
+//   buffer: Where to build the library.
+//   size: Nr. of bytes in `buffer`.
+//   max_codes: The most codes that will be added. Space is reserved for their
+//              index entries until finish() is called.
+IRcodeLibraryBuilder::IRcodeLibraryBuilder(uint8_t *buffer,
+                                           const uint32_t size,
+                                           const uint16_t max_codes)
+    : _buffer(buffer), _size(size), _max(max_codes), _count(0),
+      _finished(false) {
+  _data = kCodeLibHeaderSize +
+      (uint32_t)max_codes * (kCodeLibEntrySize + 2);
+  _data_pos = _data;
+}
+
+// Returns: The nr. of codes added so far.
+uint16_t IRcodeLibraryBuilder::count(void) { return _count; }
+
+uint8_t *IRcodeLibraryBuilder::entryPtr(const uint16_t nr) {
+  return _buffer + kCodeLibHeaderSize + (uint32_t)nr * kCodeLibEntrySize;
+}
+
+// Append a variable length integer to the data.
+// Returns: true if it fitted, false if not.
+bool IRcodeLibraryBuilder::putVarint(uint64_t value) {
+  do {
+    if (_data_pos >= _size) return false;
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    if (value) byte |= 0x80;
+    _buffer[_data_pos++] = byte;
+  } while (value);
+  return true;
+}
+
+// Add a code.
+// Args:
+//   id: Its unique id.
+//   name: Its name. Must be shorter than kCodeLibNameSize. Unique if not "".
+//   hz: Modulation frequency in Hz.
+//   values: The durations.
+//   length: Nr. of durations.
+//   intro: Nr. of durations only sent once.
+//   repeats: Nr. of times the rest of the durations are sent.
+//   multiplier: Nr. of uSeconds per unit of `values`.
+//   min_usecs: The shortest a duration can be.
+// Returns: true if it was added, false if not.
+bool IRcodeLibraryBuilder::addCode(const uint16_t id, const char *name,
+                                   const uint32_t hz, const uint16_t values[],
+                                   const uint16_t length, const uint16_t intro,
+                                   const uint16_t repeats,
+                                   const uint32_t multiplier,
+                                   const uint32_t min_usecs) {
+  if (_buffer == NULL || _finished || _count >= _max || _data > _size ||
+      name == NULL || strlen(name) >= kCodeLibNameSize)
+    return false;
+  for (uint16_t i = 0; i < _count; i++) {  // Must be unique.
+    const uint8_t *entry = entryPtr(i);
+    if (get16(entry + kCodeLibIdOffset) == id ||
+        (name[0] && !strncmp(name, (const char *)entry + kCodeLibNameOffset,
+                             kCodeLibNameSize)))
+      return false;
+  }
+  const uint32_t start = _data_pos;
+  uint32_t prev[2] = {0, 0};
+  for (uint16_t i = 0; i < length; i++) {
+    const uint32_t usecs = std::max(values[i] * multiplier, min_usecs);
+    const int64_t delta = (int64_t)usecs - prev[i & 1];
+    prev[i & 1] = usecs;
+    if (!putVarint(((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63))) {
+      _data_pos = start;  // Didn't fit. Undo it.
+      return false;
+    }
+  }
+  uint8_t *entry = entryPtr(_count++);
+  put16(entry + kCodeLibIdOffset, id);
+  memset(entry + kCodeLibNameOffset, 0, kCodeLibNameSize);
+  strncpy((char *)entry + kCodeLibNameOffset, name, kCodeLibNameSize - 1);
+  put32(entry + kCodeLibFreqOffset, hz);
+  put16(entry + kCodeLibIntroOffset, intro);
+  put16(entry + kCodeLibLengthOffset, length);
+  put16(entry + kCodeLibRepeatsOffset, repeats);
+  put32(entry + kCodeLibDataOffset, start - _data);
+  put32(entry + kCodeLibDataLenOffset, _data_pos - start);
+  return true;
+}
+
+// Add a raw code. i.e. As used by IRsend::sendRaw().
+// Args:
+//   id: Unique id of the code.
+//   name: Name of the code. Must be shorter than kCodeLibNameSize.
+//   buf: The mark & space durations, in uSeconds.
+//   len: Nr. of entries in `buf`.
+//   hz: Frequency to send it at. (kHz < 1000; Hz >= 1000)
+// Returns: true if it was added, false if not.
+bool IRcodeLibraryBuilder::addRaw(const uint16_t id, const char *name,
+                                  const uint16_t buf[], const uint16_t len,
+                                  const uint16_t hz) {
+  if (buf == NULL) return false;
+  return addCode(id, name, hz < 1000 ? hz * 1000UL : hz, buf, len, len, 0, 1,
+                 0);
+}
+
+// Add a GlobalCache code. i.e. As used by IRsend::sendGC().
+// Args:
+//   id: Unique id of the code.
+//   name: Name of the code. Must be shorter than kCodeLibNameSize.
+//   buf: The GlobalCache values. i.e. Frequency, Repeats, Offset, Data ...
+//   len: Nr. of entries in `buf`.
+// Returns: true if it was added, false if not.
+bool IRcodeLibraryBuilder::addGC(const uint16_t id, const char *name,
+                                 const uint16_t buf[], const uint16_t len) {
+  if (buf == NULL || len <= kGlobalCacheStartIndex) return false;
+  const uint16_t hz = buf[kGlobalCacheFreqIndex];
+  const uint16_t emits = std::min(buf[kGlobalCacheRptIndex],
+                                  kGlobalCacheMaxRepeat);
+  const uint16_t length = len - kGlobalCacheStartIndex;
+  // sendGC() sends everything once, then repeats from the offset (1-based).
+  // That's the same as sending what's before the offset once, then the rest
+  // `emits` times.
+  uint16_t intro = 0;
+  if (emits && buf[kGlobalCacheRptStartIndex])
+    intro = std::min((uint16_t)(buf[kGlobalCacheRptStartIndex] - 1), length);
+  return addCode(id, name, hz, buf + kGlobalCacheStartIndex, length, intro,
+                 emits, cyclePeriod(hz), kGlobalCacheMinUsec);
+}
+
+// Add a Pronto code. i.e. As used by IRsend::sendPronto().
+// Args:
+//   id: Unique id of the code.
+//   name: Name of the code. Must be shorter than kCodeLibNameSize.
+//   data: The Pronto values.
+//   len: Nr. of entries in `data`.
+//   repeat: Nr. of times to repeat the 2nd (repeat) sequence when sent.
+// Returns: true if it was added, false if not.
+bool IRcodeLibraryBuilder::addPronto(const uint16_t id, const char *name,
+                                     const uint16_t data[], const uint16_t len,
+                                     const uint16_t repeat) {
+  // We only know how to deal with 'raw' pronto codes types.
+  if (data == NULL || len < kProntoMinLength ||
+      data[kProntoTypeOffset] != 0 || data[kProntoFreqOffset] == 0)
+    return false;
+  const uint16_t hz =
+      (uint16_t)(1000000U / (data[kProntoFreqOffset] * kProntoFreqFactor));
+  const uint16_t seq_1_len = data[kProntoSeq1LenOffset] * 2;
+  uint16_t seq_2_len = data[kProntoSeq2LenOffset] * 2;
+  if (kProntoDataOffset + seq_1_len > len) return false;
+  // An incomplete 2nd sequence isn't sent.
+  if (kProntoDataOffset + seq_1_len + seq_2_len > len) seq_2_len = 0;
+  // With no 1st sequence, the 2nd is sent an additional time.
+  const uint16_t repeats = seq_1_len ? repeat : repeat + 1;
+  return addCode(id, name, hz, data + kProntoDataOffset, seq_1_len + seq_2_len,
+                 seq_1_len, repeats, cyclePeriod(hz), 0);
+}
+
+// Sort & pack the library, and write its header. No more codes can be added.
+// Returns: The size of the finished library in bytes, or 0 on failure.
+uint32_t IRcodeLibraryBuilder::finish(void) {
+  if (_buffer == NULL || _finished || _data > _size) return 0;
+  _finished = true;
+  // Sort the index by id. (Insertion sort; it's small & likely nearly sorted.)
+  uint8_t tmp[kCodeLibEntrySize];
+  for (uint16_t i = 1; i < _count; i++) {
+    memcpy(tmp, entryPtr(i), kCodeLibEntrySize);
+    const uint16_t id = get16(tmp + kCodeLibIdOffset);
+    uint16_t j = i;
+    for (; j > 0 && get16(entryPtr(j - 1) + kCodeLibIdOffset) > id; j--)
+      memcpy(entryPtr(j), entryPtr(j - 1), kCodeLibEntrySize);
+    memcpy(entryPtr(j), tmp, kCodeLibEntrySize);
+  }
+  // Build the name index, straight after the (used part of the) index.
+  uint8_t *names = entryPtr(_count);
+  for (uint16_t i = 0; i < _count; i++) {
+    const char *name = (const char *)entryPtr(i) + kCodeLibNameOffset;
+    uint16_t j = i;
+    for (; j > 0; j--) {
+      const uint16_t other = get16(names + (j - 1) * 2);
+      if (strncmp((const char *)entryPtr(other) + kCodeLibNameOffset, name,
+                  kCodeLibNameSize) <= 0)
+        break;
+      put16(names + j * 2, other);
+    }
+    put16(names + j * 2, i);
+  }
+  // Close the gap left by the unused index entries.
+  const uint32_t data = kCodeLibHeaderSize +
+      (uint32_t)_count * (kCodeLibEntrySize + 2);
+  const uint32_t data_size = _data_pos - _data;
+  memmove(_buffer + data, _buffer + _data, data_size);
+  // Header
+  memcpy(_buffer, kCodeLibMagic, sizeof(kCodeLibMagic));
+  _buffer[kCodeLibVersionOffset] = kCodeLibVersion;
+  _buffer[kCodeLibVersionOffset + 1] = 0;  // Reserved.
+  put16(_buffer + kCodeLibCountOffset, _count);
+  put32(_buffer + kCodeLibDataSizeOffset, data_size);
+  return data + data_size;
+}
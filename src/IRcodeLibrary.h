@@ -0,0 +1,145 @@
+#ifndef IRCODELIBRARY_H_
+#define IRCODELIBRARY_H_
+
+// Copyright 2019 David Conran
+
+#define __STDC_LIMIT_MACROS
+#include <stdint.h>
+#include "IRremoteESP8266.h"
+#include "IRsend.h"
+
+// A compact, binary library of stored (e.g. learned) IR codes.
+//
+// Codes are added as raw, GlobalCache or Pronto arrays, and are kept as a
+// list of mark & space durations (in uSeconds) that can be sent straight from
+// where the library is stored. e.g. A memory-mapped file, flash (PROGMEM), or
+// a file on SPIFFS. Nothing is parsed or allocated when a code is sent.
+//
+// Layout. All multi-byte values are little-endian.
+//   Header: kCodeLibHeaderSize bytes.
+//     Magic ("IRCL"), Version (1 byte), Reserved (1 byte),
+//     Nr. of codes (2 bytes), Size of the data section (4 bytes).
+//   Index: One kCodeLibEntrySize byte entry per code, sorted by id.
+//     Id (2), Name (kCodeLibNameSize, NUL padded), Frequency in Hz (4),
+//     Intro (2), Length (2), Repeats (2), Data offset (4), Data size (4).
+//   Name index: One 2 byte index entry nr. per code, sorted by name.
+//   Data: The durations of each code, one after the other.
+//
+// Durations alternate mark, space, mark, ... starting with a mark. Each is
+// stored as the (zig-zag encoded) difference from the previous mark (or
+// space) as a variable length integer. i.e. 7 bits per byte, least
+// significant first, with the top bit set on all but the last byte. As most
+// marks (and spaces) in a message are about the same length, most only take
+// a single byte.
+//
+// When sent, the first `intro` durations are sent once, then the rest are
+// sent `repeats` times.
+
+// Constants
+const uint8_t kCodeLibVersion = 1;
+const uint8_t kCodeLibNameSize = 24;  // Incl. the terminating NUL.
+const uint8_t kCodeLibHeaderSize = 12;
+const uint8_t kCodeLibEntrySize = 44;
+// Nr. of bytes read from the source at a time while sending.
+const uint8_t kCodeLibChunkSize = 32;
+
+// A code in the library.
+typedef struct {
+  uint16_t id;                   // Caller chosen unique id.
+  char name[kCodeLibNameSize];   // Caller chosen name. May be empty.
+  uint32_t frequency;            // Modulation frequency in Hz.
+  uint16_t intro;                // Nr. of durations only sent the first time.
+  uint16_t length;               // Total nr. of durations.
+  uint16_t repeats;              // Nr. of times the rest are sent.
+  uint32_t offset;               // Where its data starts in the data section.
+  uint32_t size;                 // Nr. of bytes of data.
+} ir_code_entry_t;
+
+// Somewhere a library is stored.
+// e.g. For a file on SPIFFS:
+//   class IRcodeFile : public IRcodeSource {
+//    public:
+//     explicit IRcodeFile(File *file) : _file(file) {}
+//     bool read(const uint32_t offset, uint8_t *buf, const uint16_t len) {
+//       return _file->seek(offset) && _file->read(buf, len) == len;
+//     }
+//    private:
+//     File *_file;
+//   };
+class IRcodeSource {
+ public:
+  virtual ~IRcodeSource() {}
+  // Copy `len` bytes, starting `offset` bytes in, to `buf`.
+  // Returns: true if all of them could be read, otherwise false.
+  virtual bool read(const uint32_t offset, uint8_t *buf,
+                    const uint16_t len) = 0;
+};
+
+// A library held in (or memory-mapped into) the address space.
+// e.g. A const array in flash (PROGMEM), or an mmap()ed file.
+class IRcodeMemory : public IRcodeSource {
+ public:
+  IRcodeMemory(const uint8_t *data, const uint32_t size);
+  bool read(const uint32_t offset, uint8_t *buf, const uint16_t len);
+
+ private:
+  const uint8_t *_data;
+  uint32_t _size;
+};
+
+// Look up & send codes from a library.
+class IRcodeLibrary {
+ public:
+  explicit IRcodeLibrary(IRcodeSource *source);
+  bool begin(void);
+  uint16_t count(void);
+  bool getEntry(const uint16_t nr, ir_code_entry_t *entry);
+  bool findId(const uint16_t id, ir_code_entry_t *entry);
+  bool findName(const char *name, ir_code_entry_t *entry);
+  bool send(IRsend *irsend, const ir_code_entry_t *entry);
+  bool sendId(IRsend *irsend, const uint16_t id);
+  bool sendName(IRsend *irsend, const char *name);
+  bool getDurations(const ir_code_entry_t *entry, uint32_t durations[],
+                    const uint16_t size);
+
+ private:
+  IRcodeSource *_source;
+  bool _valid;
+  uint16_t _count;
+  uint32_t _names;  // Where the name index starts.
+  uint32_t _data;   // Where the data section starts.
+  uint32_t _data_size;
+};
+
+// Build a library in a caller supplied buffer.
+// Codes can be added in any order. finish() sorts & packs them.
+class IRcodeLibraryBuilder {
+ public:
+  IRcodeLibraryBuilder(uint8_t *buffer, const uint32_t size,
+                       const uint16_t max_codes);
+  bool addRaw(const uint16_t id, const char *name, const uint16_t buf[],
+              const uint16_t len, const uint16_t hz = 38);
+  bool addGC(const uint16_t id, const char *name, const uint16_t buf[],
+             const uint16_t len);
+  bool addPronto(const uint16_t id, const char *name, const uint16_t data[],
+                 const uint16_t len, const uint16_t repeat = kNoRepeat);
+  uint16_t count(void);
+  uint32_t finish(void);
+
+ private:
+  uint8_t *_buffer;
+  uint32_t _size;
+  uint16_t _max;
+  uint16_t _count;
+  uint32_t _data;      // Where the data section is while building.
+  uint32_t _data_pos;  // Where the next code's data will go.
+  bool _finished;
+  bool addCode(const uint16_t id, const char *name, const uint32_t hz,
+               const uint16_t values[], const uint16_t length,
+               const uint16_t intro, const uint16_t repeats,
+               const uint32_t multiplier, const uint32_t min_usecs);
+  bool putVarint(uint64_t value);
+  uint8_t *entryPtr(const uint16_t nr);
+};
+
+#endif  // IRCODELIBRARY_H_
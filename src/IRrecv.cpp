@@ -19,11 +19,49 @@ extern "C" {
 #include <cassert>
 #endif  // UNIT_TEST
 #include "IRremoteESP8266.h"
+#include "IRtimer.h"
 #include "IRutils.h"
+#include "ir_Argo.h"
+#include "ir_Carrier.h"
+#include "ir_Coolix.h"
+#include "ir_Daikin.h"
+#include "ir_Dish.h"
+#include "ir_Electra.h"
+#include "ir_Fujitsu.h"
+#include "ir_GICable.h"
+#include "ir_Goodweather.h"
+#include "ir_Gree.h"
+#include "ir_Haier.h"
+#include "ir_Hitachi.h"
+#include "ir_Inax.h"
+#include "ir_Kelvinator.h"
+#include "ir_Lego.h"
+#include "ir_Midea.h"
+#include "ir_Mitsubishi.h"
+#include "ir_MitsubishiHeavy.h"
+#include "ir_NEC.h"
+#include "ir_Neoclima.h"
+#include "ir_Nikai.h"
+#include "ir_Panasonic.h"
+#include "ir_RC5_RC6.h"
+#include "ir_RCMM.h"
+#include "ir_Samsung.h"
+#include "ir_Sharp.h"
+#include "ir_Sony.h"
+#include "ir_Tcl.h"
+#include "ir_Teco.h"
+#include "ir_Toshiba.h"
+#include "ir_Trotec.h"
+#include "ir_Vestel.h"
+#include "ir_Whirlpool.h"
+#include "ir_Whynter.h"
 
 #ifdef UNIT_TEST
+// Used to help simulate elapsed time in unit tests.
+extern uint32_t _IRtimer_unittest_now;
 #undef ICACHE_RAM_ATTR
 #define ICACHE_RAM_ATTR
+#define USE_IRAM_ATTR
 #endif
 
 #ifndef USE_IRAM_ATTR
@@ -49,83 +87,617 @@ extern "C" {
 #if defined(ESP8266)
 static ETSTimer timer;
 #endif  // ESP8266
-#if defined(ESP32)
-static hw_timer_t * timer = NULL;
-#endif  // ESP32
 #endif  // UNIT_TEST
 
 #if defined(ESP32)
 portMUX_TYPE irremote_mux = portMUX_INITIALIZER_UNLOCKED;
 #endif  // ESP32
-volatile irparams_t irparams;
-irparams_t *irparams_save;  // A copy of the interrupt state while decoding.
+#ifndef UNIT_TEST
+// Which receiver's capture state the interrupt handlers are capturing into.
+// Each IRrecv owns its own state. These just point at it while it is enabled.
+typedef struct {
+  volatile irparams_t *params;
+  volatile ircapture_ring_t *ring;
+#if defined(ESP32)
+  hw_timer_t *timer;  // The timer used for the receiver's timeout.
+#endif  // ESP32
+} isr_context_t;
 
+#if defined(ESP32)
+// One per hardware timer. i.e. Up to 4 receivers can capture at the same time,
+// as long as they were each constructed with a different timer_num.
+const uint8_t kIsrContexts = 4;
+#else  // ESP32
+// There is only the one timer & GPIO interrupt handler on the ESP8266, so only
+// the receiver enableIRIn() was last called on is captured for.
+const uint8_t kIsrContexts = 1;
+#endif  // ESP32
+static isr_context_t isr_contexts[kIsrContexts];
+#endif  // UNIT_TEST
+
+// Reset the interrupt handler's state so it is ready to capture a new message.
+static void USE_IRAM_ATTR capture_reset(volatile irparams_t *params) {
+  params->rcvstate = kIdleState;
+  params->rawlen = 0;
+  params->overflow = false;
+}
+
+// Record the message just captured in the current slot of the capture ring,
+// and move the interrupt handler on to capturing into the next free slot.
+// If there isn't a free slot, the message is dropped & the slot reused.
+// Only call this with interrupts locked out, or from an interrupt handler.
+static void USE_IRAM_ATTR capture_complete(volatile irparams_t *params,
+                                           volatile ircapture_ring_t *ring) {
+  // Avoid `%` & multiplication. They are not IRAM friendly on the ESP8266.
+  uint8_t slot = ring->first + ring->completed;
+  if (slot >= ring->slots) slot -= ring->slots;
+  ring->rawlens[slot] = params->rawlen;
+  ring->overflows[slot] = params->overflow;
+  if (ring->completed + 2 <= ring->slots) {  // Is there a free slot?
+    ring->completed++;
+    if (++slot >= ring->slots) slot = 0;
+    params->rawbuf = ring->buffers[slot];
+  } else {
+    ring->dropped++;  // Nope. Drop the message & reuse the current slot.
+  }
+  capture_reset(params);
+}
+
+// Stop the interrupt handlers from changing the capture state.
+static void capture_lock(void) {
 #ifndef UNIT_TEST
 #if defined(ESP8266)
-static void USE_IRAM_ATTR read_timeout(void *arg __attribute__((unused))) {
   os_intr_lock();
 #endif  // ESP8266
 #if defined(ESP32)
-static void USE_IRAM_ATTR read_timeout(void) {
   portENTER_CRITICAL(&irremote_mux);
 #endif  // ESP32
-  if (irparams.rawlen) irparams.rcvstate = kStopState;
+#endif  // UNIT_TEST
+}
+
+// Allow the interrupt handlers to change the capture state again.
+static void capture_unlock(void) {
+#ifndef UNIT_TEST
 #if defined(ESP8266)
   os_intr_unlock();
 #endif  // ESP8266
 #if defined(ESP32)
   portEXIT_CRITICAL(&irremote_mux);
 #endif  // ESP32
+#endif  // UNIT_TEST
 }
 
-static void USE_IRAM_ATTR gpio_intr() {
-  uint32_t now = micros();
-  static uint32_t start = 0;
+#ifndef UNIT_TEST
+// The capture timed out. i.e. The message has ended.
+static void USE_IRAM_ATTR capture_timeout(isr_context_t *context) {
+  volatile irparams_t *params = context->params;
+  if (params != NULL && params->rawlen) {
+    params->rcvstate = kStopState;
+    // If we have a ring of capture slots, move on to the next one.
+    if (context->ring->slots > 1) capture_complete(params, context->ring);
+  }
+}
 
 #if defined(ESP8266)
-  uint32_t gpio_status = GPIO_REG_READ(GPIO_STATUS_ADDRESS);
-  os_timer_disarm(&timer);
-  GPIO_REG_WRITE(GPIO_STATUS_W1TC_ADDRESS, gpio_status);
+static void USE_IRAM_ATTR read_timeout(void *arg __attribute__((unused))) {
+  os_intr_lock();
+  capture_timeout(&isr_contexts[0]);
+  os_intr_unlock();
+}
 #endif  // ESP8266
+#if defined(ESP32)
+static void USE_IRAM_ATTR read_timeout(const uint8_t timer_num) {
+  portENTER_CRITICAL(&irremote_mux);
+  capture_timeout(&isr_contexts[timer_num]);
+  portEXIT_CRITICAL(&irremote_mux);
+}
+
+// The ESP32 timer interrupt handlers don't take an argument, so each timer
+// needs a handler of its own to know which receiver timed out.
+static void USE_IRAM_ATTR read_timeout0(void) { read_timeout(0); }
+static void USE_IRAM_ATTR read_timeout1(void) { read_timeout(1); }
+static void USE_IRAM_ATTR read_timeout2(void) { read_timeout(2); }
+static void USE_IRAM_ATTR read_timeout3(void) { read_timeout(3); }
+static void (* const read_timeouts[kIsrContexts])(void) = {
+    read_timeout0, read_timeout1, read_timeout2, read_timeout3};
+#endif  // ESP32
 
+// Record the time since the previous edge of the IR signal.
+//
+// Args:
+//   params: The capture state of the receiver that saw the edge.
+//   now: When the edge was seen. (uSeconds)
+// Returns:
+//   A boolean indicating if it was recorded. i.e. The timeout needs restarting.
+static bool USE_IRAM_ATTR capture_edge(volatile irparams_t *params,
+                                       const uint32_t now) {
+  if (params == NULL) return false;
   // Grab a local copy of rawlen to reduce instructions used in IRAM.
   // This is an ugly premature optimisation code-wise, but we do everything we
   // can to save IRAM.
   // It seems referencing the value via the structure uses more instructions.
   // Less instructions means faster and less IRAM used.
   // N.B. It saves about 13 bytes of IRAM.
-  uint16_t rawlen = irparams.rawlen;
+  uint16_t rawlen = params->rawlen;
 
-  if (rawlen >= irparams.bufsize) {
-    irparams.overflow = true;
-    irparams.rcvstate = kStopState;
+  if (rawlen >= params->bufsize) {
+    params->overflow = true;
+    params->rcvstate = kStopState;
   }
 
-  if (irparams.rcvstate == kStopState) return;
+  if (params->rcvstate == kStopState) return false;
 
-  if (irparams.rcvstate == kIdleState) {
-    irparams.rcvstate = kMarkState;
-    irparams.rawbuf[rawlen] = 1;
+  if (params->rcvstate == kIdleState) {
+    params->rcvstate = kMarkState;
+    params->rawbuf[rawlen] = 1;
   } else {
+    uint32_t start = params->start;
     if (now < start)
-      irparams.rawbuf[rawlen] = (UINT32_MAX - start + now) / kRawTick;
+      params->rawbuf[rawlen] = (UINT32_MAX - start + now) / kRawTick;
     else
-      irparams.rawbuf[rawlen] = (now - start) / kRawTick;
+      params->rawbuf[rawlen] = (now - start) / kRawTick;
   }
-  irparams.rawlen++;
+  params->rawlen++;
 
-  start = now;
+  params->start = now;
+  return true;
+}
 
 #if defined(ESP8266)
-  os_timer_arm(&timer, irparams.timeout, ONCE);
+static void USE_IRAM_ATTR gpio_intr() {
+  uint32_t now = micros();
+  uint32_t gpio_status = GPIO_REG_READ(GPIO_STATUS_ADDRESS);
+  os_timer_disarm(&timer);
+  GPIO_REG_WRITE(GPIO_STATUS_W1TC_ADDRESS, gpio_status);
+
+  volatile irparams_t *params = isr_contexts[0].params;
+  if (capture_edge(params, now)) os_timer_arm(&timer, params->timeout, ONCE);
+}
 #endif  // ESP8266
 #if defined(ESP32)
-  timerWrite(timer, 0);  // Reset the timeout.
-  timerAlarmEnable(timer);
-#endif  // ESP32
+// Args:
+//   arg: The isr_context_t of the receiver the GPIO belongs to.
+static void USE_IRAM_ATTR gpio_intr(void *arg) {
+  uint32_t now = micros();
+  isr_context_t *context = static_cast<isr_context_t *>(arg);
+  if (capture_edge(context->params, now)) {
+    timerWrite(context->timer, 0);  // Reset the timeout.
+    timerAlarmEnable(context->timer);
+  }
 }
+#endif  // ESP32
 #endif  // UNIT_TEST
 
+// Decoder dispatch -------------------
+//
+// decode() tries the protocol decoders listed in kDecodeSteps[], in order,
+// until one of them succeeds. The order matters. Some protocols are a more
+// specific case, or a near match, of another, so they have to be tried first.
+// e.g. Aiwa, Sanyo, Carrier & Pioneer before NEC, & Kelvinator before Gree.
+//
+// Each step also records the leading mark & space (in uSeconds) the decoder
+// expects, and the smallest capture (rawlen) it could possibly accept. From
+// those we build (once) a table, indexed by the duration of the first mark in
+// the capture, of which steps are worth attempting. That way an UNKNOWN or
+// noisy capture doesn't have to be run past every single decoder before it
+// gets to decodeHash().
+// A value of 0 for the mark or space means "any". i.e. The decoder has no
+// fixed header, or accepts several different ones (e.g. repeat codes), so it
+// is always attempted.
+// The timings are the protocols' own constants (from their ir_*.h files), so
+// they always match what the decoders themselves look for.
+
+enum decode_step_id_t {
+  kDecodeStepEnd = 0,  // Not a real step. Marks the end of kDecodeSteps[].
+  kDecodeStepAiwaRCT501,
+  kDecodeStepSanyoLC7461,
+  kDecodeStepCarrierAC,
+  kDecodeStepPioneer,
+  kDecodeStepNEC,
+  kDecodeStepSony,
+  kDecodeStepMitsubishi,
+  kDecodeStepMitsubishiAC,
+  kDecodeStepMitsubishi2,
+  kDecodeStepRC5,
+  kDecodeStepRC6,
+  kDecodeStepRCMM,
+  kDecodeStepFujitsuAC,
+  kDecodeStepDenon,
+  kDecodeStepPanasonic,
+  kDecodeStepLG,
+  kDecodeStepLG32,
+  kDecodeStepGICable,
+  kDecodeStepJVC,
+  kDecodeStepSAMSUNG,
+  kDecodeStepSamsung36,
+  kDecodeStepWhynter,
+  kDecodeStepDISH,
+  kDecodeStepSharp,
+  kDecodeStepCOOLIX,
+  kDecodeStepNikai,
+  kDecodeStepKelvinator,
+  kDecodeStepDaikin,
+  kDecodeStepDaikin2,
+  kDecodeStepDaikin216,
+  kDecodeStepToshibaAC,
+  kDecodeStepMidea,
+  kDecodeStepMagiQuest,
+  kDecodeStepNECLike,
+  kDecodeStepLasertag,
+  kDecodeStepGree,
+  kDecodeStepHaierAC,
+  kDecodeStepHaierACYRW02,
+  kDecodeStepHitachiAC2,
+  kDecodeStepHitachiAC,
+  kDecodeStepHitachiAC1,
+  kDecodeStepWhirlpoolAC,
+  kDecodeStepSamsungACExtended,
+  kDecodeStepSamsungAC,
+  kDecodeStepElectraAC,
+  kDecodeStepPanasonicAC,
+  kDecodeStepPanasonicACShort,
+  kDecodeStepLutron,
+  kDecodeStepMWM,
+  kDecodeStepVestelAc,
+  kDecodeStepTcl112Ac,
+  kDecodeStepTeco,
+  kDecodeStepLegoPf,
+  kDecodeStepMitsubishiHeavy152,
+  kDecodeStepMitsubishiHeavy88,
+  kDecodeStepArgo,
+  kDecodeStepSharpAc,
+  kDecodeStepGoodweather,
+  kDecodeStepInax,
+  kDecodeStepTrotec,
+  kDecodeStepDaikin160,
+  kDecodeStepNeoclima,
+};
+
+const decode_step_t kDecodeSteps[] = {
+#if DECODE_AIWA_RC_T501
+  // Try Aiwa RC T501 before Sanyo LC7461 & NEC because the protocols are
+  // similar. This protocol is more specific than those ones, so should go
+  // before them.
+  {kDecodeStepAiwaRCT501, AIWA_RC_T501, kNecHdrMark, kNecHdrSpace,
+   2 * kAiwaRcT501Bits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_AIWA_RC_T501
+#if DECODE_SANYO
+  // Try Sanyo LC7461 before NEC because the protocols are similar in timings &
+  // structure, but the Sanyo one is much longer than the NEC protocol (42 vs 32
+  // bits) so this one should be tried first to try to reduce false detection
+  // as a NEC packet.
+  {kDecodeStepSanyoLC7461, SANYO_LC7461, kNecHdrMark, kNecHdrSpace,
+   2 * kSanyoLC7461Bits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_SANYO
+#if DECODE_CARRIER_AC
+  // Try Carrier AC before NEC because the protocols are similar in timings &
+  // structure, but the Carrier one is much longer than the NEC protocol (3x32
+  // bits vs 1x32 bits) so this one should be tried first to try to reduce
+  // false detection as a NEC packet.
+  {kDecodeStepCarrierAC, CARRIER_AC, kCarrierAcHdrMark, kCarrierAcHdrSpace,
+   (2 * kCarrierAcBits + kHeader + kFooter) * 3 - 1, kTolerance},
+#endif  // DECODE_CARRIER_AC
+#if DECODE_PIONEER
+  // Try Pioneer before NEC because the protocols are similar in timings &
+  // structure, but the Pioneer one is much longer than the NEC protocol (2x32
+  // bits vs 1x32 bits) so this one should be tried first to try to reduce
+  // false detection as a NEC packet.
+  {kDecodeStepPioneer, PIONEER, kNecHdrMark, kNecHdrSpace,
+   2 * (kPioneerBits + kHeader + kFooter) - 1, kTolerance},
+#endif  // DECODE_PIONEER
+#if DECODE_NEC
+  {kDecodeStepNEC, NEC, kNecHdrMark, 0, kNecRptLength, kTolerance},
+#endif  // DECODE_NEC
+#if DECODE_SONY
+  {kDecodeStepSony, SONY, kSonyHdrMark, 0, 2 * kSonyMinBits + kHeader - 1,
+   kTolerance},
+#endif  // DECODE_SONY
+#if DECODE_MITSUBISHI
+  {kDecodeStepMitsubishi, MITSUBISHI, kMitsubishiBitMark, 0,
+   2 * kMitsubishiBits, kTolerance},
+#endif  // DECODE_MITSUBISHI
+#if DECODE_MITSUBISHI_AC
+  {kDecodeStepMitsubishiAC, MITSUBISHI_AC, 0, 0,
+   2 * kMitsubishiACBits + 2, kTolerance},
+#endif  // DECODE_MITSUBISHI_AC
+#if DECODE_MITSUBISHI2
+  {kDecodeStepMitsubishi2, MITSUBISHI2, kMitsubishi2HdrMark,
+   kMitsubishi2HdrSpace,
+   2 * kMitsubishiBits + kHeader + kFooter * 2 - 1, kTolerance},
+#endif  // DECODE_MITSUBISHI2
+#if DECODE_RC5
+  {kDecodeStepRC5, RC5, 0, 0, 0, kTolerance},
+#endif  // DECODE_RC5
+#if DECODE_RC6
+  {kDecodeStepRC6, RC6, kRc6HdrMark, 0, kHeader + 2 + 4, kTolerance},
+#endif  // DECODE_RC6
+#if DECODE_RCMM
+  {kDecodeStepRCMM, RCMM, kRcmmHdrMark, 0, 5, kTolerance},
+#endif  // DECODE_RCMM
+#if DECODE_FUJITSU_AC
+  // Fujitsu A/C needs to precede Panasonic and Denon as it has a short
+  // message which looks exactly the same as a Panasonic/Denon message.
+  {kDecodeStepFujitsuAC, FUJITSU_AC, kFujitsuAcHdrMark, kFujitsuAcHdrSpace,
+   2 * kFujitsuAcMinBits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_FUJITSU_AC
+#if DECODE_DENON
+  // Denon needs to precede Panasonic as it is a special case of Panasonic.
+  {kDecodeStepDenon, DENON, 0, 0, 0, kTolerance},
+#endif  // DECODE_DENON
+#if DECODE_PANASONIC
+  {kDecodeStepPanasonic, PANASONIC, kPanasonicHdrMark, kPanasonicHdrSpace,
+   2 * kPanasonicBits, kTolerance},
+#endif  // DECODE_PANASONIC
+#if DECODE_LG
+  {kDecodeStepLG, LG, 0, 0, 2 * kLgBits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_LG
+#if DECODE_LG
+  // LG32 should be tried before Samsung
+  {kDecodeStepLG32, LG, 0, 0,
+   2 * kLg32Bits + 2 * (kHeader + kFooter) - 1, kTolerance},
+#endif  // DECODE_LG
+#if DECODE_GICABLE
+  // Note: Needs to happen before JVC decode, because it looks similar except
+  //       with a required NEC-like repeat code.
+  {kDecodeStepGICable, GICABLE, kGicableHdrMark, kGicableHdrSpace,
+   2 * kGicableBits, kTolerance},
+#endif  // DECODE_GICABLE
+#if DECODE_JVC
+  {kDecodeStepJVC, JVC, 0, 0, 2 * kJvcBits + kFooter - 1, kTolerance},
+#endif  // DECODE_JVC
+#if DECODE_SAMSUNG
+  {kDecodeStepSAMSUNG, SAMSUNG, kSamsungHdrMark, kSamsungHdrSpace,
+   2 * kSamsungBits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_SAMSUNG
+#if DECODE_SAMSUNG36
+  {kDecodeStepSamsung36, SAMSUNG36, kSamsungHdrMark, kSamsungHdrSpace,
+   2 * kSamsung36Bits + kHeader + kFooter * 2 - 1, kTolerance},
+#endif  // DECODE_SAMSUNG36
+#if DECODE_WHYNTER
+  {kDecodeStepWhynter, WHYNTER, kWhynterBitMark, 0,
+   2 * kWhynterBits + 2 * kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_WHYNTER
+#if DECODE_DISH
+  {kDecodeStepDISH, DISH, kDishHdrMark, kDishHdrSpace,
+   2 * kDishBits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_DISH
+#if DECODE_SHARP
+  {kDecodeStepSharp, SHARP, kSharpBitMark, 0, 2 * kSharpBits + kFooter - 1,
+   kTolerance},
+#endif  // DECODE_SHARP
+#if DECODE_COOLIX
+  {kDecodeStepCOOLIX, COOLIX, kCoolixHdrMark, 0,
+   2 * 2 * kCoolixBits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_COOLIX
+#if DECODE_NIKAI
+  {kDecodeStepNikai, NIKAI, kNikaiHdrMark, kNikaiHdrSpace, 2 * kNikaiBits,
+   kTolerance},
+#endif  // DECODE_NIKAI
+#if DECODE_KELVINATOR
+  // Kelvinator based-devices use a similar code to Gree ones, to avoid false
+  // matches this needs to happen before Gree.
+  {kDecodeStepKelvinator, KELVINATOR, kKelvinatorHdrMark, kKelvinatorHdrSpace,
+   2 * kKelvinatorBits, kTolerance},
+#endif  // DECODE_KELVINATOR
+#if DECODE_DAIKIN
+  {kDecodeStepDaikin, DAIKIN, kDaikinBitMark, 0, 2 * kDaikinBits, 35},
+#endif  // DECODE_DAIKIN
+#if DECODE_DAIKIN2
+  {kDecodeStepDaikin2, DAIKIN2, kDaikin2LeaderMark, 0, 2 * kDaikin2Bits, 30},
+#endif  // DECODE_DAIKIN2
+#if DECODE_DAIKIN216
+  {kDecodeStepDaikin216, DAIKIN216, kDaikin216HdrMark, kDaikin216HdrSpace,
+   2 * kDaikin216Bits, kTolerance},
+#endif  // DECODE_DAIKIN216
+#if DECODE_TOSHIBA_AC
+  {kDecodeStepToshibaAC, TOSHIBA_AC, kToshibaAcHdrMark, kToshibaAcHdrSpace,
+   2 * kToshibaACBits, kTolerance},
+#endif  // DECODE_TOSHIBA_AC
+#if DECODE_MIDEA
+  {kDecodeStepMidea, MIDEA, kMideaHdrMark, kMideaHdrSpace, 2 * kMideaBits, 30},
+#endif  // DECODE_MIDEA
+#if DECODE_MAGIQUEST
+  {kDecodeStepMagiQuest, MAGIQUEST, 0, 0, 2 * kMagiquestBits, kTolerance},
+#endif  // DECODE_MAGIQUEST
+  // NOTE: The Sanyo SA8650B decoder (decodeSanyo()) is disabled due to poor
+  // quality. *IF* you are going to enable it, add it near the end of this
+  // table to avoid false positive matches.
+#if DECODE_NEC
+  // Some devices send NEC-like codes that don't follow the true NEC spec.
+  // This should detect those. e.g. Apple TV remote etc.
+  // This needs to be done after all other codes that use strict and some
+  // other protocols that are NEC-like as well, as turning off strict may
+  // cause this to match other valid protocols.
+  {kDecodeStepNECLike, NEC_LIKE, kNecHdrMark, 0, kNecRptLength, kTolerance},
+#endif  // DECODE_NEC
+#if DECODE_LASERTAG
+  {kDecodeStepLasertag, LASERTAG, 0, 0, 0, kTolerance},
+#endif  // DECODE_LASERTAG
+#if DECODE_GREE
+  // Gree based-devices use a similar code to Kelvinator ones, to avoid false
+  // matches this needs to happen after Kelvinator.
+  {kDecodeStepGree, GREE, kGreeHdrMark, kGreeHdrSpace, 2 * kGreeBits,
+   kTolerance},
+#endif  // DECODE_GREE
+#if DECODE_HAIER_AC
+  {kDecodeStepHaierAC, HAIER_AC, kHaierAcHdr, kHaierAcHdr,
+   2 * kHaierACBits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_HAIER_AC
+#if DECODE_HAIER_AC_YRW02
+  {kDecodeStepHaierACYRW02, HAIER_AC_YRW02, kHaierAcHdr, kHaierAcHdr,
+   2 * kHaierACYRW02Bits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_HAIER_AC_YRW02
+#if DECODE_HITACHI_AC2
+  // HitachiAC2 should be checked before HitachiAC
+  {kDecodeStepHitachiAC2, HITACHI_AC2, kHitachiAcHdrMark, kHitachiAcHdrSpace,
+   2 * kHitachiAc2Bits + kHeader + kFooter - 1, 30},
+#endif  // DECODE_HITACHI_AC2
+#if DECODE_HITACHI_AC
+  {kDecodeStepHitachiAC, HITACHI_AC, kHitachiAcHdrMark, kHitachiAcHdrSpace,
+   2 * kHitachiAcBits + kHeader + kFooter - 1, 30},
+#endif  // DECODE_HITACHI_AC
+#if DECODE_HITACHI_AC1
+  {kDecodeStepHitachiAC1, HITACHI_AC1, kHitachiAc1HdrMark, kHitachiAc1HdrSpace,
+   2 * kHitachiAc1Bits + kHeader + kFooter - 1, 30},
+#endif  // DECODE_HITACHI_AC1
+#if DECODE_WHIRLPOOL_AC
+  {kDecodeStepWhirlpoolAC, WHIRLPOOL_AC, kWhirlpoolAcHdrMark,
+   kWhirlpoolAcHdrSpace,
+   2 * kWhirlpoolAcBits, kTolerance},
+#endif  // DECODE_WHIRLPOOL_AC
+#if DECODE_SAMSUNG_AC
+  // Check the extended size first, as it should fail fast due to longer length.
+  {kDecodeStepSamsungACExtended, SAMSUNG_AC, kSamsungAcHdrMark,
+   kSamsungAcHdrSpace,
+   2 * kSamsungAcExtendedBits, kTolerance},
+#endif  // DECODE_SAMSUNG_AC
+#if DECODE_SAMSUNG_AC
+  {kDecodeStepSamsungAC, SAMSUNG_AC, kSamsungAcHdrMark, kSamsungAcHdrSpace,
+   2 * kSamsungAcBits, kTolerance},
+#endif  // DECODE_SAMSUNG_AC
+#if DECODE_ELECTRA_AC
+  {kDecodeStepElectraAC, ELECTRA_AC, kElectraAcHdrMark, kElectraAcHdrSpace,
+   2 * kElectraAcBits, kTolerance},
+#endif  // DECODE_ELECTRA_AC
+#if DECODE_PANASONIC_AC
+  {kDecodeStepPanasonicAC, PANASONIC_AC, kPanasonicHdrMark, kPanasonicHdrSpace,
+   2 * kPanasonicAcBits, 40},
+#endif  // DECODE_PANASONIC_AC
+#if DECODE_PANASONIC_AC
+  {kDecodeStepPanasonicACShort, PANASONIC_AC, kPanasonicHdrMark,
+   kPanasonicHdrSpace,
+   2 * kPanasonicAcShortBits, 40},
+#endif  // DECODE_PANASONIC_AC
+#if DECODE_LUTRON
+  {kDecodeStepLutron, LUTRON, 0, 0, 0, kTolerance},
+#endif  // DECODE_LUTRON
+#if DECODE_MWM
+  {kDecodeStepMWM, MWM, 0, 0, 0, kTolerance},
+#endif  // DECODE_MWM
+#if DECODE_VESTEL_AC
+  {kDecodeStepVestelAc, VESTEL_AC, kVestelAcHdrMark, kVestelAcHdrSpace,
+   2 * kVestelAcBits, 30},
+#endif  // DECODE_VESTEL_AC
+#if DECODE_TCL112AC
+  {kDecodeStepTcl112Ac, TCL112AC, kTcl112AcHdrMark, kTcl112AcHdrSpace,
+   2 * kTcl112AcBits, 30},
+#endif  // DECODE_TCL112AC
+#if DECODE_TECO
+  {kDecodeStepTeco, TECO, kTecoHdrMark, kTecoHdrSpace, 2 * kTecoBits,
+   kTolerance},
+#endif  // DECODE_TECO
+#if DECODE_LEGOPF
+  {kDecodeStepLegoPf, LEGOPF, kLegoPfBitMark, kLegoPfHdrSpace,
+   2 * kLegoPfBits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_LEGOPF
+#if DECODE_MITSUBISHIHEAVY
+  {kDecodeStepMitsubishiHeavy152, MITSUBISHI_HEAVY_152, kMitsubishiHeavyHdrMark,
+   kMitsubishiHeavyHdrSpace,
+   2 * kMitsubishiHeavy152Bits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_MITSUBISHIHEAVY
+#if DECODE_MITSUBISHIHEAVY
+  {kDecodeStepMitsubishiHeavy88, MITSUBISHI_HEAVY_88, kMitsubishiHeavyHdrMark,
+   kMitsubishiHeavyHdrSpace,
+   2 * kMitsubishiHeavy88Bits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_MITSUBISHIHEAVY
+#if DECODE_ARGO
+  {kDecodeStepArgo, ARGO, kArgoHdrMark, kArgoHdrSpace, 2 * kArgoBits,
+   kTolerance},
+#endif  // DECODE_ARGO
+#if DECODE_SHARP_AC
+  {kDecodeStepSharpAc, SHARP_AC, kSharpAcHdrMark, kSharpAcHdrSpace,
+   2 * kSharpAcBits + kHeader + kFooter - 1, kTolerance},
+#endif  // DECODE_SHARP_AC
+#if DECODE_GOODWEATHER
+  {kDecodeStepGoodweather, GOODWEATHER, kGoodweatherHdrMark,
+   kGoodweatherHdrSpace,
+   2 * (2 * kGoodweatherBits) + kHeader + 2 * kFooter - 1, kTolerance},
+#endif  // DECODE_GOODWEATHER
+#if DECODE_INAX
+  {kDecodeStepInax, INAX, kInaxHdrMark, kInaxHdrSpace, 2 * kInaxBits,
+   kTolerance},
+#endif  // DECODE_INAX
+#if DECODE_TROTEC
+  {kDecodeStepTrotec, TROTEC, kTrotecHdrMark, kTrotecHdrSpace,
+   2 * kTrotecBits + kHeader + 2 * kFooter - 1, kTolerance},
+#endif  // DECODE_TROTEC
+#if DECODE_DAIKIN160
+  {kDecodeStepDaikin160, DAIKIN160, kDaikin160HdrMark, kDaikin160HdrSpace,
+   2 * kDaikin160Bits, kTolerance},
+#endif  // DECODE_DAIKIN160
+#if DECODE_NEOCLIMA
+  {kDecodeStepNeoclima, NEOCLIMA, kNeoclimaHdrMark, kNeoclimaHdrSpace,
+   2 * kNeoclimaBits, kTolerance},
+#endif  // DECODE_NEOCLIMA
+  {kDecodeStepEnd, UNKNOWN, 0, 0, 0, 0}  // Must be last.
+};
+const uint8_t kDecodeStepsLength =
+    sizeof(kDecodeSteps) / sizeof(kDecodeSteps[0]) - 1;
+// The candidate list for each bucket is stored as a bit mask.
+static_assert(kDecodeStepsLength <= 64,
+              "Too many decode steps to fit in the dispatch bit mask.");
+
+// The protocols decodeStream() follows while they are still being captured.
+// Indexed the same as stream_state_t's decoders[]. See streamStep().
+const decode_type_t kStreamProtocols[kStreamDecoders] = {NEC, SONY, RC5};
+
+// Extra percentage added to each decoder's tolerance when bucketing, so the
+// dispatch table never rules out a message the decoder itself would accept.
+const uint8_t kDispatchSlack = 10;
+const uint16_t kDispatchBucketWidth = 256;  // uSeconds per bucket.
+// Anything longer than the last bucket's start is put in the last bucket.
+const uint8_t kDispatchBuckets = 64;
+
+// Which kDecodeSteps[] are candidates for a given first mark duration bucket.
+// It is shared by every IRrecv, & built by the first one constructed.
+static uint64_t decode_dispatch[kDispatchBuckets];
+
+// Calculate the lower bound (in uSeconds) of a dispatch window.
+static uint32_t dispatchLow(const uint16_t usecs, const uint8_t tolerance) {
+  int32_t low = (int32_t)usecs * (100 - tolerance - kDispatchSlack) / 100 -
+      kMarkExcess;
+  return (uint32_t)std::max(low, (int32_t)0);
+}
+
+// Calculate the upper bound (in uSeconds) of a dispatch window.
+static uint32_t dispatchHigh(const uint16_t usecs, const uint8_t tolerance) {
+  return (uint32_t)usecs * (100 + tolerance + kDispatchSlack) / 100 +
+      kMarkExcess + 1;
+}
+
+// Is a duration (in uSeconds) inside the dispatch window of an expected value?
+static bool inDispatchWindow(const uint32_t measured, const uint16_t desired,
+                             const uint8_t tolerance) {
+  return (measured >= dispatchLow(desired, tolerance) &&
+          measured <= dispatchHigh(desired, tolerance));
+}
+
+// Which dispatch bucket does a duration (in uSeconds) fall in?
+static uint8_t dispatchBucket(const uint32_t usecs) {
+  return std::min(usecs / kDispatchBucketWidth,
+                  (uint32_t)(kDispatchBuckets - 1));
+}
+
+// Build the first mark -> candidate decode steps lookup table.
+// Returns: true, once it is built.
+static bool buildDecodeDispatch(void) {
+  for (uint8_t bucket = 0; bucket < kDispatchBuckets; bucket++)
+    decode_dispatch[bucket] = 0;
+  for (uint8_t i = 0; i < kDecodeStepsLength; i++) {
+    uint8_t first = 0;
+    uint8_t last = kDispatchBuckets - 1;
+    if (kDecodeSteps[i].hdrmark) {  // Restricted to a range of buckets?
+      first = dispatchBucket(dispatchLow(kDecodeSteps[i].hdrmark,
+                                         kDecodeSteps[i].tolerance));
+      last = dispatchBucket(dispatchHigh(kDecodeSteps[i].hdrmark,
+                                         kDecodeSteps[i].tolerance));
+    }
+    for (uint8_t bucket = first; bucket <= last; bucket++)
+      decode_dispatch[bucket] |= (1ULL << i);
+  }
+  return true;
+}
+
 // Start of IRrecv class -------------------
 
 // Class constructor
@@ -135,26 +707,52 @@ static void USE_IRAM_ATTR gpio_intr() {
 //   timeout: Nr. of milli-Seconds of no signal before we stop capturing data.
 //            (Default: kTimeoutMs)
 //   save_buffer: Use a second (save) buffer to decode from. (Default: false)
+//                Ignored if slots > 1, as nothing needs to be copied.
 //   timer_num: Which ESP32 timer number to use? ESP32 only, otherwise unused.
 //              (Range: 0-3. Default: kDefaultESP32Timer)
+//              Receivers that capture at the same time need different ones.
+//   slots: Nr. of capture buffers (each of bufsize entries) to capture into in
+//          turn. With more than one, decode() works directly on a completed
+//          buffer while the next message is being captured into another.
+//          (Default: kDefaultCaptureSlots. i.e. 1, a single buffer.)
 // Returns:
 //   An IRrecv class object.
 #if defined(ESP32)
 IRrecv::IRrecv(const uint16_t recvpin, const uint16_t bufsize,
                const uint8_t timeout, const bool save_buffer,
-               const uint8_t timer_num) {
+               const uint8_t timer_num, const uint8_t slots) {
   // There are only 4 timers. 0 to 3.
   _timer_num = std::min(timer_num, (uint8_t)3);
 #else  // ESP32
 IRrecv::IRrecv(const uint16_t recvpin, const uint16_t bufsize,
-               const uint8_t timeout, const bool save_buffer) {
+               const uint8_t timeout, const bool save_buffer,
+               const uint8_t slots) {
+  _timer_num = 0;  // Unused.
 #endif  // ESP32
   irparams.recvpin = recvpin;
   irparams.bufsize = bufsize;
   // Ensure we are going to be able to store all possible values in the
   // capture buffer.
   irparams.timeout = std::min(timeout, (uint8_t)kMaxTimeoutMs);
-  irparams.rawbuf = new uint16_t[bufsize];
+  irparams.start = 0;
+  capture_reset(&irparams);
+  ircapture.slots = std::max(slots, (uint8_t)1);
+  ircapture.first = 0;
+  ircapture.completed = 0;
+  ircapture.held = false;
+  ircapture.dropped = 0;
+  if (ircapture.slots > 1) {
+    // One block of memory for all of the slots' capture buffers.
+    ircapture.buffers = new uint16_t*[ircapture.slots];
+    ircapture.buffers[0] = new uint16_t[bufsize * ircapture.slots];
+    for (uint8_t i = 1; i < ircapture.slots; i++)
+      ircapture.buffers[i] = ircapture.buffers[0] + i * bufsize;
+    ircapture.rawlens = new uint16_t[ircapture.slots];
+    ircapture.overflows = new bool[ircapture.slots];
+    irparams.rawbuf = ircapture.buffers[0];
+  } else {
+    irparams.rawbuf = new uint16_t[bufsize];
+  }
   if (irparams.rawbuf == NULL) {
     DPRINTLN(
         "Could not allocate memory for the primary IR buffer.\n"
@@ -164,7 +762,7 @@ IRrecv::IRrecv(const uint16_t recvpin, const uint16_t bufsize,
 #endif
   }
   // If we have been asked to use a save buffer (for decoding), then create one.
-  if (save_buffer) {
+  if (save_buffer && ircapture.slots == 1) {
     irparams_save = new irparams_t;
     irparams_save->rawbuf = new uint16_t[bufsize];
     // Check we allocated the memory successfully.
@@ -179,21 +777,47 @@ IRrecv::IRrecv(const uint16_t recvpin, const uint16_t bufsize,
   } else {
     irparams_save = NULL;
   }
-#if DECODE_HASH
-  _unknown_threshold = kUnknownThreshold;
-#endif  // DECODE_HASH
+  _options.timeout = irparams.timeout;
+  _options.unknown_threshold = kUnknownThreshold;
+  _options.header_dispatch = true;
+  // Built only once, even if receivers are being created on several threads.
+  static const bool decode_dispatch_ready = buildDecodeDispatch();
+  (void)decode_dispatch_ready;
+  enableAllProtocols();
+  _stream.rawbuf = irparams.rawbuf;
+  streamReset();
+#if DECODE_STATS
+  resetDecodeStats();
+#endif  // DECODE_STATS
 }
 
 // Class destructor
 IRrecv::~IRrecv(void) {
-  delete[] irparams.rawbuf;
+#if defined(ESP32)
+  // The timer is only ours to end if no other receiver has taken it over.
+  isr_context_t *context = &isr_contexts[_timer_num];
+  const bool own_timer = context->params == NULL ||
+                         context->params == &irparams;
+#endif  // ESP32
+  disableIRIn();  // Stop the interrupt handlers using our capture buffers.
+  if (ircapture.slots > 1) {
+    delete[] ircapture.buffers[0];
+    delete[] ircapture.buffers;
+    delete[] ircapture.rawlens;
+    delete[] ircapture.overflows;
+  } else {
+    delete[] irparams.rawbuf;
+  }
   if (irparams_save != NULL) {
     delete[] irparams_save->rawbuf;
     delete irparams_save;
   }
-  disableIRIn();
 #if defined(ESP32)
-  if (timer != NULL) timerEnd(timer);  // Cleanup the ESP32 timeout timer.
+  // Cleanup the ESP32 timeout timer.
+  if (own_timer && context->timer != NULL) {
+    timerEnd(context->timer);
+    context->timer = NULL;
+  }
 #endif  // ESP32
 }
 
@@ -202,6 +826,10 @@ IRrecv::~IRrecv(void) {
 // Args:
 //   pullup: A flag indicating should the GPIO use the internal pullup resistor.
 //           (Default: `false`. i.e. No.)
+// Note:
+//   Only one receiver at a time can capture with the same interrupt handlers.
+//   i.e. One per ESP8266, or one per timer_num on an ESP32. Any other receiver
+//   using them stops capturing, as if disableIRIn() had been called on it.
 void IRrecv::enableIRIn(const bool pullup) {
   // ESP32's seem to require explicitly setting the GPIO to INPUT etc.
   // This wasn't required on the ESP8266s, but it shouldn't hurt to make sure.
@@ -213,15 +841,26 @@ void IRrecv::enableIRIn(const bool pullup) {
 #endif  // UNIT_TEST
   }
 #if defined(ESP32)
+  isr_context_t *context = &isr_contexts[_timer_num];
   // Initialize the ESP32 timer.
-  timer = timerBegin(_timer_num, 80, true);  // 80MHz / 80 = 1 uSec granularity.
+  // 80MHz / 80 = 1 uSec granularity.
+  context->timer = timerBegin(_timer_num, 80, true);
   // Set the timer so it only fires once, and set it's trigger in uSeconds.
-  timerAlarmWrite(timer, MS_TO_USEC(irparams.timeout), ONCE);
+  timerAlarmWrite(context->timer, MS_TO_USEC(irparams.timeout), ONCE);
   // Note: Interrupt needs to be attached before it can be enabled or disabled.
-  timerAttachInterrupt(timer, &read_timeout, true);
+  timerAttachInterrupt(context->timer, read_timeouts[_timer_num], true);
 #endif  // ESP32
 
   // Initialize state machine variables
+  if (ircapture.slots > 1) {
+    capture_lock();
+    ircapture.first = 0;
+    ircapture.completed = 0;
+    ircapture.held = false;
+    irparams.rawbuf = ircapture.buffers[0];
+    capture_reset(&irparams);
+    capture_unlock();
+  }
   resume();
 
 #ifndef UNIT_TEST
@@ -231,29 +870,62 @@ void IRrecv::enableIRIn(const bool pullup) {
   os_timer_setfn(&timer, reinterpret_cast<os_timer_func_t *>(read_timeout),
                  NULL);
 #endif  // ESP8266
+  // Take the handlers over from any other receiver, so its GPIO no longer
+  // feeds our capture.
+  volatile irparams_t *previous = isr_contexts[_timer_num].params;
+  if (previous != NULL && previous != &irparams)
+    detachInterrupt(previous->recvpin);
+  // Capture for this receiver.
+  isr_contexts[_timer_num].params = &irparams;
+  isr_contexts[_timer_num].ring = &ircapture;
   // Attach Interrupt
+#if defined(ESP32)
+  attachInterruptArg(irparams.recvpin, gpio_intr, &isr_contexts[_timer_num],
+                     CHANGE);
+#else  // ESP32
   attachInterrupt(irparams.recvpin, gpio_intr, CHANGE);
+#endif  // ESP32
 #endif  // UNIT_TEST
 }
 
 void IRrecv::disableIRIn(void) {
 #ifndef UNIT_TEST
+  isr_context_t *context = &isr_contexts[_timer_num];
+  // Stop capturing for this receiver, unless another one has since taken the
+  // handlers over. (Possibly on the same GPIO.)
+  if (context->params == &irparams) {
+    detachInterrupt(irparams.recvpin);
 #if defined(ESP8266)
-  os_timer_disarm(&timer);
+    os_timer_disarm(&timer);
 #endif  // ESP8266
 #if defined(ESP32)
-  timerAlarmDisable(timer);
+    timerAlarmDisable(context->timer);
 #endif  // ESP32
-  detachInterrupt(irparams.recvpin);
+    context->params = NULL;
+    context->ring = NULL;
+  }
 #endif  // UNIT_TEST
 }
 
+// Resume capturing IR messages.
+// When using more than one capture slot, capturing never stops, so this just
+// hands back the slot used by the last decode() so it can be captured into.
 void IRrecv::resume(void) {
-  irparams.rcvstate = kIdleState;
-  irparams.rawlen = 0;
-  irparams.overflow = false;
+  if (ircapture.slots > 1) {
+    capture_lock();
+    if (ircapture.held) {
+      ircapture.held = false;
+      ircapture.completed--;
+      if (++ircapture.first >= ircapture.slots) ircapture.first = 0;
+    }
+    capture_unlock();
+    return;
+  }
+  capture_reset(&irparams);
+  streamReset();
 #if defined(ESP32)
-  timerAlarmDisable(timer);
+  if (isr_contexts[_timer_num].timer != NULL)
+    timerAlarmDisable(isr_contexts[_timer_num].timer);
 #endif  // ESP32
 }
 
@@ -290,397 +962,875 @@ void IRrecv::copyIrParams(volatile irparams_t *src, irparams_t *dst) {
 // i.e. It's size.
 uint16_t IRrecv::getBufSize(void) { return irparams.bufsize; }
 
+// Obtain the number of capture buffers (slots) being captured into.
+uint8_t IRrecv::getCaptureSlots(void) { return ircapture.slots; }
+
+// Obtain the number of messages lost because every capture slot was in use.
+// i.e. decode() wasn't called often enough to keep up with the messages.
+uint32_t IRrecv::getDroppedFrames(void) { return ircapture.dropped; }
+
+// Take a look at the capture while it is still in progress.
+// e.g. To follow (or forward) a message as it arrives, rather than waiting for
+// it to end. Entries below `rawlen` won't change until the capture is resumed.
+//
+// Args:
+//   progress: A pointer to where the snapshot will be stored.
+void IRrecv::getCaptureProgress(capture_progress_t *progress) {
+#ifndef UNIT_TEST
+  uint32_t now = micros();
+#else  // UNIT_TEST
+  uint32_t now = _IRtimer_unittest_now;
+#endif  // UNIT_TEST
+  capture_lock();
+  progress->rawbuf = irparams.rawbuf;
+  progress->rawlen = irparams.rawlen;
+  progress->since_edge = now - irparams.start;  // Unsigned, so wraps safely.
+  progress->ended = captureEnded();
+  capture_unlock();
+}
+
+// Point the results at the oldest completed capture slot, if there is one.
+// The slot is then ours (the interrupt handler won't touch it) until the next
+// call to decode() or resume().
+//
+// Args:
+//   results: A pointer to where the captured message will be referenced.
+// Returns:
+//   A boolean indicating if there was a completed message to decode.
+bool IRrecv::nextCapture(decode_results *results) {
+  resume();  // Hand back the slot we were previously using, if any.
+  capture_lock();
+  // If the interrupt handler has stopped capturing without moving on to a new
+  // slot (e.g. It overflowed), complete it ourselves.
+  if (irparams.rcvstate == kStopState)
+    capture_complete(&irparams, &ircapture);
+  bool found = ircapture.completed > 0;
+  if (found) {
+    ircapture.held = true;
+    results->rawbuf = ircapture.buffers[ircapture.first];
+    results->rawlen = ircapture.rawlens[ircapture.first];
+    results->overflow = ircapture.overflows[ircapture.first];
+  }
+  capture_unlock();
+  // Clear the junk entry at the end of the capture. See decode().
+  if (found && results->rawlen < irparams.bufsize)
+    results->rawbuf[results->rawlen] = 0;
+  return found;
+}
+
 #if DECODE_HASH
 // Set the minimum length we will consider for reporting UNKNOWN message types.
 void IRrecv::setUnknownThreshold(const uint16_t length) {
-  _unknown_threshold = length;
+  _options.unknown_threshold = length;
 }
 #endif  // DECODE_HASH
 
-// Decodes the received IR message.
-// If the interrupt state is saved, we will immediately resume waiting
-// for the next IR message to avoid missing messages.
-// Note: There is a trade-off here. Saving the state means less time lost until
-// we can receiving the next message vs. using more RAM. Choose appropriately.
+// Control if decode() uses the captured header to pick which protocol decoders
+// to attempt, or if it falls back to trying every one of them in turn.
 //
 // Args:
-//   results:  A pointer to where the decoded IR message will be stored.
-//   save:  A pointer to an irparams_t instance in which to save
-//          the interrupt's memory/state. NULL means don't save it.
+//   enable: true (default) to use the header dispatch table, false to always
+//           run the full decoder chain.
+void IRrecv::setHeaderDispatch(const bool enable) {
+  _options.header_dispatch = enable;
+}
+
+// Is decode() using the header dispatch table?
+bool IRrecv::getHeaderDispatch(void) { return _options.header_dispatch; }
+
+// Obtain all the settings decodeCapture() uses, in one go.
+// e.g. To copy them to another receiver.
+//
+// Args:
+//   options: Where to store them.
+void IRrecv::getDecodeOptions(decode_options_t *options) {
+  *options = _options;
+}
+
+// Change all the settings decodeCapture() uses, in one go.
+// N.B. The timeout only changes how messages are decoded. It doesn't change
+//      how long the receiver waits before it stops capturing a message.
+//
+// Args:
+//   options: The settings to use from now on.
+void IRrecv::setDecodeOptions(const decode_options_t *options) {
+  _options = *options;
+  _options.timeout = std::min(_options.timeout, (uint8_t)kMaxTimeoutMs);
+  updateEnabledSteps();
+}
+
+// Allow decode() to attempt to decode the given protocol.
+// Only protocols enabled at compile time (i.e. DECODE_XXX) can be decoded.
+//
+// Args:
+//   protocol: The decode_type_t of the protocol to enable.
+void IRrecv::enableProtocol(const decode_type_t protocol) {
+  if (protocol <= UNUSED || protocol > kLastDecodeType) return;
+  _options.protocol_mask[protocol / 8] |= (1 << (protocol % 8));
+  updateEnabledSteps();
+}
+
+// Stop decode() from attempting to decode the given protocol.
+//
+// Args:
+//   protocol: The decode_type_t of the protocol to disable.
+void IRrecv::disableProtocol(const decode_type_t protocol) {
+  if (protocol <= UNUSED || protocol > kLastDecodeType) return;
+  _options.protocol_mask[protocol / 8] &= ~(1 << (protocol % 8));
+  updateEnabledSteps();
+}
+
+// Allow decode() to attempt every protocol. (Default)
+void IRrecv::enableAllProtocols(void) {
+  for (uint8_t i = 0; i < kProtocolMaskSize; i++)
+    _options.protocol_mask[i] = 0xFF;
+  updateEnabledSteps();
+}
+
+// Stop decode() from attempting any protocol. Only UNKNOWN will be reported.
+void IRrecv::disableAllProtocols(void) {
+  for (uint8_t i = 0; i < kProtocolMaskSize; i++) _options.protocol_mask[i] = 0;
+  updateEnabledSteps();
+}
+
+// Is decode() allowed to attempt to decode the given protocol?
+//
+// Args:
+//   protocol: The decode_type_t of the protocol to check.
 // Returns:
-//   A boolean indicating if an IR message is ready or not.
-bool IRrecv::decode(decode_results *results, irparams_t *save) {
-  // Proceed only if an IR message been received.
-#ifndef UNIT_TEST
-  if (irparams.rcvstate != kStopState) return false;
-#endif
+//   A boolean indicating if the protocol is enabled.
+bool IRrecv::isProtocolEnabled(const decode_type_t protocol) {
+  if (protocol <= UNUSED || protocol > kLastDecodeType) return false;
+  return _options.protocol_mask[protocol / 8] & (1 << (protocol % 8));
+}
 
-  // Clear the entry we are currently pointing to when we got the timeout.
-  // i.e. Stopped collecting IR data.
-  // It's junk as we never wrote an entry to it and can only confuse decoding.
-  // This is done here rather than logically the best place in read_timeout()
-  // as it saves a few bytes of ICACHE_RAM as that routine is bound to an
-  // interrupt. decode() is not stored in ICACHE_RAM.
-  // Another better option would be to zero the entire irparams.rawbuf[] on
-  // resume() but that is a much more expensive operation compare to this.
-  irparams.rawbuf[irparams.rawlen] = 0;
+// Set which protocols decode() may attempt, all in one go.
+//
+// Args:
+//   mask: An array of kProtocolMaskSize bytes. Bit `protocol % 8` of byte
+//         `protocol / 8` indicates if that decode_type_t is enabled.
+void IRrecv::setProtocolMask(const uint8_t mask[]) {
+  for (uint8_t i = 0; i < kProtocolMaskSize; i++)
+    _options.protocol_mask[i] = mask[i];
+  updateEnabledSteps();
+}
 
-  bool resumed = false;  // Flag indicating if we have resumed.
+// Get which protocols decode() may attempt. See setProtocolMask().
+//
+// Args:
+//   mask: An array of kProtocolMaskSize bytes to store the mask in.
+void IRrecv::getProtocolMask(uint8_t mask[]) {
+  for (uint8_t i = 0; i < kProtocolMaskSize; i++)
+    mask[i] = _options.protocol_mask[i];
+}
 
-  // If we were requested to use a save buffer previously, do so.
-  if (save == NULL) save = irparams_save;
+#if DECODE_STATS
+// Get a snapshot of the decode statistics collected so far.
+//
+// Args:
+//   stats: A pointer to where to store the snapshot.
+void IRrecv::getDecodeStats(decode_stats_t *stats) { *stats = _stats; }
 
-  if (save == NULL) {
-    // We haven't been asked to copy it so use the existing memory.
-#ifndef UNIT_TEST
-    results->rawbuf = irparams.rawbuf;
-    results->rawlen = irparams.rawlen;
-    results->overflow = irparams.overflow;
-#endif
-  } else {
-    copyIrParams(&irparams, save);  // Duplicate the interrupt's memory.
-    resume();  // It's now safe to rearm. The IR message won't be overridden.
-    resumed = true;
-    // Point the results at the saved copy.
-    results->rawbuf = save->rawbuf;
-    results->rawlen = save->rawlen;
-    results->overflow = save->overflow;
+// Clear all of the decode statistics collected so far.
+void IRrecv::resetDecodeStats(void) {
+  _stats.messages = 0;
+  _stats.overflows = 0;
+  _stats.timeouts = 0;
+  for (uint8_t i = 0; i < kLastDecodeType + 2; i++) {
+    _stats.protocols[i].attempts = 0;
+    _stats.protocols[i].hits = 0;
+    _stats.protocols[i].total_usecs = 0;
+    _stats.protocols[i].max_usecs = 0;
   }
+}
 
-  // Reset any previously partially processed results.
-  results->decode_type = UNKNOWN;
-  results->bits = 0;
-  results->value = 0;
-  results->address = 0;
-  results->command = 0;
-  results->repeat = false;
+// Record an attempt at decoding a protocol in the decode statistics.
+//
+// Args:
+//   protocol: The decode_type_t that was attempted.
+//   success: Was the attempt successful?
+//   usecs: How long the attempt took, in uSeconds.
+void IRrecv::updateDecodeStats(const decode_type_t protocol,
+                               const bool success, const uint32_t usecs) {
+  decode_protocol_stats_t *stat = &_stats.protocols[protocol + 1];
+  stat->attempts++;
+  if (success) stat->hits++;
+  stat->total_usecs += usecs;
+  stat->max_usecs = std::max(stat->max_usecs, usecs);
+}
+#endif  // DECODE_STATS
+
+// Work out which of the kDecodeSteps[] decode() should attempt, based on which
+// protocols are enabled.
+void IRrecv::updateEnabledSteps(void) {
+  _enabled_steps = 0;
+  for (uint8_t i = 0; i < kDecodeStepsLength; i++) {
+    bool enabled = isProtocolEnabled(kDecodeSteps[i].type);
+    // Some decoders can also report a variant of their protocol.
+    switch (kDecodeSteps[i].type) {
+      case LG:
+        enabled |= isProtocolEnabled(LG2);
+        break;
+      case RC5:
+        enabled |= isProtocolEnabled(RC5X);
+        break;
+      default:
+        break;
+    }
+    if (enabled) _enabled_steps |= (1ULL << i);
+  }
+}
 
+// Attempt a single step of the decoder chain. See kDecodeSteps[].
+//
+// Args:
+//   step: The decode_step_id_t to attempt.
+//   results: A pointer to where the decoded IR message will be stored.
+// Returns:
+//   A boolean indicating if the step successfully decoded the message.
+bool IRrecv::decodeStep(const uint8_t step, decode_results *results) {
+  switch (step) {
 #if DECODE_AIWA_RC_T501
-  DPRINTLN("Attempting Aiwa RC T501 decode");
-  // Try decodeAiwaRCT501() before decodeSanyoLC7461() & decodeNEC()
-  // because the protocols are similar. This protocol is more specific than
-  // those ones, so should got before them.
-  if (decodeAiwaRCT501(results)) return true;
-#endif
+    case kDecodeStepAiwaRCT501:
+      DPRINTLN("Attempting Aiwa RC T501 decode");
+      return decodeAiwaRCT501(results);
+#endif  // DECODE_AIWA_RC_T501
 #if DECODE_SANYO
-  DPRINTLN("Attempting Sanyo LC7461 decode");
-  // Try decodeSanyoLC7461() before decodeNEC() because the protocols are
-  // similar in timings & structure, but the Sanyo one is much longer than the
-  // NEC protocol (42 vs 32 bits) so this one should be tried first to try to
-  // reduce false detection as a NEC packet.
-  if (decodeSanyoLC7461(results)) return true;
-#endif
+    case kDecodeStepSanyoLC7461:
+      DPRINTLN("Attempting Sanyo LC7461 decode");
+      return decodeSanyoLC7461(results);
+#endif  // DECODE_SANYO
 #if DECODE_CARRIER_AC
-  DPRINTLN("Attempting Carrier AC decode");
-  // Try decodeCarrierAC() before decodeNEC() because the protocols are
-  // similar in timings & structure, but the Carrier one is much longer than the
-  // NEC protocol (3x32 bits vs 1x32 bits) so this one should be tried first to
-  // try to reduce false detection as a NEC packet.
-  if (decodeCarrierAC(results)) return true;
-#endif
+    case kDecodeStepCarrierAC:
+      DPRINTLN("Attempting Carrier AC decode");
+      return decodeCarrierAC(results);
+#endif  // DECODE_CARRIER_AC
 #if DECODE_PIONEER
-  DPRINTLN("Attempting Pioneer decode");
-  // Try decodePioneer() before decodeNEC() because the protocols are
-  // similar in timings & structure, but the Pioneer one is much longer than the
-  // NEC protocol (2x32 bits vs 1x32 bits) so this one should be tried first to
-  // try to reduce false detection as a NEC packet.
-  if (decodePioneer(results)) return true;
-#endif
+    case kDecodeStepPioneer:
+      DPRINTLN("Attempting Pioneer decode");
+      return decodePioneer(results);
+#endif  // DECODE_PIONEER
 #if DECODE_NEC
-  DPRINTLN("Attempting NEC decode");
-  if (decodeNEC(results)) return true;
-#endif
+    case kDecodeStepNEC:
+      DPRINTLN("Attempting NEC decode");
+      return decodeNEC(results);
+#endif  // DECODE_NEC
 #if DECODE_SONY
-  DPRINTLN("Attempting Sony decode");
-  if (decodeSony(results)) return true;
-#endif
+    case kDecodeStepSony:
+      DPRINTLN("Attempting Sony decode");
+      return decodeSony(results);
+#endif  // DECODE_SONY
 #if DECODE_MITSUBISHI
-  DPRINTLN("Attempting Mitsubishi decode");
-  if (decodeMitsubishi(results)) return true;
-#endif
+    case kDecodeStepMitsubishi:
+      DPRINTLN("Attempting Mitsubishi decode");
+      return decodeMitsubishi(results);
+#endif  // DECODE_MITSUBISHI
 #if DECODE_MITSUBISHI_AC
-  DPRINTLN("Attempting Mitsubishi AC decode");
-  if (decodeMitsubishiAC(results)) return true;
-#endif
+    case kDecodeStepMitsubishiAC:
+      DPRINTLN("Attempting Mitsubishi AC decode");
+      return decodeMitsubishiAC(results);
+#endif  // DECODE_MITSUBISHI_AC
 #if DECODE_MITSUBISHI2
-  DPRINTLN("Attempting Mitsubishi2 decode");
-  if (decodeMitsubishi2(results)) return true;
-#endif
+    case kDecodeStepMitsubishi2:
+      DPRINTLN("Attempting Mitsubishi2 decode");
+      return decodeMitsubishi2(results);
+#endif  // DECODE_MITSUBISHI2
 #if DECODE_RC5
-  DPRINTLN("Attempting RC5 decode");
-  if (decodeRC5(results)) return true;
-#endif
+    case kDecodeStepRC5:
+      DPRINTLN("Attempting RC5 decode");
+      return decodeRC5(results);
+#endif  // DECODE_RC5
 #if DECODE_RC6
-  DPRINTLN("Attempting RC6 decode");
-  if (decodeRC6(results)) return true;
-#endif
+    case kDecodeStepRC6:
+      DPRINTLN("Attempting RC6 decode");
+      return decodeRC6(results);
+#endif  // DECODE_RC6
 #if DECODE_RCMM
-  DPRINTLN("Attempting RC-MM decode");
-  if (decodeRCMM(results)) return true;
-#endif
+    case kDecodeStepRCMM:
+      DPRINTLN("Attempting RC-MM decode");
+      return decodeRCMM(results);
+#endif  // DECODE_RCMM
 #if DECODE_FUJITSU_AC
-  // Fujitsu A/C needs to precede Panasonic and Denon as it has a short
-  // message which looks exactly the same as a Panasonic/Denon message.
-  DPRINTLN("Attempting Fujitsu A/C decode");
-  if (decodeFujitsuAC(results)) return true;
-#endif
+    case kDecodeStepFujitsuAC:
+      DPRINTLN("Attempting Fujitsu A/C decode");
+      return decodeFujitsuAC(results);
+#endif  // DECODE_FUJITSU_AC
 #if DECODE_DENON
-  // Denon needs to precede Panasonic as it is a special case of Panasonic.
-  DPRINTLN("Attempting Denon decode");
-  if (decodeDenon(results, kDenon48Bits) || decodeDenon(results, kDenonBits) ||
-      decodeDenon(results, kDenonLegacyBits))
-    return true;
-#endif
+    case kDecodeStepDenon:
+      DPRINTLN("Attempting Denon decode");
+      return (decodeDenon(results, kDenon48Bits) ||
+              decodeDenon(results, kDenonBits) ||
+              decodeDenon(results, kDenonLegacyBits));
+#endif  // DECODE_DENON
 #if DECODE_PANASONIC
-  DPRINTLN("Attempting Panasonic decode");
-  if (decodePanasonic(results)) return true;
-#endif
+    case kDecodeStepPanasonic:
+      DPRINTLN("Attempting Panasonic decode");
+      return decodePanasonic(results);
+#endif  // DECODE_PANASONIC
 #if DECODE_LG
-  DPRINTLN("Attempting LG (28-bit) decode");
-  if (decodeLG(results, kLgBits, true)) return true;
-  DPRINTLN("Attempting LG (32-bit) decode");
-  // LG32 should be tried before Samsung
-  if (decodeLG(results, kLg32Bits, true)) return true;
-#endif
+    case kDecodeStepLG:
+      DPRINTLN("Attempting LG (28-bit) decode");
+      return decodeLG(results, kLgBits, true);
+#endif  // DECODE_LG
+#if DECODE_LG
+    case kDecodeStepLG32:
+      DPRINTLN("Attempting LG (32-bit) decode");
+      return decodeLG(results, kLg32Bits, true);
+#endif  // DECODE_LG
 #if DECODE_GICABLE
-  // Note: Needs to happen before JVC decode, because it looks similar except
-  //       with a required NEC-like repeat code.
-  DPRINTLN("Attempting GICable decode");
-  if (decodeGICable(results)) return true;
-#endif
+    case kDecodeStepGICable:
+      DPRINTLN("Attempting GICable decode");
+      return decodeGICable(results);
+#endif  // DECODE_GICABLE
 #if DECODE_JVC
-  DPRINTLN("Attempting JVC decode");
-  if (decodeJVC(results)) return true;
-#endif
+    case kDecodeStepJVC:
+      DPRINTLN("Attempting JVC decode");
+      return decodeJVC(results);
+#endif  // DECODE_JVC
 #if DECODE_SAMSUNG
-  DPRINTLN("Attempting SAMSUNG decode");
-  if (decodeSAMSUNG(results)) return true;
-#endif
+    case kDecodeStepSAMSUNG:
+      DPRINTLN("Attempting SAMSUNG decode");
+      return decodeSAMSUNG(results);
+#endif  // DECODE_SAMSUNG
 #if DECODE_SAMSUNG36
-  DPRINTLN("Attempting Samsung36 decode");
-  if (decodeSamsung36(results)) return true;
-#endif
+    case kDecodeStepSamsung36:
+      DPRINTLN("Attempting Samsung36 decode");
+      return decodeSamsung36(results);
+#endif  // DECODE_SAMSUNG36
 #if DECODE_WHYNTER
-  DPRINTLN("Attempting Whynter decode");
-  if (decodeWhynter(results)) return true;
-#endif
+    case kDecodeStepWhynter:
+      DPRINTLN("Attempting Whynter decode");
+      return decodeWhynter(results);
+#endif  // DECODE_WHYNTER
 #if DECODE_DISH
-  DPRINTLN("Attempting DISH decode");
-  if (decodeDISH(results)) return true;
-#endif
+    case kDecodeStepDISH:
+      DPRINTLN("Attempting DISH decode");
+      return decodeDISH(results);
+#endif  // DECODE_DISH
 #if DECODE_SHARP
-  DPRINTLN("Attempting Sharp decode");
-  if (decodeSharp(results)) return true;
-#endif
+    case kDecodeStepSharp:
+      DPRINTLN("Attempting Sharp decode");
+      return decodeSharp(results);
+#endif  // DECODE_SHARP
 #if DECODE_COOLIX
-  DPRINTLN("Attempting Coolix decode");
-  if (decodeCOOLIX(results)) return true;
-#endif
+    case kDecodeStepCOOLIX:
+      DPRINTLN("Attempting Coolix decode");
+      return decodeCOOLIX(results);
+#endif  // DECODE_COOLIX
 #if DECODE_NIKAI
-  DPRINTLN("Attempting Nikai decode");
-  if (decodeNikai(results)) return true;
-#endif
+    case kDecodeStepNikai:
+      DPRINTLN("Attempting Nikai decode");
+      return decodeNikai(results);
+#endif  // DECODE_NIKAI
 #if DECODE_KELVINATOR
-  // Kelvinator based-devices use a similar code to Gree ones, to avoid false
-  // matches this needs to happen before decodeGree().
-  DPRINTLN("Attempting Kelvinator decode");
-  if (decodeKelvinator(results)) return true;
-#endif
+    case kDecodeStepKelvinator:
+      DPRINTLN("Attempting Kelvinator decode");
+      return decodeKelvinator(results);
+#endif  // DECODE_KELVINATOR
 #if DECODE_DAIKIN
-  DPRINTLN("Attempting Daikin decode");
-  if (decodeDaikin(results)) return true;
-#endif
+    case kDecodeStepDaikin:
+      DPRINTLN("Attempting Daikin decode");
+      return decodeDaikin(results);
+#endif  // DECODE_DAIKIN
 #if DECODE_DAIKIN2
-  DPRINTLN("Attempting Daikin2 decode");
-  if (decodeDaikin2(results)) return true;
-#endif
+    case kDecodeStepDaikin2:
+      DPRINTLN("Attempting Daikin2 decode");
+      return decodeDaikin2(results);
+#endif  // DECODE_DAIKIN2
 #if DECODE_DAIKIN216
-  DPRINTLN("Attempting Daikin216 decode");
-  if (decodeDaikin216(results)) return true;
-#endif
+    case kDecodeStepDaikin216:
+      DPRINTLN("Attempting Daikin216 decode");
+      return decodeDaikin216(results);
+#endif  // DECODE_DAIKIN216
 #if DECODE_TOSHIBA_AC
-  DPRINTLN("Attempting Toshiba AC decode");
-  if (decodeToshibaAC(results)) return true;
-#endif
+    case kDecodeStepToshibaAC:
+      DPRINTLN("Attempting Toshiba AC decode");
+      return decodeToshibaAC(results);
+#endif  // DECODE_TOSHIBA_AC
 #if DECODE_MIDEA
-  DPRINTLN("Attempting Midea decode");
-  if (decodeMidea(results)) return true;
-#endif
+    case kDecodeStepMidea:
+      DPRINTLN("Attempting Midea decode");
+      return decodeMidea(results);
+#endif  // DECODE_MIDEA
 #if DECODE_MAGIQUEST
-  DPRINTLN("Attempting Magiquest decode");
-  if (decodeMagiQuest(results)) return true;
-#endif
-/* NOTE: Disabled due to poor quality.
-#if DECODE_SANYO
-  // The Sanyo S866500B decoder is very poor quality & depricated.
-  // *IF* you are going to enable it, do it near last to avoid false positive
-  // matches.
-  DPRINTLN("Attempting Sanyo SA8650B decode");
-  if (decodeSanyo(results))
-    return true;
-#endif
-*/
+    case kDecodeStepMagiQuest:
+      DPRINTLN("Attempting Magiquest decode");
+      return decodeMagiQuest(results);
+#endif  // DECODE_MAGIQUEST
 #if DECODE_NEC
-  // Some devices send NEC-like codes that don't follow the true NEC spec.
-  // This should detect those. e.g. Apple TV remote etc.
-  // This needs to be done after all other codes that use strict and some
-  // other protocols that are NEC-like as well, as turning off strict may
-  // cause this to match other valid protocols.
-  DPRINTLN("Attempting NEC (non-strict) decode");
-  if (decodeNEC(results, kNECBits, false)) {
-    results->decode_type = NEC_LIKE;
-    return true;
-  }
-#endif
+    case kDecodeStepNECLike:
+      DPRINTLN("Attempting NEC (non-strict) decode");
+      if (!decodeNEC(results, kNECBits, false)) return false;
+      results->decode_type = NEC_LIKE;
+      return true;
+#endif  // DECODE_NEC
 #if DECODE_LASERTAG
-  DPRINTLN("Attempting Lasertag decode");
-  if (decodeLasertag(results)) return true;
-#endif
+    case kDecodeStepLasertag:
+      DPRINTLN("Attempting Lasertag decode");
+      return decodeLasertag(results);
+#endif  // DECODE_LASERTAG
 #if DECODE_GREE
-  // Gree based-devices use a similar code to Kelvinator ones, to avoid false
-  // matches this needs to happen after decodeKelvinator().
-  DPRINTLN("Attempting Gree decode");
-  if (decodeGree(results)) return true;
-#endif
+    case kDecodeStepGree:
+      DPRINTLN("Attempting Gree decode");
+      return decodeGree(results);
+#endif  // DECODE_GREE
 #if DECODE_HAIER_AC
-  DPRINTLN("Attempting Haier AC decode");
-  if (decodeHaierAC(results)) return true;
-#endif
+    case kDecodeStepHaierAC:
+      DPRINTLN("Attempting Haier AC decode");
+      return decodeHaierAC(results);
+#endif  // DECODE_HAIER_AC
 #if DECODE_HAIER_AC_YRW02
-  DPRINTLN("Attempting Haier AC YR-W02 decode");
-  if (decodeHaierACYRW02(results)) return true;
-#endif
+    case kDecodeStepHaierACYRW02:
+      DPRINTLN("Attempting Haier AC YR-W02 decode");
+      return decodeHaierACYRW02(results);
+#endif  // DECODE_HAIER_AC_YRW02
 #if DECODE_HITACHI_AC2
-  // HitachiAC2 should be checked before HitachiAC
-  DPRINTLN("Attempting Hitachi AC2 decode");
-  if (decodeHitachiAC(results, kHitachiAc2Bits)) return true;
-#endif
+    case kDecodeStepHitachiAC2:
+      DPRINTLN("Attempting Hitachi AC2 decode");
+      return decodeHitachiAC(results, kHitachiAc2Bits);
+#endif  // DECODE_HITACHI_AC2
 #if DECODE_HITACHI_AC
-  DPRINTLN("Attempting Hitachi AC decode");
-  if (decodeHitachiAC(results, kHitachiAcBits)) return true;
-#endif
+    case kDecodeStepHitachiAC:
+      DPRINTLN("Attempting Hitachi AC decode");
+      return decodeHitachiAC(results, kHitachiAcBits);
+#endif  // DECODE_HITACHI_AC
 #if DECODE_HITACHI_AC1
-  DPRINTLN("Attempting Hitachi AC1 decode");
-  if (decodeHitachiAC(results, kHitachiAc1Bits)) return true;
-#endif
+    case kDecodeStepHitachiAC1:
+      DPRINTLN("Attempting Hitachi AC1 decode");
+      return decodeHitachiAC(results, kHitachiAc1Bits);
+#endif  // DECODE_HITACHI_AC1
 #if DECODE_WHIRLPOOL_AC
-  DPRINTLN("Attempting Whirlpool AC decode");
-  if (decodeWhirlpoolAC(results)) return true;
-#endif
+    case kDecodeStepWhirlpoolAC:
+      DPRINTLN("Attempting Whirlpool AC decode");
+      return decodeWhirlpoolAC(results);
+#endif  // DECODE_WHIRLPOOL_AC
 #if DECODE_SAMSUNG_AC
-  DPRINTLN("Attempting Samsung AC (extended) decode");
-  // Check the extended size first, as it should fail fast due to longer length.
-  if (decodeSamsungAC(results, kSamsungAcExtendedBits, false)) return true;
-  // Now check for the more common length.
-  DPRINTLN("Attempting Samsung AC decode");
-  if (decodeSamsungAC(results, kSamsungAcBits)) return true;
-#endif
+    case kDecodeStepSamsungACExtended:
+      DPRINTLN("Attempting Samsung AC (extended) decode");
+      return decodeSamsungAC(results, kSamsungAcExtendedBits, false);
+#endif  // DECODE_SAMSUNG_AC
+#if DECODE_SAMSUNG_AC
+    case kDecodeStepSamsungAC:
+      DPRINTLN("Attempting Samsung AC decode");
+      return decodeSamsungAC(results, kSamsungAcBits);
+#endif  // DECODE_SAMSUNG_AC
 #if DECODE_ELECTRA_AC
-  DPRINTLN("Attempting Electra AC decode");
-  if (decodeElectraAC(results)) return true;
-#endif
+    case kDecodeStepElectraAC:
+      DPRINTLN("Attempting Electra AC decode");
+      return decodeElectraAC(results);
+#endif  // DECODE_ELECTRA_AC
 #if DECODE_PANASONIC_AC
-  DPRINTLN("Attempting Panasonic AC decode");
-  if (decodePanasonicAC(results)) return true;
-  DPRINTLN("Attempting Panasonic AC short decode");
-  if (decodePanasonicAC(results, kPanasonicAcShortBits)) return true;
-#endif
+    case kDecodeStepPanasonicAC:
+      DPRINTLN("Attempting Panasonic AC decode");
+      return decodePanasonicAC(results);
+#endif  // DECODE_PANASONIC_AC
+#if DECODE_PANASONIC_AC
+    case kDecodeStepPanasonicACShort:
+      DPRINTLN("Attempting Panasonic AC short decode");
+      return decodePanasonicAC(results, kPanasonicAcShortBits);
+#endif  // DECODE_PANASONIC_AC
 #if DECODE_LUTRON
-  DPRINTLN("Attempting Lutron decode");
-  if (decodeLutron(results)) return true;
-#endif
+    case kDecodeStepLutron:
+      DPRINTLN("Attempting Lutron decode");
+      return decodeLutron(results);
+#endif  // DECODE_LUTRON
 #if DECODE_MWM
-  DPRINTLN("Attempting MWM decode");
-  if (decodeMWM(results)) return true;
-#endif
+    case kDecodeStepMWM:
+      DPRINTLN("Attempting MWM decode");
+      return decodeMWM(results);
+#endif  // DECODE_MWM
 #if DECODE_VESTEL_AC
-  DPRINTLN("Attempting Vestel AC decode");
-  if (decodeVestelAc(results)) return true;
-#endif
+    case kDecodeStepVestelAc:
+      DPRINTLN("Attempting Vestel AC decode");
+      return decodeVestelAc(results);
+#endif  // DECODE_VESTEL_AC
 #if DECODE_TCL112AC
-  DPRINTLN("Attempting TCL112AC decode");
-  if (decodeTcl112Ac(results)) return true;
-#endif
+    case kDecodeStepTcl112Ac:
+      DPRINTLN("Attempting TCL112AC decode");
+      return decodeTcl112Ac(results);
+#endif  // DECODE_TCL112AC
 #if DECODE_TECO
-  DPRINTLN("Attempting Teco decode");
-  if (decodeTeco(results)) return true;
-#endif
+    case kDecodeStepTeco:
+      DPRINTLN("Attempting Teco decode");
+      return decodeTeco(results);
+#endif  // DECODE_TECO
 #if DECODE_LEGOPF
-  DPRINTLN("Attempting LEGOPF decode");
-  if (decodeLegoPf(results)) return true;
-#endif
+    case kDecodeStepLegoPf:
+      DPRINTLN("Attempting LEGOPF decode");
+      return decodeLegoPf(results);
+#endif  // DECODE_LEGOPF
 #if DECODE_MITSUBISHIHEAVY
-  DPRINTLN("Attempting MITSUBISHIHEAVY (152 bit) decode");
-  if (decodeMitsubishiHeavy(results, kMitsubishiHeavy152Bits)) return true;
-  DPRINTLN("Attempting MITSUBISHIHEAVY (88 bit) decode");
-  if (decodeMitsubishiHeavy(results, kMitsubishiHeavy88Bits)) return true;
-#endif
+    case kDecodeStepMitsubishiHeavy152:
+      DPRINTLN("Attempting MITSUBISHIHEAVY (152 bit) decode");
+      return decodeMitsubishiHeavy(results, kMitsubishiHeavy152Bits);
+#endif  // DECODE_MITSUBISHIHEAVY
+#if DECODE_MITSUBISHIHEAVY
+    case kDecodeStepMitsubishiHeavy88:
+      DPRINTLN("Attempting MITSUBISHIHEAVY (88 bit) decode");
+      return decodeMitsubishiHeavy(results, kMitsubishiHeavy88Bits);
+#endif  // DECODE_MITSUBISHIHEAVY
 #if DECODE_ARGO
-  DPRINTLN("Attempting Argo decode");
-  if (decodeArgo(results)) return true;
+    case kDecodeStepArgo:
+      DPRINTLN("Attempting Argo decode");
+      return decodeArgo(results);
 #endif  // DECODE_ARGO
 #if DECODE_SHARP_AC
-  DPRINTLN("Attempting SHARP_AC decode");
-  if (decodeSharpAc(results)) return true;
-#endif
+    case kDecodeStepSharpAc:
+      DPRINTLN("Attempting SHARP_AC decode");
+      return decodeSharpAc(results);
+#endif  // DECODE_SHARP_AC
 #if DECODE_GOODWEATHER
-  DPRINTLN("Attempting GOODWEATHER decode");
-  if (decodeGoodweather(results)) return true;
+    case kDecodeStepGoodweather:
+      DPRINTLN("Attempting GOODWEATHER decode");
+      return decodeGoodweather(results);
 #endif  // DECODE_GOODWEATHER
 #if DECODE_INAX
-  DPRINTLN("Attempting Inax decode");
-  if (decodeInax(results)) return true;
+    case kDecodeStepInax:
+      DPRINTLN("Attempting Inax decode");
+      return decodeInax(results);
 #endif  // DECODE_INAX
 #if DECODE_TROTEC
-  DPRINTLN("Attempting Trotec decode");
-  if (decodeTrotec(results)) return true;
+    case kDecodeStepTrotec:
+      DPRINTLN("Attempting Trotec decode");
+      return decodeTrotec(results);
 #endif  // DECODE_TROTEC
 #if DECODE_DAIKIN160
-  DPRINTLN("Attempting Daikin160 decode");
-  if (decodeDaikin160(results)) return true;
+    case kDecodeStepDaikin160:
+      DPRINTLN("Attempting Daikin160 decode");
+      return decodeDaikin160(results);
 #endif  // DECODE_DAIKIN160
 #if DECODE_NEOCLIMA
-  DPRINTLN("Attempting Neoclima decode");
-  if (decodeNeoclima(results)) return true;
+    case kDecodeStepNeoclima:
+      DPRINTLN("Attempting Neoclima decode");
+      return decodeNeoclima(results);
 #endif  // DECODE_NEOCLIMA
+    default:
+      return false;
+  }
+}
+
+// Decodes the received IR message.
+// If the interrupt state is saved, we will immediately resume waiting
+// for the next IR message to avoid missing messages.
+// Note: There is a trade-off here. Saving the state means less time lost until
+// we can receiving the next message vs. using more RAM. Choose appropriately.
+//
+// Args:
+//   results:  A pointer to where the decoded IR message will be stored.
+//   save:  A pointer to an irparams_t instance in which to save
+//          the interrupt's memory/state. NULL means don't save it.
+// Returns:
+//   A boolean indicating if an IR message is ready or not.
+bool IRrecv::decode(decode_results *results, irparams_t *save) {
+  bool resumed = false;  // Flag indicating if we have resumed.
+
+  if (ircapture.slots > 1) {
+    // Decode directly from a completed capture slot. Nothing to copy, and the
+    // interrupt handler is already capturing into another slot.
+    if (!nextCapture(results)) return false;
+    resumed = true;
+  } else {
+    // Proceed only if an IR message been received.
+#ifndef UNIT_TEST
+    if (irparams.rcvstate != kStopState) return false;
+#endif
+
+    // Clear the entry we are currently pointing to when we got the timeout.
+    // i.e. Stopped collecting IR data.
+    // It's junk as we never wrote an entry to it and can only confuse decoding.
+    // This is done here rather than logically the best place in read_timeout()
+    // as it saves a few bytes of ICACHE_RAM as that routine is bound to an
+    // interrupt. decode() is not stored in ICACHE_RAM.
+    // Another better option would be to zero the entire irparams.rawbuf[] on
+    // resume() but that is a much more expensive operation compare to this.
+    irparams.rawbuf[irparams.rawlen] = 0;
+
+    // If we were requested to use a save buffer previously, do so.
+    if (save == NULL) save = irparams_save;
+
+    if (save == NULL) {
+      // We haven't been asked to copy it so use the existing memory.
+#ifndef UNIT_TEST
+      results->rawbuf = irparams.rawbuf;
+      results->rawlen = irparams.rawlen;
+      results->overflow = irparams.overflow;
+#endif
+    } else {
+      copyIrParams(&irparams, save);  // Duplicate the interrupt's memory.
+      resume();  // It's now safe to rearm. The IR message won't be overridden.
+      resumed = true;
+      // Point the results at the saved copy.
+      results->rawbuf = save->rawbuf;
+      results->rawlen = save->rawlen;
+      results->overflow = save->overflow;
+    }
+  }
+
+  if (decodeCapture(results)) return true;
+  // Throw away and start over
+  if (!resumed)  // Check if we have already resumed.
+    resume();
+  return false;
+}
+
+// Decode an already captured message.
+// Only the message in the results, and the decode options of this receiver
+// (see setDecodeOptions()), affect the outcome. It doesn't touch the capture
+// state, so it can be used on messages from anywhere. e.g. A file. Different
+// receivers can decode on different threads at the same time.
+// It isn't pure though. With DECODE_STATS, it updates this receiver's decode
+// stats. So a single receiver mustn't be used on several threads at once.
+//
+// Args:
+//   results: The captured message (rawbuf, rawlen & overflow), and where the
+//            decoded IR message will be stored.
+// Returns:
+//   A boolean indicating if the message was decoded.
+bool IRrecv::decodeCapture(decode_results *results) {
+  // Reset any previously partially processed results.
+  results->decode_type = UNKNOWN;
+  results->bits = 0;
+  results->value = 0;
+  results->address = 0;
+  results->command = 0;
+  results->repeat = false;
+
+#if DECODE_STATS
+  _stats.messages++;
+  if (results->overflow)
+    _stats.overflows++;
+  else
+    _stats.timeouts++;
+#endif  // DECODE_STATS
+
+  // Work out which of the decoders could possibly match what we captured.
+  uint64_t candidates = UINT64_MAX;  // Fallback mode: Try every one of them.
+  uint32_t hdrmark = 0;
+  uint32_t hdrspace = 0;
+  if (_options.header_dispatch) {
+    if (results->rawlen > kStartOffset)
+      hdrmark = results->rawbuf[kStartOffset] * kRawTick;
+    if (results->rawlen > kStartOffset + 1)
+      hdrspace = results->rawbuf[kStartOffset + 1] * kRawTick;
+    candidates = decode_dispatch[dispatchBucket(hdrmark)];
+  }
+  candidates &= _enabled_steps;  // Skip any protocols we've been told to.
+  // Some decoders can report a variant of their protocol (e.g. LG2 or RC5X)
+  // that we've been told to skip. Keep a copy of the results so a match we
+  // reject isn't left in them.
+  const decode_results original = *results;
+  for (uint8_t i = 0; i < kDecodeStepsLength; i++) {
+    if (!((candidates >> i) & 1)) continue;  // Not a candidate.
+    const decode_step_t *step = &kDecodeSteps[i];
+    if (_options.header_dispatch) {
+      if (results->rawlen < step->minrawlen) continue;
+      if (step->hdrmark &&
+          !inDispatchWindow(hdrmark, step->hdrmark, step->tolerance)) continue;
+      if (step->hdrspace && results->rawlen > kStartOffset + 1 &&
+          !inDispatchWindow(hdrspace, step->hdrspace, step->tolerance))
+        continue;
+    }
+#if DECODE_STATS
+    IRtimer attempt;
+#endif  // DECODE_STATS
+    bool success = decodeStep(step->step, results);
+#if DECODE_STATS
+    updateDecodeStats(step->type, success, attempt.elapsed());
+#endif  // DECODE_STATS
+    // Check it's a variant of the protocol we are interested in too.
+    if (success) {
+      if (isProtocolEnabled(results->decode_type)) return true;
+      *results = original;
+    }
+  }
+
 #if DECODE_HASH
   // decodeHash returns a hash on any input.
   // Thus, it needs to be last in the list.
   // If you add any decodes, add them before this.
-  if (decodeHash(results)) {
-    return true;
-  }
+#if DECODE_STATS
+  IRtimer attempt;
+#endif  // DECODE_STATS
+  bool success = decodeHash(results);
+#if DECODE_STATS
+  updateDecodeStats(UNKNOWN, success, attempt.elapsed());
+#endif  // DECODE_STATS
+  if (success) return true;
 #endif  // DECODE_HASH
-  // Throw away and start over
-  if (!resumed)  // Check if we have already resumed.
-    resume();
   return false;
 }
 
-// Calculate the lower bound of the nr. of ticks.
+// Is there a capture that has already ended? e.g. It timed out, overflowed,
+// or is waiting in a completed capture slot.
+bool IRrecv::captureEnded(void) {
+  if (irparams.rcvstate == kStopState) return true;
+  return ircapture.completed > (ircapture.held ? 1 : 0);
+}
+
+// End the capture in progress early, as if it had timed out after `rawlen`
+// entries. Any entries captured after those are discarded.
 //
 // Args:
-//   usecs:  Nr. of uSeconds.
-//   tolerance:  Percent as an integer. e.g. 10 is 10%
-//   delta:  A non-scaling amount to reduce usecs by.
+//   rawbuf: The capture buffer we expect the capture to be in.
+//   rawlen: The nr. of entries to keep.
+// Returns:
+//   A boolean indicating if it was ended. i.e. It was still in progress.
+bool IRrecv::endCapture(volatile uint16_t *rawbuf, const uint16_t rawlen) {
+  capture_lock();
+  bool ended = irparams.rawbuf == rawbuf && irparams.rcvstate != kStopState &&
+               irparams.rawlen >= rawlen;
+  if (ended) {
+    irparams.rawlen = rawlen;
+    if (ircapture.slots > 1)
+      capture_complete(&irparams, &ircapture);
+    else
+      irparams.rcvstate = kStopState;
+  }
+  capture_unlock();
+  return ended;
+}
+
+// Start following a new capture with the streaming decoders.
+void IRrecv::streamReset(void) {
+  _stream.offset = kStartOffset;
+  _stream.quiet.reset();
+  for (uint8_t i = 0; i < kStreamDecoders; i++) {
+    stream_decoder_t *state = &_stream.decoders[i];
+    bool enabled = isProtocolEnabled(kStreamProtocols[i]);
+    if (kStreamProtocols[i] == RC5) enabled |= isProtocolEnabled(RC5X);
+    state->status = enabled ? kStreamMore : kStreamFailed;
+    state->units = 0;
+    state->end = 0;
+    state->holdoff = 0;
+  }
+}
+
+// Feed a capture entry to one of the streaming decoders.
+//
+// Args:
+//   decoder: Which of the kStreamProtocols[] to feed it to.
+//   state: A pointer to that decoder's progress through the capture.
+//   offset: The position of the entry in the capture. Odd ones are marks.
+//   entry: The captured duration, in ticks.
 // Returns:
-//   Nr. of ticks.
-uint32_t IRrecv::ticksLow(uint32_t usecs, uint8_t tolerance, uint16_t delta) {
-  // max() used to ensure the result can't drop below 0 before the cast.
-  return ((uint32_t)std::max(
-      (int32_t)(usecs * (1.0 - tolerance / 100.0) - delta), 0));
+//   The decoder's status. e.g. kStreamMore, kStreamEnd, or kStreamFailed.
+uint8_t IRrecv::streamStep(const uint8_t decoder, stream_decoder_t *state,
+                           const uint16_t offset, const uint16_t entry) {
+  switch (kStreamProtocols[decoder]) {
+#if DECODE_NEC
+    case NEC:
+      return streamNEC(state, offset, entry);
+#endif  // DECODE_NEC
+#if DECODE_SONY
+    case SONY:
+      return streamSony(state, offset, entry);
+#endif  // DECODE_SONY
+#if DECODE_RC5
+    case RC5:
+      return streamRC5(state, offset, entry);
+#endif  // DECODE_RC5
+    default:
+      return kStreamFailed;
+  }
 }
 
-// Calculate the upper bound of the nr. of ticks.
+// Decodes the received IR message as early as we can.
+// Like decode(), but a message in one of the kStreamProtocols[] (NEC, Sony &
+// RC-5) is decoded as soon as its last mark has been captured, rather than
+// after the capture has timed out. Anything else is decoded when the capture
+// times out, as normal. Call this very often. e.g. Every time through loop().
+//
+// Each call looks at the entries captured since the last one, & advances a
+// small state machine per protocol through them. Once one of those has seen
+// the end of a message, the capture is ended there & decode()'ed.
+// If a longer message could carry on from that point (e.g. A 15 bit Sony
+// message after 12 bits, or a 42 bit Sanyo one after a 32 bit NEC one), the
+// message is only ended after a space longer than any it could carry on with.
+// That is less than 2.5 mSecs, instead of the timeout. (kTimeoutMs or more.)
 //
 // Args:
-//   usecs:  Nr. of uSeconds.
-//   tolerance:  Percent as an integer. e.g. 10 is 10%
-//   delta:  A non-scaling amount to increase usecs by.
+//   results:  A pointer to where the decoded IR message will be stored.
+//   save:  A pointer to an irparams_t instance in which to save
+//          the interrupt's memory/state. NULL means don't save it.
 // Returns:
-//   Nr. of ticks.
-uint32_t IRrecv::ticksHigh(uint32_t usecs, uint8_t tolerance, uint16_t delta) {
-  return ((uint32_t)(usecs * (1.0 + tolerance / 100.0)) + 1 + delta);
+//   A boolean indicating if an IR message is ready or not.
+//
+// Note:
+//   Protocols which chain messages like these within the timeout (e.g. Pioneer
+//   & Carrier A/C are two & three NEC-like messages) are ended & reported after
+//   their first message. Use decode(), or disable the protocol concerned
+//   (e.g. NEC), for those.
+bool IRrecv::decodeStream(decode_results *results, irparams_t *save) {
+  if (captureEnded()) {  // Too late to do anything early. Decode it as normal.
+    streamReset();
+    return decode(results, save);
+  }
+  capture_lock();
+  volatile uint16_t *rawbuf = irparams.rawbuf;
+  uint16_t rawlen = irparams.rawlen;
+  capture_unlock();
+  if (rawbuf != _stream.rawbuf || rawlen < _stream.offset) {  // A new capture.
+    _stream.rawbuf = rawbuf;
+    streamReset();
+  }
+
+  uint16_t end = 0;  // The rawlen of the message, once we know it has ended.
+  if (_stream.offset < rawlen) _stream.quiet.reset();
+  for (; !end && _stream.offset < rawlen; _stream.offset++) {
+    uint16_t entry = rawbuf[_stream.offset];
+    for (uint8_t i = 0; i < kStreamDecoders; i++) {
+      stream_decoder_t *state = &_stream.decoders[i];
+      if (state->status == kStreamFailed) continue;
+      // A long enough space after a possible end confirms it.
+      if (state->status == kStreamEnd &&
+          entry * kRawTick > state->holdoff) {
+        end = state->end;
+        break;
+      }
+      state->status = streamStep(i, state, _stream.offset, entry);
+      if (state->status == kStreamEnd) state->end = _stream.offset + 1;
+    }
+  }
+  // So does nothing being captured for long enough after one.
+  for (uint8_t i = 0; !end && i < kStreamDecoders; i++) {
+    stream_decoder_t *state = &_stream.decoders[i];
+    if (state->status == kStreamEnd && state->end == _stream.offset &&
+        _stream.quiet.elapsed() >= state->holdoff)
+      end = state->end;
+  }
+  if (!end || !endCapture(rawbuf, end)) return false;
+  streamReset();
+  if (ircapture.slots == 1) {
+    results->rawbuf = rawbuf;
+    results->rawlen = end;
+    results->overflow = false;
+  }
+  return decode(results, save);
+}
+
+// Calculate the match windows for the bits of a message. See matchData().
+//
+// Args:
+//   onemark:   Nr. of uSeconds in an expected mark signal for a '1' bit.
+//   onespace:  Nr. of uSeconds in an expected space signal for a '1' bit.
+//   zeromark:  Nr. of uSeconds in an expected mark signal for a '0' bit.
+//   zerospace: Nr. of uSeconds in an expected space signal for a '0' bit.
+//   tolerance: Percentage error margin to allow.
+//   excess:  Nr. of useconds.
+// Returns:
+//   A match_bit_windows_t containing the windows for each part of a bit.
+match_bit_windows_t IRrecv::bitWindows(const uint16_t onemark,
+                                       const uint32_t onespace,
+                                       const uint16_t zeromark,
+                                       const uint32_t zerospace,
+                                       const uint8_t tolerance,
+                                       const int16_t excess) {
+  match_bit_windows_t windows;
+  windows.onemark = markWindow(onemark, tolerance, excess);
+  windows.onespace = spaceWindow(onespace, tolerance, excess);
+  windows.zeromark = markWindow(zeromark, tolerance, excess);
+  windows.zerospace = spaceWindow(zerospace, tolerance, excess);
+  return windows;
 }
 
 // Check if we match a pulse(measured) with the desired within
@@ -740,12 +1890,12 @@ bool IRrecv::matchAtLeast(uint32_t measured, uint32_t desired,
   DPRINT(". Matching: ");
   DPRINT(measured);
   DPRINT(" >= ");
-  DPRINT(ticksLow(std::min(desired, MS_TO_USEC(irparams.timeout)), tolerance,
+  DPRINT(ticksLow(std::min(desired, MS_TO_USEC(_options.timeout)), tolerance,
                   delta));
   DPRINT(" [min(");
   DPRINT(ticksLow(desired, tolerance, delta));
   DPRINT(", ");
-  DPRINT(ticksLow(MS_TO_USEC(irparams.timeout), tolerance, delta));
+  DPRINT(ticksLow(MS_TO_USEC(_options.timeout), tolerance, delta));
   DPRINTLN(")]");
 #ifdef UNIT_TEST
   // Sanity checks that we don't have values that cause integer over/underflow.
@@ -761,7 +1911,7 @@ bool IRrecv::matchAtLeast(uint32_t measured, uint32_t desired,
   // We really should never get a value of 0, except as the last value
   // in the buffer. If that is the case, then assume infinity and return true.
   if (measured == 0) return true;
-  return measured >= ticksLow(std::min(desired, MS_TO_USEC(irparams.timeout)),
+  return measured >= ticksLow(std::min(desired, MS_TO_USEC(_options.timeout)),
                               tolerance, delta);
 }
 
@@ -844,7 +1994,7 @@ int16_t IRrecv::compare(uint16_t oldval, uint16_t newval) {
  */
 bool IRrecv::decodeHash(decode_results *results) {
   // Require at least some samples to prevent triggering on noise
-  if (results->rawlen < _unknown_threshold) return false;
+  if (results->rawlen < _options.unknown_threshold) return false;
   int32_t hash = kFnvBasis32;
   // 'rawlen - 2' to avoid the look ahead from going out of bounds.
   // Should probably be -3 to avoid comparing the trailing space entry,
@@ -885,17 +2035,38 @@ match_result_t IRrecv::matchData(
     volatile uint16_t *data_ptr, const uint16_t nbits, const uint16_t onemark,
     const uint32_t onespace, const uint16_t zeromark, const uint32_t zerospace,
     const uint8_t tolerance, const int16_t excess, const bool MSBfirst) {
+  match_bit_windows_t windows = bitWindows(onemark, onespace,
+                                           zeromark, zerospace,
+                                           tolerance, excess);
+  return _matchData(data_ptr, nbits, &windows, MSBfirst);
+}
+
+// Match & decode the typical data section of an IR message, using
+// pre-calculated match windows. See matchData().
+//
+// Args:
+//   data_ptr: A pointer to where we are at in the capture buffer.
+//   nbits:     Nr. of data bits we expect.
+//   windows:   A pointer to the match windows for each part of a bit.
+//   MSBfirst: Bit order to save the data in.
+// Returns:
+//  A match_result_t structure containing the success (or not), the data value,
+//  and how many buffer entries were used.
+match_result_t IRrecv::_matchData(volatile uint16_t *data_ptr,
+                                  const uint16_t nbits,
+                                  const match_bit_windows_t *windows,
+                                  const bool MSBfirst) {
   match_result_t result;
   result.success = false;  // Fail by default.
   result.data = 0;
   for (result.used = 0; result.used < nbits * 2;
        result.used += 2, data_ptr += 2) {
     // Is the bit a '1'?
-    if (matchMark(*data_ptr, onemark, tolerance, excess) &&
-        matchSpace(*(data_ptr + 1), onespace, tolerance, excess)) {
+    if (matchWindowed(*data_ptr, windows->onemark) &&
+        matchWindowed(*(data_ptr + 1), windows->onespace)) {
       result.data = (result.data << 1) | 1;
-    } else if (matchMark(*data_ptr, zeromark, tolerance, excess) &&
-               matchSpace(*(data_ptr + 1), zerospace, tolerance, excess)) {
+    } else if (matchWindowed(*data_ptr, windows->zeromark) &&
+               matchWindowed(*(data_ptr + 1), windows->zerospace)) {
       result.data <<= 1;  // The bit is a '0'.
     } else {
       if (!MSBfirst) result.data = reverseBits(result.data, result.used / 2);
@@ -931,13 +2102,35 @@ uint16_t IRrecv::matchBytes(volatile uint16_t *data_ptr, uint8_t *result_ptr,
                             const uint16_t zeromark, const uint32_t zerospace,
                             const uint8_t tolerance, const int16_t excess,
                             const bool MSBfirst) {
+  match_bit_windows_t windows = bitWindows(onemark, onespace,
+                                           zeromark, zerospace,
+                                           tolerance, excess);
+  return _matchBytes(data_ptr, result_ptr, remaining, nbytes, &windows,
+                     MSBfirst);
+}
+
+// Match & decode the typical data section of an IR message, using
+// pre-calculated match windows. See matchBytes().
+//
+// Args:
+//   data_ptr: A pointer to where we are at in the capture buffer.
+//   result_ptr: A pointer to where to start storing the bytes we decoded.
+//   remaining: The size of the capture buffer are remaining.
+//   nbytes:    Nr. of data bytes we expect.
+//   windows:   A pointer to the match windows for each part of a bit.
+//   MSBfirst: Bit order to save the data in.
+// Returns:
+//  A uint16_t: If successful, how many buffer entries were used. Otherwise 0.
+uint16_t IRrecv::_matchBytes(volatile uint16_t *data_ptr, uint8_t *result_ptr,
+                             const uint16_t remaining, const uint16_t nbytes,
+                             const match_bit_windows_t *windows,
+                             const bool MSBfirst) {
   // Check if there is enough capture buffer to possibly have the desired bytes.
   if (remaining < nbytes * 8 * 2) return 0;  // Nope, so abort.
   uint16_t offset = 0;
   for (uint16_t byte_pos = 0; byte_pos < nbytes; byte_pos++) {
-    match_result_t result = matchData(data_ptr + offset, 8, onemark, onespace,
-                                      zeromark, zerospace, tolerance, excess,
-                                      MSBfirst);
+    match_result_t result = _matchData(data_ptr + offset, 8, windows,
+                                       MSBfirst);
     if (result.success == false) return 0;  // Fail
     result_ptr[byte_pos] = (uint8_t)result.data;
     offset += result.used;
@@ -1012,20 +2205,20 @@ uint16_t IRrecv::_matchGeneric(volatile uint16_t *data_ptr,
     return 0;
 
   // Data
+  match_bit_windows_t windows = bitWindows(onemark, onespace,
+                                           zeromark, zerospace,
+                                           tolerance, excess);
   if (use_bits) {  // Bits.
-    match_result_t result = IRrecv::matchData(data_ptr + offset, nbits,
-                                              onemark, onespace,
-                                              zeromark, zerospace, tolerance,
-                                              excess, MSBfirst);
+    match_result_t result = IRrecv::_matchData(data_ptr + offset, nbits,
+                                               &windows, MSBfirst);
     if (!result.success) return 0;
     *result_bits_ptr = result.data;
     offset += result.used;
   } else {  // bytes
-    uint16_t data_used = IRrecv::matchBytes(data_ptr + offset, result_bytes_ptr,
-                                            remaining - offset, nbits / 8,
-                                            onemark, onespace,
-                                            zeromark, zerospace, tolerance,
-                                            excess, MSBfirst);
+    uint16_t data_used = IRrecv::_matchBytes(data_ptr + offset,
+                                             result_bytes_ptr,
+                                             remaining - offset, nbits / 8,
+                                             &windows, MSBfirst);
     if (!data_used) return 0;
     offset += data_used;
   }
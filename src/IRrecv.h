@@ -13,6 +13,8 @@
 #define __STDC_LIMIT_MACROS
 #include <stdint.h>
 #include "IRremoteESP8266.h"
+#include "IRtimer.h"
+#include "IRtiming.h"
 
 // Constants
 const uint16_t kHeader = 2;        // Usual nr. of header entries.
@@ -54,6 +56,12 @@ const uint32_t kFnvBasis32 = 2166136261UL;
 // Which of the ESP32 timers to use by default. (0-3)
 const uint8_t kDefaultESP32Timer = 3;
 
+// Default nr. of capture buffers (slots) to capture into. 1 = Just the one.
+const uint8_t kDefaultCaptureSlots = 1;
+
+// Nr. of bytes needed for a bit mask of all the decode_type_t protocols.
+const uint8_t kProtocolMaskSize = kLastDecodeType / 8 + 1;
+
 #if DECODE_AC
 // Hitachi AC is the current largest state size.
 const uint16_t kStateSizeMax = kHitachiAc2StateLength;
@@ -75,8 +83,92 @@ typedef struct {
   uint16_t rawlen;   // counter of entries in rawbuf.
   uint8_t overflow;  // Buffer overflow indicator.
   uint8_t timeout;   // Nr. of milliSeconds before we give up.
+  uint32_t start;    // When the previous edge was seen. (uSeconds)
 } irparams_t;
 
+// A ring of capture buffers (slots) the interrupt handler fills in turn.
+typedef struct {
+  uint8_t slots;       // Nr. of slots in the ring.
+  uint8_t first;       // The oldest completed slot.
+  uint8_t completed;   // Nr. of completed slots. Incl. the one being decoded.
+  bool held;           // Is the first completed slot being decoded?
+  uint16_t **buffers;  // The capture buffer for each slot.
+  uint16_t *rawlens;   // The nr. of entries captured in each slot.
+  bool *overflows;     // Did the capture in each slot overflow?
+  uint32_t dropped;    // Nr. of messages lost because every slot was in use.
+} ircapture_ring_t;
+
+// A snapshot of the capture in progress. See IRrecv::getCaptureProgress().
+typedef struct {
+  volatile uint16_t *rawbuf;  // The capture buffer being captured into.
+  uint16_t rawlen;            // Nr. of entries in it so far.
+  uint32_t since_edge;        // uSecs since the last entry ended.
+  bool ended;                 // Is there a capture waiting to be decode()'ed?
+} capture_progress_t;
+
+// Everything, other than the captured message itself, that the result of
+// decoding it depends on. See IRrecv::decodeCapture().
+typedef struct {
+  uint8_t timeout;  // The longest gap the capture could hold. (mSeconds)
+  bool header_dispatch;  // Only try the protocols the header could match?
+  uint16_t unknown_threshold;  // Min. nr. of entries to report as UNKNOWN.
+  uint8_t protocol_mask[kProtocolMaskSize];  // Bit mask of protocols to report.
+} decode_options_t;
+
+// A protocol decoder decode() can try. See kDecodeSteps[] in IRrecv.cpp.
+typedef struct {
+  uint8_t step;          // Which decode_step_id_t to run.
+  decode_type_t type;    // The protocol the step attempts to decode.
+  uint16_t hdrmark;      // The expected first mark in uSeconds. 0 means any.
+  uint16_t hdrspace;     // The expected first space in uSeconds. 0 means any.
+  uint16_t minrawlen;    // The smallest rawlen the decoder could accept.
+  uint8_t tolerance;     // The percentage tolerance the decoder uses.
+} decode_step_t;
+extern const decode_step_t kDecodeSteps[];  // Ends with an UNKNOWN step.
+extern const uint8_t kDecodeStepsLength;    // Excl. that end step.
+
+#if DECODE_STATS
+// Decode statistics for a single protocol.
+typedef struct {
+  uint32_t attempts;     // Nr. of times decode() tried this protocol.
+  uint32_t hits;         // Nr. of times it was successfully decoded.
+  uint32_t total_usecs;  // Cumulative nr. of uSeconds spent trying it.
+  uint32_t max_usecs;    // The longest single attempt, in uSeconds.
+} decode_protocol_stats_t;
+
+// A snapshot of the decode statistics.
+typedef struct {
+  uint32_t messages;   // Nr. of captured messages decode() has processed.
+  uint32_t overflows;  // Nr. of those that overflowed the capture buffer.
+  uint32_t timeouts;   // Nr. of those that ended normally. i.e. Timed out.
+  // Indexed by decode_type_t + 1. i.e. UNKNOWN (decodeHash()) is [0].
+  decode_protocol_stats_t protocols[kLastDecodeType + 2];
+} decode_stats_t;
+#endif  // DECODE_STATS
+
+// Streaming decoders. See IRrecv::decodeStream().
+const uint8_t kStreamDecoders = 3;  // Nr. of protocols followed as captured.
+// The status of a streaming decoder after it has seen a capture entry.
+const uint8_t kStreamMore = 0;    // So far so good. The message isn't over.
+const uint8_t kStreamEnd = 1;     // The message could end with this entry.
+const uint8_t kStreamFailed = 2;  // Not this protocol. Stop following it.
+
+// The progress of a streaming decoder through the capture in progress.
+typedef struct {
+  uint8_t status;    // What it said about the last entry. e.g. kStreamMore.
+  uint16_t units;    // Protocol specific. e.g. Nr. of data bits seen so far.
+  uint16_t end;      // The rawlen the message would have if it ended here.
+  uint32_t holdoff;  // uSecs of space after `end` needed to confirm the end.
+} stream_decoder_t;
+
+// The state of the streaming decoders.
+typedef struct {
+  volatile uint16_t *rawbuf;  // The capture buffer being followed.
+  uint16_t offset;            // The next capture entry to look at.
+  IRtimer quiet;              // Time since a new capture entry was seen.
+  stream_decoder_t decoders[kStreamDecoders];
+} stream_state_t;
+
 // results from a data match
 typedef struct {
   bool success;   // Was the match successful?
@@ -84,6 +176,20 @@ typedef struct {
   uint16_t used;  // How many buffer positions were used.
 } match_result_t;
 
+// The range of raw capture values (ticks) that match an expected duration.
+typedef struct {
+  uint32_t low;   // Smallest matching raw capture value.
+  uint32_t high;  // Largest matching raw capture value.
+} match_window_t;
+
+// Pre-calculated match windows for the data bits of a message.
+typedef struct {
+  match_window_t onemark;
+  match_window_t onespace;
+  match_window_t zeromark;
+  match_window_t zerospace;
+} match_bit_windows_t;
+
 // Classes
 
 // Results returned from the decoder
@@ -115,21 +221,43 @@ class IRrecv {
   explicit IRrecv(const uint16_t recvpin, const uint16_t bufsize = kRawBuf,
                   const uint8_t timeout = kTimeoutMs,
                   const bool save_buffer = false,
-                  const uint8_t timer_num = kDefaultESP32Timer);  // Constructor
+                  const uint8_t timer_num = kDefaultESP32Timer,
+                  const uint8_t slots = kDefaultCaptureSlots);  // Constructor
 #else  // ESP32
   explicit IRrecv(const uint16_t recvpin, const uint16_t bufsize = kRawBuf,
                   const uint8_t timeout = kTimeoutMs,
-                  const bool save_buffer = false);                // Constructor
+                  const bool save_buffer = false,
+                  const uint8_t slots = kDefaultCaptureSlots);  // Constructor
 #endif  // ESP32
   ~IRrecv(void);                                                  // Destructor
   bool decode(decode_results *results, irparams_t *save = NULL);
+  bool decodeStream(decode_results *results, irparams_t *save = NULL);
+  bool decodeCapture(decode_results *results);
+  void getDecodeOptions(decode_options_t *options);
+  void setDecodeOptions(const decode_options_t *options);
   void enableIRIn(const bool pullup = false);
   void disableIRIn(void);
   void resume(void);
   uint16_t getBufSize(void);
+  uint8_t getCaptureSlots(void);
+  uint32_t getDroppedFrames(void);
+  void getCaptureProgress(capture_progress_t *progress);
 #if DECODE_HASH
   void setUnknownThreshold(const uint16_t length);
 #endif
+  void setHeaderDispatch(const bool enable);
+  bool getHeaderDispatch(void);
+  void enableProtocol(const decode_type_t protocol);
+  void disableProtocol(const decode_type_t protocol);
+  void enableAllProtocols(void);
+  void disableAllProtocols(void);
+  bool isProtocolEnabled(const decode_type_t protocol);
+  void setProtocolMask(const uint8_t mask[]);
+  void getProtocolMask(uint8_t mask[]);
+#if DECODE_STATS
+  void getDecodeStats(decode_stats_t *stats);
+  void resetDecodeStats(void);
+#endif  // DECODE_STATS
   static bool match(uint32_t measured, uint32_t desired,
                     uint8_t tolerance = kTolerance, uint16_t delta = 0);
   static bool matchMark(uint32_t measured, uint32_t desired,
@@ -138,22 +266,50 @@ class IRrecv {
   static bool matchSpace(uint32_t measured, uint32_t desired,
                          uint8_t tolerance = kTolerance,
                          int16_t excess = kMarkExcess);
+  static constexpr match_window_t matchWindow(
+      const uint32_t desired, const uint8_t tolerance = kTolerance,
+      const uint16_t delta = 0);
+  static constexpr match_window_t markWindow(
+      const uint32_t desired, const uint8_t tolerance = kTolerance,
+      const int16_t excess = kMarkExcess);
+  static constexpr match_window_t spaceWindow(
+      const uint32_t desired, const uint8_t tolerance = kTolerance,
+      const int16_t excess = kMarkExcess);
+  static constexpr bool matchWindowed(const uint32_t measured,
+                                      const match_window_t window);
 #ifndef UNIT_TEST
 
  private:
 #endif
-  irparams_t *irparams_save;
+  volatile irparams_t irparams;  // The interrupt handler's capture state.
+  volatile ircapture_ring_t ircapture;  // The capture slots. (If used)
+  irparams_t *irparams_save;  // A copy of the capture state while decoding.
   uint8_t _timer_num;
-#if DECODE_HASH
-  uint16_t _unknown_threshold;
-#endif
+  decode_options_t _options;
+  uint64_t _enabled_steps;  // Bit mask of which decode steps are enabled.
+#if DECODE_STATS
+  decode_stats_t _stats;
+  void updateDecodeStats(const decode_type_t protocol, const bool success,
+                         const uint32_t usecs);
+#endif  // DECODE_STATS
   // These are called by decode
   void copyIrParams(volatile irparams_t *src, irparams_t *dst);
+  bool nextCapture(decode_results *results);
+  bool captureEnded(void);
+  bool endCapture(volatile uint16_t *rawbuf, const uint16_t rawlen);
+  stream_state_t _stream;
+  void streamReset(void);
+  uint8_t streamStep(const uint8_t decoder, stream_decoder_t *state,
+                     const uint16_t offset, const uint16_t entry);
+  void updateEnabledSteps(void);
   int16_t compare(uint16_t oldval, uint16_t newval);
-  static uint32_t ticksLow(uint32_t usecs, uint8_t tolerance = kTolerance,
-                           uint16_t delta = 0);
-  static uint32_t ticksHigh(uint32_t usecs, uint8_t tolerance = kTolerance,
-                            uint16_t delta = 0);
+  static constexpr uint32_t ticksLow(uint32_t usecs,
+                                     uint8_t tolerance = kTolerance,
+                                     uint16_t delta = 0);
+  static constexpr uint32_t ticksHigh(uint32_t usecs,
+                                      uint8_t tolerance = kTolerance,
+                                      uint16_t delta = 0);
+  static constexpr uint32_t atLeastZero(const int32_t ticks);
   bool matchAtLeast(uint32_t measured, uint32_t desired,
                     uint8_t tolerance = kTolerance, uint16_t delta = 0);
   uint16_t _matchGeneric(volatile uint16_t *data_ptr,
@@ -187,6 +343,24 @@ class IRrecv {
                       const uint8_t tolerance = kTolerance,
                       const int16_t excess = kMarkExcess,
                       const bool MSBfirst = true);
+  static match_bit_windows_t bitWindows(const uint16_t onemark,
+                                        const uint32_t onespace,
+                                        const uint16_t zeromark,
+                                        const uint32_t zerospace,
+                                        const uint8_t tolerance,
+                                        const int16_t excess);
+  match_result_t _matchData(volatile uint16_t *data_ptr, const uint16_t nbits,
+                            const match_bit_windows_t *windows,
+                            const bool MSBfirst);
+  uint16_t _matchBytes(volatile uint16_t *data_ptr, uint8_t *result_ptr,
+                       const uint16_t remaining, const uint16_t nbytes,
+                       const match_bit_windows_t *windows,
+                       const bool MSBfirst);
+  template <const protocol_timing_t &T, uint8_t tolerance = kTolerance,
+            int16_t excess = kMarkExcess>
+  uint16_t matchTimed(volatile uint16_t *data_ptr, uint64_t *result_ptr,
+                      const uint16_t remaining, const uint16_t nbits,
+                      const bool atleast = true);
   uint16_t matchGeneric(volatile uint16_t *data_ptr,
                         uint64_t *result_ptr,
                         const uint16_t remaining, const uint16_t nbits,
@@ -209,11 +383,16 @@ class IRrecv {
                         const uint8_t tolerance = kTolerance,
                         const int16_t excess = kMarkExcess,
                         const bool MSBfirst = true);
+  bool decodeStep(const uint8_t step, decode_results *results);
   bool decodeHash(decode_results *results);
 #if (DECODE_NEC || DECODE_SHERWOOD || DECODE_AIWA_RC_T501 || SEND_SANYO)
   bool decodeNEC(decode_results *results, uint16_t nbits = kNECBits,
                  bool strict = true);
 #endif
+#if DECODE_NEC
+  uint8_t streamNEC(stream_decoder_t *state, const uint16_t offset,
+                    const uint16_t entry);
+#endif  // DECODE_NEC
 #if DECODE_ARGO
   bool decodeArgo(decode_results *results, const uint16_t nbits = kArgoBits,
                   const bool strict = true);
@@ -221,6 +400,8 @@ class IRrecv {
 #if DECODE_SONY
   bool decodeSony(decode_results *results, uint16_t nbits = kSonyMinBits,
                   bool strict = false);
+  uint8_t streamSony(stream_decoder_t *state, const uint16_t offset,
+                     const uint16_t entry);
 #endif
 #if DECODE_SANYO
   // DISABLED due to poor quality.
@@ -256,6 +437,8 @@ class IRrecv {
 #if DECODE_RC5
   bool decodeRC5(decode_results *results, uint16_t nbits = kRC5XBits,
                  bool strict = true);
+  uint8_t streamRC5(stream_decoder_t *state, const uint16_t offset,
+                    const uint16_t entry);
 #endif
 #if DECODE_RC6
   bool decodeRC6(decode_results *results, uint16_t nbits = kRC6Mode0Bits,
@@ -466,4 +649,180 @@ bool decodeNeoclima(decode_results *results,
 #endif  // DECODE_NEOCLIMA
 };
 
+// The match window maths is all constexpr, so windows for constant timings
+// (e.g. in matchTimed<>()) are calculated at compile time.
+
+// Returns: The nr. of ticks, or 0 if it is negative.
+constexpr uint32_t IRrecv::atLeastZero(const int32_t ticks) {
+  return ticks > 0 ? ticks : 0;
+}
+
+// Calculate the lower bound of the nr. of ticks.
+//
+// Args:
+//   usecs:  Nr. of uSeconds.
+//   tolerance:  Percent as an integer. e.g. 10 is 10%
+//   delta:  A non-scaling amount to reduce usecs by.
+// Returns:
+//   Nr. of ticks.
+constexpr uint32_t IRrecv::ticksLow(uint32_t usecs, uint8_t tolerance,
+                                    uint16_t delta) {
+  // Integer only maths. The ESP8266 has no FPU, & this is called a lot.
+  // Split the scaling up so usecs * tolerance can't overflow.
+  return atLeastZero((int32_t)(usecs - (usecs / 100) * tolerance -
+                               ((usecs % 100) * tolerance + 99) / 100) -
+                     (int32_t)delta);
+}
+
+// Calculate the upper bound of the nr. of ticks.
+//
+// Args:
+//   usecs:  Nr. of uSeconds.
+//   tolerance:  Percent as an integer. e.g. 10 is 10%
+//   delta:  A non-scaling amount to increase usecs by.
+// Returns:
+//   Nr. of ticks.
+constexpr uint32_t IRrecv::ticksHigh(uint32_t usecs, uint8_t tolerance,
+                                     uint16_t delta) {
+  // Integer only maths. See ticksLow().
+  return (usecs + (usecs / 100) * tolerance +
+          ((usecs % 100) * tolerance) / 100 + 1 + delta);
+}
+
+// Calculate the window of raw capture ticks that match an expected duration.
+// The window is calculated once, so it can be reused to match lots of
+// captured values cheaply. e.g. Every bit of a message.
+//
+// Args:
+//   desired:  The expected period (in useconds) we are matching against.
+//   tolerance:  A percentage expressed as an integer. e.g. 10 is 10%.
+//   delta:  A non-scaling (+/-) error margin (in useconds).
+// Returns:
+//   A match_window_t of the lowest & highest matching raw capture values.
+constexpr match_window_t IRrecv::matchWindow(const uint32_t desired,
+                                             const uint8_t tolerance,
+                                             const uint16_t delta) {
+  // Round inwards so that `measured * kRawTick` must be within the bounds.
+  return match_window_t{
+      (ticksLow(desired, tolerance, delta) + kRawTick - 1) / kRawTick,
+      ticksHigh(desired, tolerance, delta) / kRawTick};
+}
+
+// Calculate the match window for a mark signal. See matchMark().
+//
+// Args:
+//   desired:  The expected period (in useconds) we are matching against.
+//   tolerance:  A percentage expressed as an integer. e.g. 10 is 10%.
+//   excess:  Nr. of useconds.
+// Returns:
+//   A match_window_t of the lowest & highest matching raw capture values.
+constexpr match_window_t IRrecv::markWindow(const uint32_t desired,
+                                            const uint8_t tolerance,
+                                            const int16_t excess) {
+  return matchWindow(desired + excess, tolerance);
+}
+
+// Calculate the match window for a space signal. See matchSpace().
+//
+// Args:
+//   desired:  The expected period (in useconds) we are matching against.
+//   tolerance:  A percentage expressed as an integer. e.g. 10 is 10%.
+//   excess:  Nr. of useconds.
+// Returns:
+//   A match_window_t of the lowest & highest matching raw capture values.
+constexpr match_window_t IRrecv::spaceWindow(const uint32_t desired,
+                                             const uint8_t tolerance,
+                                             const int16_t excess) {
+  return matchWindow(desired - excess, tolerance);
+}
+
+// Check if a pulse(measured) is inside a pre-calculated match window.
+//
+// Args:
+//   measured:  The recorded period of the signal pulse. (In raw ticks)
+//   window:  The window calculated by matchWindow(), markWindow() etc.
+// Returns:
+//   Boolean: true if it matches, false if it doesn't.
+constexpr bool IRrecv::matchWindowed(const uint32_t measured,
+                                     const match_window_t window) {
+  return measured >= window.low && measured <= window.high;
+}
+
+// Match & decode a simple <= 64bit IR message described by a compile-time
+// protocol_timing_t. The equivalent of matchGeneric(), but all the match
+// windows are constants, so no timing values are passed or calculated at
+// runtime.
+//
+// Args (Template):
+//   T:  The protocol's timing descriptor. Must be constexpr.
+//   tolerance: Percentage error margin to allow. (Def: kTolerance)
+//   excess:  Nr. of useconds. (Def: kMarkExcess)
+// Args:
+//   data_ptr: A pointer to where we are at in the capture buffer.
+//   result_ptr: A pointer to where to store the bits we decoded.
+//   remaining: The size of the capture buffer are remaining.
+//   nbits:  Nr. of data bits we expect.
+//   atleast:  Is the match on the gap a matchAtLeast or matchSpace?
+// Returns:
+//  A uint16_t: If successful, how many buffer entries were used. Otherwise 0.
+template <const protocol_timing_t &T, uint8_t tolerance, int16_t excess>
+uint16_t IRrecv::matchTimed(volatile uint16_t *data_ptr, uint64_t *result_ptr,
+                            const uint16_t remaining, const uint16_t nbits,
+                            const bool atleast) {
+  static constexpr match_window_t kHdrMark = markWindow(T.hdrmark, tolerance,
+                                                        excess);
+  static constexpr match_window_t kHdrSpace = spaceWindow(T.hdrspace,
+                                                          tolerance, excess);
+  static constexpr match_window_t kOneMark = markWindow(T.onemark, tolerance,
+                                                        excess);
+  static constexpr match_window_t kOneSpace = spaceWindow(T.onespace,
+                                                          tolerance, excess);
+  static constexpr match_window_t kZeroMark = markWindow(T.zeromark,
+                                                         tolerance, excess);
+  static constexpr match_window_t kZeroSpace = spaceWindow(T.zerospace,
+                                                           tolerance, excess);
+  static constexpr match_window_t kFooterMark = markWindow(T.footermark,
+                                                           tolerance, excess);
+  static constexpr match_window_t kGap = spaceWindow(T.gap, tolerance,
+                                                     excess);
+  // Check if there is enough capture buffer to possibly have the message.
+  if (remaining < nbits * 2 + (T.hdrmark != 0) + (T.hdrspace != 0) +
+                  (T.footermark != 0))
+    return 0;  // Nope, so abort.
+  uint16_t offset = 0;
+  // Header
+  if (T.hdrmark && !matchWindowed(data_ptr[offset++], kHdrMark)) return 0;
+  if (T.hdrspace && !matchWindowed(data_ptr[offset++], kHdrSpace)) return 0;
+  // Data
+  uint64_t data = 0;
+  for (uint16_t bit = 0; bit < nbits; bit++, offset += 2) {
+    uint16_t mark = data_ptr[offset];
+    uint16_t space = data_ptr[offset + 1];
+    bool one;
+    if (matchWindowed(mark, kOneMark) && matchWindowed(space, kOneSpace))
+      one = true;
+    else if (matchWindowed(mark, kZeroMark) &&
+             matchWindowed(space, kZeroSpace))
+      one = false;
+    else
+      return 0;  // It's neither, so fail.
+    if (T.msbfirst)
+      data = (data << 1) | one;
+    else if (one)
+      data |= 1ULL << bit;
+  }
+  // Footer
+  if (T.footermark && !matchWindowed(data_ptr[offset++], kFooterMark))
+    return 0;
+  // If we have something still to match & haven't reached the end of the buffer
+  if (T.gap && offset < remaining) {
+    if (atleast ? !matchAtLeast(data_ptr[offset], T.gap, tolerance, excess)
+                : !matchWindowed(data_ptr[offset], kGap))
+      return 0;
+    offset++;
+  }
+  *result_ptr = data;
+  return offset;
+}
+
 #endif  // IRRECV_H_
@@ -254,6 +254,13 @@
 #define DECODE_AC false   // We don't need that infrastructure.
 #endif
 
+// Collect statistics on how often, & for how long, decode() attempts each
+// protocol. See IRrecv::getDecodeStats(). It costs memory & a little time per
+// decode, so it is off by default. When off, it costs nothing.
+#ifndef DECODE_STATS
+#define DECODE_STATS false
+#endif  // DECODE_STATS
+
 // Use millisecond 'delay()' calls where we can to avoid tripping the WDT.
 // Note: If you plan to send IR messages in the callbacks of the AsyncWebserver
 //       library, you need to set ALLOW_DELAY_CALLS to false.
@@ -380,6 +387,12 @@ const uint16_t kFujitsuAcBits = kFujitsuAcStateLength * 8;
 const uint16_t kFujitsuAcMinBits = (kFujitsuAcStateLengthShort - 1) * 8;
 const uint16_t kGicableBits = 16;
 const uint16_t kGicableMinRepeat = kSingleRepeat;
+const uint16_t kGlobalCacheMaxRepeat = 50;
+const uint32_t kGlobalCacheMinUsec = 80;
+const uint8_t kGlobalCacheFreqIndex = 0;
+const uint8_t kGlobalCacheRptIndex = kGlobalCacheFreqIndex + 1;
+const uint8_t kGlobalCacheRptStartIndex = kGlobalCacheRptIndex + 1;
+const uint8_t kGlobalCacheStartIndex = kGlobalCacheRptStartIndex + 1;
 const uint16_t kGoodweatherBits = 48;
 const uint16_t kGoodweatherMinRepeat = kNoRepeat;
 const uint16_t kGreeStateLength = 8;
@@ -441,6 +454,12 @@ const uint16_t kPanasonicAcShortBits = kPanasonicAcStateShortLength * 8;
 const uint16_t kPanasonicAcDefaultRepeat = kNoRepeat;
 const uint16_t kPioneerBits = 64;
 const uint16_t kProntoMinLength = 6;
+const float kProntoFreqFactor = 0.241246;
+const uint16_t kProntoTypeOffset = 0;
+const uint16_t kProntoFreqOffset = 1;
+const uint16_t kProntoSeq1LenOffset = 2;
+const uint16_t kProntoSeq2LenOffset = 3;
+const uint16_t kProntoDataOffset = 4;
 const uint16_t kRC5RawBits = 14;
 const uint16_t kRC5Bits = kRC5RawBits - 2;
 const uint16_t kRC5XBits = kRC5RawBits - 1;
@@ -0,0 +1,278 @@
+// Copyright 2019 David Conran
+//
+// Repeat IR messages from a receiver to an IR LED, with as little delay as we
+// can manage. e.g. To relay a remote control's messages into another room.
+//
+// In kRepeaterStream mode, a message is forwarded entry by entry while it is
+// still being captured. Its marks & spaces are sent with the timing they were
+// captured with, a short (bounded) delay behind the receiver, so the message
+// is repeated almost as soon as it has ended. It is decoded afterwards, so the
+// caller can see what went past.
+// If handle() wasn't called soon enough after a message started to forward it
+// within the max. delay, or in kRepeaterDecode mode, the message is decoded
+// first (as early as IRrecv::decodeStream() can), then sent afresh via its
+// protocol's send routine. i.e. With the correct modulation frequency, timing,
+// & repeats. Anything that can't be re-encoded is sent as it was captured.
+//
+// Note: When streaming, the receiver is still capturing while the message is
+//       sent. Keep it out of sight of the IR LED, or it will capture the
+//       repeated message too.
+
+#include "IRrepeater.h"
+#ifndef UNIT_TEST
+#include <Arduino.h>
+#endif
+#include <algorithm>
+#include "IRrecv.h"
+#include "IRsend.h"
+#include "IRtimer.h"
+#include "IRutils.h"
+
+// Create a repeater.
+//
+// Args:
+//   irrecv: A pointer to the enabled IRrecv to repeat the messages of.
+//   irsend: A pointer to the IRsend to repeat them with.
+//   mode: How to repeat them. i.e. kRepeaterStream or kRepeaterDecode.
+IRrepeater::IRrepeater(IRrecv *irrecv, IRsend *irsend,
+                       const repeater_mode_t mode)
+    : _irrecv(irrecv), _irsend(irsend), _mode(mode),
+      _frequency(kRepeaterFrequency), _min_delay(kRepeaterMinDelay),
+      _max_delay(kRepeaterMaxDelay), _streaming(false), _rawbuf(NULL),
+      _entry(0), _started(false), _entry_start(0), _delay(0), _missed(NULL) {
+  resetStats();
+}
+
+// Set how messages are to be repeated. It applies from the next message.
+//
+// Args:
+//   mode: kRepeaterStream or kRepeaterDecode.
+void IRrepeater::setMode(const repeater_mode_t mode) { _mode = mode; }
+
+repeater_mode_t IRrepeater::getMode(void) { return _mode; }
+
+// Set the modulation frequency of messages repeated as they were captured.
+// i.e. Streamed ones, & those that can't be re-encoded.
+//
+// Args:
+//   hz: The frequency in Hz. e.g. 38000
+void IRrepeater::setFrequency(const uint16_t hz) { _frequency = hz; }
+
+// Set the delay between a message being received & it being streamed.
+//
+// Args:
+//   min_usecs: Delay the start of a message by at least this much, so the
+//     odd late call to handle() doesn't distort it.
+//   max_usecs: If a message started longer ago than this when handle() first
+//     sees it, it isn't streamed. It is decoded & sent afresh instead.
+void IRrepeater::setDelay(const uint32_t min_usecs, const uint32_t max_usecs) {
+  _min_delay = min_usecs;
+  _max_delay = std::max(min_usecs, max_usecs);
+}
+
+// Returns: true if a message is being streamed. i.e. Call handle() very soon.
+bool IRrepeater::streaming(void) { return _streaming; }
+
+repeater_stats_t IRrepeater::getStats(void) { return _stats; }
+
+void IRrepeater::resetStats(void) {
+  _stats.frames = 0;
+  _stats.streamed = 0;
+  _stats.reencoded = 0;
+  _stats.replayed = 0;
+  _stats.late = 0;
+  _stats.max_delay = 0;
+}
+
+// Repeat whatever the receiver is capturing, or has captured.
+// Call this as often as possible. e.g. Every time through loop().
+// While a mark is being streamed, it doesn't return until the mark has been
+// sent. It returns during spaces, so the rest of loop() can carry on.
+//
+// Args:
+//   results: Where to store what the repeated message decoded as. Pass NULL if
+//     you aren't interested.
+// Returns:
+//   A boolean indicating if a message has been repeated (in full).
+bool IRrepeater::handle(decode_results *results) {
+  if (results == NULL) results = &_results;
+  if (_streaming) return stream(results);
+  if (_mode == kRepeaterStream) {
+    capture_progress_t progress;
+    _irrecv->getCaptureProgress(&progress);
+    if (!progress.ended && progress.rawlen && progress.rawbuf != _missed) {
+      if (startStream(&progress)) return stream(results);
+      _missed = progress.rawbuf;  // Too late. Let the decoder have it.
+      _stats.late++;
+    }
+  }
+  return repeatDecoded(results);
+}
+
+// Start streaming the message being captured, if it isn't too late.
+//
+// Args:
+//   progress: The capture in progress.
+// Returns:
+//   A boolean indicating if we have started. i.e. The delay is small enough.
+bool IRrepeater::startStream(const capture_progress_t *progress) {
+  // How long ago the message started. i.e. How far behind it we already are.
+  uint32_t delay = progress->since_edge;
+  for (uint16_t i = kStartOffset; i < progress->rawlen; i++)
+    delay += progress->rawbuf[i] * kRawTick;
+  if (delay > _max_delay) return false;
+  _irsend->enableIROut(_frequency);
+  _rawbuf = progress->rawbuf;
+  _entry = kStartOffset;
+  _started = false;
+  _clock.reset();
+  // Start the first mark once we are at least the min. delay behind.
+  _entry_start = (delay < _min_delay) ? _min_delay - delay : 0;
+  _delay = std::max(delay, _min_delay);
+  _streaming = true;
+  return true;
+}
+
+// Send as much of the message being streamed as has been captured.
+//
+// Args:
+//   results: Where to store what the message decoded as, once it has ended.
+// Returns:
+//   A boolean indicating if the whole message has been repeated.
+bool IRrepeater::stream(decode_results *results) {
+  capture_progress_t progress;
+  while (true) {
+    _irrecv->getCaptureProgress(&progress);
+    bool same = progress.rawbuf == _rawbuf;
+    bool is_mark = _entry & 1;
+    if (same && _entry < progress.rawlen) {  // We know how long it is.
+      sendEntry(is_mark, _rawbuf[_entry] * kRawTick);
+      _entry++;
+      _started = false;
+    } else if (progress.ended || !same) {  // The capture is over.
+      break;
+    } else if (is_mark) {  // Keep it going until we see where it ends.
+      startMark();
+      _irsend->mark(kRepeaterSlice);
+    } else {  // A space. Nothing to do until it ends.
+      return false;
+    }
+  }
+  finishStream(results);
+  return true;
+}
+
+// Get ready to send a mark of the message being streamed.
+// i.e. Wait until it is due, or, if we are running late, make everything from
+// here on later, rather than cut the mark short.
+void IRrepeater::startMark(void) {
+  if (_started) return;
+  _started = true;
+  uint32_t now = _clock.elapsed();
+  if (now < _entry_start) {
+    _irsend->space(_entry_start - now);
+  } else if (now > _entry_start + kRepeaterSlice) {
+    _delay += now - _entry_start;
+    _entry_start = now;
+  }
+}
+
+// Send (the rest of) an entry of the message being streamed, so it ends when
+// it should. i.e. `usecs` after it was due to start.
+//
+// Args:
+//   is_mark: Is the entry a mark? (Or a space.)
+//   usecs: How long the entry was when it was captured.
+void IRrepeater::sendEntry(const bool is_mark, const uint32_t usecs) {
+  if (is_mark) startMark();
+  uint32_t end = _entry_start + usecs;
+  uint32_t now = _clock.elapsed();
+  if (is_mark) {
+    while (now < end) {
+      uint16_t chunk = std::min(end - now, (uint32_t)UINT16_MAX);
+      _irsend->mark(chunk);
+      now += chunk;
+    }
+  } else if (now < end) {
+    _irsend->space(end - now);
+  }
+  _entry_start = end;
+}
+
+// The message being streamed has been captured in full. Send whatever is left
+// of it, decode it, & get the receiver going again.
+//
+// Args:
+//   results: Where to store what the message decoded as.
+void IRrepeater::finishStream(decode_results *results) {
+  capture_progress_t progress;
+  _irrecv->getCaptureProgress(&progress);
+  presetResults(results, &progress);
+  results->decode_type = UNKNOWN;
+  if (_irrecv->decode(results) && results->rawbuf == _rawbuf) {
+    // Send anything captured after we last looked. e.g. The capture moved on
+    // to the next capture slot before we saw the last mark. A trailing space
+    // isn't worth waiting for.
+    for (; _entry < results->rawlen; _entry++) {
+      bool is_mark = _entry & 1;
+      if (!is_mark && _entry + 1 == results->rawlen) break;
+      _started = false;
+      sendEntry(is_mark, results->rawbuf[_entry] * kRawTick);
+    }
+  }
+  _irrecv->resume();
+  _streaming = false;
+  _stats.frames++;
+  _stats.streamed++;
+  _stats.max_delay = std::max(_stats.max_delay, _delay);
+}
+
+// Repeat a message by decoding it, & sending it afresh via its protocol.
+// Anything that can't be re-encoded is sent as it was captured.
+//
+// Args:
+//   results: Where to store what the message decoded as.
+// Returns:
+//   A boolean indicating if a message has been repeated.
+bool IRrepeater::repeatDecoded(decode_results *results) {
+  capture_progress_t progress;
+  _irrecv->getCaptureProgress(&progress);
+  presetResults(results, &progress);
+  if (!_irrecv->decodeStream(results)) return false;
+  _missed = NULL;
+  decode_type_t protocol = results->decode_type;
+  bool success = false;
+  // Repeat codes (e.g. NEC's) have no data of their own to re-encode.
+  if (protocol != UNKNOWN && !results->repeat && !results->overflow) {
+    if (hasACState(protocol))
+      success = _irsend->send(protocol, results->state, results->bits / 8);
+    else
+      success = _irsend->send(protocol, results->value, results->bits);
+  }
+  if (success) {
+    _stats.reencoded++;
+  } else {
+    IRrawIterator raw = resultToRawIterator(results);
+    _irsend->sendRaw(&raw, _frequency);
+    _stats.replayed++;
+  }
+  // Resume capturing. It was not restarted until after we sent the message, so
+  // we didn't capture our own message. (Unless there are capture slots.)
+  _irrecv->resume();
+  _stats.frames++;
+  return true;
+}
+
+// With a single capture buffer, decoding is done on it in place. Point the
+// results at it, as IRrecv::decodeStream() does when it ends a capture early.
+//
+// Args:
+//   results: The results to be decoded into.
+//   progress: The capture they are for.
+void IRrepeater::presetResults(decode_results *results,
+                               const capture_progress_t *progress) {
+  if (_irrecv->getCaptureSlots() > 1) return;
+  results->rawbuf = progress->rawbuf;
+  results->rawlen = progress->rawlen;
+  results->overflow = false;
+}
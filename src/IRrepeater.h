@@ -0,0 +1,84 @@
+#ifndef IRREPEATER_H_
+#define IRREPEATER_H_
+
+// Copyright 2019 David Conran
+
+#define __STDC_LIMIT_MACROS
+#include <stdint.h>
+#include "IRremoteESP8266.h"
+#include "IRrecv.h"
+#include "IRsend.h"
+#include "IRtimer.h"
+
+// Constants
+// Modulation frequency (Hz) for anything repeated as it was captured.
+const uint16_t kRepeaterFrequency = 38000;
+// How finely (uSecs) a mark is extended while we wait to see when it ends.
+const uint16_t kRepeaterSlice = 50;
+// Default min. & max. delay (uSecs) between a streamed message being received
+// & it being repeated.
+const uint32_t kRepeaterMinDelay = 2 * kRepeaterSlice;
+const uint32_t kRepeaterMaxDelay = 5000;
+
+enum repeater_mode_t {
+  kRepeaterStream = 0,  // Forward messages as they are being captured.
+  kRepeaterDecode,      // Decode messages, then send them afresh.
+};
+
+typedef struct {
+  uint32_t frames;     // Nr. of messages repeated.
+  uint32_t streamed;   // Nr. forwarded while they were being captured.
+  uint32_t reencoded;  // Nr. decoded & sent afresh via their protocol.
+  uint32_t replayed;   // Nr. decoded, but sent as they were captured.
+  uint32_t late;       // Nr. seen too late to stream, so decoded instead.
+  uint32_t max_delay;  // Longest a streamed message was delayed by. (uSecs)
+} repeater_stats_t;
+
+// Class
+// Repeats whatever an IRrecv captures, via an IRsend, with as little delay as
+// possible, & without allocating any memory.
+class IRrepeater {
+ public:
+  explicit IRrepeater(IRrecv *irrecv, IRsend *irsend,
+                      const repeater_mode_t mode = kRepeaterStream);
+  bool handle(decode_results *results = NULL);
+  void setMode(const repeater_mode_t mode);
+  repeater_mode_t getMode(void);
+  void setFrequency(const uint16_t hz);
+  void setDelay(const uint32_t min_usecs, const uint32_t max_usecs);
+  bool streaming(void);
+  repeater_stats_t getStats(void);
+  void resetStats(void);
+#ifndef UNIT_TEST
+
+ private:
+#endif
+  IRrecv *_irrecv;
+  IRsend *_irsend;
+  repeater_mode_t _mode;
+  uint16_t _frequency;
+  uint32_t _min_delay;
+  uint32_t _max_delay;
+  repeater_stats_t _stats;
+  decode_results _results;  // Used if handle() isn't given any.
+  // The message being streamed.
+  bool _streaming;
+  volatile uint16_t *_rawbuf;  // The capture buffer it is in.
+  uint16_t _entry;             // The capture entry being sent.
+  bool _started;               // Have we started sending it?
+  IRtimer _clock;              // Time since we started sending it.
+  uint32_t _entry_start;       // When (on _clock) the entry started being sent.
+  uint32_t _delay;             // How far behind the capture we are. (uSecs)
+  // The capture buffer of a message seen too late to stream. NULL if none.
+  volatile uint16_t *_missed;
+  bool startStream(const capture_progress_t *progress);
+  bool stream(decode_results *results);
+  void startMark(void);
+  void sendEntry(const bool is_mark, const uint32_t usecs);
+  void finishStream(decode_results *results);
+  bool repeatDecoded(decode_results *results);
+  void presetResults(decode_results *results,
+                     const capture_progress_t *progress);
+};
+
+#endif  // IRREPEATER_H_
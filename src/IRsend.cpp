@@ -15,6 +15,11 @@
 #endif
 #include "IRtimer.h"
 
+#ifdef UNIT_TEST
+// Used to help simulate elapsed time in unit tests.
+extern uint32_t _IRtimer_unittest_now;
+#endif  // UNIT_TEST
+
 // Originally from https://github.com/shirriff/Arduino-IRremote/
 // Updated by markszabo (https://github.com/crankyoldgit/IRremoteESP8266) for
 // sending IR code on ESP8266
@@ -35,7 +40,8 @@
 // Returns:
 //   An IRsend object.
 IRsend::IRsend(uint16_t IRsendPin, bool inverted, bool use_modulation)
-    : IRpin(IRsendPin), periodOffset(kPeriodOffset) {
+    : IRpin(IRsendPin), periodOffset(kPeriodOffset), _backend(NULL),
+      _rendering(false) {
   if (inverted) {
     outputOn = LOW;
     outputOff = HIGH;
@@ -43,6 +49,19 @@ IRsend::IRsend(uint16_t IRsendPin, bool inverted, bool use_modulation)
     outputOn = HIGH;
     outputOff = LOW;
   }
+#ifdef UNIT_TEST
+  _freq_unittest = 0;
+  _carrier_misses = 0;
+#endif  // UNIT_TEST
+  for (uint8_t i = 0; i < kCarrierCacheSize; i++)
+    _carriers[i].dutycycle = kDutyMax + 1;  // i.e. Unused.
+  _carrier_next = 0;
+  _render.durations = NULL;
+  _render.size = 0;
+  _render.length = 0;
+  _render.frequency = kDefaultRenderFrequency;
+  _render.dutycycle = kDutyDefault;
+  _render.overflow = false;
   modulation = use_modulation;
   if (modulation)
     _dutycycle = kDutyDefault;
@@ -101,6 +120,8 @@ uint32_t IRsend::calcUSecPeriod(uint32_t hz, bool use_offset) {
 //   Integer timing functions & math mean we can't do fractions of
 //   microseconds timing. Thus minor changes to the freq & duty values may have
 //   limited effect. You've been warned.
+//   The on & off times of the last kCarrierCacheSize carriers used are kept,
+//   so switching back to one of them doesn't recalculate anything.
 void IRsend::enableIROut(uint32_t freq, uint8_t duty) {
   // Set the duty cycle to use if we want freq. modulation.
   if (modulation) {
@@ -112,12 +133,37 @@ void IRsend::enableIROut(uint32_t freq, uint8_t duty) {
     freq *= 1000;
 #ifdef UNIT_TEST
   _freq_unittest = freq;
+#endif  // UNIT_TEST
+  if (_rendering) {
+    _render.frequency = freq;
+    _render.dutycycle = _dutycycle;
+  }
+  // Reuse the on & off times if we've worked them out recently.
+  for (uint8_t i = 0; i < kCarrierCacheSize; i++) {
+    const ir_carrier_t *carrier = &_carriers[i];
+    if (carrier->frequency == freq && carrier->dutycycle == _dutycycle &&
+        carrier->offset == periodOffset) {
+      onTimePeriod = carrier->on;
+      offTimePeriod = carrier->off;
+      return;
+    }
+  }
+#ifdef UNIT_TEST
+  _carrier_misses++;
 #endif  // UNIT_TEST
   uint32_t period = calcUSecPeriod(freq);
   // Nr. of uSeconds the LED will be on per pulse.
   onTimePeriod = (period * _dutycycle) / kDutyMax;
   // Nr. of uSeconds the LED will be off per pulse.
   offTimePeriod = period - onTimePeriod;
+  // Remember them, in place of the oldest entry.
+  ir_carrier_t *carrier = &_carriers[_carrier_next];
+  carrier->frequency = freq;
+  carrier->dutycycle = _dutycycle;
+  carrier->offset = periodOffset;
+  carrier->on = onTimePeriod;
+  carrier->off = offTimePeriod;
+  _carrier_next = (_carrier_next + 1) % kCarrierCacheSize;
 }
 
 #if ALLOW_DELAY_CALLS
@@ -174,6 +220,10 @@ void IRsend::_delayMicroseconds(uint32_t usec) {
 // Ref:
 //   https://www.analysir.com/blog/2017/01/29/updated-esp8266-nodemcu-backdoor-upwm-hack-for-ir-signals/
 uint16_t IRsend::mark(uint16_t usec) {
+  if (_rendering) {  // Just record it for later.
+    renderPulse(true, usec);
+    return 1;
+  }
   // Handle the simple case of no required frequency modulation.
   if (!modulation || _dutycycle >= 100) {
     ledOn();
@@ -189,6 +239,17 @@ uint16_t IRsend::mark(uint16_t usec) {
   // assured that we can't have odd math problems. i.e. unsigned under/overflow.
   uint32_t elapsed = usecTimer.elapsed();
 
+  // Send whole periods as is, without working out what's left each time.
+  const uint32_t period = onTimePeriod + offTimePeriod;
+  while (elapsed + period <= usec) {
+    ledOn();
+    _delayMicroseconds(onTimePeriod);
+    ledOff();
+    counter++;
+    _delayMicroseconds(offTimePeriod);
+    elapsed = usecTimer.elapsed();  // Update & recache the actual elapsed time.
+  }
+  // Then the last, partial, period (if any).
   while (elapsed < usec) {  // Loop until we've met/exceeded our required time.
     ledOn();
     // Calculate how long we should pulse on for.
@@ -213,11 +274,144 @@ uint16_t IRsend::mark(uint16_t usec) {
 // Args:
 //   time: Time in microseconds (us).
 void IRsend::space(uint32_t time) {
+  if (_rendering) {  // Just record it for later.
+    renderPulse(false, time);
+    return;
+  }
   ledOff();
   if (time == 0) return;
   _delayMicroseconds(time);
 }
 
+// Append a mark or space to the pulse train being rendered.
+// Consecutive marks (or spaces) are merged into a single entry.
+//
+// Args:
+//   is_mark: Is it a mark (LED on) or a space (LED off)?
+//   usec: The period of time, in microseconds.
+void IRsend::renderPulse(const bool is_mark, uint32_t usec) {
+  _render_usecs += usec;
+  while (usec) {
+    uint16_t len = _render.length;
+    bool last_is_mark = len & 1;  // Even indexes are marks.
+    if (len && last_is_mark == is_mark &&
+        _render.durations[len - 1] < UINT16_MAX) {  // Extend the last entry.
+      uint32_t add = std::min(usec,
+                              (uint32_t)(UINT16_MAX -
+                                         _render.durations[len - 1]));
+      _render.durations[len - 1] += add;
+      usec -= add;
+    } else if (len >= _render.size) {
+      _render.overflow = true;
+      return;
+    } else {
+      // Start a new entry. If it is the wrong type, it stays zero length
+      // and the next pass starts one of the right type.
+      _render.durations[len] = 0;
+      _render.length++;
+    }
+  }
+}
+
+// Set where rendered messages are played. e.g. A timer interrupt driven
+// backend the sketch provides. NULL (the default) means endRender() plays
+// them synchronously. The library doesn't include an asynchronous backend.
+//
+// Args:
+//   backend: A pointer to the backend to use, or NULL.
+void IRsend::setBackend(IRsendBackend *backend) { _backend = backend; }
+
+// Returns: The backend in use, or NULL if there isn't one.
+IRsendBackend *IRsend::getBackend(void) { return _backend; }
+
+// Start rendering messages instead of sending them.
+// Until endRender() is called, mark() & space() (and hence sendRaw(),
+// sendData(), sendGeneric() & all the protocol send routines) append to a
+// pulse train in the buffer supplied, rather than driving the IR LED.
+//
+// Args:
+//   buffer: Storage for the pulse train. Must live until it has been played.
+//   size: Nr. of entries the buffer can hold.
+// Returns:
+//   true if rendering has started, false if the backend is still busy.
+//
+// e.g.
+//   uint16_t buffer[512];
+//   irsend.beginRender(buffer, sizeof(buffer) / sizeof(buffer[0]));
+//   irsend.sendDaikin(state);
+//   irsend.endRender();  // Returns almost immediately with a backend,
+//                        // otherwise once the message has been sent.
+bool IRsend::beginRender(uint16_t *buffer, const uint16_t size) {
+  if (busy()) return false;
+  _render.durations = buffer;
+  _render.size = size;
+  _render.length = 0;
+  _render.frequency = kDefaultRenderFrequency;
+  _render.dutycycle = _dutycycle;
+  _render.overflow = false;
+  _render_usecs = 0;
+  _rendering = true;
+  return true;
+}
+
+// Stop rendering, and play what was rendered.
+// With a backend, this hands the pulse train over & returns straight away.
+// Without one, the pulse train is played before it returns.
+//
+// Args:
+//   play: Play the pulse train? If false, it is left for getPulseTrain().
+// Returns:
+//   true if the pulse train was played/accepted. false if not rendering,
+//   or the buffer overflowed, or the backend refused it.
+bool IRsend::endRender(const bool play) {
+  if (!_rendering) return false;
+  _rendering = false;
+  if (_render.overflow) return false;
+  if (!play) return true;
+  if (_backend != NULL) return _backend->play(&_render);
+  playPulseTrain(&_render);
+  return true;
+}
+
+// Returns: A pointer to the last pulse train rendered.
+const ir_pulse_train_t *IRsend::getPulseTrain(void) { return &_render; }
+
+// Returns: true if we are rendering, rather than sending.
+bool IRsend::isRendering(void) { return _rendering; }
+
+// Returns: true if the backend is still playing a previous pulse train.
+bool IRsend::busy(void) { return _backend != NULL && _backend->busy(); }
+
+// Synchronously play a pre-rendered pulse train on the IR LED.
+//
+// Args:
+//   train: A pointer to the pulse train to play.
+void IRsend::playPulseTrain(const ir_pulse_train_t *train) {
+  enableIROut(train->frequency, train->dutycycle);
+  for (uint16_t i = 0; i < train->length; i++) {
+    if (i & 1)
+      space(train->durations[i]);
+    else if (train->durations[i])
+      mark(train->durations[i]);
+  }
+}
+
+// A microsecond clock for timing how long a message has taken to send.
+// e.g. For protocols with a fixed message length.
+// When rendering, nothing is actually sent, so it is the total duration of
+// what has been rendered so far instead.
+//
+// Returns:
+//   Nr. of usecs. Only the difference between two calls is meaningful.
+uint32_t IRsend::messageClock(void) {
+  if (_rendering) return _render_usecs;
+#ifndef UNIT_TEST
+  return micros();
+#else
+  return _IRtimer_unittest_now;
+#endif
+}
+
 // Calculate & set any offsets to account for execution times.
 //
 // Args:
@@ -385,11 +579,10 @@ void IRsend::sendGeneric(const uint16_t headermark, const uint32_t headerspace,
                          const uint8_t dutycycle) {
   // Setup
   enableIROut(frequency, dutycycle);
-  IRtimer usecs = IRtimer();
 
   // We always send a message, even for repeat=0, hence '<= repeat'.
   for (uint16_t r = 0; r <= repeat; r++) {
-    usecs.reset();
+    uint32_t start = messageClock();
 
     // Header
     if (headermark) mark(headermark);
@@ -400,7 +593,7 @@ void IRsend::sendGeneric(const uint16_t headermark, const uint32_t headerspace,
 
     // Footer
     if (footermark) mark(footermark);
-    uint32_t elapsed = usecs.elapsed();
+    uint32_t elapsed = messageClock() - start;
     // Avoid potential unsigned integer underflow. e.g. when mesgtime is 0.
     if (elapsed >= mesgtime)
       space(gap);
@@ -462,6 +655,66 @@ void IRsend::sendGeneric(const uint16_t headermark, const uint32_t headerspace,
   }
 }
 
+// Create an iterator over a list of mark & space periods.
+//
+// Args:
+//   buf: The periods. Even elements are marks, odd elements are spaces.
+//   len: Nr. of elements in buf[].
+//   multiplier: Factor to convert an element into usecs. e.g. kRawTick.
+IRrawIterator::IRrawIterator(const volatile uint16_t *buf, const uint16_t len,
+                             const uint16_t multiplier)
+    : _buf(buf), _len(len), _multiplier(multiplier) {
+  rewind();
+}
+
+// Go back to the start of the periods.
+void IRrawIterator::rewind(void) {
+  _pos = 0;
+  _remaining = 0;
+  _split = false;
+  _zero = false;
+}
+
+// Get the next sendRaw() compatible value.
+//
+// Args:
+//   usecs: A ptr to where to store the value.
+// Returns:
+//   true if there was a value, false if we have reached the end.
+bool IRrawIterator::next(uint16_t *usecs) {
+  if (_zero) {  // A period is being split. Skip the opposite type of period.
+    _zero = false;
+    *usecs = 0;
+    return true;
+  }
+  uint32_t period = _remaining;
+  if (!_split) {
+    if (_pos >= _len) return false;
+    period = (uint32_t)_buf[_pos++] * _multiplier;
+  }
+  _split = period > UINT16_MAX;
+  if (_split) {  // Too big, so output as much as we can, and the rest later.
+    *usecs = UINT16_MAX;
+    _remaining = period - UINT16_MAX;
+    _zero = true;
+  } else {
+    *usecs = period;
+  }
+  return true;
+}
+
+// Returns: The nr. of values next() will produce in total.
+//          i.e. The size of the equivalent sendRaw() array.
+uint16_t IRrawIterator::length(void) const {
+  uint16_t result = 0;
+  for (uint16_t i = 0; i < _len; i++) {
+    uint32_t period = (uint32_t)_buf[i] * _multiplier;
+    for (; period > UINT16_MAX; period -= UINT16_MAX) result += 2;
+    result++;
+  }
+  return result;
+}
+
 #if SEND_RAW
 // Send a raw IRremote message.
 //
@@ -489,6 +742,27 @@ void IRsend::sendRaw(uint16_t buf[], uint16_t len, uint16_t hz) {
   }
   ledOff();  // We potentially have ended with a mark(), so turn of the LED.
 }
+
+// Send a raw IRremote message, straight from an iterator. No array needed.
+//
+// Args:
+//   raw: A ptr to an iterator of the periods. e.g. From resultToRawIterator().
+//        It is rewound first, so it can be reused.
+//   hz:  Frequency to send the message at. (kHz < 1000; Hz >= 1000)
+//
+// Status: BETA / Should be working.
+void IRsend::sendRaw(IRrawIterator *raw, uint16_t hz) {
+  enableIROut(hz);
+  raw->rewind();
+  uint16_t usecs;
+  for (bool is_mark = true; raw->next(&usecs); is_mark = !is_mark) {
+    if (is_mark)
+      mark(usecs);
+    else
+      space(usecs);
+  }
+  ledOff();  // We potentially have ended with a mark(), so turn of the LED.
+}
 #endif  // SEND_RAW
 
 // Get the minimum number of repeats for a given protocol.
@@ -7,6 +7,7 @@
 #define __STDC_LIMIT_MACROS
 #include <stdint.h>
 #include "IRremoteESP8266.h"
+#include "IRtiming.h"
 
 // Originally from https://github.com/shirriff/Arduino-IRremote/
 // Updated by markszabo (https://github.com/crankyoldgit/IRremoteESP8266) for
@@ -39,6 +40,72 @@ const uint8_t kDutyMax = 100;     // Percentage
 const uint16_t kMaxAccurateUsecDelay = 16383;
 //  Usecs to wait between messages we don't know the proper gap time.
 const uint32_t kDefaultMessageGap = 100000;
+// Frequency (Hz) a rendered pulse train uses if enableIROut() wasn't called.
+const uint32_t kDefaultRenderFrequency = 38000;
+// Nr. of carrier setups each IRsend remembers. See enableIROut().
+const uint8_t kCarrierCacheSize = 3;
+
+// The precomputed LED on & off times of a modulation carrier.
+typedef struct {
+  uint32_t frequency;  // In Hz.
+  uint8_t dutycycle;   // Percentage. > kDutyMax means the entry is unused.
+  int8_t offset;       // The period offset it was calculated with.
+  uint16_t on;         // Nr. of uSeconds the LED is on per period.
+  uint16_t off;        // Nr. of uSeconds the LED is off per period.
+} ir_carrier_t;
+
+// A message pre-rendered into a compact list of mark & space durations.
+// Entries alternate mark, space, mark, ... starting with a mark. Periods that
+// don't fit in 16 bits are split up with zero length entries of the opposite
+// type between them.
+typedef struct {
+  uint16_t *durations;  // Caller supplied storage. Nr. of usecs per entry.
+  uint16_t size;        // Nr. of entries the storage can hold.
+  uint16_t length;      // Nr. of entries used.
+  uint32_t frequency;   // Modulation frequency in Hz.
+  uint8_t dutycycle;    // Percentage.
+  bool overflow;        // Did the message not fit in the storage?
+} ir_pulse_train_t;
+
+// Something that can play a pre-rendered pulse train on an IR LED.
+// e.g. A hardware timer interrupt, an RMT peripheral, or a unit test.
+// Note: The library only provides this interface. It doesn't include an
+//       asynchronous backend for any board, as that is hardware specific.
+//       Without one, IRsend::endRender() plays the pulse train synchronously
+//       with IRsend::playPulseTrain(), so sending still blocks.
+class IRsendBackend {
+ public:
+  virtual ~IRsendBackend() {}
+  // Start playing the pulse train & return as soon as possible.
+  // The train's storage must be left alone until busy() returns false.
+  // Returns: true if it was accepted, false if not.
+  virtual bool play(const ir_pulse_train_t *train) = 0;
+  // Returns: true if a previous pulse train is still being played.
+  virtual bool busy() = 0;
+};
+
+// Walks through a list of mark & space periods, producing the sendRaw()
+// compatible (i.e. uint16_t usecs) version of each, without storing them.
+// Periods that don't fit in 16 bits are split in the same way
+// resultToRawArray() does. i.e. UINT16_MAX, 0, <the rest>.
+// e.g. Used to replay a capture via resultToRawIterator() & sendRaw().
+class IRrawIterator {
+ public:
+  IRrawIterator(const volatile uint16_t *buf, const uint16_t len,
+                const uint16_t multiplier = 1);
+  bool next(uint16_t *usecs);
+  uint16_t length(void) const;
+  void rewind(void);
+
+ private:
+  const volatile uint16_t *_buf;
+  uint16_t _len;
+  uint16_t _multiplier;
+  uint16_t _pos;         // Next entry of _buf to use.
+  uint32_t _remaining;   // Usecs left of a split up period.
+  bool _split;           // Are we part way through a period?
+  bool _zero;            // Is the next output the 0 between split up parts?
+};
 
 
 namespace stdAc {
@@ -115,6 +182,7 @@ class IRsend {
   VIRTUAL void space(uint32_t usec);
   int8_t calibrate(uint16_t hz = 38000U);
   void sendRaw(uint16_t buf[], uint16_t len, uint16_t hz);
+  void sendRaw(IRrawIterator *raw, uint16_t hz);
   void sendData(uint16_t onemark, uint32_t onespace, uint16_t zeromark,
                 uint32_t zerospace, uint64_t data, uint16_t nbits,
                 bool MSBfirst = true);
@@ -140,12 +208,23 @@ class IRsend {
                    const uint8_t *dataptr, const uint16_t nbytes,
                    const uint16_t frequency, const bool MSBfirst,
                    const uint16_t repeat, const uint8_t dutycycle);
+  template <const protocol_timing_t &T>
+  void sendTimed(const uint64_t data, const uint16_t nbits,
+                 const uint16_t repeat = kNoRepeat);
   static uint16_t minRepeats(const decode_type_t protocol);
   static uint16_t defaultBits(const decode_type_t protocol);
   bool send(const decode_type_t type, const uint64_t data,
             const uint16_t nbits, const uint16_t repeat = kNoRepeat);
   bool send(const decode_type_t type, const uint8_t state[],
             const uint16_t nbytes);
+  void setBackend(IRsendBackend *backend);
+  IRsendBackend *getBackend(void);
+  bool beginRender(uint16_t *buffer, const uint16_t size);
+  bool endRender(const bool play = true);
+  const ir_pulse_train_t *getPulseTrain(void);
+  bool isRendering(void);
+  bool busy(void);
+  void playPulseTrain(const ir_pulse_train_t *train);
 #if (SEND_NEC || SEND_SHERWOOD || SEND_AIWA_RC_T501 || SEND_SANYO)
   void sendNEC(uint64_t data, uint16_t nbits = kNECBits,
                uint16_t repeat = kNoRepeat);
@@ -474,14 +553,40 @@ class IRsend {
  private:
 #else
   uint32_t _freq_unittest;
+  uint16_t _carrier_misses;
 #endif  // UNIT_TEST
   uint16_t onTimePeriod;
   uint16_t offTimePeriod;
+  ir_carrier_t _carriers[kCarrierCacheSize];
+  uint8_t _carrier_next;
   uint16_t IRpin;
   int8_t periodOffset;
   uint8_t _dutycycle;
   bool modulation;
+  IRsendBackend *_backend;
+  ir_pulse_train_t _render;
+  bool _rendering;
+  uint32_t _render_usecs;
   uint32_t calcUSecPeriod(uint32_t hz, bool use_offset = true);
+  void renderPulse(const bool is_mark, uint32_t usec);
+  uint32_t messageClock(void);
 };
 
+// Send a simple <= 64bit message described by a compile-time
+// protocol_timing_t. See sendGeneric().
+//
+// Args (Template):
+//   T:  The protocol's timing descriptor. Must be constexpr.
+// Args:
+//   data:    The data to be transmitted.
+//   nbits:   Nr. of bits of data to be sent.
+//   repeat:  Nr. of additional times the message is to be sent.
+template <const protocol_timing_t &T>
+void IRsend::sendTimed(const uint64_t data, const uint16_t nbits,
+                       const uint16_t repeat) {
+  sendGeneric(T.hdrmark, T.hdrspace, T.onemark, T.onespace, T.zeromark,
+              T.zerospace, T.footermark, T.gap, T.mesgtime, data, nbits,
+              T.frequency, T.msbfirst, repeat, T.dutycycle);
+}
+
 #endif  // IRSEND_H_
@@ -0,0 +1,285 @@
+// Copyright 2019 David Conran
+//
+// A bounded, non-blocking queue of messages to send.
+//
+// enqueue() just stores the message & returns. handle(), which should be
+// called regularly from loop() (or a timer tick), sends the next message when
+// the IR LED is free. Gaps between messages are timed, not waited for.
+// Note: Unless the IRsend object has a backend, handle() still blocks while
+//       each message itself is being sent. See IRsendBackend.
+
+#include "IRsendQueue.h"
+#ifndef UNIT_TEST
+#include <Arduino.h>
+#endif
+#include <string.h>
+#include <algorithm>
+#include "IRac.h"
+#include "IRsend.h"
+#include "IRtimer.h"
+
+// Create a send queue.
+//
+// Args:
+//   irsend: A pointer to the IRsend object to send messages with.
+//           If it has a backend set, messages are played in the background.
+//           Otherwise, they are sent synchronously. See IRsendBackend.
+//   ac: A pointer to an IRac object, if enqueueAc() is to be used.
+//   length: Nr. of normal jobs that can be waiting.
+//   priority_length: Nr. of priority jobs that can be waiting.
+//   buffer_size: Nr. of mark/space entries a message can be rendered to.
+//                Messages that don't fit are sent the blocking way.
+IRsendQueue::IRsendQueue(IRsend *irsend, IRac *ac, const uint16_t length,
+                         const uint16_t priority_length,
+                         const uint16_t buffer_size)
+    : _irsend(irsend), _ac(ac), _buffer_size(buffer_size), _next_id(1),
+      _active(false), _gap(0) {
+  _normal.jobs = new send_job_t[length];
+  _normal.size = length;
+  _priority.jobs = new send_job_t[priority_length];
+  _priority.size = priority_length;
+  _buffer = new uint16_t[buffer_size];
+  _normal.count = 0;
+  _priority.count = 0;
+  _normal.first = 0;
+  _priority.first = 0;
+  resetStats();
+}
+
+IRsendQueue::~IRsendQueue(void) {
+  delete[] _normal.jobs;
+  delete[] _priority.jobs;
+  delete[] _buffer;
+}
+
+// Reserve the next free slot in one of the queue's lanes.
+//
+// Args:
+//   priority: Use the priority lane?
+// Returns:
+//   A pointer to the (id'ed) job to fill in, or NULL if the lane is full.
+send_job_t *IRsendQueue::push(const bool priority) {
+  send_lane_t *lane = priority ? &_priority : &_normal;
+  if (lane->count >= lane->size) {
+    _stats.dropped++;
+    return NULL;
+  }
+  uint16_t pos = lane->first + lane->count;
+  if (pos >= lane->size) pos -= lane->size;
+  lane->count++;
+  _stats.enqueued++;
+  _stats.max_depth = std::max(_stats.max_depth, depth());
+  send_job_t *job = &lane->jobs[pos];
+  job->id = _next_id++;
+  if (_next_id == kSendQueueFull) _next_id++;  // Skip the reserved id.
+  return job;
+}
+
+// Queue a message for a simple (i.e. value based) protocol.
+//
+// Args:
+//   type: The protocol to send. e.g. NEC.
+//   data: The value to send.
+//   nbits: The size of the message in bits.
+//   repeat: Nr. of times to repeat the message.
+//   callback: Function to call when the job has finished. NULL for none.
+//   priority: Send it before any normal jobs?
+// Returns:
+//   The id of the job, or kSendQueueFull if it wasn't queued.
+uint16_t IRsendQueue::enqueue(const decode_type_t type, const uint64_t data,
+                              const uint16_t nbits, const uint16_t repeat,
+                              send_callback_t callback, const bool priority) {
+  send_job_t *job = push(priority);
+  if (job == NULL) return kSendQueueFull;
+  job->kind = kSendJobValue;
+  job->type = type;
+  job->simple.value = data;
+  job->simple.nbits = nbits;
+  job->simple.repeat = repeat;
+  job->callback = callback;
+  return job->id;
+}
+
+// Queue a message for a state (i.e. byte array) based protocol.
+//
+// Args:
+//   type: The protocol to send. e.g. DAIKIN.
+//   state: The state/message to send. It is copied.
+//   nbytes: The size of the state in bytes.
+//   callback: Function to call when the job has finished. NULL for none.
+//   priority: Send it before any normal jobs?
+// Returns:
+//   The id of the job, or kSendQueueFull if it wasn't queued.
+uint16_t IRsendQueue::enqueue(const decode_type_t type, const uint8_t state[],
+                              const uint16_t nbytes, send_callback_t callback,
+                              const bool priority) {
+  if (nbytes > kStateSizeMax) {
+    _stats.dropped++;
+    return kSendQueueFull;
+  }
+  send_job_t *job = push(priority);
+  if (job == NULL) return kSendQueueFull;
+  job->kind = kSendJobState;
+  job->type = type;
+  memcpy(job->raw.state, state, nbytes);
+  job->raw.nbytes = nbytes;
+  job->callback = callback;
+  return job->id;
+}
+
+// Queue a common A/C state to be sent via IRac::sendAc().
+//
+// Args:
+//   desired: The A/C state wanted.
+//   prev: A pointer to the previous state, for toggle handling. Can be NULL.
+//   callback: Function to call when the job has finished. NULL for none.
+//   priority: Send it before any normal jobs?
+// Returns:
+//   The id of the job, or kSendQueueFull if it wasn't queued.
+//
+// Note:
+//   IRac uses its own IRsend objects, so these are sent synchronously from
+//   handle(), rather than in the background.
+uint16_t IRsendQueue::enqueueAc(const stdAc::state_t desired,
+                                const stdAc::state_t *prev,
+                                send_callback_t callback,
+                                const bool priority) {
+  if (_ac == NULL) {
+    _stats.dropped++;
+    return kSendQueueFull;
+  }
+  send_job_t *job = push(priority);
+  if (job == NULL) return kSendQueueFull;
+  job->kind = kSendJobAc;
+  job->type = desired.protocol;
+  job->ac.desired = desired;
+  job->ac.has_prev = prev != NULL;
+  if (prev != NULL) job->ac.prev = *prev;
+  job->callback = callback;
+  return job->id;
+}
+
+// Send a job the normal (blocking) way.
+bool IRsendQueue::sendNow(const send_job_t *job) {
+  switch (job->kind) {
+    case kSendJobValue:
+      return _irsend->send(job->type, job->simple.value, job->simple.nbits,
+                           job->simple.repeat);
+    case kSendJobState:
+      return _irsend->send(job->type, job->raw.state, job->raw.nbytes);
+    case kSendJobAc:
+      return _ac->sendAc(job->ac.desired,
+                         job->ac.has_prev ? &job->ac.prev : NULL);
+  }
+  return false;
+}
+
+// Send a job without waiting for it where we can.
+//
+// Returns:
+//   true if it was sent (or is being sent by the backend), false if not.
+bool IRsendQueue::sendJob(const send_job_t *job) {
+  // IRac drives its own IRsend objects, so we can't render those.
+  if (job->kind == kSendJobAc) return sendNow(job);
+  if (!_irsend->beginRender(_buffer, _buffer_size))
+    return sendNow(job);
+  bool success = sendNow(job);
+  // Too big to render? Then send it the blocking way.
+  if (!_irsend->endRender(false)) return sendNow(job);
+  if (!success) return false;
+  IRsendBackend *backend = _irsend->getBackend();
+  if (backend != NULL) {  // It gets played (including any gap) for us.
+    _active = backend->play(_irsend->getPulseTrain());
+    return _active;
+  }
+  // Play it now, but time the trailing gap rather than wait for it.
+  ir_pulse_train_t train = *_irsend->getPulseTrain();
+  while (train.length && !(train.length & 1)) {  // It ends with a space.
+    _gap += train.durations[--train.length];
+    // Skip any zero length mark used to split up a very long space.
+    if (train.length && train.durations[train.length - 1] == 0)
+      train.length--;
+  }
+  _irsend->playPulseTrain(&train);
+  _gap_timer.reset();
+  return true;
+}
+
+// Call a job's callback, and record how it went.
+void IRsendQueue::finish(const uint16_t id, send_callback_t callback,
+                         const bool success) {
+  if (success)
+    _stats.sent++;
+  else
+    _stats.failed++;
+  if (callback != NULL) callback(id, success);
+}
+
+// Do any queued work. Call this often. e.g. Every time through loop().
+// Priority jobs are always sent before normal ones.
+// Without a backend, this blocks while the message is sent, but not for the
+// gap after it.
+//
+// Returns:
+//   true if a job was started, false if there was nothing we could do yet.
+bool IRsendQueue::handle(void) {
+  if (_irsend->busy()) return false;  // The backend is still playing.
+  if (_active) {  // The last job has finished playing.
+    _active = false;
+    finish(_active_id, _active_callback, true);
+  }
+  if (_gap_timer.elapsed() < _gap) return false;  // Still in the gap.
+  _gap = 0;
+  send_lane_t *lane = _priority.count ? &_priority : &_normal;
+  if (lane->count == 0) return false;
+  send_job_t *job = &lane->jobs[lane->first];
+  _active_id = job->id;
+  _active_callback = job->callback;
+  bool success = sendJob(job);
+  // Remove it from the queue before any callback, so it can enqueue more.
+  lane->first++;
+  if (lane->first >= lane->size) lane->first = 0;
+  lane->count--;
+  if (!_active) finish(_active_id, _active_callback, success);
+  return true;
+}
+
+// Returns: true if there is nothing queued, playing, or being waited on.
+bool IRsendQueue::idle(void) {
+  return !_active && depth() == 0 && _gap_timer.elapsed() >= _gap;
+}
+
+// Returns: Nr. of jobs waiting to be sent.
+uint16_t IRsendQueue::depth(void) { return _normal.count + _priority.count; }
+
+// Returns: Nr. of priority jobs waiting to be sent.
+uint16_t IRsendQueue::priorityDepth(void) { return _priority.count; }
+
+// Discard all the jobs waiting to be sent. They count as failed, and their
+// callbacks are told so.
+void IRsendQueue::clear(void) {
+  send_lane_t *lanes[2] = {&_priority, &_normal};
+  for (uint8_t i = 0; i < 2; i++) {
+    send_lane_t *lane = lanes[i];
+    while (lane->count) {
+      send_job_t *job = &lane->jobs[lane->first];
+      lane->first++;
+      if (lane->first >= lane->size) lane->first = 0;
+      lane->count--;
+      finish(job->id, job->callback, false);
+    }
+    lane->first = 0;
+  }
+}
+
+// Returns: The queue's counters.
+send_queue_stats_t IRsendQueue::getStats(void) { return _stats; }
+
+// Reset the queue's counters.
+void IRsendQueue::resetStats(void) {
+  _stats.enqueued = 0;
+  _stats.sent = 0;
+  _stats.failed = 0;
+  _stats.dropped = 0;
+  _stats.max_depth = depth();
+}
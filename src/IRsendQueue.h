@@ -0,0 +1,127 @@
+#ifndef IRSENDQUEUE_H_
+#define IRSENDQUEUE_H_
+
+// Copyright 2019 David Conran
+
+#define __STDC_LIMIT_MACROS
+#include <stdint.h>
+#include "IRremoteESP8266.h"
+#include "IRac.h"
+#include "IRsend.h"
+#include "IRtimer.h"
+
+// Constants
+// The default sizes. Each can be changed when creating an IRsendQueue.
+const uint16_t kSendQueueLength = 4;          // Nr. of normal jobs.
+const uint16_t kSendQueuePriorityLength = 1;  // Nr. of priority jobs.
+// Nr. of mark/space entries a job may render to. Enough for most simple
+// protocols & many A/C ones. Bigger messages are sent the blocking way.
+const uint16_t kSendQueueBufferSize = 256;
+const uint16_t kSendQueueFull = 0;  // The id returned when a job isn't queued.
+
+// Called when a queued job has finished.
+// Args:
+//   id: The id enqueue() returned for the job.
+//   success: Was the message sent okay?
+typedef void (*send_callback_t)(const uint16_t id, const bool success);
+
+enum send_job_kind_t {
+  kSendJobValue = 0,  // A simple protocol. e.g. NEC.
+  kSendJobState,      // A state based protocol. e.g. A/C messages.
+  kSendJobAc,         // A common A/C state sent via IRac.
+};
+
+typedef struct {
+  uint16_t id;
+  send_job_kind_t kind;
+  decode_type_t type;
+  send_callback_t callback;
+  // Only the members for the job's kind are used, so they can share memory.
+  union {
+    struct {
+      uint64_t value;
+      uint16_t nbits;
+      uint16_t repeat;
+    } simple;  // kSendJobValue
+    struct {
+      uint8_t state[kStateSizeMax];
+      uint16_t nbytes;
+    } raw;  // kSendJobState
+    struct {
+      stdAc::state_t desired;
+      stdAc::state_t prev;
+      bool has_prev;
+    } ac;  // kSendJobAc
+  };
+} send_job_t;
+
+// A bounded ring of jobs.
+typedef struct {
+  send_job_t *jobs;
+  uint16_t size;
+  uint16_t first;
+  uint16_t count;
+} send_lane_t;
+
+typedef struct {
+  uint32_t enqueued;   // Nr. of jobs accepted.
+  uint32_t sent;       // Nr. of jobs sent successfully.
+  uint32_t failed;     // Nr. of jobs that failed to send.
+  uint32_t dropped;    // Nr. of jobs refused. e.g. The queue was full.
+  uint16_t max_depth;  // High water mark of jobs waiting.
+} send_queue_stats_t;
+
+// Class
+class IRsendQueue {
+ public:
+  explicit IRsendQueue(IRsend *irsend, IRac *ac = NULL,
+                       const uint16_t length = kSendQueueLength,
+                       const uint16_t priority_length =
+                           kSendQueuePriorityLength,
+                       const uint16_t buffer_size = kSendQueueBufferSize);
+  ~IRsendQueue(void);
+  uint16_t enqueue(const decode_type_t type, const uint64_t data,
+                   const uint16_t nbits, const uint16_t repeat = kNoRepeat,
+                   send_callback_t callback = NULL,
+                   const bool priority = false);
+  uint16_t enqueue(const decode_type_t type, const uint8_t state[],
+                   const uint16_t nbytes, send_callback_t callback = NULL,
+                   const bool priority = false);
+  uint16_t enqueueAc(const stdAc::state_t desired,
+                     const stdAc::state_t *prev = NULL,
+                     send_callback_t callback = NULL,
+                     const bool priority = false);
+  bool handle(void);
+  bool idle(void);
+  uint16_t depth(void);
+  uint16_t priorityDepth(void);
+  void clear(void);
+  send_queue_stats_t getStats(void);
+  void resetStats(void);
+
+ private:
+  IRsend *_irsend;
+  IRac *_ac;
+  send_lane_t _normal;
+  send_lane_t _priority;
+  uint16_t *_buffer;
+  uint16_t _buffer_size;
+  uint16_t _next_id;
+  send_queue_stats_t _stats;
+  // The job handed to the backend, which hasn't finished playing yet.
+  uint16_t _active_id;
+  send_callback_t _active_callback;
+  bool _active;
+  // The gap we owe after the last message, which we don't busy-wait for.
+  IRtimer _gap_timer;
+  uint32_t _gap;
+  IRsendQueue(const IRsendQueue &);  // Not copyable. It owns its buffers.
+  IRsendQueue &operator=(const IRsendQueue &);
+  send_job_t *push(const bool priority);
+  bool sendNow(const send_job_t *job);
+  bool sendJob(const send_job_t *job);
+  void finish(const uint16_t id, send_callback_t callback,
+              const bool success);
+};
+
+#endif  // IRSENDQUEUE_H_
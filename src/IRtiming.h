@@ -0,0 +1,33 @@
+// Copyright 2019 David Conran
+
+#ifndef IRTIMING_H_
+#define IRTIMING_H_
+
+#define __STDC_LIMIT_MACROS
+#include <stdint.h>
+
+// Compile-time description of a simple protocol's timings.
+//
+// Protocols declare these as `constexpr`, and hand them to the templated
+// IRsend::sendTimed<>() & IRrecv::matchTimed<>() engines. That lets the
+// compiler fold the timings & match windows into constants, rather than
+// passing a dozen values through the generic routines at runtime.
+//
+// All times are in microseconds. A value of 0 means that part isn't used.
+// e.g. No header mark.
+typedef struct {
+  uint16_t hdrmark;     // Header mark.
+  uint32_t hdrspace;    // Header space.
+  uint16_t onemark;     // Mark of a '1' bit.
+  uint32_t onespace;    // Space of a '1' bit.
+  uint16_t zeromark;    // Mark of a '0' bit.
+  uint32_t zerospace;   // Space of a '0' bit.
+  uint16_t footermark;  // Footer mark.
+  uint32_t gap;         // (Minimum) space after the footer.
+  uint32_t mesgtime;    // Minimum length of a whole message, incl. the gap.
+  uint16_t frequency;   // Modulation freq. Assumes < 1000 means kHz else Hz.
+  uint8_t dutycycle;    // Percentage.
+  bool msbfirst;        // Are the data bits sent Most Significant Bit first?
+} protocol_timing_t;
+
+#endif  // IRTIMING_H_
@@ -14,6 +14,24 @@
 #endif
 #include "IRrecv.h"
 #include "IRremoteESP8266.h"
+#include "IRsend.h"
+
+#ifndef ARDUINO
+// Host (i.e. Unit test) stand-ins for the Arduino flash string routines.
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define strcasecmp_P strcasecmp
+#endif  // ARDUINO
+
+// Reverse the order of all 32 bits of a value.
+// Swaps ever smaller halves, rather than moving a bit at a time.
+static uint32_t reverse32(uint32_t input) {
+  input = ((input >> 1) & 0x55555555UL) | ((input & 0x55555555UL) << 1);
+  input = ((input >> 2) & 0x33333333UL) | ((input & 0x33333333UL) << 2);
+  input = ((input >> 4) & 0x0F0F0F0FUL) | ((input & 0x0F0F0F0FUL) << 4);
+  input = ((input >> 8) & 0x00FF00FFUL) | ((input & 0x00FF00FFUL) << 8);
+  return (input >> 16) | (input << 16);
+}
 
 // Reverse the order of the requested least significant nr. of bits.
 // Args:
@@ -25,38 +43,41 @@ uint64_t reverseBits(uint64_t input, uint16_t nbits) {
   if (nbits <= 1) return input;  // Reversing <= 1 bits makes no change at all.
   // Cap the nr. of bits to rotate to the max nr. of bits in the input.
   nbits = std::min(nbits, (uint16_t)(sizeof(input) * 8));
-  uint64_t output = 0;
-  for (uint16_t i = 0; i < nbits; i++) {
-    output <<= 1;
-    output |= (input & 1);
-    input >>= 1;
-  }
+  uint64_t output;
+  // Most callers reverse <= 32 bits, so avoid 64-bit maths when we can.
+  if (nbits <= 32)
+    output = reverse32((uint32_t)input) >> (32 - nbits);
+  else
+    output = (((uint64_t)reverse32((uint32_t)input) << 32) |
+              reverse32((uint32_t)(input >> 32))) >> (64 - nbits);
+  if (nbits == 64) return output;
   // Merge any remaining unreversed bits back to the top of the reversed bits.
-  return (input << nbits) | output;
+  return ((input >> nbits) << nbits) | output;
 }
 
-// Convert a uint64_t (unsigned long long) to a string.
+// Convert a uint64_t (unsigned long long) to a string, in a char buffer.
 // Arduino String/toInt/Serial.print() can't handle printing 64 bit values.
 //
 // Args:
 //   input: The value to print
+//   buf:   Where to store the text. It is always NUL terminated. Can be NULL.
+//   size:  The size of buf, in chars. kUint64StringSize is always enough.
 //   base:  The output base.
 // Returns:
-//   A string representation of the integer.
+//   The nr. of chars in the text. (Excl. the NUL, & even if it didn't fit.)
 // Note: Based on Arduino's Print::printNumber()
-String uint64ToString(uint64_t input, uint8_t base) {
-  String result = "";
+size_t uint64ToString(uint64_t input, char *buf, const size_t size,
+                      uint8_t base) {
   // prevent issues if called with base <= 1
   if (base < 2) base = 10;
   // Check we have a base that we can actually print.
   // i.e. [0-9A-Z] == 36
   if (base > 36) base = 10;
 
-  // Reserve some string space to reduce fragmentation.
-  // 16 bytes should store a uint64 in hex text which is the likely worst case.
-  // 64 bytes would be the worst case (base 2).
-  result.reserve(16);
-
+  // Fill in the digits from the end, least significant first.
+  char digits[kUint64StringSize];
+  char *first = digits + kUint64StringSize - 1;
+  *first = '\0';
   do {
     char c = input % base;
     input /= base;
@@ -65,9 +86,29 @@ String uint64ToString(uint64_t input, uint8_t base) {
       c += '0';
     else
       c += 'A' - 10;
-    result = c + result;
+    *(--first) = c;
   } while (input);
-  return result;
+  size_t length = digits + kUint64StringSize - 1 - first;
+  if (buf != NULL && size) {
+    size_t count = std::min(length, size - 1);
+    memcpy(buf, first, count);
+    buf[count] = '\0';
+  }
+  return length;
+}
+
+// Convert a uint64_t (unsigned long long) to a string.
+// Arduino String/toInt/Serial.print() can't handle printing 64 bit values.
+//
+// Args:
+//   input: The value to print
+//   base:  The output base.
+// Returns:
+//   A string representation of the integer.
+String uint64ToString(uint64_t input, uint8_t base) {
+  char digits[kUint64StringSize];
+  uint64ToString(input, digits, kUint64StringSize, base);
+  return String(digits);
 }
 
 #ifdef ARDUINO
@@ -82,6 +123,103 @@ void serialPrintUint64(uint64_t input, uint8_t base) {
 }
 #endif
 
+// Protocol names -------------------
+//
+// Indexed by decode_type_t, so looking up a name is just an array access.
+// A protocol's name MUST be added here, and to kSortedProtocols[] below,
+// when it is added to decode_type_t.
+static const char kProtocolNames[][kProtocolNameSize] PROGMEM = {
+    "UNUSED",
+    "RC5",
+    "RC6",
+    "NEC",
+    "SONY",
+    "PANASONIC",  // (5)
+    "JVC",
+    "SAMSUNG",
+    "WHYNTER",
+    "AIWA_RC_T501",
+    "LG",  // (10)
+    "SANYO",
+    "MITSUBISHI",
+    "DISH",
+    "SHARP",
+    "COOLIX",  // (15)
+    "DAIKIN",
+    "DENON",
+    "KELVINATOR",
+    "SHERWOOD",
+    "MITSUBISHI_AC",  // (20)
+    "RCMM",
+    "SANYO_LC7461",
+    "RC5X",
+    "GREE",
+    "PRONTO",  // (25)
+    "NEC (non-strict)",  // NEC_LIKE
+    "ARGO",
+    "TROTEC",
+    "NIKAI",
+    "RAW",  // (30)
+    "GLOBALCACHE",
+    "TOSHIBA_AC",
+    "FUJITSU_AC",
+    "MIDEA",
+    "MAGIQUEST",  // (35)
+    "LASERTAG",
+    "CARRIER_AC",
+    "HAIER_AC",
+    "MITSUBISHI2",
+    "HITACHI_AC",  // (40)
+    "HITACHI_AC1",
+    "HITACHI_AC2",
+    "GICABLE",
+    "HAIER_AC_YRW02",
+    "WHIRLPOOL_AC",  // (45)
+    "SAMSUNG_AC",
+    "LUTRON",
+    "ELECTRA_AC",
+    "PANASONIC_AC",
+    "PIONEER",  // (50)
+    "LG2",
+    "MWM",
+    "DAIKIN2",
+    "VESTEL_AC",
+    "TECO",  // (55)
+    "SAMSUNG36",
+    "TCL112AC",
+    "LEGOPF",
+    "MITSUBISHI_HEAVY_88",
+    "MITSUBISHI_HEAVY_152",  // (60)
+    "DAIKIN216",
+    "SHARP_AC",
+    "GOODWEATHER",
+    "INAX",
+    "DAIKIN160",  // (65)
+    "NEOCLIMA",
+};
+static_assert(sizeof(kProtocolNames) / sizeof(kProtocolNames[0]) ==
+              kLastDecodeType + 1, "kProtocolNames[] is out of date.");
+static const char kUnknownStr[] PROGMEM = "UNKNOWN";
+// Other names strToDecodeType() accepts. i.e. The enum name of NEC_LIKE.
+static const char kNecLikeStr[] PROGMEM = "NEC_LIKE";
+
+// The protocols in (case insensitive) alphabetical order of their names, so
+// strToDecodeType() can do a binary search of kProtocolNames[].
+static const uint8_t kSortedProtocols[] PROGMEM = {
+    AIWA_RC_T501, ARGO, CARRIER_AC, COOLIX, DAIKIN, DAIKIN160, DAIKIN2,
+    DAIKIN216, DENON, DISH, ELECTRA_AC, FUJITSU_AC, GICABLE, GLOBALCACHE,
+    GOODWEATHER, GREE, HAIER_AC, HAIER_AC_YRW02, HITACHI_AC, HITACHI_AC1,
+    HITACHI_AC2, INAX, JVC, KELVINATOR, LASERTAG, LEGOPF, LG, LG2, LUTRON,
+    MAGIQUEST, MIDEA, MITSUBISHI, MITSUBISHI2, MITSUBISHI_AC,
+    MITSUBISHI_HEAVY_152, MITSUBISHI_HEAVY_88, MWM, NEC, NEC_LIKE, NEOCLIMA,
+    NIKAI, PANASONIC, PANASONIC_AC, PIONEER, PRONTO, RAW, RC5, RC5X, RC6, RCMM,
+    SAMSUNG, SAMSUNG36, SAMSUNG_AC, SANYO, SANYO_LC7461, SHARP, SHARP_AC,
+    SHERWOOD, SONY, TCL112AC, TECO, TOSHIBA_AC, TROTEC, UNUSED, VESTEL_AC,
+    WHIRLPOOL_AC, WHYNTER,
+};
+static_assert(sizeof(kSortedProtocols) == kLastDecodeType + 1,
+              "kSortedProtocols[] is out of date.");
+
 // Convert a C-style str to a decode_type_t
 //
 // Args:
@@ -89,150 +227,37 @@ void serialPrintUint64(uint64_t input, uint8_t base) {
 // Returns:
 //  A decode_type_t enum.
 decode_type_t strToDecodeType(const char * const str) {
-  if (!strcasecmp(str, "UNKNOWN"))
-    return decode_type_t::UNKNOWN;
-  else if (!strcasecmp(str, "UNUSED"))
-    return decode_type_t::UNUSED;
-  else if (!strcasecmp(str, "AIWA_RC_T501"))
-    return decode_type_t::AIWA_RC_T501;
-  else if (!strcasecmp(str, "ARGO"))
-    return decode_type_t::ARGO;
-  else if (!strcasecmp(str, "CARRIER_AC"))
-    return decode_type_t::CARRIER_AC;
-  else if (!strcasecmp(str, "COOLIX"))
-    return decode_type_t::COOLIX;
-  else if (!strcasecmp(str, "DAIKIN"))
-    return decode_type_t::DAIKIN;
-  else if (!strcasecmp(str, "DAIKIN160"))
-    return decode_type_t::DAIKIN160;
-  else if (!strcasecmp(str, "DAIKIN2"))
-    return decode_type_t::DAIKIN2;
-  else if (!strcasecmp(str, "DAIKIN216"))
-    return decode_type_t::DAIKIN216;
-  else if (!strcasecmp(str, "DENON"))
-    return decode_type_t::DENON;
-  else if (!strcasecmp(str, "DISH"))
-    return decode_type_t::DISH;
-  else if (!strcasecmp(str, "ELECTRA_AC"))
-    return decode_type_t::ELECTRA_AC;
-  else if (!strcasecmp(str, "FUJITSU_AC"))
-    return decode_type_t::FUJITSU_AC;
-  else if (!strcasecmp(str, "GICABLE"))
-    return decode_type_t::GICABLE;
-  else if (!strcasecmp(str, "GLOBALCACHE"))
-    return decode_type_t::GLOBALCACHE;
-  else if (!strcasecmp(str, "GOODWEATHER"))
-    return decode_type_t::GOODWEATHER;
-  else if (!strcasecmp(str, "GREE"))
-    return decode_type_t::GREE;
-  else if (!strcasecmp(str, "HAIER_AC"))
-    return decode_type_t::HAIER_AC;
-  else if (!strcasecmp(str, "HAIER_AC_YRW02"))
-    return decode_type_t::HAIER_AC_YRW02;
-  else if (!strcasecmp(str, "HITACHI_AC"))
-    return decode_type_t::HITACHI_AC;
-  else if (!strcasecmp(str, "HITACHI_AC1"))
-    return decode_type_t::HITACHI_AC1;
-  else if (!strcasecmp(str, "HITACHI_AC2"))
-    return decode_type_t::HITACHI_AC2;
-  else if (!strcasecmp(str, "INAX"))
-    return decode_type_t::INAX;
-  else if (!strcasecmp(str, "JVC"))
-    return decode_type_t::JVC;
-  else if (!strcasecmp(str, "KELVINATOR"))
-    return decode_type_t::KELVINATOR;
-  else if (!strcasecmp(str, "LEGOPF"))
-    return decode_type_t::LEGOPF;
-  else if (!strcasecmp(str, "LG"))
-    return decode_type_t::LG;
-  else if (!strcasecmp(str, "LG2"))
-    return decode_type_t::LG2;
-  else if (!strcasecmp(str, "LASERTAG"))
-    return decode_type_t::LASERTAG;
-  else if (!strcasecmp(str, "LUTRON"))
-    return decode_type_t::LUTRON;
-  else if (!strcasecmp(str, "MAGIQUEST"))
-    return decode_type_t::MAGIQUEST;
-  else if (!strcasecmp(str, "MIDEA"))
-    return decode_type_t::MIDEA;
-  else if (!strcasecmp(str, "MITSUBISHI"))
-    return decode_type_t::MITSUBISHI;
-  else if (!strcasecmp(str, "MITSUBISHI2"))
-    return decode_type_t::MITSUBISHI2;
-  else if (!strcasecmp(str, "MITSUBISHI_AC"))
-    return decode_type_t::MITSUBISHI_AC;
-  else if (!strcasecmp(str, "MITSUBISHI_HEAVY_88"))
-    return decode_type_t::MITSUBISHI_HEAVY_88;
-  else if (!strcasecmp(str, "MITSUBISHI_HEAVY_152"))
-    return decode_type_t::MITSUBISHI_HEAVY_152;
-  else if (!strcasecmp(str, "MWM"))
-    return decode_type_t::MWM;
-  else if (!strcasecmp(str, "NEOCLIMA"))
-    return decode_type_t::NEOCLIMA;
-  else if (!strcasecmp(str, "NEC"))
-    return decode_type_t::NEC;
-  else if (!strcasecmp(str, "NEC_LIKE") ||
-           !strcasecmp(str, "NEC (NON-STRICT)"))
-    return decode_type_t::NEC_LIKE;
-  else if (!strcasecmp(str, "NIKAI"))
-    return decode_type_t::NIKAI;
-  else if (!strcasecmp(str, "PANASONIC"))
-    return decode_type_t::PANASONIC;
-  else if (!strcasecmp(str, "PANASONIC_AC"))
-    return decode_type_t::PANASONIC_AC;
-  else if (!strcasecmp(str, "PIONEER"))
-    return decode_type_t::PIONEER;
-  else if (!strcasecmp(str, "PRONTO"))
-    return decode_type_t::PRONTO;
-  else if (!strcasecmp(str, "RAW"))
-    return decode_type_t::RAW;
-  else if (!strcasecmp(str, "RC5"))
-    return decode_type_t::RC5;
-  else if (!strcasecmp(str, "RC5X"))
-    return decode_type_t::RC5X;
-  else if (!strcasecmp(str, "RC6"))
-    return decode_type_t::RC6;
-  else if (!strcasecmp(str, "RCMM"))
-    return decode_type_t::RCMM;
-  else if (!strcasecmp(str, "SAMSUNG"))
-    return decode_type_t::SAMSUNG;
-  else if (!strcasecmp(str, "SAMSUNG36"))
-    return decode_type_t::SAMSUNG36;
-  else if (!strcasecmp(str, "SAMSUNG_AC"))
-    return decode_type_t::SAMSUNG_AC;
-  else if (!strcasecmp(str, "SANYO"))
-    return decode_type_t::SANYO;
-  else if (!strcasecmp(str, "SANYO_LC7461"))
-    return decode_type_t::SANYO_LC7461;
-  else if (!strcasecmp(str, "SHARP"))
-    return decode_type_t::SHARP;
-  else if (!strcasecmp(str, "SHARP_AC"))
-    return decode_type_t::SHARP_AC;
-  else if (!strcasecmp(str, "SHERWOOD"))
-    return decode_type_t::SHERWOOD;
-  else if (!strcasecmp(str, "SONY"))
-    return decode_type_t::SONY;
-  else if (!strcasecmp(str, "TCL112AC"))
-    return decode_type_t::TCL112AC;
-  else if (!strcasecmp(str, "TECO"))
-    return decode_type_t::TECO;
-  else if (!strcasecmp(str, "TOSHIBA_AC"))
-    return decode_type_t::TOSHIBA_AC;
-  else if (!strcasecmp(str, "TROTEC"))
-    return decode_type_t::TROTEC;
-  else if (!strcasecmp(str, "VESTEL_AC"))
-    return decode_type_t::VESTEL_AC;
-  else if (!strcasecmp(str, "WHIRLPOOL_AC"))
-    return decode_type_t::WHIRLPOOL_AC;
-  else if (!strcasecmp(str, "WHYNTER"))
-    return decode_type_t::WHYNTER;
-  // Handle integer values of the type by converting to a string and back again.
-  decode_type_t result = strToDecodeType(
-      typeToString((decode_type_t)atoi(str)).c_str());
-  if (result > 0)
-    return result;
-  else
-    return decode_type_t::UNKNOWN;
+  int16_t low = 0;
+  int16_t high = kLastDecodeType;
+  while (low <= high) {
+    const int16_t mid = (low + high) / 2;
+    const uint8_t protocol = pgm_read_byte(kSortedProtocols + mid);
+    const int cmp = strcasecmp_P(str, kProtocolNames[protocol]);
+    if (cmp == 0) return (decode_type_t)protocol;
+    if (cmp < 0)
+      high = mid - 1;
+    else
+      low = mid + 1;
+  }
+  if (strcasecmp_P(str, kNecLikeStr) == 0) return decode_type_t::NEC_LIKE;
+  // Handle integer values of the type.
+  const int number = atoi(str);
+  if (number > 0 && number <= kLastDecodeType) return (decode_type_t)number;
+  return decode_type_t::UNKNOWN;
+}
+
+// Convert a protocol type (enum etc) to its name, without using the heap.
+// Args:
+//   protocol: Nr. (enum) of the protocol.
+// Returns:
+//   A ptr to a C-style string containing the protocol name.
+// Note:
+//   The name is stored in flash (PROGMEM). On the ESP8266, that means it must
+//   be accessed with the `_P` string functions, or via FPSTR(). e.g.
+//   `Serial.print(FPSTR(typeToName(protocol)));`
+const char *typeToName(const decode_type_t protocol) {
+  if (protocol < 0 || protocol > kLastDecodeType) return kUnknownStr;
+  return kProtocolNames[protocol];
 }
 
 // Convert a protocol type (enum etc) to a human readable string.
@@ -242,214 +267,11 @@ decode_type_t strToDecodeType(const char * const str) {
 // Returns:
 //   A string containing the protocol name.
 String typeToString(const decode_type_t protocol, const bool isRepeat) {
-  String result = "";
-  switch (protocol) {
-    case UNUSED:
-      result = F("UNUSED");
-      break;
-    case AIWA_RC_T501:
-      result = F("AIWA_RC_T501");
-      break;
-    case ARGO:
-      result = F("ARGO");
-      break;
-    case CARRIER_AC:
-      result = F("CARRIER_AC");
-      break;
-    case COOLIX:
-      result = F("COOLIX");
-      break;
-    case DAIKIN:
-      result = F("DAIKIN");
-      break;
-    case DAIKIN160:
-      result = F("DAIKIN160");
-      break;
-    case DAIKIN2:
-      result = F("DAIKIN2");
-      break;
-    case DAIKIN216:
-      result = F("DAIKIN216");
-      break;
-    case DENON:
-      result = F("DENON");
-      break;
-    case DISH:
-      result = F("DISH");
-      break;
-    case ELECTRA_AC:
-      result = F("ELECTRA_AC");
-      break;
-    case FUJITSU_AC:
-      result = F("FUJITSU_AC");
-      break;
-    case GICABLE:
-      result = F("GICABLE");
-      break;
-    case GLOBALCACHE:
-      result = F("GLOBALCACHE");
-      break;
-    case GOODWEATHER:
-      result = F("GOODWEATHER");
-      break;
-    case GREE:
-      result = F("GREE");
-      break;
-    case HAIER_AC:
-      result = F("HAIER_AC");
-      break;
-    case HAIER_AC_YRW02:
-      result = F("HAIER_AC_YRW02");
-      break;
-    case HITACHI_AC:
-      result = F("HITACHI_AC");
-      break;
-    case HITACHI_AC1:
-      result = F("HITACHI_AC1");
-      break;
-    case HITACHI_AC2:
-      result = F("HITACHI_AC2");
-      break;
-    case INAX:
-      result = F("INAX");
-      break;
-    case JVC:
-      result = F("JVC");
-      break;
-    case KELVINATOR:
-      result = F("KELVINATOR");
-      break;
-    case LEGOPF:
-      result = F("LEGOPF");
-      break;
-    case LG:
-      result = F("LG");
-      break;
-    case LG2:
-      result = F("LG2");
-      break;
-    case LASERTAG:
-      result = F("LASERTAG");
-      break;
-    case LUTRON:
-      result = F("LUTRON");
-      break;
-    case MAGIQUEST:
-      result = F("MAGIQUEST");
-      break;
-    case MIDEA:
-      result = F("MIDEA");
-      break;
-    case MITSUBISHI:
-      result = F("MITSUBISHI");
-      break;
-    case MITSUBISHI2:
-      result = F("MITSUBISHI2");
-      break;
-    case MITSUBISHI_AC:
-      result = F("MITSUBISHI_AC");
-      break;
-    case MITSUBISHI_HEAVY_88:
-      result = F("MITSUBISHI_HEAVY_88");
-      break;
-    case MITSUBISHI_HEAVY_152:
-      result = F("MITSUBISHI_HEAVY_152");
-      break;
-    case MWM:
-      result = F("MWM");
-      break;
-    case NEOCLIMA:
-      result = F("NEOCLIMA");
-      break;
-    case NEC:
-      result = F("NEC");
-      break;
-    case NEC_LIKE:
-      result = F("NEC (non-strict)");
-      break;
-    case NIKAI:
-      result = F("NIKAI");
-      break;
-    case PANASONIC:
-      result = F("PANASONIC");
-      break;
-    case PANASONIC_AC:
-      result = F("PANASONIC_AC");
-      break;
-    case PIONEER:
-      result = F("PIONEER");
-      break;
-    case PRONTO:
-      result = F("PRONTO");
-      break;
-    case RAW:
-      result = F("RAW");
-      break;
-    case RC5:
-      result = F("RC5");
-      break;
-    case RC5X:
-      result = F("RC5X");
-      break;
-    case RC6:
-      result = F("RC6");
-      break;
-    case RCMM:
-      result = F("RCMM");
-      break;
-    case SAMSUNG:
-      result = F("SAMSUNG");
-      break;
-    case SAMSUNG36:
-      result = F("SAMSUNG36");
-      break;
-    case SAMSUNG_AC:
-      result = F("SAMSUNG_AC");
-      break;
-    case SANYO:
-      result = F("SANYO");
-      break;
-    case SANYO_LC7461:
-      result = F("SANYO_LC7461");
-      break;
-    case SHARP:
-      result = F("SHARP");
-      break;
-    case SHARP_AC:
-      result = F("SHARP_AC");
-      break;
-    case SHERWOOD:
-      result = F("SHERWOOD");
-      break;
-    case SONY:
-      result = F("SONY");
-      break;
-    case TCL112AC:
-      result = F("TCL112AC");
-      break;
-    case TECO:
-      result = F("TECO");
-      break;
-    case TOSHIBA_AC:
-      result = F("TOSHIBA_AC");
-      break;
-    case TROTEC:
-      result = F("TROTEC");
-      break;
-    case VESTEL_AC:
-      result = F("VESTEL_AC");
-      break;
-    case WHIRLPOOL_AC:
-      result = F("WHIRLPOOL_AC");
-      break;
-    case WHYNTER:
-      result = F("WHYNTER");
-      break;
-    case UNKNOWN:
-    default:
-      result = F("UNKNOWN");
-      break;
-  }
+#ifdef ARDUINO
+  String result = FPSTR(typeToName(protocol));
+#else
+  String result = typeToName(protocol);
+#endif  // ARDUINO
   if (isRepeat) result += F(" (Repeat)");
   return result;
 }
@@ -496,71 +318,196 @@ bool hasACState(const decode_type_t protocol) {
 // Returns:
 //   A uint16_t containing the length.
 uint16_t getCorrectedRawLength(const decode_results * const results) {
-  uint16_t extended_length = results->rawlen - 1;
-  for (uint16_t i = 0; i < results->rawlen - 1; i++) {
-    uint32_t usecs = results->rawbuf[i] * kRawTick;
-    // Add two extra entries for multiple larger than UINT16_MAX it is.
-    extended_length += (usecs / (UINT16_MAX + 1)) * 2;
+  return resultToRawIterator(results).length();
+}
+
+// Text output -------------------
+//
+// The result formatters write their text to a text_sink_t, which can be any
+// (or all) of: A fixed size char buffer, an Arduino Print (e.g. Serial), or a
+// String. Writing to a buffer or a Print never touches the heap.
+
+typedef struct {
+  char *buf;    // The buffer to write to. NULL if none.
+  size_t size;  // The size of buf, incl. the terminating NUL.
+  size_t len;   // Nr. of chars written so far. Incl. any that didn't fit.
+#ifdef ARDUINO
+  Print *print;  // The Print to write to. NULL if none.
+#endif  // ARDUINO
+  String *str;  // The String to append to. NULL if none.
+} text_sink_t;
+
+// A formatter that writes a decode_results out as text.
+typedef void (*result_writer_t)(text_sink_t *sink,
+                                const decode_results * const results);
+
+static void sinkInit(text_sink_t *sink, char *buf, const size_t size) {
+  sink->buf = buf;
+  sink->size = size;
+  sink->len = 0;
+#ifdef ARDUINO
+  sink->print = NULL;
+#endif  // ARDUINO
+  sink->str = NULL;
+  if (buf != NULL && size) buf[0] = '\0';
+}
+
+// Copy as much of some text as will still fit into the sink's buffer.
+static void sinkCopy(text_sink_t *sink, const char *text,
+                     const size_t length) {
+  if (sink->buf != NULL && sink->len + 1 < sink->size) {
+    size_t count = std::min(length, sink->size - 1 - sink->len);
+    memcpy(sink->buf + sink->len, text, count);
+    sink->buf[sink->len + count] = '\0';
   }
-  return extended_length;
+  sink->len += length;
 }
 
-// Return a string containing the key values of a decode_results structure
-// in a C/C++ code style format.
-String resultToSourceCode(const decode_results * const results) {
+// Write a NUL terminated string to the sink.
+static void sinkWrite(text_sink_t *sink, const char *text) {
+  sinkCopy(sink, text, strlen(text));
+#ifdef ARDUINO
+  if (sink->print != NULL) sink->print->print(text);
+#endif  // ARDUINO
+  if (sink->str != NULL) *sink->str += text;
+}
+
+#ifdef ARDUINO
+// Write a flash (i.e. F()) string to the sink.
+static void sinkWrite(text_sink_t *sink, const __FlashStringHelper *text) {
+  PGM_P ptext = reinterpret_cast<PGM_P>(text);
+  char chunk[16];  // Flash has to be copied to RAM first.
+  const size_t length = strlen_P(ptext);
+  for (size_t done = 0; done < length; done += sizeof(chunk)) {
+    size_t count = std::min(length - done, sizeof(chunk));
+    memcpy_P(chunk, ptext + done, count);
+    sinkCopy(sink, chunk, count);
+  }
+  if (sink->print != NULL) sink->print->print(text);
+  if (sink->str != NULL) *sink->str += text;
+}
+#endif  // ARDUINO
+
+// Write a single char to the sink.
+static void sinkWrite(text_sink_t *sink, const char c) {
+  const char text[2] = {c, '\0'};
+  sinkWrite(sink, text);
+}
+
+// Write a number to the sink, space padded on the left to `width` chars.
+static void sinkUint64(text_sink_t *sink, const uint64_t value,
+                       const uint8_t base = 10, const uint8_t width = 0) {
+  char digits[kUint64StringSize];
+  for (size_t length = uint64ToString(value, digits, kUint64StringSize, base);
+       length < width; length++)
+    sinkWrite(sink, ' ');
+  sinkWrite(sink, digits);
+}
+
+// Write a protocol's name to the sink.
+static void sinkType(text_sink_t *sink, const decode_type_t protocol,
+                     const bool isRepeat = false) {
+#ifdef ARDUINO
+  sinkWrite(sink, FPSTR(typeToName(protocol)));
+#else
+  sinkWrite(sink, typeToName(protocol));
+#endif  // ARDUINO
+  if (isRepeat) sinkWrite(sink, F(" (Repeat)"));
+}
+
+// Run a formatter over a decode_results, into a caller supplied buffer.
+static size_t resultToBuffer(result_writer_t writer,
+                             const decode_results * const results, char *buf,
+                             const size_t size) {
+  text_sink_t sink;
+  sinkInit(&sink, buf, size);
+  writer(&sink, results);
+  return sink.len;
+}
+
+#ifdef ARDUINO
+// Run a formatter over a decode_results, straight out to a Print.
+static size_t resultToPrint(result_writer_t writer,
+                            const decode_results * const results,
+                            Print *out) {
+  text_sink_t sink;
+  sinkInit(&sink, NULL, 0);
+  sink.print = out;
+  writer(&sink, results);
+  return sink.len;
+}
+#endif  // ARDUINO
+
+// Run a formatter over a decode_results, into a String.
+// It is run twice. Once to find out how big the String needs to be, so the
+// String is only allocated once.
+static String resultToString(result_writer_t writer,
+                             const decode_results * const results) {
   String output = "";
-  // Reserve some space for the string to reduce heap fragmentation.
-  output.reserve(1536);  // 1.5KB should cover most cases.
+  output.reserve(resultToBuffer(writer, results, NULL, 0));
+  text_sink_t sink;
+  sinkInit(&sink, NULL, 0);
+  sink.str = &output;
+  writer(&sink, results);
+  return output;
+}
+
+// Write the key values of a decode_results structure in a C/C++ code style
+// format.
+static void writeSourceCode(text_sink_t *sink,
+                            const decode_results * const results) {
   // Start declaration
-  output += F("uint16_t ");  // variable type
-  output += F("rawData[");   // array name
-  output += uint64ToString(getCorrectedRawLength(results), 10);
+  sinkWrite(sink, F("uint16_t "));  // variable type
+  sinkWrite(sink, F("rawData["));   // array name
+  sinkUint64(sink, getCorrectedRawLength(results));
   // array size
-  output += F("] = {");  // Start declaration
+  sinkWrite(sink, F("] = {"));  // Start declaration
 
   // Dump data
   for (uint16_t i = 1; i < results->rawlen; i++) {
     uint32_t usecs;
     for (usecs = results->rawbuf[i] * kRawTick; usecs > UINT16_MAX;
          usecs -= UINT16_MAX) {
-      output += uint64ToString(UINT16_MAX);
+      sinkUint64(sink, UINT16_MAX);
       if (i % 2)
-        output += F(", 0,  ");
+        sinkWrite(sink, F(", 0,  "));
       else
-        output += F(",  0, ");
+        sinkWrite(sink, F(",  0, "));
     }
-    output += uint64ToString(usecs, 10);
+    sinkUint64(sink, usecs);
     if (i < results->rawlen - 1)
-      output += F(", ");            // ',' not needed on the last one
-    if (i % 2 == 0) output += ' ';  // Extra if it was even.
+      sinkWrite(sink, F(", "));            // ',' not needed on the last one
+    if (i % 2 == 0) sinkWrite(sink, ' ');  // Extra if it was even.
   }
 
   // End declaration
-  output += F("};");
+  sinkWrite(sink, F("};"));
 
   // Comment
-  output += F("  // ");
-  output += typeToString(results->decode_type, results->repeat);
+  sinkWrite(sink, F("  // "));
+  sinkType(sink, results->decode_type, results->repeat);
   // Only display the value if the decode type doesn't have an A/C state.
-  if (!hasACState(results->decode_type))
-    output += ' ' + uint64ToString(results->value, 16);
-  output += F("\n");
+  if (!hasACState(results->decode_type)) {
+    sinkWrite(sink, ' ');
+    sinkUint64(sink, results->value, 16);
+  }
+  sinkWrite(sink, F("\n"));
 
   // Now dump "known" codes
   if (results->decode_type != UNKNOWN) {
     if (hasACState(results->decode_type)) {
 #if DECODE_AC
       uint16_t nbytes = results->bits / 8;
-      output += F("uint8_t state[");
-      output += uint64ToString(nbytes);
-      output += F("] = {");
+      sinkWrite(sink, F("uint8_t state["));
+      sinkUint64(sink, nbytes);
+      sinkWrite(sink, F("] = {"));
       for (uint16_t i = 0; i < nbytes; i++) {
-        output += F("0x");
-        if (results->state[i] < 0x10) output += '0';
-        output += uint64ToString(results->state[i], 16);
-        if (i < nbytes - 1) output += F(", ");
+        sinkWrite(sink, F("0x"));
+        if (results->state[i] < 0x10) sinkWrite(sink, '0');
+        sinkUint64(sink, results->state[i], 16);
+        if (i < nbytes - 1) sinkWrite(sink, F(", "));
       }
-      output += F("};\n");
+      sinkWrite(sink, F("};\n"));
 #endif  // DECODE_AC
     } else {
       // Simple protocols
@@ -568,89 +515,195 @@ String resultToSourceCode(const decode_results * const results) {
       // NOTE: It will ignore the atypical case when a message has been
       // decoded but the address & the command are both 0.
       if (results->address > 0 || results->command > 0) {
-        output += F("uint32_t address = 0x");
-        output += uint64ToString(results->address, 16);
-        output += F(";\n");
-        output += F("uint32_t command = 0x");
-        output += uint64ToString(results->command, 16);
-        output += F(";\n");
+        sinkWrite(sink, F("uint32_t address = 0x"));
+        sinkUint64(sink, results->address, 16);
+        sinkWrite(sink, F(";\n"));
+        sinkWrite(sink, F("uint32_t command = 0x"));
+        sinkUint64(sink, results->command, 16);
+        sinkWrite(sink, F(";\n"));
       }
       // Most protocols have data
-      output += F("uint64_t data = 0x");
-      output += uint64ToString(results->value, 16);
-      output += F(";\n");
+      sinkWrite(sink, F("uint64_t data = 0x"));
+      sinkUint64(sink, results->value, 16);
+      sinkWrite(sink, F(";\n"));
     }
   }
-  return output;
 }
 
-// Dump out the decode_results structure.
-//
-String resultToTimingInfo(const decode_results * const results) {
-  String output = "";
-  String value = "";
-  // Reserve some space for the string to reduce heap fragmentation.
-  output.reserve(2048);  // 2KB should cover most cases.
-  value.reserve(6);  // Max value should be 2^17 = 131072
-  output += F("Raw Timing[");
-  output += uint64ToString(results->rawlen - 1, 10);
-  output += F("]:\n");
+// Write out the raw timings of the decode_results structure.
+static void writeTimingInfo(text_sink_t *sink,
+                            const decode_results * const results) {
+  sinkWrite(sink, F("Raw Timing["));
+  sinkUint64(sink, results->rawlen - 1);
+  sinkWrite(sink, F("]:\n"));
 
   for (uint16_t i = 1; i < results->rawlen; i++) {
     if (i % 2 == 0)
-      output += '-';  // even
+      sinkWrite(sink, '-');  // even
     else
-      output += F("   +");  // odd
-    value = uint64ToString(results->rawbuf[i] * kRawTick);
+      sinkWrite(sink, F("   +"));  // odd
     // Space pad the value till it is at least 6 chars long.
-    while (value.length() < 6) value = ' ' + value;
-    output += value;
+    sinkUint64(sink, results->rawbuf[i] * kRawTick, 10, 6);
     if (i < results->rawlen - 1)
-      output += F(", ");  // ',' not needed for last one
-    if (!(i % 8)) output += '\n';  // Newline every 8 entries.
+      sinkWrite(sink, F(", "));  // ',' not needed for last one
+    if (!(i % 8)) sinkWrite(sink, '\n');  // Newline every 8 entries.
   }
-  output += '\n';
-  return output;
+  sinkWrite(sink, '\n');
 }
 
-// Convert the decode_results structure's value/state to simple hexadecimal.
-//
-String resultToHexidecimal(const decode_results * const result) {
-  String output = "";
-  // Reserve some space for the string to reduce heap fragmentation.
-  output.reserve(2 * kStateSizeMax);  // Should cover worst cases.
+// Write the decode_results structure's value/state as simple hexadecimal.
+static void writeHexidecimal(text_sink_t *sink,
+                             const decode_results * const result) {
   if (hasACState(result->decode_type)) {
 #if DECODE_AC
     for (uint16_t i = 0; result->bits > i * 8; i++) {
-      if (result->state[i] < 0x10) output += '0';  // Zero pad
-      output += uint64ToString(result->state[i], 16);
+      if (result->state[i] < 0x10) sinkWrite(sink, '0');  // Zero pad
+      sinkUint64(sink, result->state[i], 16);
     }
 #endif  // DECODE_AC
   } else {
-    output += uint64ToString(result->value, 16);
+    sinkUint64(sink, result->value, 16);
   }
-  return output;
+}
+
+// Write the basics of the decode_results structure. i.e. Protocol & value.
+static void writeHumanReadableBasic(text_sink_t *sink,
+                                    const decode_results * const results) {
+  // Show Encoding standard
+  sinkWrite(sink, F("Encoding  : "));
+  sinkType(sink, results->decode_type, results->repeat);
+  sinkWrite(sink, '\n');
+
+  // Show Code & length
+  sinkWrite(sink, F("Code      : "));
+  writeHexidecimal(sink, results);
+  sinkWrite(sink, F(" ("));
+  sinkUint64(sink, results->bits);
+  sinkWrite(sink, F(" bits)\n"));
+}
+
+// Return a string containing the key values of a decode_results structure
+// in a C/C++ code style format.
+String resultToSourceCode(const decode_results * const results) {
+  return resultToString(writeSourceCode, results);
+}
+
+// Write the key values of a decode_results structure in a C/C++ code style
+// format into a caller supplied buffer. No memory is allocated.
+//
+// Args:
+//   results: A pointer to the decode_results to describe.
+//   buf:     Where to store the text. It is always NUL terminated.
+//            It can be NULL, to find out how big it needs to be.
+//   size:    The size of buf, in chars.
+// Returns:
+//   The nr. of chars in the full text. (Excl. the NUL.)
+//   If it is >= size, the text didn't fit & has been truncated.
+size_t resultToSourceCode(const decode_results * const results, char *buf,
+                          const size_t size) {
+  return resultToBuffer(writeSourceCode, results, buf, size);
+}
+
+// Dump out the decode_results structure.
+//
+String resultToTimingInfo(const decode_results * const results) {
+  return resultToString(writeTimingInfo, results);
+}
+
+// Dump out the decode_results structure into a caller supplied buffer.
+// No memory is allocated. See resultToSourceCode() for the Args & Returns.
+size_t resultToTimingInfo(const decode_results * const results, char *buf,
+                          const size_t size) {
+  return resultToBuffer(writeTimingInfo, results, buf, size);
+}
+
+// Convert the decode_results structure's value/state to simple hexadecimal.
+//
+String resultToHexidecimal(const decode_results * const result) {
+  return resultToString(writeHexidecimal, result);
+}
+
+// Convert the decode_results structure's value/state to simple hexadecimal,
+// in a caller supplied buffer. No memory is allocated.
+// See resultToSourceCode() for the Args & Returns.
+size_t resultToHexidecimal(const decode_results * const result, char *buf,
+                           const size_t size) {
+  return resultToBuffer(writeHexidecimal, result, buf, size);
 }
 
 // Dump out the decode_results structure.
 //
 String resultToHumanReadableBasic(const decode_results * const results) {
-  String output = "";
-  // Reserve some space for the string to reduce heap fragmentation.
-  output.reserve(2 * kStateSizeMax + 50);  // Should cover most cases.
-  // Show Encoding standard
-  output += F("Encoding  : ");
-  output += typeToString(results->decode_type, results->repeat);
-  output += '\n';
+  return resultToString(writeHumanReadableBasic, results);
+}
 
-  // Show Code & length
-  output += F("Code      : ");
-  output += resultToHexidecimal(results);
-  output += F(" (");
-  output += uint64ToString(results->bits);
-  output += F(" bits)\n");
+// Dump out the decode_results structure into a caller supplied buffer.
+// No memory is allocated. See resultToSourceCode() for the Args & Returns.
+size_t resultToHumanReadableBasic(const decode_results * const results,
+                                  char *buf, const size_t size) {
+  return resultToBuffer(writeHumanReadableBasic, results, buf, size);
+}
+
+#ifdef ARDUINO
+// Print the formatted decode_results straight out to a Print. e.g. Serial.
+// No memory is allocated.
+//
+// Args:
+//   results: A pointer to the decode_results to describe.
+//   out:     A pointer to where to print it. e.g. &Serial
+// Returns:
+//   The nr. of chars printed.
+size_t resultToSourceCode(const decode_results * const results, Print *out) {
+  return resultToPrint(writeSourceCode, results, out);
+}
+
+size_t resultToTimingInfo(const decode_results * const results, Print *out) {
+  return resultToPrint(writeTimingInfo, results, out);
+}
+
+size_t resultToHexidecimal(const decode_results * const result, Print *out) {
+  return resultToPrint(writeHexidecimal, result, out);
+}
+
+size_t resultToHumanReadableBasic(const decode_results * const results,
+                                  Print *out) {
+  return resultToPrint(writeHumanReadableBasic, results, out);
+}
+#endif  // ARDUINO
+
+#if DECODE_STATS
+// Convert a snapshot of IRrecv's decode statistics into a human readable
+// summary. Only protocols that have been attempted are listed.
+// Args:
+//   stats:  A pointer to a decode_stats_t from IRrecv::getDecodeStats().
+// Returns:
+//   A String containing the summary.
+String decodeStatsToString(const decode_stats_t * const stats) {
+  String output = "";
+  output += F("Messages  : ");
+  output += uint64ToString(stats->messages);
+  output += F(" (Overflows: ");
+  output += uint64ToString(stats->overflows);
+  output += F(", Timeouts: ");
+  output += uint64ToString(stats->timeouts);
+  output += F(")\n");
+  for (int16_t i = UNKNOWN; i <= kLastDecodeType; i++) {
+    const decode_protocol_stats_t *stat = &stats->protocols[i + 1];
+    if (!stat->attempts) continue;
+    output += typeToString((decode_type_t)i);
+    output += F(": ");
+    output += uint64ToString(stat->attempts);
+    output += F(" attempts, ");
+    output += uint64ToString(stat->hits);
+    output += F(" hits, ");
+    output += uint64ToString(stat->total_usecs);
+    output += F("uS total, ");
+    output += uint64ToString(stat->max_usecs);
+    output += F("uS max\n");
+  }
   return output;
 }
+#endif  // DECODE_STATS
 
 // Convert a decode_results into an array suitable for `sendRaw()`.
 // Args:
@@ -659,40 +712,533 @@ String resultToHumanReadableBasic(const decode_results * const results) {
 //   A pointer to a dynamically allocated uint16_t sendRaw compatible array.
 // Note:
 //   Result needs to be delete[]'ed/free()'ed (deallocated) after use by caller.
+//   resultToRawIterator() does the same job without allocating any memory.
 uint16_t* resultToRawArray(const decode_results * const decode) {
-  uint16_t *result = new uint16_t[getCorrectedRawLength(decode)];
+  IRrawIterator raw = resultToRawIterator(decode);
+  uint16_t *result = new uint16_t[raw.length()];
   if (result != NULL) {  // The memory was allocated successfully.
     // Convert the decode data.
     uint16_t pos = 0;
-    for (uint16_t i = 1; i < decode->rawlen; i++) {
-      uint32_t usecs = decode->rawbuf[i] * kRawTick;
-      while (usecs > UINT16_MAX) {  // Keep truncating till it fits.
-        result[pos++] = UINT16_MAX;
-        result[pos++] = 0;  // A 0 in a sendRaw() array basically means skip.
-        usecs -= UINT16_MAX;
+    while (raw.next(&result[pos])) pos++;
+  }
+  return result;
+}
+
+// Get an iterator over the `sendRaw()` compatible version of a capture.
+// i.e. The same values resultToRawArray() would produce, but one at a time,
+// and without allocating any memory.
+// Args:
+//   decode:  A pointer to an IR decode_results structure that contains a mesg.
+// Returns:
+//   An IRrawIterator. It only refers to the capture's rawbuf, so it is only
+//   valid while that is left untouched. e.g. Until IRrecv::resume().
+// Example:
+//   IRrawIterator raw = resultToRawIterator(&results);
+//   irsend.sendRaw(&raw, 38000);
+IRrawIterator resultToRawIterator(const decode_results * const decode) {
+  // rawbuf[0] is the gap before the message, so skip it.
+  if (decode->rawlen < 1) return IRrawIterator(decode->rawbuf, 0, kRawTick);
+  return IRrawIterator(decode->rawbuf + 1, decode->rawlen - 1, kRawTick);
+}
+
+// Compressed captures -------------------
+//
+// Marks (and spaces) in a message are nearly always one of a handful of
+// lengths. e.g. A header mark, & a bit mark. So each type is clustered into
+// a small alphabet of symbols, and every duration is replaced by a (canonical
+// Huffman) code for its symbol. The most common ones (e.g. The bit mark) only
+// take a single bit.
+// If there are more different durations than kCaptureMaxSymbols, the last
+// symbol is a literal one (with a duration of 0). Its code is followed by the
+// actual duration (16 bits), so any capture can be kept.
+// When it has to be lossless, each code is also followed by how far that
+// duration is from its symbol (the jitter), as a Rice code. i.e. The sign
+// folded into the lowest bit, then the top bits in unary, then the bottom
+// `rice` bits. Each symbol has the nr. of bottom bits that suits its spread,
+// or none at all if every duration in it is exactly the symbol.
+//
+// Layout. All multi-byte values are little-endian.
+//   Nr. of mark symbols (1 byte, | kCaptureJitter if any jitter is kept),
+//   Nr. of space symbols (1 byte), Nr. of durations (2 bytes),
+//   The mark, then space, symbols. (2 bytes each, in kRawTick units)
+//   The code length of each of those symbols. (4 bits each, low nibble first)
+//   The Rice bits of each of those symbols, if any jitter is kept. (Ditto)
+//   The code of each duration, then the duration itself for a literal one,
+//   or its jitter. (Most significant bit first, packed into the least
+//   significant bits of each byte first)
+
+// Longest code for a symbol. It has to fit in 4 bits.
+const uint8_t kCaptureMaxCodeBits = 15;
+// The duration of the literal symbol, & the nr. of bits of each literal.
+const uint16_t kCaptureLiteral = 0;
+const uint8_t kCaptureLiteralBits = 16;
+// Percentage durations are clustered within, when it has to be lossless.
+const uint8_t kCaptureJitterTolerance = 3;
+// The Rice bits of a symbol without any jitter, & the most it can have.
+const uint8_t kCaptureNoJitter = 0xF;
+const uint8_t kCaptureMaxRiceBits = 14;
+// More (folded) jitter than this can't be a valid duration.
+const uint32_t kCaptureMaxJitter = 2UL * UINT16_MAX;
+
+// Cluster either the marks, or the spaces, of a capture into symbols.
+// The longest duration not yet in a symbol starts a new one, which includes
+// everything within `tolerance` percent below it. Its value is their average.
+// If the last symbol available isn't enough for the rest, it is the literal
+// one instead.
+// Args:
+//   results: The capture.
+//   first: Where in rawbuf to start. 1 for marks, 2 for spaces.
+//   tolerance: Percentage to cluster durations within.
+//   symbols: Where to store the symbols. (Longest first)
+//   lower: Where to store the shortest duration in each symbol.
+//   freq: Where to store how many durations are in each symbol.
+// Returns:
+//   The nr. of symbols.
+static uint8_t clusterDurations(const decode_results * const results,
+                                const uint16_t first, const uint8_t tolerance,
+                                uint16_t symbols[], uint16_t lower[],
+                                uint32_t freq[]) {
+  uint32_t limit = UINT16_MAX + 1;
+  uint8_t count = 0;
+  while (limit) {
+    bool found = false;
+    uint16_t top = 0;
+    for (uint16_t i = first; i < results->rawlen; i += 2)
+      if (results->rawbuf[i] < limit && (!found || results->rawbuf[i] > top)) {
+        top = results->rawbuf[i];
+        found = true;
+      }
+    if (!found) break;
+    uint16_t bottom = top - (uint32_t)top * tolerance / 100;
+    bool literal = false;
+    if (count == kCaptureMaxSymbols - 1)  // The last one. Is it enough?
+      for (uint16_t i = first; i < results->rawlen; i += 2)
+        if (results->rawbuf[i] < bottom) literal = true;
+    if (literal) bottom = 0;
+    uint32_t sum = 0;
+    uint32_t members = 0;
+    for (uint16_t i = first; i < results->rawlen; i += 2)
+      if (results->rawbuf[i] >= bottom && results->rawbuf[i] < limit) {
+        sum += results->rawbuf[i];
+        members++;
       }
-      result[pos++] = usecs;
+    symbols[count] = literal ? kCaptureLiteral
+                             : (sum + members / 2) / members;
+    lower[count] = bottom;
+    freq[count] = members;
+    count++;
+    limit = bottom;
+  }
+  return count;
+}
+
+// Calculate the (Huffman) code length of each symbol from how often it is
+// used. None are longer than kCaptureMaxCodeBits.
+// Args:
+//   freq: How many times each symbol is used. Altered if codes are too long.
+//   count: Nr. of symbols.
+//   lengths: Where to store the code length of each symbol.
+static void codeLengths(uint32_t freq[], const uint8_t count,
+                        uint8_t lengths[]) {
+  if (count == 1) {  // A single symbol doesn't need a code at all.
+    lengths[0] = 0;
+    return;
+  }
+  uint32_t weight[2 * kCaptureMaxSymbols];
+  uint8_t parent[2 * kCaptureMaxSymbols];
+  bool done;
+  do {
+    for (uint8_t i = 0; i < count; i++) weight[i] = freq[i];
+    uint8_t nodes = count;
+    bool merged[2 * kCaptureMaxSymbols] = {false};
+    // Repeatedly join the two least used (sub)trees.
+    for (uint8_t joins = 1; joins < count; joins++) {
+      uint8_t least[2];
+      for (uint8_t n = 0; n < 2; n++) {
+        int16_t best = -1;
+        for (uint8_t i = 0; i < nodes; i++)
+          if (!merged[i] && (best < 0 || weight[i] < weight[best])) best = i;
+        merged[best] = true;
+        least[n] = best;
+      }
+      weight[nodes] = weight[least[0]] + weight[least[1]];
+      parent[least[0]] = nodes;
+      parent[least[1]] = nodes;
+      nodes++;
     }
+    // The code length of a symbol is its depth in the tree.
+    done = true;
+    for (uint8_t i = 0; i < count; i++) {
+      lengths[i] = 0;
+      for (uint8_t node = i; node != nodes - 1; node = parent[node])
+        lengths[i]++;
+      if (lengths[i] > kCaptureMaxCodeBits) done = false;
+    }
+    // Too long, so even out how often they're used & try again.
+    if (!done)
+      for (uint8_t i = 0; i < count; i++) freq[i] = (freq[i] + 1) / 2;
+  } while (!done);
+}
+
+// Get the canonical Huffman code of a symbol from the code lengths.
+// Codes are assigned in order of length, then symbol nr.
+static uint16_t symbolCode(const uint8_t lengths[], const uint8_t count,
+                           const uint8_t nr) {
+  uint16_t code = 0;
+  for (uint8_t len = 1; len <= lengths[nr]; len++) {
+    for (uint8_t i = 0; i < count; i++)
+      if (lengths[i] == len && (len < lengths[nr] || i < nr)) code++;
+    if (len < lengths[nr]) code <<= 1;
   }
-  return result;
+  return code;
+}
+
+// The nr. of bits a Rice code of the (folded) jitter takes.
+static inline uint32_t riceBits(const uint32_t folded, const uint8_t rice) {
+  return (folded >> rice) + 1 + rice;
 }
 
+// Fold the sign of the jitter of a duration into the lowest bit.
+// i.e. 0, -1, 1, -2, 2 ... become 0, 1, 2, 3, 4 ...
+static inline uint32_t foldJitter(const uint16_t duration,
+                                  const uint16_t symbol) {
+  return duration >= symbol ? 2UL * (duration - symbol)
+                            : 2UL * (symbol - duration) - 1;
+}
+
+// Pick how many Rice bits suit the jitter of each symbol best.
+// Args:
+//   results: The capture.
+//   first: Where in rawbuf to start. 1 for marks, 2 for spaces.
+//   symbols: The symbols. (Longest first)
+//   lower: The shortest duration in each symbol.
+//   count: Nr. of symbols.
+//   rice: Where to store the Rice bits of each symbol.
+//   bits: Where to store the nr. of bits the jitter takes for each symbol.
+static void riceParameters(const decode_results * const results,
+                           const uint16_t first, const uint16_t symbols[],
+                           const uint16_t lower[], const uint8_t count,
+                           uint8_t rice[], uint32_t bits[]) {
+  bool exact[kCaptureMaxSymbols];
+  for (uint8_t s = 0; s < count; s++) {
+    rice[s] = kCaptureNoJitter;
+    bits[s] = 0;
+    exact[s] = true;
+  }
+  for (uint8_t k = 0; k <= kCaptureMaxRiceBits; k++) {
+    uint32_t cost[kCaptureMaxSymbols] = {0};
+    for (uint16_t i = first; i < results->rawlen; i += 2) {
+      uint8_t nr = 0;
+      while (results->rawbuf[i] < lower[nr]) nr++;
+      if (symbols[nr] == kCaptureLiteral) continue;
+      const uint32_t folded = foldJitter(results->rawbuf[i], symbols[nr]);
+      if (folded) exact[nr] = false;
+      cost[nr] += riceBits(folded, k);
+    }
+    for (uint8_t s = 0; s < count; s++)
+      if (!exact[s] && (rice[s] == kCaptureNoJitter || cost[s] < bits[s])) {
+        rice[s] = k;
+        bits[s] = cost[s];
+      }
+  }
+}
+
+// Get a nibble from an array of them.
+static inline uint8_t getNibble(const uint8_t * const start,
+                                const uint16_t nibble) {
+  return (start[nibble / 2] >> (4 * (nibble % 2))) & 0xF;
+}
+
+// Get the code lengths of a type of symbol from a compressed capture.
+// Returns: true if they make a valid set of codes, otherwise false.
+static bool readCodeLengths(const uint8_t * const buf, const uint16_t start,
+                            const uint8_t offset, const uint8_t count,
+                            uint8_t lengths[]) {
+  uint32_t kraft = 0;  // Sum of 2^-length, in units of 2^-kCaptureMaxCodeBits
+  for (uint8_t i = 0; i < count; i++) {
+    lengths[i] = getNibble(buf + start, offset + i);
+    if (count > 1 && !lengths[i]) return false;
+    if (lengths[i]) kraft += 1UL << (kCaptureMaxCodeBits - lengths[i]);
+  }
+  return kraft <= (1UL << kCaptureMaxCodeBits);
+}
+
+// Compress a capture, for storage or transmission. e.g. To a backend.
+//
+// Args:
+//   results: A pointer to an IR decode_results structure that contains a mesg.
+//   buf: Where to store the compressed capture.
+//   size: The size of buf in bytes.
+//   tolerance: Percentage of variation to treat as the same duration.
+//              0 (the default) keeps every duration exactly as captured.
+// Returns:
+//   The nr. of bytes of buf used, or 0 if it didn't fit.
+// Note:
+//   rawbuf[0] (The gap before the message) isn't kept. This is what
+//   resultToRawIterator() & resultToRawArray() skip too.
+//   A tolerance makes it lossy, but usually much smaller, as the jitter of
+//   each duration isn't kept. Durations are clustered with ones up to
+//   `tolerance` percent shorter than the longest, so each is decompressed to
+//   between (100 - tolerance)% and 100 / (100 - tolerance) of what was
+//   captured. e.g. -10% to +11.1% for kCaptureTolerance, which decode()
+//   tolerates.
+//   On the unit test captures, it is about 2.8 times smaller losslessly, &
+//   5.8 times with kCaptureTolerance.
+uint16_t compressCapture(const decode_results * const results, uint8_t *buf,
+                         const uint16_t size, const uint8_t tolerance) {
+  uint16_t symbols[2][kCaptureMaxSymbols];
+  uint16_t lower[2][kCaptureMaxSymbols];
+  uint32_t freq[2][kCaptureMaxSymbols];
+  uint8_t lengths[2][kCaptureMaxSymbols];
+  uint8_t rice[2][kCaptureMaxSymbols];
+  const bool lossless = tolerance == 0;
+  const uint8_t percent = lossless ? kCaptureJitterTolerance
+                                   : std::min(tolerance, (uint8_t)100);
+  const uint16_t entries = results->rawlen ? results->rawlen - 1 : 0;
+  uint8_t count[2];
+  uint32_t bits = 0;
+  bool jitter = false;
+  for (uint8_t type = 0; type < 2; type++) {
+    count[type] = clusterDurations(results, type + 1, percent, symbols[type],
+                                   lower[type], freq[type]);
+    if (count[type] == 0) continue;
+    uint32_t used[kCaptureMaxSymbols];
+    for (uint8_t s = 0; s < count[type]; s++) used[s] = freq[type][s];
+    codeLengths(used, count[type], lengths[type]);
+    for (uint8_t s = 0; s < count[type]; s++)
+      bits += freq[type][s] * (lengths[type][s] +
+          (symbols[type][s] == kCaptureLiteral ? kCaptureLiteralBits : 0));
+    if (lossless) {
+      riceParameters(results, type + 1, symbols[type], lower[type],
+                     count[type], rice[type], used);
+      for (uint8_t s = 0; s < count[type]; s++) {
+        bits += used[s];
+        if (rice[type][s] != kCaptureNoJitter) jitter = true;
+      }
+    } else {
+      for (uint8_t s = 0; s < count[type]; s++)
+        rice[type][s] = kCaptureNoJitter;
+    }
+  }
+  const uint16_t nr_symbols = count[0] + count[1];
+  const uint16_t nibbles = kCaptureHeaderSize + 2 * nr_symbols;
+  const uint16_t start = nibbles + (jitter ? 2 : 1) * ((nr_symbols + 1) / 2);
+  const uint32_t total = start + (bits + 7) / 8;
+  if (buf == NULL || total > size) return 0;
+  memset(buf, 0, total);
+  buf[0] = count[0] | (jitter ? kCaptureJitter : 0);
+  buf[1] = count[1];
+  buf[2] = entries;
+  buf[3] = entries >> 8;
+  uint16_t pos = kCaptureHeaderSize;
+  uint16_t nr = 0;
+  for (uint8_t type = 0; type < 2; type++)
+    for (uint8_t s = 0; s < count[type]; s++, nr++) {
+      buf[pos++] = symbols[type][s];
+      buf[pos++] = symbols[type][s] >> 8;
+      buf[nibbles + nr / 2] |= lengths[type][s] << (4 * (nr % 2));
+      if (jitter)
+        buf[nibbles + (nr_symbols + 1) / 2 + nr / 2] |=
+            rice[type][s] << (4 * (nr % 2));
+    }
+  uint32_t bitpos = (uint32_t)start * 8;
+  for (uint16_t i = 0; i < entries; i++) {
+    const uint8_t type = i % 2;
+    uint8_t nr = 0;
+    while (results->rawbuf[i + 1] < lower[type][nr]) nr++;
+    const uint16_t code = symbolCode(lengths[type], count[type], nr);
+    for (uint8_t b = lengths[type][nr]; b > 0; b--, bitpos++)
+      if (code & (1 << (b - 1))) buf[bitpos / 8] |= 1 << (bitpos % 8);
+    if (symbols[type][nr] == kCaptureLiteral) {
+      for (uint8_t b = kCaptureLiteralBits; b > 0; b--, bitpos++)
+        if (results->rawbuf[i + 1] & (1 << (b - 1)))
+          buf[bitpos / 8] |= 1 << (bitpos % 8);
+    } else if (rice[type][nr] != kCaptureNoJitter) {
+      const uint8_t k = rice[type][nr];
+      const uint32_t folded = foldJitter(results->rawbuf[i + 1],
+                                         symbols[type][nr]);
+      for (uint32_t q = folded >> k; q > 0; q--, bitpos++)
+        buf[bitpos / 8] |= 1 << (bitpos % 8);
+      bitpos++;  // The 0 that ends the unary part.
+      for (uint8_t b = k; b > 0; b--, bitpos++)
+        if (folded & (1UL << (b - 1))) buf[bitpos / 8] |= 1 << (bitpos % 8);
+    }
+  }
+  return total;
+}
+
+// Decompress a capture made by compressCapture().
+//
+// Args:
+//   buf: The compressed capture.
+//   size: The size of buf in bytes.
+//   ticks: Where to store the durations (in kRawTick units), or NULL to just
+//          find out how many there are.
+//   len: The nr. of elements ticks can hold.
+// Returns:
+//   The nr. of durations, or 0 if there were none, or the compressed capture
+//   was invalid, or they didn't fit.
+// Example:
+//   uint16_t ticks[kRawBuf];
+//   uint16_t len = decompressCapture(buf, size, ticks, kRawBuf);
+//   IRrawIterator raw(ticks, len, kRawTick);
+//   irsend.sendRaw(&raw, 38000);
+uint16_t decompressCapture(const uint8_t * const buf, const uint16_t size,
+                           uint16_t *ticks, const uint16_t len) {
+  if (buf == NULL || size < kCaptureHeaderSize) return 0;
+  const bool jitter = buf[0] & kCaptureJitter;
+  const uint8_t count[2] = {(uint8_t)(buf[0] & ~kCaptureJitter), buf[1]};
+  const uint16_t entries = buf[2] | (buf[3] << 8);
+  if (count[0] > kCaptureMaxSymbols || count[1] > kCaptureMaxSymbols ||
+      (entries > 0 && !count[0]) || (entries > 1 && !count[1]))
+    return 0;
+  const uint16_t nr_symbols = count[0] + count[1];
+  const uint16_t nibbles = kCaptureHeaderSize + 2 * nr_symbols;
+  const uint16_t start = nibbles + (jitter ? 2 : 1) * ((nr_symbols + 1) / 2);
+  if (start > size) return 0;
+  uint8_t lengths[2][kCaptureMaxSymbols];
+  uint8_t rice[2][kCaptureMaxSymbols];
+  for (uint8_t type = 0; type < 2; type++) {
+    if (!readCodeLengths(buf, nibbles, type * count[0], count[type],
+                         lengths[type]))
+      return 0;
+    for (uint8_t s = 0; s < count[type]; s++)
+      rice[type][s] = jitter ? getNibble(buf + nibbles + (nr_symbols + 1) / 2,
+                                         type * count[0] + s)
+                             : kCaptureNoJitter;
+  }
+  if (ticks != NULL && entries > len) return 0;
+  const uint32_t end = (uint32_t)size * 8;
+  uint32_t bitpos = (uint32_t)start * 8;
+  for (uint16_t i = 0; i < entries; i++) {
+    const uint8_t type = i % 2;
+    // Read the code a bit at a time until it matches one of that length.
+    int16_t nr = count[type] == 1 ? 0 : -1;
+    uint16_t code = 0;
+    uint16_t first = 0;  // The first code of the current length.
+    for (uint8_t length = 1; nr < 0 && length <= kCaptureMaxCodeBits;
+         length++, bitpos++) {
+      if (bitpos >= end) return 0;
+      code = (code << 1) | ((buf[bitpos / 8] >> (bitpos % 8)) & 1);
+      for (uint8_t s = 0; nr < 0 && s < count[type]; s++)
+        if (lengths[type][s] == length) {
+          if (code == first) nr = s;
+          first++;
+        }
+      first <<= 1;
+    }
+    if (nr < 0) return 0;
+    const uint16_t symbol = kCaptureHeaderSize + 2 * (type * count[0] + nr);
+    uint16_t duration = buf[symbol] | (buf[symbol + 1] << 8);
+    if (duration == kCaptureLiteral) {
+      if (bitpos + kCaptureLiteralBits > end) return 0;
+      for (uint8_t b = 0; b < kCaptureLiteralBits; b++, bitpos++)
+        duration = (duration << 1) | ((buf[bitpos / 8] >> (bitpos % 8)) & 1);
+    } else if (rice[type][nr] != kCaptureNoJitter) {
+      const uint8_t k = rice[type][nr];
+      uint32_t folded = 0;
+      for (;; bitpos++) {  // The unary part.
+        if (bitpos >= end || folded > kCaptureMaxJitter) return 0;
+        if (!((buf[bitpos / 8] >> (bitpos % 8)) & 1)) break;
+        folded += 1UL << k;
+      }
+      bitpos++;
+      if (bitpos + k > end) return 0;
+      uint32_t bottom = 0;
+      for (uint8_t b = 0; b < k; b++, bitpos++)
+        bottom = (bottom << 1) | ((buf[bitpos / 8] >> (bitpos % 8)) & 1);
+      folded += bottom;
+      const int32_t exact = (int32_t)duration + ((folded & 1) ?
+          -(int32_t)((folded + 1) / 2) : (int32_t)(folded / 2));
+      if (exact < 0 || exact > UINT16_MAX) return 0;
+      duration = exact;
+    }
+    if (ticks != NULL) ticks[i] = duration;
+  }
+  return entries;
+}
+
+// Load 4 bytes as a word, whatever their alignment. Their order in the word
+// doesn't matter to any of the kernels that use it.
+static inline uint32_t loadWord(const uint8_t * const ptr) {
+  uint32_t word;
+  memcpy(&word, ptr, sizeof(word));
+  return word;
+}
+
+// Add up the bytes of a word, mod 256.
+static inline uint8_t foldSum(uint32_t word) {
+  word = (word & 0x00FF00FFUL) + ((word >> 8) & 0x00FF00FFUL);
+  return word + (word >> 16);
+}
+
+// Add up all the bytes in a block, mod 256.
+// Args:
+//   start: Ptr to the start of the block.
+//   length: How many bytes to add up.
+//   init: Start the sum from this value.
+// Returns:
+//   The 8-bit sum.
 uint8_t sumBytes(const uint8_t * const start, const uint16_t length,
                  const uint8_t init) {
   uint8_t checksum = init;
-  const uint8_t *ptr;
-  for (ptr = start; ptr - start < length; ptr++) checksum += *ptr;
+  const uint8_t *ptr = start;
+  const uint8_t *end = start + length;
+  // A word at a time. Each 16-bit lane gets the sum of two byte lanes, and
+  // is folded before it can carry into the next lane. i.e. Every 128 words.
+  while (end - ptr >= 4) {
+    uint32_t lanes = 0;
+    for (uint8_t i = 0; i < 128 && end - ptr >= 4; i++, ptr += 4) {
+      const uint32_t word = loadWord(ptr);
+      lanes += (word & 0x00FF00FFUL) + ((word >> 8) & 0x00FF00FFUL);
+    }
+    checksum += lanes + (lanes >> 16);
+  }
+  for (; ptr < end; ptr++) checksum += *ptr;
   return checksum;
 }
 
+// Exclusive-or all the bytes in a block together.
+// Args:
+//   start: Ptr to the start of the block.
+//   length: How many bytes to xor.
+//   init: Start from this value.
+// Returns:
+//   The 8-bit xor of them all.
 uint8_t xorBytes(const uint8_t * const start, const uint16_t length,
                  const uint8_t init) {
-  uint8_t checksum = init;
-  const uint8_t *ptr;
-  for (ptr = start; ptr - start < length; ptr++) checksum ^= *ptr;
+  const uint8_t *ptr = start;
+  const uint8_t *end = start + length;
+  uint32_t word = init;
+  for (; end - ptr >= 4; ptr += 4) word ^= loadWord(ptr);
+  word ^= word >> 16;
+  uint8_t checksum = word ^ (word >> 8);
+  for (; ptr < end; ptr++) checksum ^= *ptr;
   return checksum;
 }
 
+// Add up the nibbles of a value, starting from the least significant one.
+// Args:
+//   data: The value to add up the nibbles of.
+//   count: How many nibbles to add up. Capped at 16.
+//   init: Start the sum from this value.
+//   nibbleonly: Return the sum mod 16. False for mod 256.
+// Returns:
+//   The sum.
+uint8_t sumNibbles(const uint64_t data, const uint8_t count,
+                   const uint8_t init, const bool nibbleonly) {
+  uint64_t copy = data;
+  if (count < 16) copy &= ((uint64_t)1 << (count * 4)) - 1;
+  const uint32_t low = copy;
+  const uint32_t high = copy >> 32;
+  // Each byte lane is at most 60, so there is no carry between them.
+  uint8_t sum = init + foldSum((low & 0x0F0F0F0FUL) +
+                               ((low >> 4) & 0x0F0F0F0FUL) +
+                               (high & 0x0F0F0F0FUL) +
+                               ((high >> 4) & 0x0F0F0F0FUL));
+  return nibbleonly ? sum & 0xF : sum;
+}
+
 // Count the number of bits of a certain type.
 // Args:
 //   start: Ptr to the start of data to count bits in.
@@ -704,11 +1250,10 @@ uint8_t xorBytes(const uint8_t * const start, const uint16_t length,
 uint16_t countBits(const uint8_t * const start, const uint16_t length,
                    const bool ones, const uint16_t init) {
   uint16_t count = init;
-  for (uint16_t offset = 0; offset < length; offset++)
-    for (uint8_t currentbyte = *(start + offset);
-         currentbyte;
-         currentbyte >>= 1)
-      if (currentbyte & 1) count++;
+  const uint8_t *ptr = start;
+  const uint8_t *end = start + length;
+  for (; end - ptr >= 4; ptr += 4) count += __builtin_popcount(loadWord(ptr));
+  for (; ptr < end; ptr++) count += __builtin_popcount(*ptr);
   if (ones || length == 0)
     return count;
   else
@@ -725,11 +1270,10 @@ uint16_t countBits(const uint8_t * const start, const uint16_t length,
 //   Nr. of bits found.
 uint16_t countBits(const uint64_t data, const uint8_t length, const bool ones,
                    const uint16_t init) {
-  uint16_t count = init;
-  uint8_t bitsSoFar = length;
-  for (uint64_t remainder = data; remainder && bitsSoFar;
-       remainder >>= 1, bitsSoFar--)
-      if (remainder & 1) count++;
+  uint64_t remainder = data;
+  if (length < 64) remainder &= ((uint64_t)1 << length) - 1;
+  uint16_t count = init + __builtin_popcount((uint32_t)remainder) +
+      __builtin_popcount((uint32_t)(remainder >> 32));
   if (ones || length == 0)
     return count;
   else
@@ -6,6 +6,7 @@
 #ifndef UNIT_TEST
 #include <Arduino.h>
 #endif
+#include <stddef.h>
 #define __STDC_LIMIT_MACROS
 #include <stdint.h>
 #ifndef ARDUINO
@@ -13,9 +14,23 @@
 #endif
 #include "IRremoteESP8266.h"
 #include "IRrecv.h"
+#include "IRsend.h"
+
+// Max. size of the text uint64ToString() produces, incl. the NUL. (base 2)
+const uint8_t kUint64StringSize = 64 + 1;
+// Max. size of a protocol name, incl. the NUL. e.g. "MITSUBISHI_HEAVY_152"
+const uint8_t kProtocolNameSize = 20 + 1;
+// Compressed captures. See compressCapture().
+const uint8_t kCaptureHeaderSize = 4;
+const uint8_t kCaptureMaxSymbols = 32;  // Each. i.e. Marks, and spaces.
+const uint8_t kCaptureTolerance = 10;   // Suggested percent, if lossy is ok.
+const uint8_t kCaptureJitter = 0x80;  // Flag in the 1st byte. Jitter is kept.
 
 uint64_t reverseBits(uint64_t input, uint16_t nbits);
 String uint64ToString(uint64_t input, uint8_t base = 10);
+size_t uint64ToString(uint64_t input, char *buf, const size_t size,
+                      uint8_t base = 10);
+const char *typeToName(const decode_type_t protocol);
 String typeToString(const decode_type_t protocol,
                     const bool isRepeat = false);
 void serialPrintUint64(uint64_t input, uint8_t base = 10);
@@ -23,13 +38,39 @@ String resultToSourceCode(const decode_results * const results);
 String resultToTimingInfo(const decode_results * const results);
 String resultToHumanReadableBasic(const decode_results * const results);
 String resultToHexidecimal(const decode_results * const result);
+// Allocation free versions. They return the length of the (full) text.
+size_t resultToSourceCode(const decode_results * const results, char *buf,
+                          const size_t size);
+size_t resultToTimingInfo(const decode_results * const results, char *buf,
+                          const size_t size);
+size_t resultToHumanReadableBasic(const decode_results * const results,
+                                  char *buf, const size_t size);
+size_t resultToHexidecimal(const decode_results * const result, char *buf,
+                           const size_t size);
+#ifdef ARDUINO
+size_t resultToSourceCode(const decode_results * const results, Print *out);
+size_t resultToTimingInfo(const decode_results * const results, Print *out);
+size_t resultToHumanReadableBasic(const decode_results * const results,
+                                  Print *out);
+size_t resultToHexidecimal(const decode_results * const result, Print *out);
+#endif  // ARDUINO
+#if DECODE_STATS
+String decodeStatsToString(const decode_stats_t * const stats);
+#endif  // DECODE_STATS
 bool hasACState(const decode_type_t protocol);
 uint16_t getCorrectedRawLength(const decode_results * const results);
 uint16_t *resultToRawArray(const decode_results * const decode);
+IRrawIterator resultToRawIterator(const decode_results * const decode);
+uint16_t compressCapture(const decode_results * const results, uint8_t *buf,
+                         const uint16_t size, const uint8_t tolerance = 0);
+uint16_t decompressCapture(const uint8_t * const buf, const uint16_t size,
+                           uint16_t *ticks, const uint16_t len);
 uint8_t sumBytes(const uint8_t * const start, const uint16_t length,
                  const uint8_t init = 0);
 uint8_t xorBytes(const uint8_t * const start, const uint16_t length,
                  const uint8_t init = 0);
+uint8_t sumNibbles(const uint64_t data, const uint8_t count = 16,
+                   const uint8_t init = 0, const bool nibbleonly = true);
 uint16_t countBits(const uint8_t * const start, const uint16_t length,
                    const bool ones = true, const uint16_t init = 0);
 uint16_t countBits(const uint64_t data, const uint8_t length,
@@ -15,8 +15,6 @@ Copyright 2019 crankyoldgit
 
 // Constants
 // using SPACE modulation. MARK is always const 400u
-const uint16_t kArgoHdrMark = 6400;
-const uint16_t kArgoHdrSpace = 3300;
 const uint16_t kArgoBitMark = 400;
 const uint16_t kArgoOneSpace = 2200;
 const uint16_t kArgoZeroSpace = 900;
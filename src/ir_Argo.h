@@ -38,6 +38,8 @@
 */
 
 // Constants. Store MSB left.
+const uint16_t kArgoHdrMark = 6400;
+const uint16_t kArgoHdrSpace = 3300;
 
 // byte[2]
 const uint8_t kArgoHeatBit =      0b00100000;
@@ -117,6 +119,7 @@ class IRArgoAC {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif  // SEND_ARGO
   void begin(void);
+  void stateReset(void);
   void on(void);
   void off(void);
 
@@ -170,7 +173,6 @@ class IRArgoAC {
 #endif
   // # of bytes per command
   uint8_t argo[kArgoStateLength];  // Defined in IRremoteESP8266.h
-  void stateReset(void);
   void checksum(void);
 
   // Attributes
@@ -11,12 +11,11 @@
 #include "IRrecv.h"
 #include "IRsend.h"
 #include "IRutils.h"
+#include "ir_Carrier.h"
 
 // Constants
 // Ref:
 //   https://github.com/crankyoldgit/IRremoteESP8266/issues/385
-const uint16_t kCarrierAcHdrMark = 8532;
-const uint16_t kCarrierAcHdrSpace = 4228;
 const uint16_t kCarrierAcBitMark = 628;
 const uint16_t kCarrierAcOneSpace = 1320;
 const uint16_t kCarrierAcZeroSpace = 532;
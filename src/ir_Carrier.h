@@ -0,0 +1,12 @@
+// Copyright 2018 David Conran
+
+#ifndef IR_CARRIER_H_
+#define IR_CARRIER_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kCarrierAcHdrMark = 8532;
+const uint16_t kCarrierAcHdrSpace = 4228;
+
+#endif  // IR_CARRIER_H_
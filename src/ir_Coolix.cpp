@@ -25,17 +25,12 @@
 // Pulse parms are *50-100 for the Mark and *50+100 for the space
 // First MARK is the one after the long gap
 // pulse parameters in usec
-const uint16_t kCoolixTick = 560;  // Approximately 21 cycles at 38kHz
 const uint16_t kCoolixBitMarkTicks = 1;
 const uint16_t kCoolixBitMark = kCoolixBitMarkTicks * kCoolixTick;
 const uint16_t kCoolixOneSpaceTicks = 3;
 const uint16_t kCoolixOneSpace = kCoolixOneSpaceTicks * kCoolixTick;
 const uint16_t kCoolixZeroSpaceTicks = 1;
 const uint16_t kCoolixZeroSpace = kCoolixZeroSpaceTicks * kCoolixTick;
-const uint16_t kCoolixHdrMarkTicks = 8;
-const uint16_t kCoolixHdrMark = kCoolixHdrMarkTicks * kCoolixTick;
-const uint16_t kCoolixHdrSpaceTicks = 8;
-const uint16_t kCoolixHdrSpace = kCoolixHdrSpaceTicks * kCoolixTick;
 const uint16_t kCoolixMinGapTicks = kCoolixHdrMarkTicks + kCoolixZeroSpaceTicks;
 const uint16_t kCoolixMinGap = kCoolixMinGapTicks * kCoolixTick;
 
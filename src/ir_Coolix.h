@@ -28,6 +28,11 @@
 //   Hamper: For the breakdown and mapping of the bit values.
 
 // Constants
+const uint16_t kCoolixTick = 560;  // Approximately 21 cycles at 38kHz
+const uint16_t kCoolixHdrMarkTicks = 8;
+const uint16_t kCoolixHdrMark = kCoolixHdrMarkTicks * kCoolixTick;
+const uint16_t kCoolixHdrSpaceTicks = 8;
+const uint16_t kCoolixHdrSpace = kCoolixHdrSpaceTicks * kCoolixTick;
 // Modes
 const uint8_t kCoolixCool = 0b000;
 const uint8_t kCoolixDry = 0b001;
@@ -266,6 +266,7 @@ class IRDaikinESP {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif
   void begin(void);
+  void stateReset(void);
   void on(void);
   void off(void);
   void setPower(const bool on);
@@ -327,7 +328,6 @@ class IRDaikinESP {
 #endif
   // # of bytes per command
   uint8_t remote[kDaikinStateLength];
-  void stateReset(void);
   void checksum(void);
 };
 
@@ -341,6 +341,7 @@ class IRDaikin2 {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif
   void begin();
+  void stateReset();
   void on();
   void off();
   void setPower(const bool state);
@@ -418,7 +419,6 @@ class IRDaikin2 {
 #endif
   // # of bytes per command
   uint8_t remote_state[kDaikin2StateLength];
-  void stateReset();
   void checksum();
   void clearOnTimerFlag();
   void clearSleepTimerFlag();
@@ -434,6 +434,7 @@ class IRDaikin216 {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif
   void begin();
+  void stateReset();
   uint8_t* getRaw();
   void setRaw(const uint8_t new_code[]);
   static bool validChecksum(uint8_t state[],
@@ -470,7 +471,6 @@ class IRDaikin216 {
 #endif
   // # of bytes per command
   uint8_t remote_state[kDaikin216StateLength];
-  void stateReset();
   void checksum();
 };
 
@@ -484,6 +484,7 @@ class IRDaikin160 {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif
   void begin();
+  void stateReset();
   uint8_t* getRaw();
   void setRaw(const uint8_t new_code[]);
   static bool validChecksum(uint8_t state[],
@@ -515,7 +516,6 @@ class IRDaikin160 {
 #endif
   // # of bytes per command
   uint8_t remote_state[kDaikin160StateLength];
-  void stateReset();
   void checksum();
 };
 
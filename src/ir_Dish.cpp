@@ -4,6 +4,7 @@
 #include "IRrecv.h"
 #include "IRsend.h"
 #include "IRutils.h"
+#include "ir_Dish.h"
 
 // DISH support originally by Todd Treece
 //   http://unionbridge.org/design/ircommand
@@ -15,11 +16,6 @@
 // Ref:
 //   https://github.com/marcosamarinho/IRremoteESP8266/blob/master/ir_Dish.cpp
 //   http://www.hifi-remote.com/wiki/index.php?title=Dish
-const uint16_t kDishTick = 100;
-const uint16_t kDishHdrMarkTicks = 4;
-const uint16_t kDishHdrMark = kDishHdrMarkTicks * kDishTick;
-const uint16_t kDishHdrSpaceTicks = 61;
-const uint16_t kDishHdrSpace = kDishHdrSpaceTicks * kDishTick;
 const uint16_t kDishBitMarkTicks = 4;
 const uint16_t kDishBitMark = kDishBitMarkTicks * kDishTick;
 const uint16_t kDishOneSpaceTicks = 17;
@@ -0,0 +1,16 @@
+// Copyright Todd Treece
+// Copyright 2017 David Conran
+
+#ifndef IR_DISH_H_
+#define IR_DISH_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kDishTick = 100;
+const uint16_t kDishHdrMarkTicks = 4;
+const uint16_t kDishHdrMark = kDishHdrMarkTicks * kDishTick;
+const uint16_t kDishHdrSpaceTicks = 61;
+const uint16_t kDishHdrSpace = kDishHdrSpaceTicks * kDishTick;
+
+#endif  // IR_DISH_H_
@@ -16,9 +16,7 @@
 //   https://github.com/ToniA/arduino-heatpumpir/blob/master/AUXHeatpumpIR.cpp
 
 // Constants
-const uint16_t kElectraAcHdrMark = 9166;
 const uint16_t kElectraAcBitMark = 646;
-const uint16_t kElectraAcHdrSpace = 4470;
 const uint16_t kElectraAcOneSpace = 1647;
 const uint16_t kElectraAcZeroSpace = 547;
 const uint32_t kElectraAcMessageGap = kDefaultMessageGap;  // Just a guess.
@@ -24,6 +24,8 @@
 //  https://github.com/ToniA/arduino-heatpumpir/blob/master/AUXHeatpumpIR.cpp
 
 // Constants
+const uint16_t kElectraAcHdrMark = 9166;
+const uint16_t kElectraAcHdrSpace = 4470;
 // state[1]
 const uint8_t kElectraAcTempMask =   0b11111000;
 const uint8_t kElectraAcMinTemp = 16;   // 16C
@@ -20,8 +20,6 @@
 
 // Ref:
 // These values are based on averages of measurements
-const uint16_t kFujitsuAcHdrMark = 3324;
-const uint16_t kFujitsuAcHdrSpace = 1574;
 const uint16_t kFujitsuAcBitMark = 448;
 const uint16_t kFujitsuAcOneSpace = 1182;
 const uint16_t kFujitsuAcZeroSpace = 390;
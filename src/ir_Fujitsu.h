@@ -29,6 +29,8 @@
 // FUJITSU A/C support added by Jonny Graham
 
 // Constants
+const uint16_t kFujitsuAcHdrMark = 3324;
+const uint16_t kFujitsuAcHdrSpace = 1574;
 const uint8_t kFujitsuAcModeAuto = 0x00;
 const uint8_t kFujitsuAcModeCool = 0x01;
 const uint8_t kFujitsuAcModeDry = 0x02;
@@ -7,14 +7,13 @@
 #include "IRrecv.h"
 #include "IRsend.h"
 #include "IRutils.h"
+#include "ir_GICable.h"
 
 // Ref:
 //   https://github.com/cyborg5/IRLib2/blob/master/IRLibProtocols/IRLib_P09_GICable.h
 //   https://github.com/crankyoldgit/IRremoteESP8266/issues/447
 
 // Constants
-const uint16_t kGicableHdrMark = 9000;
-const uint16_t kGicableHdrSpace = 4400;
 const uint16_t kGicableBitMark = 550;
 const uint16_t kGicableOneSpace = 4400;
 const uint16_t kGicableZeroSpace = 2200;
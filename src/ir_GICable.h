@@ -0,0 +1,12 @@
+// Copyright 2018 David Conran
+
+#ifndef IR_GICABLE_H_
+#define IR_GICABLE_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kGicableHdrMark = 9000;
+const uint16_t kGicableHdrSpace = 4400;
+
+#endif  // IR_GICABLE_H_
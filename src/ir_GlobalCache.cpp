@@ -7,14 +7,6 @@
 #include <algorithm>
 #include "IRsend.h"
 
-// Constants
-const uint16_t kGlobalCacheMaxRepeat = 50;
-const uint32_t kGlobalCacheMinUsec = 80;
-const uint8_t kGlobalCacheFreqIndex = 0;
-const uint8_t kGlobalCacheRptIndex = kGlobalCacheFreqIndex + 1;
-const uint8_t kGlobalCacheRptStartIndex = kGlobalCacheRptIndex + 1;
-const uint8_t kGlobalCacheStartIndex = kGlobalCacheRptStartIndex + 1;
-
 #if SEND_GLOBALCACHE
 // Send a shortened GlobalCache (GC) IRdb/control tower formatted message.
 //
@@ -60,6 +60,7 @@ void IRsend::sendGoodweather(const uint64_t data, const uint16_t nbits,
 IRGoodweatherAc::IRGoodweatherAc(uint16_t pin) : _irsend(pin) { stateReset(); }
 
 void IRGoodweatherAc::stateReset(void) {
+  remote = 0;
 }
 
 void IRGoodweatherAc::begin(void) { _irsend.begin(); }
@@ -22,6 +22,8 @@
 #endif
 
 // Constants
+const uint16_t kGreeHdrMark = 9000;
+const uint16_t kGreeHdrSpace = 4500;  // See #684 and real example in unit tests
 const uint8_t kGreeAuto = 0;
 const uint8_t kGreeCool = 1;
 const uint8_t kGreeDry = 2;
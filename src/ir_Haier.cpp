@@ -23,8 +23,6 @@
 //   https://www.dropbox.com/sh/w0bt7egp0fjger5/AADRFV6Wg4wZskJVdFvzb8Z0a?dl=0&preview=haer2.ods
 
 // Constants
-const uint16_t kHaierAcHdr = 3000;
-const uint16_t kHaierAcHdrGap = 4300;
 const uint16_t kHaierAcBitMark = 520;
 const uint16_t kHaierAcOneSpace = 1650;
 const uint16_t kHaierAcZeroSpace = 650;
@@ -25,6 +25,8 @@
 //   https://www.dropbox.com/sh/w0bt7egp0fjger5/AADRFV6Wg4wZskJVdFvzb8Z0a?dl=0&preview=haer2.ods
 
 // Constants
+const uint16_t kHaierAcHdr = 3000;
+const uint16_t kHaierAcHdrGap = 4300;
 
 // Haier HSU07-HEA03 remote
 // Byte 0
@@ -194,6 +196,7 @@ class IRHaierAC {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif  // SEND_HAIER_AC
   void begin(void);
+  void stateReset(void);
 
   void setCommand(const uint8_t command);
   uint8_t getCommand(void);
@@ -245,7 +248,6 @@ class IRHaierAC {
   IRsendTest _irsend;
 #endif
   uint8_t remote_state[kHaierACStateLength];
-  void stateReset(void);
   void checksum(void);
   static uint16_t getTime(const uint8_t ptr[]);
   static void setTime(uint8_t ptr[], const uint16_t nr_mins);
@@ -259,6 +261,7 @@ class IRHaierACYRW02 {
   void send(const uint16_t repeat = kHaierAcYrw02DefaultRepeat);
 #endif  // SEND_HAIER_AC_YRW02
   void begin(void);
+  void stateReset(void);
 
   void setButton(const uint8_t button);
   uint8_t getButton(void);
@@ -308,7 +311,6 @@ class IRHaierACYRW02 {
   IRsendTest _irsend;
 #endif
   uint8_t remote_state[kHaierACYRW02StateLength];
-  void stateReset(void);
   void checksum(void);
 };
 
@@ -17,10 +17,6 @@
 
 // Constants
 // Ref: https://github.com/crankyoldgit/IRremoteESP8266/issues/417
-const uint16_t kHitachiAcHdrMark = 3300;
-const uint16_t kHitachiAcHdrSpace = 1700;
-const uint16_t kHitachiAc1HdrMark = 3400;
-const uint16_t kHitachiAc1HdrSpace = 3400;
 const uint16_t kHitachiAcBitMark = 400;
 const uint16_t kHitachiAcOneSpace = 1250;
 const uint16_t kHitachiAcZeroSpace = 500;
@@ -22,6 +22,10 @@
 #endif
 
 // Constants
+const uint16_t kHitachiAcHdrMark = 3300;
+const uint16_t kHitachiAcHdrSpace = 1700;
+const uint16_t kHitachiAc1HdrMark = 3400;
+const uint16_t kHitachiAc1HdrSpace = 3400;
 const uint8_t kHitachiAcAuto = 2;
 const uint8_t kHitachiAcHeat = 3;
 const uint8_t kHitachiAcCool = 4;
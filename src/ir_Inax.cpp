@@ -5,6 +5,7 @@
 #include "IRrecv.h"
 #include "IRsend.h"
 #include "IRutils.h"
+#include "ir_Inax.h"
 
 // Supports:
 //   Brand: Lixil,  Model: Inax DT-BA283 Toilet
@@ -16,8 +17,6 @@
 // Ref:
 //   https://github.com/crankyoldgit/IRremoteESP8266/issues/706
 const uint16_t kInaxTick = 500;
-const uint16_t kInaxHdrMark = 9000;
-const uint16_t kInaxHdrSpace = 4500;
 const uint16_t kInaxBitMark = 560;
 const uint16_t kInaxOneSpace = 1675;
 const uint16_t kInaxZeroSpace = kInaxBitMark;
@@ -0,0 +1,12 @@
+// Copyright 2019 David Conran (crankyoldgit)
+
+#ifndef IR_INAX_H_
+#define IR_INAX_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kInaxHdrMark = 9000;
+const uint16_t kInaxHdrSpace = 4500;
+
+#endif  // IR_INAX_H_
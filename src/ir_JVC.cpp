@@ -4,7 +4,6 @@
 #include <algorithm>
 #include "IRrecv.h"
 #include "IRsend.h"
-#include "IRtimer.h"
 #include "IRutils.h"
 
 // JVC originally added by Kristian Lauszus
@@ -31,6 +30,11 @@ const uint16_t kJvcMinGapTicks =
     (kJvcHdrMarkTicks + kJvcHdrSpaceTicks +
      kJvcBits * (kJvcBitMarkTicks + kJvcOneSpaceTicks) + kJvcBitMarkTicks);
 const uint16_t kJvcMinGap = kJvcMinGapTicks * kJvcTick;
+// The data & footer of a JVC message. The header is only in the first one.
+constexpr protocol_timing_t kJvcDataTiming = {
+    0, 0,  // No Header
+    kJvcBitMark, kJvcOneSpace, kJvcBitMark, kJvcZeroSpace,
+    kJvcBitMark, kJvcMinGap, 0, 38, 33, true};
 
 #if SEND_JVC
 // Send a JVC message.
@@ -48,7 +52,7 @@ void IRsend::sendJVC(uint64_t data, uint16_t nbits, uint16_t repeat) {
   // Set 38kHz IR carrier frequency & a 1/3 (33%) duty cycle.
   enableIROut(38, 33);
 
-  IRtimer usecs = IRtimer();
+  uint32_t start = messageClock();
   // Header
   // Only sent for the first message.
   mark(kJvcHdrMark);
@@ -56,17 +60,13 @@ void IRsend::sendJVC(uint64_t data, uint16_t nbits, uint16_t repeat) {
 
   // We always send the data & footer at least once, hence '<= repeat'.
   for (uint16_t i = 0; i <= repeat; i++) {
-    sendGeneric(0, 0,  // No Header
-                kJvcBitMark, kJvcOneSpace, kJvcBitMark, kJvcZeroSpace,
-                kJvcBitMark, kJvcMinGap, data, nbits, 38, true,
-                0,  // Repeats are handles elsewhere.
-                33);
+    sendTimed<kJvcDataTiming>(data, nbits);  // Repeats are handled here.
     // Wait till the end of the repeat time window before we send another code.
-    uint32_t elapsed = usecs.elapsed();
+    uint32_t elapsed = messageClock() - start;
     // Avoid potential unsigned integer underflow.
     // e.g. when elapsed > kJvcRptLength.
     if (elapsed < kJvcRptLength) space(kJvcRptLength - elapsed);
-    usecs.reset();
+    start = messageClock();
   }
 }
 
@@ -124,12 +124,9 @@ bool IRrecv::decodeJVC(decode_results *results, uint16_t nbits, bool strict) {
   }
 
   // Data + Footer
-  if (!matchGeneric(results->rawbuf + offset, &data,
-                    results->rawlen - offset, nbits,
-                    0, 0,
-                    kJvcBitMark, kJvcOneSpace,
-                    kJvcBitMark, kJvcZeroSpace,
-                    kJvcBitMark, kJvcMinGap, true)) return false;
+  if (!matchTimed<kJvcDataTiming>(results->rawbuf + offset, &data,
+                                  results->rawlen - offset, nbits))
+    return false;
   // Success
   results->decode_type = JVC;
   results->bits = nbits;
@@ -26,11 +26,6 @@
 
 // Constants
 
-const uint16_t kKelvinatorTick = 85;
-const uint16_t kKelvinatorHdrMarkTicks = 106;
-const uint16_t kKelvinatorHdrMark = kKelvinatorHdrMarkTicks * kKelvinatorTick;
-const uint16_t kKelvinatorHdrSpaceTicks = 53;
-const uint16_t kKelvinatorHdrSpace = kKelvinatorHdrSpaceTicks * kKelvinatorTick;
 const uint16_t kKelvinatorBitMarkTicks = 8;
 const uint16_t kKelvinatorBitMark = kKelvinatorBitMarkTicks * kKelvinatorTick;
 const uint16_t kKelvinatorOneSpaceTicks = 18;
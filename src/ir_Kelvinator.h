@@ -29,6 +29,11 @@
 #endif
 
 // Constants
+const uint16_t kKelvinatorTick = 85;
+const uint16_t kKelvinatorHdrMarkTicks = 106;
+const uint16_t kKelvinatorHdrMark = kKelvinatorHdrMarkTicks * kKelvinatorTick;
+const uint16_t kKelvinatorHdrSpaceTicks = 53;
+const uint16_t kKelvinatorHdrSpace = kKelvinatorHdrSpaceTicks * kKelvinatorTick;
 const uint8_t kKelvinatorAuto = 0;
 const uint8_t kKelvinatorCool = 1;
 const uint8_t kKelvinatorDry = 2;
@@ -55,9 +55,7 @@ const uint16_t kLg2BitMark = kLg2BitMarkTicks * kLgTick;  // 500
 //  Returns:
 //    A 4-bit checksum.
 uint8_t calcLGChecksum(uint16_t data) {
-  return (((data >> 12) + ((data >> 8) & 0xF) + ((data >> 4) & 0xF) +
-           (data & 0xF)) &
-          0xF);
+  return sumNibbles(data, 4);
 }
 #endif
 
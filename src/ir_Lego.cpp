@@ -4,6 +4,7 @@
 #include "IRrecv.h"
 #include "IRsend.h"
 #include "IRutils.h"
+#include "ir_Lego.h"
 
 // LEGO
 // (LEGO is a Registrated Trademark of the Lego Group.)
@@ -16,8 +17,6 @@
 // - https://github.com/crankyoldgit/IRremoteESP8266/files/2974525/LEGO_Power_Functions_RC_v120.pdf
 
 // Constants
-const uint16_t kLegoPfBitMark = 158;
-const uint16_t kLegoPfHdrSpace = 1026;
 const uint16_t kLegoPfZeroSpace = 263;
 const uint16_t kLegoPfOneSpace = 553;
 const uint32_t kLegoPfMinCommandLength = 16000;  // 16ms
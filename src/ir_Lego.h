@@ -0,0 +1,12 @@
+// Copyright 2019 David Conran
+
+#ifndef IR_LEGO_H_
+#define IR_LEGO_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kLegoPfBitMark = 158;
+const uint16_t kLegoPfHdrSpace = 1026;
+
+#endif  // IR_LEGO_H_
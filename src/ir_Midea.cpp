@@ -21,17 +21,12 @@
 //   https://docs.google.com/spreadsheets/d/1TZh4jWrx4h9zzpYUI9aYXMl1fYOiqu-xVuOOMqagxrs/edit?usp=sharing
 
 // Constants
-const uint16_t kMideaTick = 80;
 const uint16_t kMideaBitMarkTicks = 7;
 const uint16_t kMideaBitMark = kMideaBitMarkTicks * kMideaTick;
 const uint16_t kMideaOneSpaceTicks = 21;
 const uint16_t kMideaOneSpace = kMideaOneSpaceTicks * kMideaTick;
 const uint16_t kMideaZeroSpaceTicks = 7;
 const uint16_t kMideaZeroSpace = kMideaZeroSpaceTicks * kMideaTick;
-const uint16_t kMideaHdrMarkTicks = 56;
-const uint16_t kMideaHdrMark = kMideaHdrMarkTicks * kMideaTick;
-const uint16_t kMideaHdrSpaceTicks = 56;
-const uint16_t kMideaHdrSpace = kMideaHdrSpaceTicks * kMideaTick;
 const uint16_t kMideaMinGapTicks =
     kMideaHdrMarkTicks + kMideaZeroSpaceTicks + kMideaBitMarkTicks;
 const uint16_t kMideaMinGap = kMideaMinGapTicks * kMideaTick;
@@ -24,6 +24,11 @@
 //   https://docs.google.com/spreadsheets/d/1TZh4jWrx4h9zzpYUI9aYXMl1fYOiqu-xVuOOMqagxrs/edit?usp=sharing
 
 // Constants
+const uint16_t kMideaTick = 80;
+const uint16_t kMideaHdrMarkTicks = 56;
+const uint16_t kMideaHdrMark = kMideaHdrMarkTicks * kMideaTick;
+const uint16_t kMideaHdrSpaceTicks = 56;
+const uint16_t kMideaHdrSpace = kMideaHdrSpaceTicks * kMideaTick;
 const uint8_t kMideaACCool = 0;     // 0b000
 const uint8_t kMideaACDry = 1;      // 0b001
 const uint8_t kMideaACAuto = 2;     // 0b010
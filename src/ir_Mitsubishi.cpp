@@ -22,9 +22,6 @@
 // Ref:
 //   GlobalCache's Control Tower's Mitsubishi TV data.
 //   https://github.com/marcosamarinho/IRremoteESP8266/blob/master/ir_Mitsubishi.cpp
-const uint16_t kMitsubishiTick = 30;
-const uint16_t kMitsubishiBitMarkTicks = 10;
-const uint16_t kMitsubishiBitMark = kMitsubishiBitMarkTicks * kMitsubishiTick;
 const uint16_t kMitsubishiOneSpaceTicks = 70;
 const uint16_t kMitsubishiOneSpace = kMitsubishiOneSpaceTicks * kMitsubishiTick;
 const uint16_t kMitsubishiZeroSpaceTicks = 30;
@@ -40,8 +37,6 @@ const uint16_t kMitsubishiMinGap = kMitsubishiMinGapTicks * kMitsubishiTick;
 // Ref:
 //   https://github.com/crankyoldgit/IRremoteESP8266/issues/441
 
-const uint16_t kMitsubishi2HdrMark = 8400;
-const uint16_t kMitsubishi2HdrSpace = kMitsubishi2HdrMark / 2;
 const uint16_t kMitsubishi2BitMark = 560;
 const uint16_t kMitsubishi2ZeroSpace = 520;
 const uint16_t kMitsubishi2OneSpace = kMitsubishi2ZeroSpace * 3;
@@ -442,11 +437,9 @@ void IRMitsubishiAC::checksum(void) {
 }
 
 uint8_t IRMitsubishiAC::calculateChecksum(const uint8_t *data) {
-  uint8_t sum = 0;
   // Checksum is simple addition of all previous bytes stored
   // as an 8 bit value.
-  for (uint8_t i = 0; i < 17; i++) sum += data[i];
-  return sum & 0xFFU;
+  return sumBytes(data, 17);
 }
 
 // Set the requested power state of the A/C to off.
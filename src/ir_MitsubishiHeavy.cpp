@@ -27,8 +27,6 @@
 //   https://github.com/ToniA/arduino-heatpumpir/blob/master/MitsubishiHeavyHeatpumpIR.cpp
 
 // Constants
-const uint16_t kMitsubishiHeavyHdrMark = 3140;
-const uint16_t kMitsubishiHeavyHdrSpace = 1630;
 const uint16_t kMitsubishiHeavyBitMark = 370;
 const uint16_t kMitsubishiHeavyOneSpace = 420;
 const uint16_t kMitsubishiHeavyZeroSpace = 1220;
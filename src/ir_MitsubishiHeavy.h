@@ -25,6 +25,8 @@
 //   https://github.com/ToniA/arduino-heatpumpir/blob/master/MitsubishiHeavyHeatpumpIR.cpp
 
 // Constants.
+const uint16_t kMitsubishiHeavyHdrMark = 3140;
+const uint16_t kMitsubishiHeavyHdrSpace = 1630;
 const uint8_t kMitsubishiHeavySigLength = 5;
 
 
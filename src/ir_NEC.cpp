@@ -25,10 +25,7 @@
 // Ref:
 //  http://www.sbprojects.com/knowledge/ir/nec.php
 void IRsend::sendNEC(uint64_t data, uint16_t nbits, uint16_t repeat) {
-  sendGeneric(kNecHdrMark, kNecHdrSpace, kNecBitMark, kNecOneSpace, kNecBitMark,
-              kNecZeroSpace, kNecBitMark, kNecMinGap, kNecMinCommandLength,
-              data, nbits, 38, true, 0,  // Repeats are handled later.
-              33);
+  sendTimed<kNecTiming>(data, nbits);  // Repeats are handled later.
   // Optional command repeat sequence.
   if (repeat)
     sendGeneric(kNecHdrMark, kNecRptSpace, 0, 0, 0, 0,  // No actual data sent.
@@ -96,12 +93,11 @@ bool IRrecv::decodeNEC(decode_results *results, uint16_t nbits, bool strict) {
   uint64_t data = 0;
   uint16_t offset = kStartOffset;
 
-  // Header
-  if (!matchMark(results->rawbuf[offset++], kNecHdrMark)) return false;
   // Check if it is a repeat code.
   if (results->rawlen == kNecRptLength &&
-      matchSpace(results->rawbuf[offset], kNecRptSpace) &&
-      matchMark(results->rawbuf[offset + 1], kNecBitMark)) {
+      matchMark(results->rawbuf[offset], kNecHdrMark) &&
+      matchSpace(results->rawbuf[offset + 1], kNecRptSpace) &&
+      matchMark(results->rawbuf[offset + 2], kNecBitMark)) {
     results->value = kRepeat;
     results->decode_type = NEC;
     results->bits = 0;
@@ -111,13 +107,9 @@ bool IRrecv::decodeNEC(decode_results *results, uint16_t nbits, bool strict) {
     return true;
   }
 
-  // Match Header (cont.) + Data + Footer
-  if (!matchGeneric(results->rawbuf + offset, &data,
-                    results->rawlen - offset, nbits,
-                    0, kNecHdrSpace,
-                    kNecBitMark, kNecOneSpace,
-                    kNecBitMark, kNecZeroSpace,
-                    kNecBitMark, kNecMinGap, true)) return false;
+  // Match Header + Data + Footer
+  if (!matchTimed<kNecTiming>(results->rawbuf + offset, &data,
+                              results->rawlen - offset, nbits)) return false;
   // Compliance
   // Calculate command and optionally enforce integrity checking.
   uint8_t command = (data & 0xFF00) >> 8;
@@ -145,3 +137,41 @@ bool IRrecv::decodeNEC(decode_results *results, uint16_t nbits, bool strict) {
   return true;
 }
 #endif  // DECODE_NEC || DECODE_SHERWOOD || DECODE_AIWA_RC_T501 || DECODE_SANYO
+
+#if DECODE_NEC
+// Follow a NEC message (or repeat code) while it is being captured.
+// See IRrecv::decodeStream().
+//
+// Args:
+//   state:  A pointer to our progress through the capture.
+//   offset: The position of the entry in the capture. Odd ones are marks.
+//   entry:  The captured duration, in ticks.
+// Returns:
+//   kStreamEnd once the footer mark has been seen, kStreamFailed if it isn't a
+//   NEC message, otherwise kStreamMore.
+uint8_t IRrecv::streamNEC(stream_decoder_t *state, const uint16_t offset,
+                          const uint16_t entry) {
+  if (offset == kStartOffset)  // Header mark.
+    return matchMark(entry, kNecHdrMark) ? kStreamMore : kStreamFailed;
+  if (offset == kStartOffset + 1) {  // Header space.
+    if (matchSpace(entry, kNecRptSpace)) {
+      state->units = kNECBits;  // A repeat code. Only the footer is left.
+      return kStreamMore;
+    }
+    return matchSpace(entry, kNecHdrSpace) ? kStreamMore : kStreamFailed;
+  }
+  if (offset & 1) {  // A bit mark, or the footer mark.
+    if (!matchMark(entry, kNecBitMark)) return kStreamFailed;
+    if (state->units < kNECBits) return kStreamMore;
+    // Longer NEC-like messages (e.g. Sanyo LC7461) carry on with a bit space.
+    state->holdoff = spaceWindow(kNecOneSpace).high * kRawTick;
+    return kStreamEnd;
+  }
+  // A bit space.
+  if (state->units >= kNECBits) return kStreamFailed;  // Too long for NEC.
+  if (!matchSpace(entry, kNecOneSpace) && !matchSpace(entry, kNecZeroSpace))
+    return kStreamFailed;
+  state->units++;
+  return kStreamMore;
+}
+#endif  // DECODE_NEC
@@ -8,6 +8,7 @@
 
 #include <stdint.h>
 #include "IRremoteESP8266.h"
+#include "IRtiming.h"
 
 // Constants
 // Ref:
@@ -36,5 +37,9 @@ const uint16_t kNecMinGapTicks =
     kNecMinCommandLengthTicks -
     (kNecHdrMarkTicks + kNecHdrSpaceTicks +
      kNECBits * (kNecBitMarkTicks + kNecOneSpaceTicks) + kNecBitMarkTicks);
+constexpr protocol_timing_t kNecTiming = {
+    kNecHdrMark, kNecHdrSpace, kNecBitMark, kNecOneSpace, kNecBitMark,
+    kNecZeroSpace, kNecBitMark, kNecMinGap, kNecMinCommandLength,
+    38, 33, true};
 
 #endif  // IR_NEC_H_
@@ -21,8 +21,6 @@
 
 // Constants
 
-const uint16_t kNeoclimaHdrMark = 6112;
-const uint16_t kNeoclimaHdrSpace = 7391;
 const uint16_t kNeoclimaBitMark = 537;
 const uint16_t kNeoclimaOneSpace = 1651;
 const uint16_t kNeoclimaZeroSpace = 571;
@@ -27,6 +27,8 @@
 //  https://drive.google.com/file/d/1kjYk4zS9NQcMQhFkak-L4mp4UuaAIesW/view
 
 // Constants
+const uint16_t kNeoclimaHdrMark = 6112;
+const uint16_t kNeoclimaHdrSpace = 7391;
 // state[1]
 const uint8_t kNeoclima8CHeatMask = 0b00000010;
 const uint8_t kNeoclimaIonMask =    0b00000100;
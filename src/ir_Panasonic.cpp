@@ -35,11 +35,6 @@
 // Ref:
 //   http://www.remotecentral.com/cgi-bin/mboard/rc-pronto/thread.cgi?26152
 
-const uint16_t kPanasonicTick = 432;
-const uint16_t kPanasonicHdrMarkTicks = 8;
-const uint16_t kPanasonicHdrMark = kPanasonicHdrMarkTicks * kPanasonicTick;
-const uint16_t kPanasonicHdrSpaceTicks = 4;
-const uint16_t kPanasonicHdrSpace = kPanasonicHdrSpaceTicks * kPanasonicTick;
 const uint16_t kPanasonicBitMarkTicks = 1;
 const uint16_t kPanasonicBitMark = kPanasonicBitMarkTicks * kPanasonicTick;
 const uint16_t kPanasonicOneSpaceTicks = 3;
@@ -37,6 +37,11 @@
 //   https://github.com/ToniA/ESPEasy/blob/HeatpumpIR/lib/HeatpumpIR/PanasonicHeatpumpIR.cpp
 
 // Constants
+const uint16_t kPanasonicTick = 432;
+const uint16_t kPanasonicHdrMarkTicks = 8;
+const uint16_t kPanasonicHdrMark = kPanasonicHdrMarkTicks * kPanasonicTick;
+const uint16_t kPanasonicHdrSpaceTicks = 4;
+const uint16_t kPanasonicHdrSpace = kPanasonicHdrSpaceTicks * kPanasonicTick;
 const uint16_t kPanasonicFreq = 36700;
 const uint16_t kPanasonicAcExcess = 0;
 // Much higher than usual. See issue #540.
@@ -5,14 +5,6 @@
 #include <algorithm>
 #include "IRsend.h"
 
-// Constants
-const float kProntoFreqFactor = 0.241246;
-const uint16_t kProntoTypeOffset = 0;
-const uint16_t kProntoFreqOffset = 1;
-const uint16_t kProntoSeq1LenOffset = 2;
-const uint16_t kProntoSeq2LenOffset = 3;
-const uint16_t kProntoDataOffset = 4;
-
 #if SEND_PRONTO
 // Send a Pronto Code formatted message.
 //
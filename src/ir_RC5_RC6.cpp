@@ -7,8 +7,8 @@
 #include <algorithm>
 #include "IRrecv.h"
 #include "IRsend.h"
-#include "IRtimer.h"
 #include "IRutils.h"
+#include "ir_RC5_RC6.h"
 
 // Constants
 // RC-5/RC-5X
@@ -27,11 +27,6 @@ const uint16_t kRc5SamplesMin = 11;
 //   https://en.wikipedia.org/wiki/RC-6
 //   http://www.pcbheaven.com/userpages/The_Philips_RC6_Protocol/
 
-const uint16_t kRc6Tick = 444;
-const uint16_t kRc6HdrMarkTicks = 6;
-const uint16_t kRc6HdrMark = kRc6HdrMarkTicks * kRc6Tick;
-const uint16_t kRc6HdrSpaceTicks = 2;
-const uint16_t kRc6HdrSpace = kRc6HdrSpaceTicks * kRc6Tick;
 const uint16_t kRc6RptLengthTicks = 187;
 const uint32_t kRc6RptLength = kRc6RptLengthTicks * kRc6Tick;
 const uint32_t kRc6ToggleMask = 0x10000UL;  // The 17th bit.
@@ -75,9 +70,8 @@ void IRsend::sendRC5(uint64_t data, uint16_t nbits, uint16_t repeat) {
     nbits--;
   }
 
-  IRtimer usecTimer = IRtimer();
   for (uint16_t i = 0; i <= repeat; i++) {
-    usecTimer.reset();
+    uint32_t start = messageClock();
 
     // Header
     // First start bit (0x1). space, then mark.
@@ -105,7 +99,8 @@ void IRsend::sendRC5(uint64_t data, uint16_t nbits, uint16_t repeat) {
         space(kRc5T1);
       }
     // Footer
-    space(std::max(kRc5MinGap, kRc5MinCommandLength - usecTimer.elapsed()));
+    space(std::max(kRc5MinGap,
+                   kRc5MinCommandLength - (messageClock() - start)));
   }
 }
 
@@ -425,6 +420,40 @@ bool IRrecv::decodeRC5(decode_results *results, uint16_t nbits, bool strict) {
   results->bits = actual_bits;
   return true;
 }
+
+// Follow a RC-5/RC-5X message while it is being captured.
+// See IRrecv::decodeStream().
+//
+// Args:
+//   state:  A pointer to our progress through the capture.
+//   offset: The position of the entry in the capture. Odd ones are marks.
+//   entry:  The captured duration, in ticks.
+// Returns:
+//   kStreamEnd after the last mark of the message, kStreamFailed if it isn't a
+//   RC-5 message, otherwise kStreamMore.
+uint8_t IRrecv::streamRC5(stream_decoder_t *state, const uint16_t offset,
+                          const uint16_t entry) {
+  // Each entry is one or two half-bit (kRc5T1) periods long.
+  uint16_t halves;
+  bool mark = offset & 1;
+  if (mark ? matchMark(entry, kRc5T1) : matchSpace(entry, kRc5T1))
+    halves = 1;
+  else if (mark ? matchMark(entry, 2 * kRc5T1) : matchSpace(entry, 2 * kRc5T1))
+    halves = 2;
+  else
+    return kStreamFailed;
+  // The space half of the first start bit is never captured.
+  if (offset == kStartOffset) state->units = 1;
+  state->units += halves;
+  if (state->units > 2 * kRC5RawBits) return kStreamFailed;
+  // Always kRC5RawBits long. If the last bit is a '0', it ends in a mark, & its
+  // space half is part of the gap. So, nothing can follow the last mark.
+  if (mark && state->units >= 2 * kRC5RawBits - 1) {
+    state->holdoff = 0;
+    return kStreamEnd;
+  }
+  return kStreamMore;
+}
 #endif  // DECODE_RC5
 
 #if DECODE_RC6
@@ -0,0 +1,16 @@
+// Copyright 2009 Ken Shirriff
+// Copyright 2017 David Conran
+
+#ifndef IR_RC5_RC6_H_
+#define IR_RC5_RC6_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kRc6Tick = 444;
+const uint16_t kRc6HdrMarkTicks = 6;
+const uint16_t kRc6HdrMark = kRc6HdrMarkTicks * kRc6Tick;
+const uint16_t kRc6HdrSpaceTicks = 2;
+const uint16_t kRc6HdrSpace = kRc6HdrSpaceTicks * kRc6Tick;
+
+#endif  // IR_RC5_RC6_H_
@@ -8,17 +8,12 @@
 #include <algorithm>
 #include "IRrecv.h"
 #include "IRsend.h"
-#include "IRtimer.h"
 #include "IRutils.h"
+#include "ir_RCMM.h"
 
 // Constants
 // Ref:
 //   http://www.sbprojects.com/knowledge/ir/rcmm.php
-const uint16_t kRcmmTick = 28;  // Technically it would be 27.777*
-const uint16_t kRcmmHdrMarkTicks = 15;
-const uint16_t kRcmmHdrMark = 416;
-const uint16_t kRcmmHdrSpaceTicks = 10;
-const uint16_t kRcmmHdrSpace = 277;
 const uint16_t kRcmmBitMarkTicks = 6;
 const uint16_t kRcmmBitMark = 166;
 const uint16_t kRcmmBitSpace0Ticks = 10;
@@ -52,10 +47,9 @@ const uint16_t kRcmmExcess = 50;
 void IRsend::sendRCMM(uint64_t data, uint16_t nbits, uint16_t repeat) {
   // Set 36kHz IR carrier frequency & a 1/3 (33%) duty cycle.
   enableIROut(36, 33);
-  IRtimer usecs = IRtimer();
 
   for (uint16_t r = 0; r <= repeat; r++) {
-    usecs.reset();
+    uint32_t start = messageClock();
     // Header
     mark(kRcmmHdrMark);
     space(kRcmmHdrSpace);
@@ -85,7 +79,7 @@ void IRsend::sendRCMM(uint64_t data, uint16_t nbits, uint16_t repeat) {
     mark(kRcmmBitMark);
     // Protocol requires us to wait at least kRcmmRptLength usecs from the
     // start or kRcmmMinGap usecs.
-    space(std::max(kRcmmRptLength - usecs.elapsed(), kRcmmMinGap));
+    space(std::max(kRcmmRptLength - (messageClock() - start), kRcmmMinGap));
   }
 }
 #endif
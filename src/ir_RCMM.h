@@ -0,0 +1,15 @@
+// Copyright 2017 David Conran
+
+#ifndef IR_RCMM_H_
+#define IR_RCMM_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kRcmmTick = 28;  // Technically it would be 27.777*
+const uint16_t kRcmmHdrMarkTicks = 15;
+const uint16_t kRcmmHdrMark = 416;
+const uint16_t kRcmmHdrSpaceTicks = 10;
+const uint16_t kRcmmHdrSpace = 277;
+
+#endif  // IR_RCMM_H_
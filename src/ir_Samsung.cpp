@@ -17,11 +17,6 @@
 // Constants
 // Ref:
 //   http://elektrolab.wz.cz/katalog/samsung_protocol.pdf
-const uint16_t kSamsungTick = 560;
-const uint16_t kSamsungHdrMarkTicks = 8;
-const uint16_t kSamsungHdrMark = kSamsungHdrMarkTicks * kSamsungTick;
-const uint16_t kSamsungHdrSpaceTicks = 8;
-const uint16_t kSamsungHdrSpace = kSamsungHdrSpaceTicks * kSamsungTick;
 const uint16_t kSamsungBitMarkTicks = 1;
 const uint16_t kSamsungBitMark = kSamsungBitMarkTicks * kSamsungTick;
 const uint16_t kSamsungOneSpaceTicks = 3;
@@ -39,9 +34,11 @@ const uint16_t kSamsungMinGapTicks =
      kSamsungBits * (kSamsungBitMarkTicks + kSamsungOneSpaceTicks) +
      kSamsungBitMarkTicks);
 const uint32_t kSamsungMinGap = kSamsungMinGapTicks * kSamsungTick;
+constexpr protocol_timing_t kSamsungTiming = {
+    kSamsungHdrMark, kSamsungHdrSpace, kSamsungBitMark, kSamsungOneSpace,
+    kSamsungBitMark, kSamsungZeroSpace, kSamsungBitMark, kSamsungMinGap,
+    kSamsungMinMessageLength, 38, 33, true};
 
-const uint16_t kSamsungAcHdrMark = 690;
-const uint16_t kSamsungAcHdrSpace = 17844;
 const uint8_t kSamsungAcSections = 2;
 const uint16_t kSamsungAcSectionMark = 3086;
 const uint16_t kSamsungAcSectionSpace = 8864;
@@ -66,10 +63,7 @@ const uint16_t kSamsungAcZeroSpace = 436;
 // Ref: http://elektrolab.wz.cz/katalog/samsung_protocol.pdf
 void IRsend::sendSAMSUNG(const uint64_t data, const uint16_t nbits,
                          const uint16_t repeat) {
-  sendGeneric(kSamsungHdrMark, kSamsungHdrSpace, kSamsungBitMark,
-              kSamsungOneSpace, kSamsungBitMark, kSamsungZeroSpace,
-              kSamsungBitMark, kSamsungMinGap, kSamsungMinMessageLength, data,
-              nbits, 38, true, repeat, 33);
+  sendTimed<kSamsungTiming>(data, nbits, repeat);
 }
 
 // Construct a raw Samsung message from the supplied customer(address) &
@@ -121,12 +115,9 @@ bool IRrecv::decodeSAMSUNG(decode_results *results, const uint16_t nbits,
   uint16_t offset = kStartOffset;
 
   // Match Header + Data + Footer
-  if (!matchGeneric(results->rawbuf + offset, &data,
-                    results->rawlen - offset, nbits,
-                    kSamsungHdrMark, kSamsungHdrSpace,
-                    kSamsungBitMark, kSamsungOneSpace,
-                    kSamsungBitMark, kSamsungZeroSpace,
-                    kSamsungBitMark, kSamsungMinGap, true)) return false;
+  if (!matchTimed<kSamsungTiming>(results->rawbuf + offset, &data,
+                                  results->rawlen - offset, nbits))
+    return false;
   // Compliance
   // According to the spec, the customer (address) code is the first 8
   // transmitted bits. It's then repeated. Check for that.
@@ -26,6 +26,13 @@
 //   https://github.com/crankyoldgit/IRremoteESP8266/issues/505
 
 // Constants
+const uint16_t kSamsungTick = 560;
+const uint16_t kSamsungHdrMarkTicks = 8;
+const uint16_t kSamsungHdrMark = kSamsungHdrMarkTicks * kSamsungTick;
+const uint16_t kSamsungHdrSpaceTicks = 8;
+const uint16_t kSamsungHdrSpace = kSamsungHdrSpaceTicks * kSamsungTick;
+const uint16_t kSamsungAcHdrMark = 690;
+const uint16_t kSamsungAcHdrSpace = 17844;
 const uint8_t kSamsungAcAuto = 0;
 const uint8_t kSamsungAcCool = 1;
 const uint8_t kSamsungAcDry = 2;
@@ -22,9 +22,6 @@
 // Ref:
 //   GlobalCache's IR Control Tower data.
 //   http://www.sbprojects.com/knowledge/ir/sharp.php
-const uint16_t kSharpTick = 26;
-const uint16_t kSharpBitMarkTicks = 10;
-const uint16_t kSharpBitMark = kSharpBitMarkTicks * kSharpTick;
 const uint16_t kSharpOneSpaceTicks = 70;
 const uint16_t kSharpOneSpace = kSharpOneSpaceTicks * kSharpTick;
 const uint16_t kSharpZeroSpaceTicks = 30;
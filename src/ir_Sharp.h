@@ -18,6 +18,9 @@
 #endif
 
 // Constants
+const uint16_t kSharpTick = 26;
+const uint16_t kSharpBitMarkTicks = 10;
+const uint16_t kSharpBitMark = kSharpBitMarkTicks * kSharpTick;
 const uint16_t kSharpAcHdrMark = 3800;
 const uint16_t kSharpAcHdrSpace = 1900;
 const uint16_t kSharpAcBitMark = 470;
@@ -58,6 +61,7 @@ class IRSharpAc {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif  // SEND_SHARP_AC
   void begin(void);
+  void stateReset(void);
   void on(void);
   void off(void);
   void setPower(const bool on);
@@ -89,7 +93,6 @@ class IRSharpAc {
 #endif
   // # of bytes per command
   uint8_t remote[kSharpAcStateLength];
-  void stateReset(void);
   void checksum(void);
   static uint8_t calcChecksum(uint8_t state[],
                               const uint16_t length = kSharpAcStateLength);
@@ -8,6 +8,7 @@
 #include "IRrecv.h"
 #include "IRsend.h"
 #include "IRutils.h"
+#include "ir_Sony.h"
 
 // Sony originally added from https://github.com/shirriff/Arduino-IRremote/
 // Updates from marcosamarinho
@@ -15,9 +16,6 @@
 // Constants
 // Ref:
 //   http://www.sbprojects.com/knowledge/ir/sirc.php
-const uint16_t kSonyTick = 200;
-const uint16_t kSonyHdrMarkTicks = 12;
-const uint16_t kSonyHdrMark = kSonyHdrMarkTicks * kSonyTick;
 const uint16_t kSonySpaceTicks = 3;
 const uint16_t kSonySpace = kSonySpaceTicks * kSonyTick;
 const uint16_t kSonyOneMarkTicks = 6;
@@ -28,6 +26,10 @@ const uint16_t kSonyRptLengthTicks = 225;
 const uint16_t kSonyRptLength = kSonyRptLengthTicks * kSonyTick;
 const uint16_t kSonyMinGapTicks = 50;
 const uint16_t kSonyMinGap = kSonyMinGapTicks * kSonyTick;
+constexpr protocol_timing_t kSonyTiming = {
+    kSonyHdrMark, kSonySpace, kSonyOneMark, kSonySpace, kSonyZeroMark,
+    kSonySpace, 0,  // No Footer mark.
+    kSonyMinGap, kSonyRptLength, 40, 33, true};
 
 #if SEND_SONY
 // Send a Sony/SIRC(Serial Infra-Red Control) message.
@@ -46,10 +48,7 @@ const uint16_t kSonyMinGap = kSonyMinGapTicks * kSonyTick;
 // Ref:
 //   http://www.sbprojects.com/knowledge/ir/sirc.php
 void IRsend::sendSony(uint64_t data, uint16_t nbits, uint16_t repeat) {
-  sendGeneric(kSonyHdrMark, kSonySpace, kSonyOneMark, kSonySpace, kSonyZeroMark,
-              kSonySpace,
-              0,  // No Footer mark.
-              kSonyMinGap, kSonyRptLength, data, nbits, 40, true, repeat, 33);
+  sendTimed<kSonyTiming>(data, nbits, repeat);
 }
 
 // Convert Sony/SIRC command, address, & extended bits into sendSony format.
@@ -169,4 +168,43 @@ bool IRrecv::decodeSony(decode_results *results, uint16_t nbits, bool strict) {
   }
   return true;
 }
+
+// Follow a Sony message while it is being captured.
+// See IRrecv::decodeStream().
+//
+// Args:
+//   state:  A pointer to our progress through the capture.
+//   offset: The position of the entry in the capture. Odd ones are marks.
+//   entry:  The captured duration, in ticks.
+// Returns:
+//   kStreamEnd after the last mark of a 12, 15 or 20 bit message,
+//   kStreamFailed if it isn't a Sony message, otherwise kStreamMore.
+//
+// Note:
+//   Unlike decodeSony(), this uses the nominal tick rather than one calculated
+//   from the header mark. Messages it doesn't follow are still decoded when the
+//   capture times out.
+uint8_t IRrecv::streamSony(stream_decoder_t *state, const uint16_t offset,
+                           const uint16_t entry) {
+  if (offset == kStartOffset)  // Header mark.
+    return matchMark(entry, kSonyHdrMark) ? kStreamMore : kStreamFailed;
+  if (!(offset & 1))  // The space before each bit.
+    return (state->units < kSony20Bits && matchSpace(entry, kSonySpace)) ?
+        kStreamMore : kStreamFailed;
+  // A bit mark. There is no footer.
+  if (!matchMark(entry, kSonyOneMark) && !matchMark(entry, kSonyZeroMark))
+    return kStreamFailed;
+  switch (++state->units) {
+    case kSony12Bits:
+    case kSony15Bits:
+      // It could still be a longer message.
+      state->holdoff = spaceWindow(kSonySpace).high * kRawTick;
+      return kStreamEnd;
+    case kSony20Bits:
+      state->holdoff = 0;  // Nothing is longer.
+      return kStreamEnd;
+    default:
+      return kStreamMore;
+  }
+}
 #endif
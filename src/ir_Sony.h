@@ -0,0 +1,15 @@
+// Copyright 2009 Ken Shirriff
+// Copyright 2016 marcosamarinho
+// Copyright 2017 David Conran
+
+#ifndef IR_SONY_H_
+#define IR_SONY_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kSonyTick = 200;
+const uint16_t kSonyHdrMarkTicks = 12;
+const uint16_t kSonyHdrMark = kSonyHdrMarkTicks * kSonyTick;
+
+#endif  // IR_SONY_H_
@@ -58,6 +58,7 @@ class IRTcl112Ac {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif  // SEND_TCL
   void begin(void);
+  void stateReset(void);
   uint8_t* getRaw(void);
   void setRaw(const uint8_t new_code[],
               const uint16_t length = kTcl112AcStateLength);
@@ -101,7 +102,6 @@ class IRTcl112Ac {
   IRsendTest _irsend;
 #endif
   uint8_t remote_state[kTcl112AcStateLength];
-  void stateReset(void);
   void checksum(const uint16_t length = kTcl112AcStateLength);
 };
 
@@ -13,8 +13,6 @@ Node MCU/ESP8266 Sketch to emulate Teco
 
 // Constants
 // using SPACE modulation.
-const uint16_t kTecoHdrMark = 9000;
-const uint16_t kTecoHdrSpace = 4440;
 const uint16_t kTecoBitMark = 620;
 const uint16_t kTecoOneSpace = 1650;
 const uint16_t kTecoZeroSpace = 580;
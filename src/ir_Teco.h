@@ -13,6 +13,8 @@
 #endif
 
 // Constants. Using LSB to be able to send only 35bits.
+const uint16_t kTecoHdrMark = 9000;
+const uint16_t kTecoHdrSpace = 4440;
 const uint8_t kTecoAuto = 0;  // 0b000
 const uint8_t kTecoCool = 1;  // 0b001
 const uint8_t kTecoDry = 2;  // 0b010
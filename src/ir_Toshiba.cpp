@@ -24,8 +24,6 @@
 // Toshiba A/C
 // Ref:
 //   https://github.com/r45635/HVAC-IR-Control/blob/master/HVAC_ESP8266/HVAC_ESP8266T.ino#L77
-const uint16_t kToshibaAcHdrMark = 4400;
-const uint16_t kToshibaAcHdrSpace = 4300;
 const uint16_t kToshibaAcBitMark = 543;
 const uint16_t kToshibaAcOneSpace = 1623;
 const uint16_t kToshibaAcZeroSpace = 472;
@@ -115,13 +113,11 @@ void IRToshibaAC::setRaw(const uint8_t newState[]) {
 //   The 8 bit checksum value.
 uint8_t IRToshibaAC::calcChecksum(const uint8_t state[],
                                   const uint16_t length) {
-  uint8_t checksum = 0;
   // Only calculate it for valid lengths.
-  if (length > 1) {
+  if (length > 1)
     // Checksum is simple XOR of all bytes except the last one.
-    for (uint8_t i = 0; i < length - 1; i++) checksum ^= state[i];
-  }
-  return checksum;
+    return xorBytes(state, length - 1);
+  return 0;
 }
 
 // Verify the checksum is valid for a given state.
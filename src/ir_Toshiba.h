@@ -25,6 +25,8 @@
 #endif
 
 // Constants
+const uint16_t kToshibaAcHdrMark = 4400;
+const uint16_t kToshibaAcHdrSpace = 4300;
 const uint8_t kToshibaAcAuto = 0;
 const uint8_t kToshibaAcCool = 1;
 const uint8_t kToshibaAcDry = 2;
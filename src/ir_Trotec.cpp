@@ -10,8 +10,6 @@
 #include "IRutils.h"
 
 // Constants
-const uint16_t kTrotecHdrMark = 5952;
-const uint16_t kTrotecHdrSpace = 7364;
 const uint16_t kTrotecBitMark = 592;
 const uint16_t kTrotecOneSpace = 1560;
 const uint16_t kTrotecZeroSpace = 592;
@@ -27,11 +25,11 @@ void IRsend::sendTrotec(const unsigned char data[], const uint16_t nbytes,
   for (uint16_t r = 0; r <= repeat; r++) {
     sendGeneric(kTrotecHdrMark, kTrotecHdrSpace, kTrotecBitMark,
                 kTrotecOneSpace, kTrotecBitMark, kTrotecZeroSpace,
-                kTrotecBitMark, kTrotecGap, data, nbytes, 36, false,
+                kTrotecBitMark, kTrotecGap, data, nbytes, kTrotecFreq, false,
                 0,  // Repeats handled elsewhere
                 50);
     // More footer
-    enableIROut(36);
+    enableIROut(kTrotecFreq);
     mark(kTrotecBitMark);
     space(kTrotecGapEnd);
   }
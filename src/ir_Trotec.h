@@ -14,6 +14,10 @@
 #endif
 
 // Constants
+const uint16_t kTrotecHdrMark = 5952;
+const uint16_t kTrotecHdrSpace = 7364;
+const uint16_t kTrotecFreq = 36000;  // Modulation Frequency in Hz.
+
 // Byte 0
 const uint8_t kTrotecIntro1 = 0x12;
 
@@ -66,6 +70,7 @@ class IRTrotecESP {
   uint8_t calibrate(void) { return _irsend.calibrate(); }
 #endif  // SEND_TROTEC
   void begin(void);
+  void stateReset(void);
 
   void setPower(const bool state);
   bool getPower(void);
@@ -105,7 +110,6 @@ class IRTrotecESP {
   uint8_t remote_state[kTrotecStateLength];
   static uint8_t calcChecksum(const uint8_t state[],
                               const uint16_t length = kTrotecStateLength);
-  void stateReset(void);
   void checksum(void);
 };
 
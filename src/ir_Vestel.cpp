@@ -365,13 +365,8 @@ bool IRVestelAc::getSwing(void) {
 //   The 8 bit checksum value.
 uint8_t IRVestelAc::calcChecksum(const uint64_t state) {
   // Just counts the set bits +1 on stream and take inverse after mask
-  uint8_t sum = 0;
-  uint64_t temp_state = state & kVestelAcCRCMask;
-  for (; temp_state; temp_state >>= 1)
-    if (temp_state & 1) sum++;
-  sum += 2;
-  sum = 0xff - sum;
-  return sum;
+  uint8_t sum = countBits(state & kVestelAcCRCMask, 64, true, 2);
+  return 0xff - sum;
 }
 
 // Verify the checksum is valid for a given state.
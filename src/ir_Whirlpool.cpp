@@ -26,8 +26,6 @@
 
 // Constants
 // Ref: https://github.com/crankyoldgit/IRremoteESP8266/issues/509
-const uint16_t kWhirlpoolAcHdrMark = 8950;
-const uint16_t kWhirlpoolAcHdrSpace = 4484;
 const uint16_t kWhirlpoolAcBitMark = 597;
 const uint16_t kWhirlpoolAcOneSpace = 1649;
 const uint16_t kWhirlpoolAcZeroSpace = 533;
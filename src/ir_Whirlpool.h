@@ -30,6 +30,8 @@
 //   https://github.com/crankyoldgit/IRremoteESP8266/issues/509
 
 // Constants
+const uint16_t kWhirlpoolAcHdrMark = 8950;
+const uint16_t kWhirlpoolAcHdrSpace = 4484;
 const uint8_t kWhirlpoolAcChecksumByte1 = 13;
 const uint8_t kWhirlpoolAcChecksumByte2 = kWhirlpoolAcStateLength - 1;
 const uint8_t kWhirlpoolAcHeat = 0;
@@ -0,0 +1,14 @@
+// Copyright 2009 Ken Shirriff
+// Copyright 2017 David Conran
+
+#ifndef IR_WHYNTER_H_
+#define IR_WHYNTER_H_
+
+#include <stdint.h>
+
+// Constants
+const uint16_t kWhynterTick = 50;
+const uint16_t kWhynterBitMarkTicks = 15;
+const uint16_t kWhynterBitMark = kWhynterBitMarkTicks * kWhynterTick;
+
+#endif  // IR_WHYNTER_H_
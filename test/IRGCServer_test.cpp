@@ -0,0 +1,298 @@
+// Copyright 2019 David Conran
+
+#include <string>
+#include <vector>
+#include "IRGCServer.h"
+#include "IRsend.h"
+#include "IRsend_test.h"
+#include "gtest/gtest.h"
+
+// Record what each client was sent.
+static std::string replies[kGcServerConnections];
+
+void recordReply(const uint8_t connection, const char *reply) {
+  replies[connection] += reply;
+}
+
+void clearReplies(void) {
+  for (uint8_t i = 0; i < kGcServerConnections; i++) replies[i].clear();
+}
+
+// Give the server a whole string.
+// Returns: The nr. of characters it took.
+uint16_t receiveString(IRGCServer *server, const uint8_t connection,
+                       const std::string &data) {
+  return server->receive(connection, data.c_str(), data.size());
+}
+
+// What sendGC() on its own would have sent.
+std::string expectedGC(std::vector<uint16_t> code) {
+  IRsendTest irsend(0);
+  irsend.begin();
+  irsend.reset();
+  irsend.sendGC(code.data(), code.size());
+  return irsend.outputStr();
+}
+
+// A backend that just remembers what it was asked to play.
+class IRGCServerTestBackend : public IRsendBackend {
+ public:
+  uint16_t plays = 0;
+  bool playing = false;
+
+  bool play(const ir_pulse_train_t *train __attribute__((unused))) {
+    plays++;
+    playing = true;
+    return true;
+  }
+  bool busy() { return playing; }
+};
+
+TEST(TestIRGCServer, SendAndComplete) {
+  IRsendTest irsend(0);
+  IRGCServer server(&irsend, recordReply);
+  irsend.begin();
+  clearReplies();
+  uint8_t client = server.connect();
+  ASSERT_NE(kGcServerNoConnection, client);
+  EXPECT_EQ(1, server.connections());
+  EXPECT_TRUE(server.idle());
+  irsend.reset();
+  std::string line = "sendir,1:1,7,38000,1,1,342,171,21,21,21,64,21,1500\r";
+  EXPECT_EQ(line.size(), receiveString(&server, client, line));
+  EXPECT_EQ(1, server.depth());
+  EXPECT_EQ("", replies[client]);
+  EXPECT_EQ("", irsend.outputStr());  // Nothing is sent until handle().
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ("completeir,1:1,7\r", replies[client]);
+  EXPECT_EQ(expectedGC({38000, 1, 1, 342, 171, 21, 21, 21, 64, 21, 1500}),
+            irsend.outputStr());
+  EXPECT_TRUE(server.idle());
+  EXPECT_FALSE(server.handle());
+  gc_server_stats_t stats = server.getStats();
+  EXPECT_EQ(1, stats.commands);
+  EXPECT_EQ(1, stats.sent);
+  EXPECT_EQ(0, stats.errors);
+}
+
+// Lines can arrive in any size pieces.
+TEST(TestIRGCServer, Incremental) {
+  IRsendTest irsend(0);
+  IRGCServer server(&irsend, recordReply);
+  irsend.begin();
+  clearReplies();
+  uint8_t client = server.connect();
+  std::string lines = "getversion\r\nsendir,1:1,65535,40000,1,1,96,24,48,24"
+                      ",24,1000\r\n";
+  for (size_t i = 0; i < lines.size(); i++)
+    ASSERT_EQ(1, server.receive(client, &lines[i], 1));
+  EXPECT_EQ("IRremoteESP8266 v" _IRREMOTEESP8266_VERSION_ "\r",
+            replies[client]);
+  clearReplies();
+  irsend.reset();
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ("completeir,1:1,65535\r", replies[client]);
+  EXPECT_EQ(expectedGC({40000, 1, 1, 96, 24, 48, 24, 24, 1000}),
+            irsend.outputStr());
+}
+
+TEST(TestIRGCServer, Repeats) {
+  IRsendTest irsend(0);
+  IRGCServer server(&irsend, recordReply);
+  irsend.begin();
+  clearReplies();
+  uint8_t client = server.connect();
+  irsend.reset();
+  receiveString(&server, client,
+                "sendir,1:1,2,38000,3,5,342,171,21,21,21,64,21,1500\r");
+  // One copy per handle().
+  EXPECT_TRUE(server.handle());
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ("", replies[client]);
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ("completeir,1:1,2\r", replies[client]);
+  EXPECT_FALSE(server.handle());
+  EXPECT_EQ(expectedGC({38000, 3, 5, 342, 171, 21, 21, 21, 64, 21, 1500}),
+            irsend.outputStr());
+  // The message was left as it was.
+  EXPECT_EQ(38000, server._connections[client].values[0]);
+  EXPECT_EQ(3, server._connections[client].values[1]);
+  EXPECT_EQ(5, server._connections[client].values[2]);
+  EXPECT_EQ(342, server._connections[client].values[3]);
+  EXPECT_EQ(21, server._connections[client].values[5]);
+}
+
+// Several clients, pipelining commands. First come, first served.
+TEST(TestIRGCServer, PipelinedClients) {
+  IRsendTest irsend(0);
+  IRGCServer server(&irsend, recordReply);
+  irsend.begin();
+  clearReplies();
+  uint8_t a = server.connect();
+  uint8_t b = server.connect();
+  ASSERT_NE(a, b);
+  std::string first = "sendir,1:1,1,38000,1,1,100,100\r";
+  std::string second = "sendir,1:1,2,38000,1,1,200,200\r";
+  std::string data = first + "getdevices\r" + second;
+  // It takes the 1st sendir & the getdevices, but the 2nd has to wait.
+  uint16_t taken = receiveString(&server, a, data);
+  EXPECT_EQ(first.size() + 11 + 6, taken);  // Up to the ',' after "sendir".
+  EXPECT_EQ("device,0,0 ETHERNET\rdevice,1,1 IR\rendlistdevices\r",
+            replies[a]);
+  // Still waiting.
+  EXPECT_EQ(0, server.receive(a, data.c_str() + taken, data.size() - taken));
+  receiveString(&server, b, "sendir,1:1,3,38000,1,1,300,300\r");
+  EXPECT_EQ(2, server.depth());
+  clearReplies();
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ("completeir,1:1,1\r", replies[a]);
+  // Now the rest of a's data can go in. Behind b's.
+  EXPECT_EQ(data.size() - taken,
+            server.receive(a, data.c_str() + taken, data.size() - taken));
+  EXPECT_EQ(2, server.depth());
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ("completeir,1:1,3\r", replies[b]);
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ("completeir,1:1,1\rcompleteir,1:1,2\r", replies[a]);
+  EXPECT_EQ(2, server.getStats().max_depth);
+}
+
+// stopir cuts short the sendir being sent, & drops the rest.
+TEST(TestIRGCServer, StopIr) {
+  IRsendTest irsend(0);
+  IRGCServer server(&irsend, recordReply);
+  irsend.begin();
+  clearReplies();
+  uint8_t a = server.connect();
+  uint8_t b = server.connect();
+  uint8_t c = server.connect();
+  receiveString(&server, a, "sendir,1:1,1,38000,50,1,100,100\r");
+  receiveString(&server, b, "sendir,1:1,2,38000,1,1,100,100\r");
+  EXPECT_TRUE(server.handle());
+  EXPECT_TRUE(server.handle());
+  receiveString(&server, c, "stopir,1:1\r");
+  EXPECT_EQ("stopir,1:1\r", replies[a]);
+  EXPECT_EQ("stopir,1:1\r", replies[b]);
+  EXPECT_EQ("stopir,1:1\r", replies[c]);
+  EXPECT_EQ(0, server.depth());
+  EXPECT_FALSE(server.handle());
+  EXPECT_EQ(2, server.getStats().stopped);
+  EXPECT_EQ(0, server.getStats().sent);
+  // The client that sent it only gets the one reply.
+  clearReplies();
+  receiveString(&server, a, "sendir,1:1,4,38000,1,1,100,100\r");
+  receiveString(&server, a, "stopir,1:1\r");
+  EXPECT_EQ("stopir,1:1\r", replies[a]);
+  // Nothing to stop is fine too.
+  receiveString(&server, b, "stopir,1:1\r");
+  EXPECT_EQ("stopir,1:1\r", replies[b]);
+}
+
+TEST(TestIRGCServer, Errors) {
+  IRsendTest irsend(0);
+  IRGCServer server(&irsend, recordReply);
+  irsend.begin();
+  uint8_t client = server.connect();
+  const struct {
+    const char *line;
+    const char *reply;
+  } kTests[] = {
+      {"bogus\r", "ERR_0:0,001\r"},
+      {"sendirx,1:1,1\r", "ERR_0:0,001\r"},
+      {"sendir,2:1,1,38000,1,1,100,100\r", "ERR_2:1,002\r"},
+      {"sendir,1:3,1,38000,1,1,100,100\r", "ERR_1:3,003\r"},
+      {"sendir,1-1,1,38000,1,1,100,100\r", "ERR_0:0,017\r"},
+      {"sendir,1:1,x,38000,1,1,100,100\r", "ERR_1:1,004\r"},
+      {"sendir,1:1,65536,38000,1,1,100,100\r", "ERR_1:1,004\r"},
+      {"sendir,1:1,1,1000,1,1,100,100\r", "ERR_1:1,005\r"},
+      {"sendir,1:1,1,70000,1,1,100,100\r", "ERR_1:1,005\r"},
+      {"sendir,1:1,1,38000,0,1,100,100\r", "ERR_1:1,006\r"},
+      {"sendir,1:1,1,38000,51,1,100,100\r", "ERR_1:1,006\r"},
+      {"sendir,1:1,1,38000,1,2,100,100\r", "ERR_1:1,007\r"},
+      {"sendir,1:1,1,38000,1,3,100,100\r", "ERR_1:1,007\r"},
+      {"sendir,1:1,1,38000,1,1\r", "ERR_1:1,008\r"},
+      {"sendir,1:1,1,38000,1,1,100,0\r", "ERR_1:1,009\r"},
+      {"sendir,1:1,1,38000,1,1,100,,100\r", "ERR_1:1,009\r"},
+      {"sendir,1:1,1,38000,1,1,100,100,100\r", "ERR_1:1,010\r"},
+      {"sendir,1:1,1,38000\r", "ERR_1:1,017\r"},
+      {"stopir\r", "ERR_0:0,017\r"},
+      {"stopir,1:1,2\r", "ERR_1:1,017\r"},
+      {"getdevices,1:1\r", "ERR_1:1,017\r"},
+  };
+  for (const auto &test : kTests) {
+    clearReplies();
+    receiveString(&server, client, test.line);
+    EXPECT_EQ(test.reply, replies[client]) << test.line;
+  }
+  EXPECT_EQ(0, server.depth());
+  EXPECT_EQ(sizeof(kTests) / sizeof(kTests[0]), server.getStats().errors);
+
+  // Too many values.
+  std::string line = "sendir,1:1,1,38000,1,1";
+  for (uint16_t i = 0; i < kGcServerMaxValues; i++) line += ",10";
+  clearReplies();
+  receiveString(&server, client, line + "\r");
+  EXPECT_EQ("ERR_1:1,020\r", replies[client]);
+  // It recovers for the next line.
+  clearReplies();
+  receiveString(&server, client, "sendir,1:1,9,38000,1,1,100,100\r");
+  EXPECT_EQ("", replies[client]);
+  EXPECT_EQ(1, server.depth());
+}
+
+TEST(TestIRGCServer, Connections) {
+  IRsendTest irsend(0);
+  IRGCServer server(&irsend, recordReply);
+  irsend.begin();
+  clearReplies();
+  uint8_t clients[kGcServerConnections];
+  for (uint8_t i = 0; i < kGcServerConnections; i++) {
+    clients[i] = server.connect();
+    ASSERT_EQ(i, clients[i]);
+  }
+  EXPECT_EQ(kGcServerNoConnection, server.connect());
+  EXPECT_EQ(1, server.getStats().refused);
+  for (uint8_t i = 0; i < kGcServerConnections; i++)
+    receiveString(&server, clients[i], "sendir,1:1,1,38000,2,1,100,100\r");
+  EXPECT_EQ(kGcServerConnections, server.depth());
+  // Drop the one being sent, part way through, & one waiting.
+  EXPECT_TRUE(server.handle());
+  server.disconnect(clients[0]);
+  server.disconnect(clients[2]);
+  EXPECT_EQ(kGcServerConnections - 2, server.connections());
+  EXPECT_EQ(2, server.depth());
+  while (server.handle()) {}
+  EXPECT_EQ("", replies[clients[0]]);
+  EXPECT_EQ("completeir,1:1,1\r", replies[clients[1]]);
+  EXPECT_EQ("", replies[clients[2]]);
+  EXPECT_EQ("completeir,1:1,1\r", replies[clients[3]]);
+  // The connection can be reused, & starts afresh.
+  EXPECT_EQ(clients[0], server.connect());
+  EXPECT_EQ(0, server.depth());
+}
+
+// With a backend, copies are played in the background, & acknowledged once
+// they have finished.
+TEST(TestIRGCServer, Backend) {
+  IRsendTest irsend(0);
+  IRGCServerTestBackend backend;
+  irsend.setBackend(&backend);
+  IRGCServer server(&irsend, recordReply);
+  irsend.begin();
+  clearReplies();
+  uint8_t client = server.connect();
+  receiveString(&server, client, "sendir,1:1,5,38000,2,1,100,100\r");
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ(1, backend.plays);
+  EXPECT_FALSE(server.handle());  // Still playing.
+  backend.playing = false;
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ(2, backend.plays);
+  EXPECT_EQ("", replies[client]);
+  EXPECT_FALSE(server.idle());
+  backend.playing = false;
+  EXPECT_TRUE(server.handle());
+  EXPECT_EQ("completeir,1:1,5\r", replies[client]);
+  EXPECT_TRUE(server.idle());
+  irsend.setBackend(NULL);
+}
@@ -1,5 +1,6 @@
 // Copyright 2019 David Conran
 
+#include <string.h>
 #include <string>
 #include "ir_Argo.h"
 #include "ir_Daikin.h"
@@ -1052,6 +1053,368 @@ TEST(TestIRac, handleToggles) {
   ASSERT_NE(stdAc::swingv_t::kOff, result.swingv);  // i.e A toggle.
 }
 
+// A pooled object's captured output, and how to clear it.
+template <class AC>
+std::string pooledOutput(void *ac) {
+  return static_cast<AC *>(ac)->_irsend.outputStr();
+}
+
+template <class AC>
+void pooledReset(void *ac) { static_cast<AC *>(ac)->_irsend.reset(); }
+
+typedef struct {
+  decode_type_t protocol;
+  std::string (*output)(void *);
+  void (*reset)(void *);
+} pooled_type_t;
+
+#define POOLED(protocol, type) \
+    {protocol, pooledOutput<type>, pooledReset<type>}
+
+const pooled_type_t kPooledTypes[] = {
+    POOLED(ARGO, IRArgoAC),
+    POOLED(COOLIX, IRCoolixAC),
+    POOLED(DAIKIN, IRDaikinESP),
+    POOLED(DAIKIN160, IRDaikin160),
+    POOLED(DAIKIN2, IRDaikin2),
+    POOLED(DAIKIN216, IRDaikin216),
+    POOLED(ELECTRA_AC, IRElectraAc),
+    POOLED(FUJITSU_AC, IRFujitsuAC),
+    POOLED(GOODWEATHER, IRGoodweatherAc),
+    POOLED(GREE, IRGreeAC),
+    POOLED(HAIER_AC, IRHaierAC),
+    POOLED(HAIER_AC_YRW02, IRHaierACYRW02),
+    POOLED(HITACHI_AC, IRHitachiAc),
+    POOLED(KELVINATOR, IRKelvinatorAC),
+    POOLED(MIDEA, IRMideaAC),
+    POOLED(MITSUBISHI_AC, IRMitsubishiAC),
+    POOLED(MITSUBISHI_HEAVY_88, IRMitsubishiHeavy88Ac),
+    POOLED(MITSUBISHI_HEAVY_152, IRMitsubishiHeavy152Ac),
+    POOLED(NEOCLIMA, IRNeoclimaAc),
+    POOLED(PANASONIC_AC, IRPanasonicAc),
+    POOLED(SAMSUNG_AC, IRSamsungAc),
+    POOLED(SHARP_AC, IRSharpAc),
+    POOLED(TCL112AC, IRTcl112Ac),
+    POOLED(TECO, IRTecoAc),
+    POOLED(TOSHIBA_AC, IRToshibaAC),
+    POOLED(TROTEC, IRTrotecESP),
+    POOLED(VESTEL_AC, IRVestelAc),
+    POOLED(WHIRLPOOL_AC, IRWhirlpoolAc),
+};
+
+// A state with every option turned on, and a plain one.
+void makePoolStates(const decode_type_t protocol, stdAc::state_t *busy,
+                    stdAc::state_t *plain) {
+  busy->protocol = protocol;
+  busy->model = 1;
+  busy->power = true;
+  busy->mode = stdAc::opmode_t::kHeat;
+  busy->degrees = 27;
+  busy->celsius = true;
+  busy->fanspeed = stdAc::fanspeed_t::kHigh;
+  busy->swingv = stdAc::swingv_t::kAuto;
+  busy->swingh = stdAc::swingh_t::kAuto;
+  busy->quiet = true;
+  busy->turbo = true;
+  busy->econo = true;
+  busy->light = true;
+  busy->filter = true;
+  busy->clean = true;
+  busy->beep = true;
+  busy->sleep = 60;
+  busy->clock = 600;
+  *plain = *busy;
+  plain->mode = stdAc::opmode_t::kCool;
+  plain->degrees = 22;
+  plain->fanspeed = stdAc::fanspeed_t::kLow;
+  plain->swingv = stdAc::swingv_t::kOff;
+  plain->swingh = stdAc::swingh_t::kOff;
+  plain->quiet = false;
+  plain->turbo = false;
+  plain->econo = false;
+  plain->light = false;
+  plain->filter = false;
+  plain->clean = false;
+  plain->beep = false;
+  plain->sleep = -1;
+  // The clock is left alone. Pooled objects remember the last time they were
+  // given, like a real remote does.
+}
+
+TEST(TestIRac, PoolReusesObjects) {
+  IRac irac(0);
+  stdAc::state_t daikin, plain;
+  makePoolStates(DAIKIN, &daikin, &plain);
+
+  EXPECT_FALSE(irac.isPoolEnabled());
+  EXPECT_TRUE(irac.sendAc(daikin));
+  EXPECT_EQ(NULL, irac.findPooled(DAIKIN, 1));  // Nothing kept.
+
+  irac.enablePool();
+  EXPECT_TRUE(irac.isPoolEnabled());
+  EXPECT_TRUE(irac.sendAc(daikin));
+  ac_pool_entry_t *entry = irac.findPooled(DAIKIN, 1);
+  ASSERT_NE(nullptr, entry);
+  void *first = entry->ac;
+  EXPECT_TRUE(entry->has_last);
+  EXPECT_FALSE(IRac::cmpStates(daikin, entry->last));
+  EXPECT_TRUE(irac.sendAc(plain));
+  EXPECT_EQ(first, irac.findPooled(DAIKIN, 1)->ac);  // The same object.
+  EXPECT_FALSE(IRac::cmpStates(plain, irac.findPooled(DAIKIN, 1)->last));
+  // A different model is a different A/C.
+  plain.model = 2;
+  EXPECT_TRUE(irac.sendAc(plain));
+  EXPECT_NE(first, irac.findPooled(DAIKIN, 2)->ac);
+  EXPECT_FALSE(irac.sendAc(UNKNOWN, -1, true, stdAc::opmode_t::kCool, 25,
+                           true, stdAc::fanspeed_t::kAuto,
+                           stdAc::swingv_t::kOff, stdAc::swingh_t::kOff,
+                           false, false, false, false, false, false, false));
+
+  // Fill the pool. The least recently used (DAIKIN model 1) goes first.
+  irac.findPooled(DAIKIN, 2);
+  for (uint8_t i = 3; i < kAcPoolSize + 2; i++) {  // Skip the DAIKIN types.
+    makePoolStates(kPooledTypes[i].protocol, &daikin, &plain);
+    EXPECT_TRUE(irac.sendAc(plain));
+  }
+  EXPECT_EQ(NULL, irac.findPooled(DAIKIN, 1));
+  EXPECT_NE(nullptr, irac.findPooled(DAIKIN, 2));
+
+  irac.enablePool(false);
+  for (uint8_t i = 0; i < kAcPoolSize; i++)
+    EXPECT_EQ(NULL, irac._pool[i].ac);
+}
+
+// A reused object must send exactly what a new one would.
+TEST(TestIRac, PoolMatchesNewObjects) {
+  for (uint8_t i = 0; i < sizeof(kPooledTypes) / sizeof(kPooledTypes[0]);
+       i++) {
+    const pooled_type_t *type = &kPooledTypes[i];
+    stdAc::state_t busy, plain;
+    makePoolStates(type->protocol, &busy, &plain);
+    IRac reused(0);
+    IRac fresh(0);
+    reused.enablePool();
+    fresh.enablePool();
+    ASSERT_TRUE(reused.sendAc(busy)) << typeToString(type->protocol);
+    ASSERT_TRUE(fresh.sendAc(plain, &busy)) << typeToString(type->protocol);
+    type->reset(reused.findPooled(type->protocol, 1)->ac);
+    ASSERT_TRUE(reused.sendAc(plain, &busy));
+    EXPECT_EQ(type->output(fresh.findPooled(type->protocol, 1)->ac),
+              type->output(reused.findPooled(type->protocol, 1)->ac)) <<
+        "Protocol " << typeToString(type->protocol) <<
+        " sends something different when its object is reused.";
+  }
+}
+
+// Without a previous state, the pool uses the last one it sent.
+TEST(TestIRac, PoolRemembersToggles) {
+  IRac irac(0);
+  irac.enablePool();
+  stdAc::state_t busy, plain;
+  makePoolStates(COOLIX, &busy, &plain);
+  plain.swingv = stdAc::swingv_t::kAuto;
+  ASSERT_TRUE(irac.sendAc(plain));
+  IRCoolixAC *ac = static_cast<IRCoolixAC *>(irac.findPooled(COOLIX, 1)->ac);
+  ac->_irsend.reset();
+  // Nothing changed, so the swing shouldn't be toggled again.
+  ASSERT_TRUE(irac.sendAc(plain));
+  ac->_irsend.makeDecodeResult();
+  IRrecv capture(0);
+  ASSERT_TRUE(capture.decode(&ac->_irsend.capture));
+  EXPECT_NE(kCoolixSwing, ac->_irsend.capture.value);
+}
+
+// Units of the same model are kept apart by their targets.
+TEST(TestIRac, PoolKeepsTargetsApart) {
+  IRac irac(0);
+  irac.enablePool();
+  stdAc::state_t busy, plain;
+  makePoolStates(COOLIX, &busy, &plain);
+  plain.swingv = stdAc::swingv_t::kAuto;
+  ASSERT_TRUE(irac.sendAc(plain, NULL, 1));
+  ASSERT_TRUE(irac.sendAc(plain, NULL, 2));
+  ac_pool_entry_t *first = irac.findPooled(COOLIX, 1, 1);
+  ac_pool_entry_t *second = irac.findPooled(COOLIX, 1, 2);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_NE(first, second);
+  EXPECT_NE(first->ac, second->ac);
+  EXPECT_EQ(nullptr, irac.findPooled(COOLIX, 1));  // The default target.
+  IRrecv capture(0);
+  // The 2nd unit didn't inherit the 1st one's state, so it got the toggle.
+  IRCoolixAC *ac = static_cast<IRCoolixAC *>(second->ac);
+  ac->_irsend.makeDecodeResult();
+  ASSERT_TRUE(capture.decode(&ac->_irsend.capture));
+  EXPECT_EQ(kCoolixSwing, ac->_irsend.capture.value);
+  // Nothing changed for the 1st unit, so it isn't toggled again.
+  ac = static_cast<IRCoolixAC *>(first->ac);
+  ac->_irsend.reset();
+  ASSERT_TRUE(irac.sendAc(plain, NULL, 1));
+  ac->_irsend.makeDecodeResult();
+  ASSERT_TRUE(capture.decode(&ac->_irsend.capture));
+  EXPECT_NE(kCoolixSwing, ac->_irsend.capture.value);
+}
+
+// Converting with a kept object must give exactly what a new object would.
+TEST(TestIRAcDecoder, MatchesNewObjects) {
+  IRAcDecoder decoder;
+  decode_results decode;
+  uint64_t seed = 1;
+  uint16_t converted[kLastDecodeType + 1] = {0};
+  // A few messages of each type in a row, so the kept object is both reused &
+  // replaced. Random data reaches more of each toCommon() than real messages.
+  for (uint8_t round = 0; round < 4; round++) {
+    for (uint16_t type = 0; type <= kLastDecodeType; type++) {
+      for (uint8_t message = 0; message < 3; message++) {
+        decode.decode_type = (decode_type_t)type;
+        decode.bits = IRsend::defaultBits(decode.decode_type);
+        // Fujitsu has messages of several lengths.
+        if (decode.decode_type == decode_type_t::FUJITSU_AC && message)
+          decode.bits = kFujitsuAcMinBits + 8 * (message - 1);
+        for (uint16_t i = 0; i < kStateSizeMax; i++) {
+          seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+          decode.state[i] = seed >> 56;
+        }
+        if (!hasACState(decode.decode_type)) {
+          decode.value = seed ^ (seed >> 29);
+          if (decode.bits < 64) decode.value &= (1ULL << decode.bits) - 1;
+        }
+        stdAc::state_t expected, result;
+        const bool success = IRAcUtils::decodeToState(&decode, &expected);
+        ASSERT_EQ(success, decoder.decodeToState(&decode, &result)) <<
+            typeToString(decode.decode_type);
+        if (!success) continue;
+        converted[type]++;
+        EXPECT_FALSE(IRac::cmpStates(expected, result)) <<
+            "Protocol " << typeToString(decode.decode_type) <<
+            " converts differently when its object is reused. Message " <<
+            (uint16_t)message << " of round " << (uint16_t)round;
+        EXPECT_EQ(expected.clock, result.clock);
+      }
+    }
+  }
+  // Every protocol IRAcUtils::decodeToState() knows was tried.
+  uint16_t protocols = 0;
+  for (uint16_t type = 0; type <= kLastDecodeType; type++)
+    if (converted[type]) protocols++;
+  EXPECT_EQ(28, protocols);
+}
+
+TEST(TestIRAcDecoder, KeepsOneObject) {
+  IRAcDecoder decoder;
+  decode_results decode;
+  stdAc::state_t result;
+  EXPECT_EQ(decode_type_t::UNKNOWN, decoder._protocol);
+  // Not an A/C message.
+  decode.decode_type = decode_type_t::NEC;
+  decode.value = 0x807F40BF;
+  decode.bits = kNECBits;
+  EXPECT_FALSE(decoder.decodeToState(&decode, &result));
+  EXPECT_EQ(decode_type_t::UNKNOWN, decoder._protocol);
+  EXPECT_FALSE(decoder.decodeToState(NULL, &result));
+  EXPECT_FALSE(decoder.decodeToState(&decode, NULL));
+
+  IRDaikin2 daikin(0);
+  daikin.setPower(true);
+  daikin.setMode(kDaikinCool);
+  daikin.setTemp(21);
+  decode.decode_type = decode_type_t::DAIKIN2;
+  decode.bits = kDaikin2Bits;
+  memcpy(decode.state, daikin.getRaw(), kDaikin2StateLength);
+  ASSERT_TRUE(decoder.decodeToState(&decode, &result));
+  EXPECT_EQ(decode_type_t::DAIKIN2, decoder._protocol);
+  EXPECT_EQ(decode_type_t::DAIKIN2, result.protocol);
+  EXPECT_TRUE(result.power);
+  EXPECT_EQ(stdAc::opmode_t::kCool, result.mode);
+  EXPECT_EQ(21, result.degrees);
+  // The same object again, with a different message.
+  IRDaikin2 *kept = reinterpret_cast<IRDaikin2 *>(decoder._storage.raw);
+  daikin.setTemp(25);
+  memcpy(decode.state, daikin.getRaw(), kDaikin2StateLength);
+  ASSERT_TRUE(decoder.decodeToState(&decode, &result));
+  EXPECT_EQ(25, result.degrees);
+  EXPECT_EQ(kept, reinterpret_cast<IRDaikin2 *>(decoder._storage.raw));
+  // Another protocol replaces it.
+  decode.decode_type = decode_type_t::COOLIX;
+  decode.value = kCoolixOff;
+  decode.bits = kCoolixBits;
+  ASSERT_TRUE(decoder.decodeToState(&decode, &result));
+  EXPECT_EQ(decode_type_t::COOLIX, decoder._protocol);
+  EXPECT_EQ(decode_type_t::COOLIX, result.protocol);
+  EXPECT_FALSE(result.power);
+}
+
+TEST(TestIRac, SendBatch) {
+  IRac irac(0);
+  irac.enablePool();
+  stdAc::state_t busy, plain, trotec, daikin2, panasonic, unknown;
+  makePoolStates(COOLIX, &busy, &plain);
+  makePoolStates(TROTEC, &trotec, &unknown);
+  makePoolStates(DAIKIN2, &daikin2, &unknown);
+  makePoolStates(PANASONIC_AC, &panasonic, &unknown);
+  makePoolStates(UNKNOWN, &unknown, &unknown);
+  const ac_update_t updates[] = {
+      {1, busy},       // Superseded by a different state.
+      {2, trotec},     // Repeated later.
+      {3, daikin2},
+      {1, plain},
+      {4, panasonic},
+      {2, trotec},
+      {5, unknown},    // Fails.
+  };
+  const uint16_t count = sizeof(updates) / sizeof(updates[0]);
+  ac_batch_status_t results[count];
+  EXPECT_EQ(4, irac.sendBatch(updates, count, results));
+  EXPECT_EQ(kAcBatchSuperseded, results[0]);
+  EXPECT_EQ(kAcBatchDuplicate, results[1]);
+  EXPECT_EQ(kAcBatchSent, results[2]);
+  EXPECT_EQ(kAcBatchSent, results[3]);
+  EXPECT_EQ(kAcBatchSent, results[4]);
+  EXPECT_EQ(kAcBatchSent, results[5]);
+  EXPECT_EQ(kAcBatchFailed, results[6]);
+  // Sent in the order they were given.
+  uint32_t used[kLastDecodeType + 1] = {0};
+  for (uint8_t i = 0; i < kAcPoolSize; i++)
+    used[irac._pool[i].protocol] = irac._pool[i].used;
+  EXPECT_LT(used[DAIKIN2], used[COOLIX]);
+  EXPECT_LT(used[COOLIX], used[PANASONIC_AC]);
+  EXPECT_LT(used[PANASONIC_AC], used[TROTEC]);
+  // Only the last state for a target was sent.
+  ac_pool_entry_t *coolix = irac.findPooled(COOLIX, 1, 1);
+  ASSERT_NE(nullptr, coolix);
+  EXPECT_FALSE(IRac::cmpStates(plain, coolix->last));
+  EXPECT_EQ(0, irac.sendBatch(updates, 0, results));
+  EXPECT_EQ(0, irac.sendBatch(NULL, count, results));
+}
+
+// Each target's toggles are worked out against its own last state.
+TEST(TestIRac, SendBatchPerTarget) {
+  IRac irac(0);
+  irac.enablePool();
+  stdAc::state_t busy, plain;
+  makePoolStates(COOLIX, &busy, &plain);
+  plain.swingv = stdAc::swingv_t::kAuto;
+  const ac_update_t first[] = {{1, plain}, {2, busy}};
+  ac_batch_status_t results[2];
+  EXPECT_EQ(2, irac.sendBatch(first, 2, results));
+  ac_pool_entry_t *unit1 = irac.findPooled(COOLIX, 1, 1);
+  ac_pool_entry_t *unit2 = irac.findPooled(COOLIX, 1, 2);
+  ASSERT_NE(nullptr, unit1);
+  ASSERT_NE(nullptr, unit2);
+  EXPECT_FALSE(IRac::cmpStates(plain, unit1->last));
+  EXPECT_FALSE(IRac::cmpStates(busy, unit2->last));
+  // Unit 1 hasn't changed, so its swing isn't toggled again, even though
+  // unit 2 (the same model) was sent something else since.
+  IRCoolixAC *ac = static_cast<IRCoolixAC *>(unit1->ac);
+  ac->_irsend.reset();
+  const ac_update_t second[] = {{1, plain}};
+  EXPECT_EQ(1, irac.sendBatch(second, 1, results));
+  ac->_irsend.makeDecodeResult();
+  IRrecv capture(0);
+  ASSERT_TRUE(capture.decode(&ac->_irsend.capture));
+  EXPECT_NE(kCoolixSwing, ac->_irsend.capture.value);
+}
+
 TEST(TestIRac, strToBool) {
   EXPECT_TRUE(IRac::strToBool("ON"));
   EXPECT_TRUE(IRac::strToBool("1"));
@@ -1163,3 +1526,171 @@ TEST(TestIRac, swinghToString) {
   EXPECT_EQ("auto", IRac::swinghToString(stdAc::swingh_t::kAuto));
   EXPECT_EQ("unknown", IRac::swinghToString((stdAc::swingh_t)500));
 }
+
+TEST(TestIRac, NamesOfEverySetting) {
+  EXPECT_EQ("fan_only", IRac::opmodeToString(stdAc::opmode_t::kFan));
+  EXPECT_EQ("unknown", IRac::opmodeToString((stdAc::opmode_t)-2));
+  EXPECT_EQ("max", IRac::fanspeedToString(stdAc::fanspeed_t::kMax));
+  EXPECT_EQ("unknown", IRac::fanspeedToString((stdAc::fanspeed_t)-1));
+  EXPECT_EQ("lowest", IRac::swingvToString(stdAc::swingv_t::kLowest));
+  EXPECT_EQ("unknown", IRac::swingvToString((stdAc::swingv_t)6));
+  EXPECT_EQ("rightmax", IRac::swinghToString(stdAc::swingh_t::kRightMax));
+  EXPECT_EQ("unknown", IRac::swinghToString((stdAc::swingh_t)-2));
+}
+
+// A state with every setting used, & none the same as another.
+static stdAc::state_t exampleState(void) {
+  stdAc::state_t state;
+  state.protocol = decode_type_t::DAIKIN2;
+  state.model = 3;
+  state.power = true;
+  state.mode = stdAc::opmode_t::kHeat;
+  state.degrees = 21.5;
+  state.celsius = true;
+  state.fanspeed = stdAc::fanspeed_t::kMedium;
+  state.swingv = stdAc::swingv_t::kLowest;
+  state.swingh = stdAc::swingh_t::kOff;
+  state.quiet = false;
+  state.turbo = true;
+  state.econo = false;
+  state.light = true;
+  state.filter = false;
+  state.clean = true;
+  state.beep = true;
+  state.sleep = 120;
+  state.clock = 1234;
+  return state;
+}
+
+TEST(TestIRac, PackState) {
+  stdAc::state_t state = exampleState();
+  stdAc::state_t result;
+  uint8_t buf[kAcPackedStateSize + kStateSizeMax];
+
+  ASSERT_EQ(kAcPackedStateSize, IRac::packState(state, buf, sizeof(buf)));
+  const uint8_t expected[kAcPackedStateSize] = {
+      0x01, DAIKIN2, 0x03, 0x00, 0xAB, 0x37, 0x06, 0xD7, 0x00, 0x78, 0x00,
+      0xD2, 0x04, 0x00};
+  EXPECT_EQ(0, memcmp(expected, buf, kAcPackedStateSize));
+  ASSERT_TRUE(IRac::unpackState(buf, kAcPackedStateSize, &result));
+  EXPECT_FALSE(IRac::cmpStates(state, result));
+  EXPECT_EQ(state.clock, result.clock);
+
+  // Every value of every setting survives the trip.
+  for (int8_t mode = -1; mode <= 4; mode++)
+    for (int8_t fan = 0; fan <= 5; fan++)
+      for (int8_t swing = -1; swing <= 5; swing++) {
+        state.mode = (stdAc::opmode_t)mode;
+        state.fanspeed = (stdAc::fanspeed_t)fan;
+        state.swingv = (stdAc::swingv_t)swing;
+        state.swingh = (stdAc::swingh_t)(4 - swing);
+        state.power = swing & 1;
+        state.celsius = fan & 1;
+        state.quiet = mode & 1;
+        state.filter = swing & 2;
+        state.degrees = -10 + mode * 20.5;
+        state.protocol = (mode < 0) ? decode_type_t::UNKNOWN
+                                    : (decode_type_t)(fan * 10 + mode);
+        state.model = -swing;
+        state.sleep = -1;
+        state.clock = -32768;
+        ASSERT_EQ(kAcPackedStateSize, IRac::packState(state, buf, sizeof(buf)));
+        ASSERT_TRUE(IRac::unpackState(buf, kAcPackedStateSize, &result));
+        EXPECT_FALSE(IRac::cmpStates(state, result));
+        EXPECT_EQ(state.clock, result.clock);
+      }
+
+  // With the vendor's raw state.
+  state = exampleState();
+  const uint8_t raw[5] = {0x11, 0xDA, 0x27, 0x00, 0x42};
+  uint8_t raw_result[kStateSizeMax];
+  uint16_t rawlen = 0;
+  ASSERT_EQ(kAcPackedStateSize + 5,
+            IRac::packState(state, buf, sizeof(buf), raw, 5));
+  ASSERT_TRUE(IRac::unpackState(buf, kAcPackedStateSize + 5, &result,
+                                raw_result, &rawlen));
+  EXPECT_FALSE(IRac::cmpStates(state, result));
+  ASSERT_EQ(5, rawlen);
+  EXPECT_EQ(0, memcmp(raw, raw_result, rawlen));
+  // The raw state can be ignored.
+  EXPECT_TRUE(IRac::unpackState(buf, kAcPackedStateSize + 5, &result));
+
+  // Things that don't fit, or aren't valid.
+  EXPECT_EQ(0, IRac::packState(state, buf, kAcPackedStateSize - 1));
+  EXPECT_EQ(0, IRac::packState(state, buf, kAcPackedStateSize + 4, raw, 5));
+  EXPECT_EQ(0, IRac::packState(state, NULL, sizeof(buf)));
+  EXPECT_EQ(0, IRac::packState(state, buf, 1000, raw, kStateSizeMax + 1));
+  EXPECT_FALSE(IRac::unpackState(buf, kAcPackedStateSize + 4, &result));
+  EXPECT_FALSE(IRac::unpackState(buf, kAcPackedStateSize - 1, &result));
+  EXPECT_FALSE(IRac::unpackState(NULL, sizeof(buf), &result));
+  ASSERT_EQ(kAcPackedStateSize, IRac::packState(state, buf, sizeof(buf)));
+  buf[0] = kAcPackedStateVersion + 1;
+  EXPECT_FALSE(IRac::unpackState(buf, kAcPackedStateSize, &result));
+  buf[0] = kAcPackedStateVersion;
+  buf[5] |= 0x70;  // Fan speed 7.
+  EXPECT_FALSE(IRac::unpackState(buf, kAcPackedStateSize, &result));
+  buf[5] &= ~0x70;
+  buf[6] = 0x80;  // Horizontal swing 7.
+  EXPECT_FALSE(IRac::unpackState(buf, kAcPackedStateSize, &result));
+  buf[6] = 0x00;
+  buf[1] = kLastDecodeType + 1;
+  EXPECT_FALSE(IRac::unpackState(buf, kAcPackedStateSize, &result));
+  buf[1] = DAIKIN2;
+  EXPECT_TRUE(IRac::unpackState(buf, kAcPackedStateSize, &result));
+}
+
+TEST(TestIRac, StateToJson) {
+  stdAc::state_t state = exampleState();
+  char buf[kAcStateJsonSize + 2 * kStateSizeMax + 9];
+  const char expected[] =
+      "{\"protocol\":\"DAIKIN2\",\"model\":3,\"power\":\"on\","
+      "\"mode\":\"heat\",\"use_celsius\":\"on\",\"temp\":21.5,"
+      "\"fanspeed\":\"medium\",\"swingv\":\"lowest\",\"swingh\":\"off\","
+      "\"quiet\":\"off\",\"turbo\":\"on\",\"econo\":\"off\","
+      "\"light\":\"on\",\"filter\":\"off\",\"clean\":\"on\","
+      "\"beep\":\"on\",\"sleep\":120}";
+  EXPECT_EQ(strlen(expected), IRac::stateToJson(state, buf, sizeof(buf)));
+  EXPECT_STREQ(expected, buf);
+
+  // Temperatures.
+  state.degrees = 72;
+  IRac::stateToJson(state, buf, sizeof(buf));
+  EXPECT_NE(nullptr, strstr(buf, ",\"temp\":72,"));
+  state.degrees = -0.5;
+  IRac::stateToJson(state, buf, sizeof(buf));
+  EXPECT_NE(nullptr, strstr(buf, ",\"temp\":-0.5,"));
+  state.degrees = 19.96;
+  IRac::stateToJson(state, buf, sizeof(buf));
+  EXPECT_NE(nullptr, strstr(buf, ",\"temp\":20,"));
+
+  // With the vendor's raw state.
+  state = exampleState();
+  const uint8_t raw[3] = {0x11, 0xDA, 0x07};
+  size_t length = IRac::stateToJson(state, buf, sizeof(buf), raw, 3);
+  EXPECT_EQ(strlen(expected) + 9 + 2 * 3, length);
+  EXPECT_STREQ(",\"raw\":\"11DA07\"}", buf + strlen(expected) - 1);
+
+  // Too small a buffer. It is cut short, but the full length is reported.
+  EXPECT_EQ(strlen(expected), IRac::stateToJson(state, buf, 10));
+  EXPECT_STREQ("{\"protoco", buf);
+  EXPECT_EQ(strlen(expected), IRac::stateToJson(state, NULL, 0));
+
+  // The longest a state can be fits in kAcStateJsonSize.
+  state.protocol = decode_type_t::MITSUBISHI_HEAVY_152;
+  state.model = -32768;
+  state.power = false;
+  state.mode = stdAc::opmode_t::kFan;
+  state.degrees = -3276.7;
+  state.celsius = false;
+  state.fanspeed = (stdAc::fanspeed_t)100;
+  state.swingv = (stdAc::swingv_t)100;
+  state.swingh = (stdAc::swingh_t)100;
+  state.quiet = state.turbo = state.econo = state.light = false;
+  state.filter = state.clean = state.beep = false;
+  state.sleep = -32768;
+  state.clock = -32768;
+  length = IRac::stateToJson(state, buf, sizeof(buf));
+  EXPECT_LT(length, kAcStateJsonSize);
+  EXPECT_EQ(length, strlen(buf));
+  EXPECT_NE(nullptr, strstr(buf, "\"fanspeed\":\"unknown\""));
+}
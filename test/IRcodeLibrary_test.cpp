@@ -0,0 +1,259 @@
+// Copyright 2019 David Conran
+
+#include "IRcodeLibrary.h"
+#include <string.h>
+#include "IRsend.h"
+#include "IRsend_test.h"
+#include "gtest/gtest.h"
+
+// Tests for IRcodeLibrary & IRcodeLibraryBuilder.
+
+// Modified NEC TV "Power On" from Global Cache with no repeats.
+uint16_t kGcNec[71] = {38000, 1,  1,  342, 172, 21, 22, 21, 21, 21, 65,  21,
+                       21,    21, 22, 21,  22,  21, 21, 21, 22, 21, 65,  21,
+                       65,    21, 22, 21,  65,  21, 65, 21, 65, 21, 65,  21,
+                       65,    21, 65, 21,  22,  21, 22, 21, 21, 21, 22,  21,
+                       22,    21, 65, 21,  22,  21, 21, 21, 65, 21, 65,  21,
+                       65,    21, 64, 22,  65,  21, 22, 21, 65, 21, 1519};
+
+// Sherwood (NEC-like) "Power On" from Global Cache with 2 repeats.
+uint16_t kGcSherwood[75] = {
+    38000, 2,  69, 341, 171, 21, 64, 21, 64, 21, 21,   21,  21, 21, 21,
+    21,    21, 21, 21,  21,  64, 21, 64, 21, 21, 21,   64,  21, 21, 21,
+    21,    21, 21, 21,  64,  21, 21, 21, 64, 21, 21,   21,  21, 21, 21,
+    21,    64, 21, 21,  21,  21, 21, 21, 21, 21, 21,   64,  21, 64, 21,
+    64,    21, 21, 21,  64,  21, 64, 21, 64, 21, 1600, 341, 85, 21, 3647};
+
+// Sony 20-bit command. Only has a repeat sequence.
+uint16_t kProntoSony[46] = {
+    0x0000, 0x0067, 0x0000, 0x0015, 0x0060, 0x0018, 0x0018, 0x0018,
+    0x0030, 0x0018, 0x0030, 0x0018, 0x0030, 0x0018, 0x0018, 0x0018,
+    0x0030, 0x0018, 0x0018, 0x0018, 0x0018, 0x0018, 0x0030, 0x0018,
+    0x0018, 0x0018, 0x0030, 0x0018, 0x0030, 0x0018, 0x0030, 0x0018,
+    0x0018, 0x0018, 0x0018, 0x0018, 0x0030, 0x0018, 0x0018, 0x0018,
+    0x0018, 0x0018, 0x0030, 0x0018, 0x0018, 0x03f6};
+
+// Both a normal & a repeat sequence.
+uint16_t kProntoBoth[10] = {0x0000, 0x006D, 0x0002, 0x0001, 0x0010,
+                            0x0020, 0x0030, 0x0040, 0x0050, 0x0060};
+
+// NEC 0x807F40BF as raw uSeconds.
+uint16_t kRawNec[67] = {
+    9000, 4500, 560, 1690, 560, 560, 560, 560, 560, 560, 560, 560, 560, 560,
+    560, 560, 560, 560, 560, 560, 560, 1690, 560, 1690, 560, 1690, 560, 1690,
+    560, 1690, 560, 1690, 560, 1690, 560, 560, 560, 1690, 560, 560, 560, 560,
+    560, 560, 560, 560, 560, 560, 560, 560, 560, 1690, 560, 560, 560, 1690,
+    560, 1690, 560, 1690, 560, 1690, 560, 1690, 560, 1690, 560};
+
+// A source that keeps track of how it is read.
+class IRcodeTestSource : public IRcodeMemory {
+ public:
+  uint16_t reads = 0;
+  uint16_t largest = 0;
+
+  IRcodeTestSource(const uint8_t *data, const uint32_t size)
+      : IRcodeMemory(data, size) {}
+
+  bool read(const uint32_t offset, uint8_t *buf, const uint16_t len) {
+    reads++;
+    largest = std::max(largest, len);
+    return IRcodeMemory::read(offset, buf, len);
+  }
+};
+
+// Build a library of all the test codes. Ids are deliberately out of order.
+uint32_t buildTestLibrary(uint8_t *buffer, const uint32_t size) {
+  IRcodeLibraryBuilder builder(buffer, size, 10);
+  EXPECT_TRUE(builder.addGC(30, "TV Power", kGcNec, 71));
+  EXPECT_TRUE(builder.addGC(10, "Amp Power", kGcSherwood, 75));
+  EXPECT_TRUE(builder.addPronto(20, "DVD", kProntoSony, 46, 2));
+  EXPECT_TRUE(builder.addPronto(5, "", kProntoBoth, 10, 3));
+  EXPECT_TRUE(builder.addRaw(1000, "NEC raw", kRawNec, 67, 38));
+  EXPECT_EQ(5, builder.count());
+  return builder.finish();
+}
+
+TEST(TestIRcodeLibrary, SendsTheSameAsTheOriginal) {
+  uint8_t buffer[2048];
+  uint32_t size = buildTestLibrary(buffer, sizeof(buffer));
+  ASSERT_NE(0, size);
+  IRcodeMemory source(buffer, size);
+  IRcodeLibrary library(&source);
+  ASSERT_TRUE(library.begin());
+  EXPECT_EQ(5, library.count());
+
+  IRsendTest direct(0);
+  IRsendTest stored(0);
+  direct.begin();
+  stored.begin();
+
+  direct.reset();
+  stored.reset();
+  direct.sendGC(kGcNec, 71);
+  EXPECT_TRUE(library.sendId(&stored, 30));
+  EXPECT_EQ(direct.outputStr(), stored.outputStr());
+
+  direct.reset();
+  stored.reset();
+  direct.sendGC(kGcSherwood, 75);
+  EXPECT_TRUE(library.sendName(&stored, "Amp Power"));
+  EXPECT_EQ(direct.outputStr(), stored.outputStr());
+
+  direct.reset();
+  stored.reset();
+  direct.sendPronto(kProntoSony, 46, 2);
+  EXPECT_TRUE(library.sendId(&stored, 20));
+  EXPECT_EQ(direct.outputStr(), stored.outputStr());
+
+  direct.reset();
+  stored.reset();
+  direct.sendPronto(kProntoBoth, 10, 3);
+  EXPECT_TRUE(library.sendId(&stored, 5));
+  EXPECT_EQ(direct.outputStr(), stored.outputStr());
+
+  direct.reset();
+  stored.reset();
+  direct.sendRaw(kRawNec, 67, 38);
+  EXPECT_TRUE(library.sendName(&stored, "NEC raw"));
+  EXPECT_EQ(direct.outputStr(), stored.outputStr());
+}
+
+TEST(TestIRcodeLibrary, Lookups) {
+  uint8_t buffer[2048];
+  uint32_t size = buildTestLibrary(buffer, sizeof(buffer));
+  IRcodeMemory source(buffer, size);
+  IRcodeLibrary library(&source);
+  ASSERT_TRUE(library.begin());
+
+  // The index is in order of id.
+  ir_code_entry_t entry;
+  const uint16_t ids[5] = {5, 10, 20, 30, 1000};
+  for (uint16_t i = 0; i < library.count(); i++) {
+    ASSERT_TRUE(library.getEntry(i, &entry));
+    EXPECT_EQ(ids[i], entry.id);
+  }
+  EXPECT_FALSE(library.getEntry(5, &entry));
+
+  ASSERT_TRUE(library.findId(30, &entry));
+  EXPECT_STREQ("TV Power", entry.name);
+  EXPECT_EQ(38000, entry.frequency);
+  EXPECT_EQ(0, entry.intro);
+  EXPECT_EQ(68, entry.length);
+  EXPECT_EQ(1, entry.repeats);
+  ASSERT_TRUE(library.findId(10, &entry));
+  EXPECT_EQ(68, entry.intro);  // i.e. GC repeat offset - 1.
+  EXPECT_EQ(2, entry.repeats);
+  ASSERT_TRUE(library.findName("DVD", &entry));
+  EXPECT_EQ(20, entry.id);
+  EXPECT_EQ(0, entry.intro);
+  EXPECT_EQ(3, entry.repeats);  // No normal sequence, so one extra.
+  for (uint16_t i = 0; i < 5; i++) {
+    ASSERT_TRUE(library.findId(ids[i], &entry));
+    EXPECT_EQ(ids[i], entry.id);
+  }
+  EXPECT_FALSE(library.findId(0, &entry));
+  EXPECT_FALSE(library.findId(11, &entry));
+  EXPECT_FALSE(library.findId(UINT16_MAX, &entry));
+  EXPECT_FALSE(library.findName("dvd", &entry));  // Case sensitive.
+  EXPECT_FALSE(library.findName("TV", &entry));
+  EXPECT_FALSE(library.findName(NULL, &entry));
+  EXPECT_FALSE(library.sendId(NULL, 30));
+  IRsendTest irsend(0);
+  EXPECT_FALSE(library.sendId(&irsend, 11));
+  EXPECT_FALSE(library.sendName(&irsend, "Nope"));
+
+  // The durations come back as uSeconds.
+  uint32_t durations[67];
+  ASSERT_TRUE(library.findId(1000, &entry));
+  EXPECT_FALSE(library.getDurations(&entry, durations, 66));
+  ASSERT_TRUE(library.getDurations(&entry, durations, 67));
+  for (uint16_t i = 0; i < 67; i++) EXPECT_EQ(kRawNec[i], durations[i]);
+}
+
+TEST(TestIRcodeLibrary, IsCompactAndStreamed) {
+  uint8_t buffer[2048];
+  uint32_t size = buildTestLibrary(buffer, sizeof(buffer));
+  IRcodeTestSource source(buffer, size);
+  IRcodeLibrary library(&source);
+  ASSERT_TRUE(library.begin());
+
+  // Smaller than even the uint16_t array it came from.
+  ir_code_entry_t entry;
+  ASSERT_TRUE(library.findId(1000, &entry));
+  EXPECT_EQ(67, entry.length);
+  EXPECT_GT(entry.length * sizeof(uint16_t), entry.size);
+  ASSERT_TRUE(library.findId(30, &entry));
+  EXPECT_GT(entry.length * sizeof(uint16_t), entry.size);
+
+  // Sending only reads small chunks of it.
+  IRsendTest irsend(0);
+  source.reads = 0;
+  source.largest = 0;
+  ASSERT_TRUE(library.send(&irsend, &entry));
+  EXPECT_EQ((entry.size + kCodeLibChunkSize - 1) / kCodeLibChunkSize,
+            source.reads);
+  EXPECT_GE(kCodeLibChunkSize, source.largest);
+}
+
+TEST(TestIRcodeLibrary, BuilderRejects) {
+  uint8_t buffer[512];
+  IRcodeLibraryBuilder builder(buffer, sizeof(buffer), 2);
+  EXPECT_TRUE(builder.addRaw(1, "One", kRawNec, 4));
+  EXPECT_FALSE(builder.addRaw(1, "Two", kRawNec, 4));  // Duplicate id.
+  EXPECT_FALSE(builder.addRaw(2, "One", kRawNec, 4));  // Duplicate name.
+  EXPECT_FALSE(builder.addRaw(2, "A name that is far too long", kRawNec, 4));
+  EXPECT_FALSE(builder.addRaw(2, NULL, kRawNec, 4));
+  EXPECT_FALSE(builder.addRaw(2, "Two", NULL, 4));
+  EXPECT_FALSE(builder.addGC(2, "Two", kGcNec, 3));  // No data.
+  uint16_t bad_pronto[6] = {0x0000, 0x0067, 0x0010, 0x0000, 0x0000, 0x0000};
+  EXPECT_FALSE(builder.addPronto(2, "Two", bad_pronto, 6));  // Too short.
+  bad_pronto[0] = 1;
+  bad_pronto[2] = 0;
+  EXPECT_FALSE(builder.addPronto(2, "Two", bad_pronto, 6));  // Not raw.
+  EXPECT_FALSE(builder.addRaw(2, "Two", kRawNec, 67 * 8));  // Doesn't fit.
+  EXPECT_TRUE(builder.addRaw(2, "", kRawNec, 67));
+  EXPECT_FALSE(builder.addRaw(3, "", kRawNec, 4));  // Too many codes.
+  EXPECT_EQ(2, builder.count());
+  uint32_t size = builder.finish();
+  EXPECT_NE(0, size);
+  EXPECT_FALSE(builder.addRaw(3, "Three", kRawNec, 4));  // Finished.
+  EXPECT_EQ(0, builder.finish());
+
+  // Doesn't even have room for the index.
+  IRcodeLibraryBuilder tiny(buffer, 100, 10);
+  EXPECT_FALSE(tiny.addRaw(1, "One", kRawNec, 4));
+  EXPECT_EQ(0, tiny.finish());
+
+  IRcodeMemory source(buffer, size);
+  IRcodeLibrary library(&source);
+  EXPECT_TRUE(library.begin());
+  EXPECT_EQ(2, library.count());
+}
+
+TEST(TestIRcodeLibrary, BadLibraries) {
+  uint8_t buffer[2048];
+  uint32_t size = buildTestLibrary(buffer, sizeof(buffer));
+
+  IRcodeLibrary none(NULL);
+  EXPECT_FALSE(none.begin());
+  EXPECT_EQ(0, none.count());
+
+  // Truncated.
+  IRcodeMemory truncated(buffer, size - 1);
+  IRcodeLibrary library(&truncated);
+  EXPECT_FALSE(library.begin());
+  EXPECT_EQ(0, library.count());
+  ir_code_entry_t entry;
+  EXPECT_FALSE(library.findId(30, &entry));
+
+  // Not a library.
+  IRcodeMemory source(buffer, size);
+  IRcodeLibrary bad(&source);
+  buffer[0] = 'X';
+  EXPECT_FALSE(bad.begin());
+  buffer[0] = 'I';
+  buffer[4] = kCodeLibVersion + 1;
+  EXPECT_FALSE(bad.begin());
+  buffer[4] = kCodeLibVersion;
+  EXPECT_TRUE(bad.begin());
+}
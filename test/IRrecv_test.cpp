@@ -1,16 +1,19 @@
 // Copyright 2017 David Conran
 
 #include "IRrecv_test.h"
+#include <thread>  // NOLINT(build/c++11)
 #include "IRrecv.h"
 #include "IRremoteESP8266.h"
 #include "IRsend.h"
 #include "IRsend_test.h"
 #include "gtest/gtest.h"
+#include "ir_NEC.h"
 
 // Tests for the IRrecv object.
 TEST(TestIRrecv, DefaultBufferSize) {
   IRrecv irrecv_default(1);
   EXPECT_EQ(kRawBuf, irrecv_default.getBufSize());
+  EXPECT_EQ(kDefaultCaptureSlots, irrecv_default.getCaptureSlots());
 }
 
 TEST(TestIRrecv, LargeBufferSize) {
@@ -42,6 +45,193 @@ TEST(TestIRrecv, IRrecvDestructor) {
   delete irrecv_ptr;
 }
 
+// Pretend the interrupt handler has captured a message, & has timed out.
+void captureMessage(IRrecv *irrecv, IRsendTest *irsend) {
+  for (uint16_t i = 0; i < irsend->capture.rawlen; i++)
+    irrecv->irparams.rawbuf[i] = irsend->capture.rawbuf[i];
+  irrecv->irparams.rawlen = irsend->capture.rawlen;
+  irrecv->irparams.rcvstate = kStopState;
+}
+
+TEST(TestIRrecv, CaptureSlots) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1, kRawBuf, kTimeoutMs, false, 3);
+  decode_results results;
+  EXPECT_EQ(3, irrecv.getCaptureSlots());
+  irrecv.enableIRIn();
+  EXPECT_FALSE(irrecv.decode(&results));  // Nothing has been captured yet.
+
+  irsend.begin();
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  volatile uint16_t *first_slot = irrecv.irparams.rawbuf;
+  captureMessage(&irrecv, &irsend);
+  ASSERT_TRUE(irrecv.decode(&results));
+  EXPECT_EQ(NEC, results.decode_type);
+  EXPECT_EQ(0x807F40BF, results.value);
+  // It was decoded directly from the slot it was captured into. i.e. No copy.
+  EXPECT_EQ(first_slot, results.rawbuf);
+  // The interrupt handler has moved on to capturing into a different slot.
+  EXPECT_NE(first_slot, irrecv.irparams.rawbuf);
+  EXPECT_EQ(kIdleState, irrecv.irparams.rcvstate);
+
+  irsend.reset();
+  irsend.sendSAMSUNG(0xE0E09966);
+  irsend.makeDecodeResult();
+  captureMessage(&irrecv, &irsend);
+  ASSERT_TRUE(irrecv.decode(&results));
+  EXPECT_EQ(SAMSUNG, results.decode_type);
+  EXPECT_EQ(0xE0E09966, results.value);
+  EXPECT_NE(first_slot, results.rawbuf);
+  EXPECT_FALSE(irrecv.decode(&results));  // Nothing new has been captured.
+  EXPECT_EQ(0, irrecv.getDroppedFrames());
+}
+
+// Each receiver has its own capture state.
+TEST(TestIRrecv, IndependentReceivers) {
+  IRsendTest irsend(0);
+  IRrecv first(1, 200, kTimeoutMs, false, 2);
+  IRrecv second(2, 300, kTimeoutMs, false, 2);
+  decode_results results;
+  EXPECT_EQ(200, first.getBufSize());
+  EXPECT_EQ(300, second.getBufSize());
+  EXPECT_NE(first.irparams.rawbuf, second.irparams.rawbuf);
+  first.enableIRIn();
+  second.enableIRIn();
+  irsend.begin();
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  captureMessage(&first, &irsend);
+  irsend.reset();
+  irsend.sendSAMSUNG(0xE0E09966);
+  irsend.makeDecodeResult();
+  captureMessage(&second, &irsend);
+  ASSERT_TRUE(second.decode(&results));
+  EXPECT_EQ(SAMSUNG, results.decode_type);
+  EXPECT_EQ(0xE0E09966, results.value);
+  ASSERT_TRUE(first.decode(&results));
+  EXPECT_EQ(NEC, results.decode_type);
+  EXPECT_EQ(0x807F40BF, results.value);
+  EXPECT_FALSE(second.decode(&results));
+}
+
+// Receivers can be created & used on several threads at once.
+TEST(TestIRrecv, DecodeOnThreads) {
+  const uint8_t kThreads = 4;
+  const uint64_t kValues[kThreads] = {0x807F40BF, 0x1, 0xFF00FF00, 0x12345678};
+  bool ok[kThreads] = {false};
+  std::thread threads[kThreads];
+  for (uint8_t t = 0; t < kThreads; t++)
+    threads[t] = std::thread([t, &kValues, &ok]() {
+      IRsendTest irsend(0);
+      IRrecv irrecv(1);
+      irsend.begin();
+      ok[t] = true;
+      for (uint16_t n = 0; n < 200; n++) {
+        irsend.reset();
+        irsend.sendNEC(kValues[t] + n);
+        irsend.makeDecodeResult();
+        // N.B. Most of these aren't strictly valid NEC, so are NEC_LIKE.
+        ok[t] &= irrecv.decodeCapture(&irsend.capture) &&
+            irsend.capture.value == ((kValues[t] + n) & 0xFFFFFFFF);
+      }
+    });
+  for (uint8_t t = 0; t < kThreads; t++) {
+    threads[t].join();
+    EXPECT_TRUE(ok[t]) << "Thread " << (int)t;
+  }
+}
+
+// decodeCapture() only depends on the message & the decode options.
+TEST(TestIRrecv, DecodeCapture) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1, 200, kTimeoutMs, false, 2);
+  irsend.begin();
+  irrecv.enableIRIn();
+  irsend.reset();
+  irsend.sendSAMSUNG(0xE0E09966);
+  irsend.makeDecodeResult();
+  volatile uint16_t *capturing = irrecv.irparams.rawbuf;
+  ASSERT_TRUE(irrecv.decodeCapture(&irsend.capture));
+  EXPECT_EQ(SAMSUNG, irsend.capture.decode_type);
+  EXPECT_EQ(0xE0E09966, irsend.capture.value);
+  // The capture state wasn't touched.
+  EXPECT_EQ(capturing, irrecv.irparams.rawbuf);
+  EXPECT_EQ(kIdleState, irrecv.irparams.rcvstate);
+  EXPECT_EQ(0, irrecv.ircapture.completed);
+  EXPECT_FALSE(irrecv.decode(&irsend.capture));
+  // Decoding it again gives the same result.
+  ASSERT_TRUE(irrecv.decodeCapture(&irsend.capture));
+  EXPECT_EQ(SAMSUNG, irsend.capture.decode_type);
+  EXPECT_EQ(0xE0E09966, irsend.capture.value);
+}
+
+TEST(TestIRrecv, DecodeOptions) {
+  IRrecv irrecv(1, kRawBuf, 50);
+  decode_options_t options;
+  irrecv.getDecodeOptions(&options);
+  EXPECT_EQ(50, options.timeout);
+  EXPECT_TRUE(options.header_dispatch);
+  EXPECT_EQ(kUnknownThreshold, options.unknown_threshold);
+  for (uint8_t i = 0; i < kProtocolMaskSize; i++)
+    EXPECT_EQ(0xFF, options.protocol_mask[i]);
+
+  irrecv.disableProtocol(NEC);
+  irrecv.setHeaderDispatch(false);
+  irrecv.getDecodeOptions(&options);
+  EXPECT_FALSE(options.header_dispatch);
+  EXPECT_EQ(0, options.protocol_mask[NEC / 8] & (1 << (NEC % 8)));
+
+  // Copy them to another receiver.
+  IRrecv other(2);
+  other.setDecodeOptions(&options);
+  EXPECT_FALSE(other.getHeaderDispatch());
+  EXPECT_FALSE(other.isProtocolEnabled(NEC));
+  EXPECT_TRUE(other.isProtocolEnabled(SONY));
+  EXPECT_EQ(50, other._options.timeout);
+
+  // The timeout is capped at what a capture can hold.
+  options.timeout = UINT8_MAX;
+  other.setDecodeOptions(&options);
+  other.getDecodeOptions(&options);
+  EXPECT_EQ(kMaxTimeoutMs, options.timeout);
+}
+
+// The decode timeout limits how long matchAtLeast() expects a gap to be.
+TEST(TestIRrecv, DecodeOptionsTimeout) {
+  IRrecv irrecv(1);
+  decode_options_t options;
+  irrecv.getDecodeOptions(&options);
+  const uint32_t gap = 20000 / kRawTick;  // 20ms, in ticks.
+  options.timeout = 15;
+  irrecv.setDecodeOptions(&options);
+  EXPECT_TRUE(irrecv.matchAtLeast(gap, 100000));
+  options.timeout = 90;
+  irrecv.setDecodeOptions(&options);
+  EXPECT_FALSE(irrecv.matchAtLeast(gap, 100000));
+  // The capture's own timeout is unchanged.
+  EXPECT_EQ(kTimeoutMs, irrecv.irparams.timeout);
+}
+
+// Receivers with different options decode the same message differently.
+TEST(TestIRrecv, DecodeCaptureWithDifferentOptions) {
+  IRsendTest irsend(0);
+  IRrecv all(1);
+  IRrecv no_nec(2);
+  no_nec.disableProtocol(NEC);
+  irsend.begin();
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  no_nec.decodeCapture(&irsend.capture);
+  EXPECT_NE(NEC, irsend.capture.decode_type);
+  ASSERT_TRUE(all.decodeCapture(&irsend.capture));
+  EXPECT_EQ(NEC, irsend.capture.decode_type);
+  EXPECT_EQ(0x807F40BF, irsend.capture.value);
+}
+
 // Tests for copyIrParams()
 
 TEST(TestCopyIrParams, CopyEmpty) {
@@ -447,6 +637,240 @@ TEST(TestDecode, DecodeAiwa) {
   EXPECT_EQ(0x7F, irsend.capture.value);
 }
 
+// Test the header dispatch can be turned on and off.
+TEST(TestDecode, HeaderDispatchSetting) {
+  IRrecv irrecv(1);
+  EXPECT_TRUE(irrecv.getHeaderDispatch());  // Default is on.
+  irrecv.setHeaderDispatch(false);
+  EXPECT_FALSE(irrecv.getHeaderDispatch());
+  irrecv.setHeaderDispatch(true);
+  EXPECT_TRUE(irrecv.getHeaderDispatch());
+}
+
+// Test decoding via the header dispatch gives the same results as trying the
+// full chain of decoders.
+// Decode what was sent, with & without header dispatch, & check both agree.
+// Returns: true if it was decoded as the given protocol.
+bool decodesTheSameDispatched(IRsendTest *irsend, IRrecv *irrecv,
+                              const decode_type_t sent) {
+  irsend->makeDecodeResult();
+  irrecv->setHeaderDispatch(false);
+  const bool chain_ok = irrecv->decode(&irsend->capture);
+  const decode_results chain = irsend->capture;  // Incl. any state.
+  irsend->makeDecodeResult();
+  irrecv->setHeaderDispatch(true);
+  EXPECT_EQ(chain_ok, irrecv->decode(&irsend->capture));
+  EXPECT_EQ(chain.decode_type, irsend->capture.decode_type);
+  EXPECT_EQ(chain.bits, irsend->capture.bits);
+  EXPECT_EQ(chain.repeat, irsend->capture.repeat);
+  if (hasACState(chain.decode_type)) {
+    EXPECT_STATE_EQ(chain.state, irsend->capture.state, chain.bits);
+  } else {
+    EXPECT_EQ(chain.value, irsend->capture.value);
+    EXPECT_EQ(chain.address, irsend->capture.address);
+    EXPECT_EQ(chain.command, irsend->capture.command);
+  }
+  return chain_ok && chain.decode_type == sent;
+}
+
+TEST(TestDecode, HeaderDispatchMatchesFullChain) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  // Every protocol we can send, with a few different values/states.
+  uint16_t decoded = 0;
+  uint64_t seed = 5;
+  for (uint16_t type = 1; type <= kLastDecodeType; type++) {
+    const decode_type_t protocol = (decode_type_t)type;
+    const uint16_t bits = IRsend::defaultBits(protocol);
+    if (!bits) continue;
+    SCOPED_TRACE(typeToString(protocol));
+    bool any = false;
+    for (uint8_t pattern = 0; pattern < 3; pattern++) {
+      uint8_t state[kStateSizeMax] = {};
+      uint64_t value = 0;
+      for (uint16_t i = 0; pattern && i < kStateSizeMax; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        state[i] = seed >> 56;
+      }
+      if (pattern) value = seed ^ (seed >> 29);
+      if (bits < 64) value &= (1ULL << bits) - 1;
+      irsend.reset();
+      if (hasACState(protocol)) {
+        if (!irsend.send(protocol, state, bits / 8)) break;
+      } else {
+        if (!irsend.send(protocol, value, bits)) break;
+      }
+      any |= decodesTheSameDispatched(&irsend, &irrecv, protocol);
+    }
+    if (any) decoded++;
+  }
+  // Most protocols decode at least one of those as themselves. (The rest need
+  // e.g. a valid checksum, but must still agree about not decoding.)
+  EXPECT_LE(40, decoded);
+  // Some special cases.
+  for (uint8_t i = 0; i < 5; i++) {
+    irsend.reset();
+    switch (i) {
+      case 0: irsend.sendNEC(0x807F40BF); break;
+      case 1: irsend.sendNEC(kRepeat); break;
+      case 2: irsend.sendSony(0x240, kSony12Bits); break;
+      case 3: irsend.sendRC5(0x175); break;
+      default:  // Something no protocol matches.
+        irsend.mark(1234);
+        irsend.space(5678);
+        irsend.mark(2345);
+        irsend.space(6789);
+        irsend.mark(3456);
+        irsend.space(100000);
+    }
+    decodesTheSameDispatched(&irsend, &irrecv, UNKNOWN);
+  }
+}
+
+// Test turning the decoding of protocols on & off at runtime.
+TEST(TestDecode, ProtocolMask) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  // Everything is enabled by default.
+  EXPECT_TRUE(irrecv.isProtocolEnabled(NEC));
+  EXPECT_TRUE(irrecv.isProtocolEnabled(SONY));
+  EXPECT_TRUE(irrecv.isProtocolEnabled(kLastDecodeType));
+  EXPECT_FALSE(irrecv.isProtocolEnabled(UNKNOWN));
+  EXPECT_FALSE(irrecv.isProtocolEnabled(UNUSED));
+
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(NEC, irsend.capture.decode_type);
+
+  irrecv.disableProtocol(NEC);
+  EXPECT_FALSE(irrecv.isProtocolEnabled(NEC));
+  EXPECT_TRUE(irrecv.isProtocolEnabled(SONY));
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_NE(NEC, irsend.capture.decode_type);
+
+  irrecv.disableAllProtocols();
+  EXPECT_FALSE(irrecv.isProtocolEnabled(SONY));
+  irrecv.enableProtocol(NEC);
+  irrecv.enableProtocol(DAIKIN);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(NEC, irsend.capture.decode_type);
+  EXPECT_EQ(0x807F40BF, irsend.capture.value);
+  irsend.reset();
+  irsend.sendSony(0x240, kSony12Bits);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(UNKNOWN, irsend.capture.decode_type);
+
+  // Save & restore the mask.
+  uint8_t mask[kProtocolMaskSize];
+  irrecv.getProtocolMask(mask);
+  irrecv.enableAllProtocols();
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(SONY, irsend.capture.decode_type);
+  irrecv.setProtocolMask(mask);
+  EXPECT_TRUE(irrecv.isProtocolEnabled(NEC));
+  EXPECT_TRUE(irrecv.isProtocolEnabled(DAIKIN));
+  EXPECT_FALSE(irrecv.isProtocolEnabled(SONY));
+
+  // Variants of a protocol are decoded if only the variant is enabled.
+  irrecv.disableAllProtocols();
+  irrecv.enableProtocol(LG2);
+  irsend.reset();
+  irsend.sendLG2(0x880094D);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(LG2, irsend.capture.decode_type);
+}
+
+// Test decode() only attempts the decoders of the protocols that are enabled.
+TEST(TestDecode, ProtocolMaskScaling) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  irsend.reset();
+  // Something no protocol matches, so every enabled decoder is attempted.
+  for (uint8_t i = 0; i < 30; i++) {
+    irsend.mark(1234 + i * 37);
+    irsend.space(2345 - i * 41);
+  }
+  irsend.space(100000);
+  irsend.makeDecodeResult();
+  irrecv.setHeaderDispatch(false);  // Make sure nothing else skips decoders.
+  decode_stats_t stats;
+
+  irrecv.resetDecodeStats();
+  irrecv.decode(&irsend.capture);
+  irrecv.getDecodeStats(&stats);
+  uint32_t attempts = 0;
+  for (uint16_t i = 1; i < kLastDecodeType + 2; i++)  // Excl. decodeHash().
+    attempts += stats.protocols[i].attempts;
+  EXPECT_EQ(kDecodeStepsLength, attempts);
+
+  irrecv.disableAllProtocols();
+  irrecv.enableProtocol(NEC);
+  irrecv.enableProtocol(DAIKIN);
+  irrecv.resetDecodeStats();
+  irrecv.decode(&irsend.capture);
+  irrecv.getDecodeStats(&stats);
+  EXPECT_EQ(UNKNOWN, irsend.capture.decode_type);
+  attempts = 0;
+  for (uint16_t i = 1; i < kLastDecodeType + 2; i++)
+    attempts += stats.protocols[i].attempts;
+  EXPECT_EQ(2, attempts);
+  EXPECT_EQ(1, stats.protocols[NEC + 1].attempts);
+  EXPECT_EQ(1, stats.protocols[DAIKIN + 1].attempts);
+}
+
+// Test a match of a variant we've been told to skip isn't left in the results.
+TEST(TestDecode, DisabledVariantLeavesResults) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  irrecv.setUnknownThreshold(UINT16_MAX);  // No decodeHash() fallback.
+  irrecv.disableAllProtocols();
+  irrecv.enableProtocol(LG);  // But not LG2.
+  irsend.reset();
+  irsend.sendLG2(0x880094D);
+  irsend.makeDecodeResult();
+  ASSERT_FALSE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(UNKNOWN, irsend.capture.decode_type);
+  EXPECT_EQ(0, irsend.capture.value);
+  EXPECT_EQ(0, irsend.capture.address);
+  EXPECT_EQ(0, irsend.capture.command);
+  EXPECT_EQ(0, irsend.capture.bits);
+}
+
+// Test the header timings in kDecodeSteps[] are what each protocol sends.
+TEST(TestDecode, DecodeStepHeaders) {
+  IRsendTest irsend(0);
+  irsend.begin();
+  uint8_t state[kStateSizeMax] = {};
+  for (uint8_t i = 0; i < kDecodeStepsLength; i++) {
+    const decode_step_t *step = &kDecodeSteps[i];
+    if (!step->hdrmark) continue;  // No fixed header to check.
+    irsend.reset();
+    const uint16_t bits = IRsend::defaultBits(step->type);
+    if (hasACState(step->type)) {
+      ASSERT_TRUE(irsend.send(step->type, state, bits / 8));
+    } else {
+      ASSERT_TRUE(irsend.send(step->type, (uint64_t)0, bits));
+    }
+    SCOPED_TRACE(typeToString(step->type));
+    // Exact, not within the step's tolerance, so a near miss is caught too.
+    EXPECT_EQ(step->hdrmark, irsend.output[0]);
+    if (step->hdrspace) {
+      EXPECT_EQ(step->hdrspace, irsend.output[1]);
+    }
+  }
+}
+
 // Test matchData() on space encoded data.
 TEST(TestMatchData, SpaceEncoded) {
   IRsendTest irsend(0);
@@ -1207,3 +1631,386 @@ TEST(TestMatchGeneric, UsingBytes) {
       true);  // MSB first.
   ASSERT_EQ(0, entries_used);
 }
+
+// Test the integer calculation of the lower & upper match bounds.
+TEST(TestMatch, TicksLowAndHigh) {
+  IRrecv irrecv(1);
+  EXPECT_EQ(750, irrecv.ticksLow(1000, 25));
+  EXPECT_EQ(1251, irrecv.ticksHigh(1000, 25));
+  EXPECT_EQ(700, irrecv.ticksLow(1000, 25, 50));
+  EXPECT_EQ(1301, irrecv.ticksHigh(1000, 25, 50));
+  // Fractions round inwards for the lower bound.
+  EXPECT_EQ(74, irrecv.ticksLow(99, 25));
+  EXPECT_EQ(124, irrecv.ticksHigh(99, 25));
+  // The lower bound can't go below zero.
+  EXPECT_EQ(0, irrecv.ticksLow(100, 25, 200));
+  // No overflow with large values.
+  EXPECT_EQ(75000000, irrecv.ticksLow(100000000, 25));
+  EXPECT_EQ(125000001, irrecv.ticksHigh(100000000, 25));
+  EXPECT_EQ(0, irrecv.ticksLow(0, 25));
+  EXPECT_EQ(1, irrecv.ticksHigh(0, 25));
+}
+
+// Test a pre-calculated match window agrees with match() etc.
+TEST(TestMatch, MatchWindowed) {
+  const uint8_t tolerances[] = {0, 1, 25, 30, 40};
+  const uint32_t durations[] = {0, 1, 99, 300, 560, 1000, 4480, 8960, 100000};
+  for (uint8_t t = 0; t < sizeof(tolerances); t++) {
+    for (uint8_t d = 0; d < sizeof(durations) / sizeof(durations[0]); d++) {
+      match_window_t window = IRrecv::matchWindow(durations[d], tolerances[t]);
+      match_window_t mark = IRrecv::markWindow(durations[d] + kMarkExcess,
+                                               tolerances[t]);
+      match_window_t space = IRrecv::spaceWindow(durations[d] + kMarkExcess,
+                                                 tolerances[t]);
+      for (uint32_t measured = 0; measured <= durations[d] + 100; measured++) {
+        ASSERT_EQ(IRrecv::match(measured, durations[d], tolerances[t]),
+                  IRrecv::matchWindowed(measured, window));
+        ASSERT_EQ(IRrecv::matchMark(measured, durations[d] + kMarkExcess,
+                                    tolerances[t]),
+                  IRrecv::matchWindowed(measured, mark));
+        ASSERT_EQ(IRrecv::matchSpace(measured, durations[d] + kMarkExcess,
+                                     tolerances[t]),
+                  IRrecv::matchWindowed(measured, space));
+      }
+    }
+  }
+}
+
+// The match window maths can be done at compile time.
+static_assert(IRrecv::matchWindow(560).low == 210, "Not constexpr?");
+static_assert(IRrecv::matchWindow(560).high == 350, "Not constexpr?");
+static_assert(IRrecv::matchWindowed(300, IRrecv::markWindow(560)), "Bad?");
+
+// Timings for testing the templated send/match engines.
+constexpr protocol_timing_t kTestMsbTiming = {
+    8000, 4000, 600, 1600, 600, 500, 600, 10000, 0, 38, 50, true};
+constexpr protocol_timing_t kTestLsbTiming = {
+    0, 0, 400, 1200, 400, 400, 400, 5000, 0, 38, 50, false};
+
+// matchTimed<>() must agree with matchGeneric() for the same timings.
+TEST(TestMatch, MatchTimedEquivalence) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  const uint64_t values[] = {0x0, 0x1, 0xA5, 0x807F40BF, 0xFEDCBA9876543210};
+  const uint16_t sizes[] = {1, 8, 32, 64};
+  for (uint8_t v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+    for (uint8_t n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++) {
+      uint64_t timed = 0;
+      uint64_t generic = 0;
+      irsend.reset();
+      irsend.sendTimed<kTestMsbTiming>(values[v], sizes[n]);
+      irsend.makeDecodeResult();
+      volatile uint16_t *buf = irsend.capture.rawbuf + kStartOffset;
+      uint16_t remaining = irsend.capture.rawlen - kStartOffset;
+      uint16_t used = irrecv.matchTimed<kTestMsbTiming>(buf, &timed,
+                                                        remaining, sizes[n]);
+      EXPECT_NE(0, used);
+      EXPECT_EQ(used, irrecv.matchGeneric(buf, &generic, remaining, sizes[n],
+                                          8000, 4000, 600, 1600, 600, 500,
+                                          600, 10000, true));
+      EXPECT_EQ(generic, timed);
+      // Wrong number of bits, or the wrong timings, shouldn't match.
+      EXPECT_EQ(0, irrecv.matchTimed<kTestMsbTiming>(buf, &timed, remaining,
+                                                     sizes[n] + 1));
+      EXPECT_EQ(0, irrecv.matchTimed<kTestLsbTiming>(buf, &timed, remaining,
+                                                     sizes[n]));
+
+      irsend.reset();
+      irsend.sendTimed<kTestLsbTiming>(values[v], sizes[n]);
+      irsend.makeDecodeResult();
+      remaining = irsend.capture.rawlen - kStartOffset;
+      used = irrecv.matchTimed<kTestLsbTiming>(buf, &timed, remaining,
+                                               sizes[n]);
+      EXPECT_NE(0, used);
+      EXPECT_EQ(used, irrecv.matchGeneric(buf, &generic, remaining, sizes[n],
+                                          0, 0, 400, 1200, 400, 400,
+                                          400, 5000, true, kTolerance,
+                                          kMarkExcess, false));
+      EXPECT_EQ(generic, timed);
+      if (sizes[n] < 64)
+        EXPECT_EQ(values[v] & ((1ULL << sizes[n]) - 1), timed);
+      else
+        EXPECT_EQ(values[v], timed);
+    }
+  }
+}
+
+#if DECODE_STATS
+// Test the collection of decode statistics.
+TEST(TestDecode, DecodeStats) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  decode_stats_t stats;
+  irsend.begin();
+
+  irrecv.getDecodeStats(&stats);
+  EXPECT_EQ(0, stats.messages);
+  EXPECT_EQ(0, stats.protocols[NEC + 1].attempts);
+  EXPECT_EQ("Messages  : 0 (Overflows: 0, Timeouts: 0)\n",
+            decodeStatsToString(&stats));
+
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  ASSERT_EQ(NEC, irsend.capture.decode_type);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  irrecv.getDecodeStats(&stats);
+  EXPECT_EQ(2, stats.messages);
+  EXPECT_EQ(0, stats.overflows);
+  EXPECT_EQ(2, stats.timeouts);
+  EXPECT_EQ(2, stats.protocols[NEC + 1].attempts);
+  EXPECT_EQ(2, stats.protocols[NEC + 1].hits);
+  EXPECT_EQ(0, stats.protocols[SONY + 1].attempts);  // Skipped by dispatch.
+  EXPECT_EQ(0, stats.protocols[UNKNOWN + 1].attempts);
+
+  // Something no protocol matches.
+  irsend.reset();
+  irsend.mark(1234);
+  irsend.space(5678);
+  irsend.mark(2345);
+  irsend.space(6789);
+  irsend.mark(3456);
+  irsend.space(100000);
+  irsend.makeDecodeResult();
+  irsend.capture.overflow = true;
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  ASSERT_EQ(UNKNOWN, irsend.capture.decode_type);
+  irrecv.getDecodeStats(&stats);
+  EXPECT_EQ(3, stats.messages);
+  EXPECT_EQ(1, stats.overflows);
+  EXPECT_EQ(2, stats.timeouts);
+  EXPECT_EQ(2, stats.protocols[NEC + 1].hits);
+  EXPECT_EQ(1, stats.protocols[UNKNOWN + 1].attempts);
+  EXPECT_EQ(1, stats.protocols[UNKNOWN + 1].hits);
+  EXPECT_NE(std::string::npos,
+            decodeStatsToString(&stats).find(
+                "Messages  : 3 (Overflows: 1, Timeouts: 2)\n"));
+  EXPECT_NE(std::string::npos,
+            decodeStatsToString(&stats).find(
+                "UNKNOWN: 1 attempts, 1 hits, 0uS total, 0uS max\n"));
+
+  irrecv.resetDecodeStats();
+  irrecv.getDecodeStats(&stats);
+  EXPECT_EQ(0, stats.messages);
+  EXPECT_EQ(0, stats.protocols[NEC + 1].hits);
+}
+#endif  // DECODE_STATS
+
+// Tests for decodeStream().
+
+// Pretend the interrupt handler has captured only the first `rawlen` entries
+// of a message, so far.
+void captureSoFar(IRrecv *irrecv, IRsendTest *irsend, const uint16_t rawlen) {
+  for (uint16_t i = 0; i < rawlen; i++)
+    irrecv->irparams.rawbuf[i] = irsend->capture.rawbuf[i];
+  irrecv->irparams.rawlen = rawlen;
+  irrecv->irparams.rcvstate = (rawlen & 1) ? kSpaceState : kMarkState;
+}
+
+TEST(TestDecodeStream, NEC) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  // The length of the capture, up to & including the footer mark.
+  const uint16_t length = 2 * kNECBits + kHeader + kFooter;
+
+  // Nothing is reported until the footer mark has been captured.
+  for (uint16_t rawlen = 0; rawlen < length; rawlen++) {
+    captureSoFar(&irrecv, &irsend, rawlen);
+    EXPECT_FALSE(irrecv.decodeStream(&results));
+  }
+  // It could still be a longer message (e.g. Sanyo), until the space after the
+  // footer is longer than a bit space could be.
+  captureSoFar(&irrecv, &irsend, length);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  IRtimer::add(1000);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  IRtimer::add(2000);
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(NEC, results.decode_type);
+  EXPECT_EQ(kNECBits, results.bits);
+  EXPECT_EQ(0x807F40BF, results.value);
+  EXPECT_EQ(length, results.rawlen);
+  // The capture was ended there, as if it had timed out.
+  EXPECT_EQ(kStopState, irrecv.irparams.rcvstate);
+
+  // Capturing the start of the next message also ends it.
+  irrecv.resume();
+  irsend.reset();
+  irsend.sendNEC(irsend.encodeNEC(0x12, 0x34));
+  irsend.makeDecodeResult();
+  captureSoFar(&irrecv, &irsend, length);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  captureSoFar(&irrecv, &irsend, length + 1);
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(NEC, results.decode_type);
+  EXPECT_EQ(0x12, results.address);
+  EXPECT_EQ(0x34, results.command);
+  EXPECT_EQ(length, results.rawlen);
+
+  // Repeat codes.
+  irrecv.resume();
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF, kNECBits, 1);
+  irsend.makeDecodeResult(length);  // Skip to the repeat code.
+  captureSoFar(&irrecv, &irsend, kNecRptLength);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  IRtimer::add(kNecOneSpace * 2);
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(NEC, results.decode_type);
+  EXPECT_TRUE(results.repeat);
+}
+
+TEST(TestDecodeStream, Sony) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+
+  // Nothing is longer than 20 bits, so it is reported straight away.
+  irsend.reset();
+  irsend.sendSony(irsend.encodeSony(kSony20Bits, 0x7F, 0x1F, 0xFF), kSony20Bits,
+                  0);
+  irsend.makeDecodeResult();
+  const uint16_t last = 2 * kSony20Bits + kHeader;  // rawlen to the last mark.
+  captureSoFar(&irrecv, &irsend, last - 1);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  captureSoFar(&irrecv, &irsend, last);
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(SONY, results.decode_type);
+  EXPECT_EQ(kSony20Bits, results.bits);
+  EXPECT_EQ(last, results.rawlen);
+
+  // A 12 bit message could still turn out to be a 15 bit one.
+  irrecv.resume();
+  irsend.reset();
+  irsend.sendSony(irsend.encodeSony(kSony12Bits, 0x1, 0x2), kSony12Bits, 0);
+  irsend.makeDecodeResult();
+  captureSoFar(&irrecv, &irsend, 2 * kSony12Bits + kHeader);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  IRtimer::add(1000);
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(SONY, results.decode_type);
+  EXPECT_EQ(kSony12Bits, results.bits);
+
+  // ... which it does if it carries on.
+  irrecv.resume();
+  irsend.reset();
+  irsend.sendSony(irsend.encodeSony(kSony15Bits, 0x1, 0x2), kSony15Bits, 0);
+  irsend.makeDecodeResult();
+  captureSoFar(&irrecv, &irsend, 2 * kSony12Bits + kHeader);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  captureSoFar(&irrecv, &irsend, 2 * kSony15Bits + kHeader - 1);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  captureSoFar(&irrecv, &irsend, 2 * kSony15Bits + kHeader);
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  IRtimer::add(1000);
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(SONY, results.decode_type);
+  EXPECT_EQ(kSony15Bits, results.bits);
+}
+
+TEST(TestDecodeStream, RC5) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+
+  const uint64_t messages[2] = {irsend.encodeRC5(0x1F, 0x3F),   // Ends in 1.
+                                irsend.encodeRC5(0x1F, 0x3E)};  // Ends in 0.
+  for (uint8_t i = 0; i < 2; i++) {
+    irrecv.resume();
+    irsend.reset();
+    irsend.sendRC5(messages[i], kRC5Bits);
+    irsend.makeDecodeResult();
+    // Find the last mark of the message.
+    uint16_t last = irsend.capture.rawlen - 1;
+    if (!(last & 1)) last--;
+    captureSoFar(&irrecv, &irsend, last);
+    EXPECT_FALSE(irrecv.decodeStream(&results));
+    captureSoFar(&irrecv, &irsend, last + 1);
+    ASSERT_TRUE(irrecv.decodeStream(&results));
+    EXPECT_EQ(RC5, results.decode_type);
+    EXPECT_EQ(kRC5Bits, results.bits);
+    EXPECT_EQ(messages[i], results.value);
+  }
+}
+
+TEST(TestDecodeStream, OtherMessagesWaitForTheTimeout) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1, kRawBuf, kTimeoutMs, false, 2);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+
+  // A Sanyo LC7461 message starts off looking just like a NEC one.
+  irsend.reset();
+  irsend.sendSanyoLC7461(0x2468DCB56A9);
+  irsend.makeDecodeResult();
+  for (uint16_t rawlen = 0; rawlen < irsend.capture.rawlen; rawlen++) {
+    captureSoFar(&irrecv, &irsend, rawlen);
+    EXPECT_FALSE(irrecv.decodeStream(&results));
+  }
+  IRtimer::add(MS_TO_USEC(kTimeoutMs));
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  irrecv.irparams.rcvstate = kStopState;  // i.e. It timed out.
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(SANYO_LC7461, results.decode_type);
+  EXPECT_EQ(0x2468DCB56A9, results.value);
+
+  // Protocols we've been told not to decode aren't followed either.
+  irrecv.disableProtocol(NEC);
+  irrecv.resume();
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  captureSoFar(&irrecv, &irsend, irsend.capture.rawlen);
+  IRtimer::add(MS_TO_USEC(kTimeoutMs));
+  EXPECT_FALSE(irrecv.decodeStream(&results));
+  irrecv.irparams.rcvstate = kStopState;
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_NE(NEC, results.decode_type);
+}
+
+TEST(TestDecodeStream, CaptureSlots) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1, kRawBuf, kTimeoutMs, false, 3);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+
+  irsend.reset();
+  irsend.sendRC5(irsend.encodeRC5(0x1, 0x2), kRC5Bits);
+  irsend.makeDecodeResult();
+  volatile uint16_t *first_slot = irrecv.irparams.rawbuf;
+  captureSoFar(&irrecv, &irsend, irsend.capture.rawlen);
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(RC5, results.decode_type);
+  // It was decoded from the slot it was captured into, & the interrupt handler
+  // has already moved on to capturing into the next one.
+  EXPECT_EQ(first_slot, results.rawbuf);
+  EXPECT_NE(first_slot, irrecv.irparams.rawbuf);
+  EXPECT_EQ(kIdleState, irrecv.irparams.rcvstate);
+  EXPECT_FALSE(irrecv.decodeStream(&results));  // Nothing new.
+
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  // Incl. the next message.
+  captureSoFar(&irrecv, &irsend, irsend.capture.rawlen);
+  ASSERT_TRUE(irrecv.decodeStream(&results));
+  EXPECT_EQ(NEC, results.decode_type);
+  EXPECT_EQ(0x807F40BF, results.value);
+  EXPECT_NE(first_slot, results.rawbuf);
+  EXPECT_EQ(0, irrecv.getDroppedFrames());
+}
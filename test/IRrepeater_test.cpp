@@ -0,0 +1,243 @@
+// Copyright 2019 David Conran
+
+#include <string>
+#include <vector>
+#include "IRrecv.h"
+#include "IRrepeater.h"
+#include "IRsend.h"
+#include "IRsend_test.h"
+#include "gtest/gtest.h"
+
+// Sends like IRsendTest, but as time passes (i.e. as it sends) it also plays
+// the part of the interrupt handler, capturing a message into a receiver as the
+// message "arrives".
+class IRsendCapturing : public IRsendTest {
+ public:
+  IRrecv *irrecv;
+  std::vector<uint32_t> message;  // Mark & space usecs. Starting with a mark.
+  uint32_t start;    // When the message starts to arrive.
+  uint16_t edges;    // Nr. of its edges captured so far.
+
+  explicit IRsendCapturing(IRrecv *recv) : IRsendTest(0), irrecv(recv) {}
+
+  // The message starts arriving now.
+  void arrive(const std::vector<uint32_t> &marks_and_spaces) {
+    message = marks_and_spaces;
+    start = _IRtimer_unittest_now;
+    edges = 0;
+    capture();
+  }
+
+  // Time passes with the IR LED off.
+  void wait(const uint32_t usecs) { space(usecs); }
+
+  uint16_t mark(uint16_t usec) {
+    IRsendTest::mark(usec);
+    capture();
+    return 0;
+  }
+
+  void space(uint32_t usec) {
+    IRsendTest::space(usec);
+    capture();
+  }
+
+  // Capture the edges of the message that have arrived by now, & time out
+  // when there have been none for long enough.
+  void capture(void) {
+    uint32_t edge = start;
+    uint16_t seen = 0;
+    while (seen <= message.size() && edge <= _IRtimer_unittest_now) {
+      if (seen < message.size()) edge += message[seen];
+      seen++;
+    }
+    if (seen > edges) {
+      edges = seen;
+      irrecv->irparams.rawbuf[0] = 1;
+      uint32_t last = start;
+      for (uint16_t i = 1; i < seen; i++) {
+        irrecv->irparams.rawbuf[i] = message[i - 1] / kRawTick;
+        last += message[i - 1];
+      }
+      irrecv->irparams.rawlen = seen;
+      irrecv->irparams.start = last;
+      irrecv->irparams.rcvstate = (seen & 1) ? kMarkState : kSpaceState;
+    } else if (edges > message.size() && irrecv->irparams.rawlen == edges &&
+               irrecv->irparams.rcvstate != kStopState &&
+               _IRtimer_unittest_now - irrecv->irparams.start >=
+                   MS_TO_USEC(kTimeoutMs)) {
+      irrecv->irparams.rcvstate = kStopState;  // i.e. It timed out.
+    }
+  }
+};
+
+// The marks & spaces of a message, without the gap after it.
+std::vector<uint32_t> marksAndSpaces(IRsendTest *irsend) {
+  std::vector<uint32_t> result;
+  for (uint16_t i = 0; i < irsend->last; i++)
+    result.push_back(irsend->output[i]);
+  return result;
+}
+
+// Call handle() every `step` usecs, until a message has been repeated.
+bool repeatIt(IRrepeater *repeater, IRsendCapturing *irsend,
+              decode_results *results, const uint32_t step = 100) {
+  for (uint16_t i = 0; i < 10000; i++) {
+    if (repeater->handle(results)) return true;
+    irsend->wait(step);
+  }
+  return false;
+}
+
+TEST(TestIRrepeater, StreamMessages) {
+  IRrecv irrecv(1);
+  IRsendCapturing irsend(&irrecv);
+  IRrepeater repeater(&irrecv, &irsend);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+  irsend.reset();
+
+  IRsendTest source(0);
+  source.begin();
+  source.reset();
+  source.sendNEC(0x807F40BF);
+  std::vector<uint32_t> message = marksAndSpaces(&source);
+
+  irsend.arrive(message);
+  EXPECT_FALSE(repeater.streaming());
+  ASSERT_FALSE(repeater.handle(&results));  // It has started streaming.
+  EXPECT_TRUE(repeater.streaming());
+  ASSERT_TRUE(repeatIt(&repeater, &irsend, &results));
+  EXPECT_FALSE(repeater.streaming());
+  EXPECT_EQ(NEC, results.decode_type);
+  EXPECT_EQ(0x807F40BF, results.value);
+  // It was sent the min. delay behind the message, & every mark & space was
+  // within a slice (or a step of the test) of how it was received.
+  EXPECT_EQ(kRepeaterMinDelay, irsend.output[1]);
+  ASSERT_LE(message.size() + 2, irsend.last + 1);
+  for (uint16_t i = 0; i < message.size(); i++) {
+    EXPECT_NEAR(message[i], irsend.output[i + 2], 100 + kRepeaterSlice)
+        << "Entry " << i;
+    EXPECT_EQ(kRepeaterFrequency, irsend.freq[i + 2]);
+  }
+  // It doesn't get any further behind as it goes.
+  uint32_t sent = 0, received = 0;
+  for (uint16_t i = 0; i < message.size(); i++) {
+    sent += irsend.output[i + 2];
+    received += message[i];
+  }
+  EXPECT_NEAR(received, sent, kRepeaterSlice);
+
+  repeater_stats_t stats = repeater.getStats();
+  EXPECT_EQ(1, stats.frames);
+  EXPECT_EQ(1, stats.streamed);
+  EXPECT_EQ(0, stats.late);
+  EXPECT_EQ(kRepeaterMinDelay, stats.max_delay);
+  // The receiver was resumed.
+  EXPECT_EQ(kIdleState, irrecv.irparams.rcvstate);
+  EXPECT_EQ(0, irrecv.irparams.rawlen);
+}
+
+TEST(TestIRrepeater, UnknownMessagesStreamToo) {
+  IRrecv irrecv(1, kRawBuf, kTimeoutMs, false, 2);  // With capture slots.
+  IRsendCapturing irsend(&irrecv);
+  IRrepeater repeater(&irrecv, &irsend);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+  irsend.reset();
+  repeater.setFrequency(40000);
+  repeater.setDelay(0, kRepeaterMaxDelay);
+
+  std::vector<uint32_t> message = {3000, 1000, 800, 2200, 800, 1200, 5000};
+  irsend.arrive(message);
+  ASSERT_TRUE(repeatIt(&repeater, &irsend, &results, 10));
+  EXPECT_EQ(UNKNOWN, results.decode_type);
+  for (uint16_t i = 0; i < message.size(); i++) {
+    EXPECT_NEAR(message[i], irsend.output[i], kRepeaterSlice) << "Entry " << i;
+    EXPECT_EQ(40000, irsend.freq[i]);
+  }
+  EXPECT_EQ(1, repeater.getStats().streamed);
+  EXPECT_FALSE(irrecv.decode(&results));  // The capture slot has been used.
+}
+
+TEST(TestIRrepeater, LateMessagesAreDecoded) {
+  IRrecv irrecv(1);
+  IRsendCapturing irsend(&irrecv);
+  IRrepeater repeater(&irrecv, &irsend);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+
+  IRsendTest source(0);
+  source.begin();
+  source.reset();
+  source.sendSony(source.encodeSony(kSony20Bits, 0x7F, 0x1F, 0xFF),
+                  kSony20Bits, 0);
+  std::vector<uint32_t> message = marksAndSpaces(&source);
+
+  // We don't get to see it until it is too late to stream it.
+  irsend.arrive(message);
+  irsend.wait(kRepeaterMaxDelay + 1);
+  irsend.reset();
+  ASSERT_TRUE(repeatIt(&repeater, &irsend, &results));
+  EXPECT_EQ(SONY, results.decode_type);
+  EXPECT_EQ(kSony20Bits, results.bits);
+  // It was sent afresh, by the protocol's send routine.
+  source.reset();
+  source.sendSony(results.value, kSony20Bits);
+  std::string expected = source.outputStr();
+  EXPECT_NE(std::string::npos,
+            irsend.outputStr().find(expected.substr(expected.find('m'))));
+
+  repeater_stats_t stats = repeater.getStats();
+  EXPECT_EQ(1, stats.frames);
+  EXPECT_EQ(0, stats.streamed);
+  EXPECT_EQ(1, stats.late);
+  EXPECT_EQ(1, stats.reencoded);
+}
+
+TEST(TestIRrepeater, DecodeMode) {
+  IRrecv irrecv(1);
+  IRsendCapturing irsend(&irrecv);
+  IRrepeater repeater(&irrecv, &irsend, kRepeaterDecode);
+  decode_results results;
+  irrecv.enableIRIn();
+  irsend.begin();
+  EXPECT_EQ(kRepeaterDecode, repeater.getMode());
+
+  IRsendTest source(0);
+  source.begin();
+  source.reset();
+  source.sendNEC(0x807F40BF);
+  std::vector<uint32_t> message = marksAndSpaces(&source);
+  std::string expected = source.outputStr();
+
+  // Nothing is sent while the message is arriving.
+  irsend.reset();
+  irsend.arrive(message);
+  EXPECT_FALSE(repeater.handle(&results));
+  EXPECT_FALSE(repeater.streaming());
+  irsend.wait(message[0] + message[1]);
+  EXPECT_FALSE(repeater.handle(&results));
+  ASSERT_TRUE(repeatIt(&repeater, &irsend, &results));
+  EXPECT_EQ(NEC, results.decode_type);
+  EXPECT_EQ(0x807F40BF, results.value);
+  EXPECT_NE(std::string::npos,
+            irsend.outputStr().find(expected.substr(expected.find('m'))));
+  EXPECT_EQ(1, repeater.getStats().reencoded);
+  EXPECT_EQ(0, repeater.getStats().late);
+
+  // Unknown messages are sent as they were captured, at the set frequency.
+  repeater.setFrequency(36000);
+  irsend.reset();
+  irsend.arrive({3000, 1000, 800, 2200, 800, 1200, 5000});
+  ASSERT_TRUE(repeatIt(&repeater, &irsend, &results));
+  EXPECT_EQ(UNKNOWN, results.decode_type);
+  std::string sent = irsend.outputStr();
+  EXPECT_NE(std::string::npos,
+            sent.find("f36000d50m3000s1000m800s2200m800s1200m5000"));
+  EXPECT_EQ(1, repeater.getStats().replayed);
+  EXPECT_EQ(2, repeater.getStats().frames);
+}
@@ -0,0 +1,247 @@
+// Copyright 2019 David Conran
+
+#include "IRsendQueue.h"
+#include "IRac.h"
+#include "IRsend.h"
+#include "IRsend_test.h"
+#include "gtest/gtest.h"
+
+// Record what the completion callbacks were told.
+static uint16_t callbacks = 0;
+static uint16_t callback_ids[kSendQueueLength * 2];
+static bool callback_results[kSendQueueLength * 2];
+
+void recordCallback(const uint16_t id, const bool success) {
+  callback_ids[callbacks] = id;
+  callback_results[callbacks] = success;
+  callbacks++;
+}
+
+// A backend that just remembers what it was asked to play.
+class IRsendQueueTestBackend : public IRsendBackend {
+ public:
+  const ir_pulse_train_t *train = NULL;
+  uint16_t plays = 0;
+  bool playing = false;
+
+  bool play(const ir_pulse_train_t *t) {
+    train = t;
+    plays++;
+    playing = true;
+    return true;
+  }
+  bool busy() { return playing; }
+};
+
+// A simple, valid, common A/C state.
+stdAc::state_t acState(const decode_type_t protocol) {
+  stdAc::state_t state;
+  state.protocol = protocol;
+  state.model = -1;
+  state.power = true;
+  state.mode = stdAc::opmode_t::kCool;
+  state.degrees = 24;
+  state.celsius = true;
+  state.fanspeed = stdAc::fanspeed_t::kAuto;
+  state.swingv = stdAc::swingv_t::kOff;
+  state.swingh = stdAc::swingh_t::kOff;
+  state.quiet = false;
+  state.turbo = false;
+  state.econo = false;
+  state.light = false;
+  state.filter = false;
+  state.clean = false;
+  state.beep = false;
+  state.sleep = -1;
+  state.clock = -1;
+  return state;
+}
+
+TEST(TestIRsendQueue, PriorityLaneAndCallbacks) {
+  IRsend irsend(4);
+  IRsendQueueTestBackend backend;
+  irsend.setBackend(&backend);
+  IRsendQueue queue(&irsend);
+  callbacks = 0;
+
+  EXPECT_TRUE(queue.idle());
+  EXPECT_FALSE(queue.handle());  // Nothing to do.
+  uint16_t sony = queue.enqueue(SONY, 0x240, kSony12Bits, kSonyMinRepeat,
+                                recordCallback);
+  uint16_t nec = queue.enqueue(NEC, 0x807F40BF, kNECBits, kNoRepeat,
+                               recordCallback, true);
+  EXPECT_NE(kSendQueueFull, sony);
+  EXPECT_NE(kSendQueueFull, nec);
+  EXPECT_NE(sony, nec);
+  EXPECT_EQ(2, queue.depth());
+  EXPECT_EQ(1, queue.priorityDepth());
+  EXPECT_FALSE(queue.idle());
+  EXPECT_EQ(0, backend.plays);  // Nothing is sent by enqueue().
+
+  // The priority job goes first, even though it was queued last.
+  EXPECT_TRUE(queue.handle());
+  EXPECT_EQ(1, backend.plays);
+  EXPECT_EQ(38000, backend.train->frequency);  // i.e. NEC.
+  EXPECT_EQ(68, backend.train->length);
+  EXPECT_EQ(1, queue.depth());
+  EXPECT_EQ(0, queue.priorityDepth());
+  EXPECT_EQ(0, callbacks);  // Still playing.
+  EXPECT_FALSE(queue.handle());
+  EXPECT_EQ(1, backend.plays);
+
+  // Once it has played, it is reported & the next one starts.
+  backend.playing = false;
+  EXPECT_TRUE(queue.handle());
+  ASSERT_EQ(1, callbacks);
+  EXPECT_EQ(nec, callback_ids[0]);
+  EXPECT_TRUE(callback_results[0]);
+  EXPECT_EQ(2, backend.plays);
+  EXPECT_EQ(40000, backend.train->frequency);  // i.e. Sony.
+  EXPECT_EQ(0, queue.depth());
+
+  backend.playing = false;
+  EXPECT_FALSE(queue.handle());  // Nothing left to start.
+  ASSERT_EQ(2, callbacks);
+  EXPECT_EQ(sony, callback_ids[1]);
+  EXPECT_TRUE(callback_results[1]);
+  EXPECT_TRUE(queue.idle());
+
+  send_queue_stats_t stats = queue.getStats();
+  EXPECT_EQ(2, stats.enqueued);
+  EXPECT_EQ(2, stats.sent);
+  EXPECT_EQ(0, stats.failed);
+  EXPECT_EQ(0, stats.dropped);
+  EXPECT_EQ(2, stats.max_depth);
+  queue.resetStats();
+  EXPECT_EQ(0, queue.getStats().enqueued);
+  EXPECT_EQ(0, queue.getStats().max_depth);
+}
+
+TEST(TestIRsendQueue, Bounded) {
+  IRsend irsend(4);
+  IRsendQueueTestBackend backend;
+  irsend.setBackend(&backend);
+  IRsendQueue queue(&irsend);
+  callbacks = 0;
+
+  for (uint16_t i = 0; i < kSendQueueLength; i++)
+    EXPECT_NE(kSendQueueFull, queue.enqueue(NEC, i, kNECBits, kNoRepeat,
+                                            recordCallback));
+  EXPECT_EQ(kSendQueueFull, queue.enqueue(NEC, 1, kNECBits));
+  for (uint16_t i = 0; i < kSendQueuePriorityLength; i++)
+    EXPECT_NE(kSendQueueFull, queue.enqueue(NEC, i, kNECBits, kNoRepeat,
+                                            recordCallback, true));
+  EXPECT_EQ(kSendQueueFull, queue.enqueue(NEC, 1, kNECBits, kNoRepeat, NULL,
+                                          true));
+  uint8_t state[kStateSizeMax + 1] = {0};
+  EXPECT_EQ(kSendQueueFull, queue.enqueue(DAIKIN, state, kStateSizeMax + 1));
+  EXPECT_EQ(kSendQueueFull, queue.enqueueAc(acState(COOLIX)));  // No IRac.
+
+  send_queue_stats_t stats = queue.getStats();
+  EXPECT_EQ(kSendQueueLength + kSendQueuePriorityLength, stats.enqueued);
+  EXPECT_EQ(kSendQueueLength + kSendQueuePriorityLength, stats.max_depth);
+  EXPECT_EQ(4, stats.dropped);
+
+  // Clearing it tells everyone waiting that they failed.
+  queue.clear();
+  EXPECT_EQ(0, queue.depth());
+  EXPECT_EQ(kSendQueueLength + kSendQueuePriorityLength, callbacks);
+  for (uint16_t i = 0; i < callbacks; i++) EXPECT_FALSE(callback_results[i]);
+  stats = queue.getStats();
+  EXPECT_EQ(kSendQueueLength + kSendQueuePriorityLength, stats.failed);
+  EXPECT_EQ(0, stats.sent);
+  EXPECT_TRUE(queue.idle());
+  EXPECT_FALSE(queue.handle());
+  EXPECT_EQ(0, backend.plays);
+}
+
+TEST(TestIRsendQueue, Sizes) {
+  IRsendLowLevelTest irsend(4);
+  IRsendQueueTestBackend backend;
+  irsend.setBackend(&backend);
+  IRsendQueue queue(&irsend, NULL, 2, 0, 16);
+  irsend.begin();
+  irsend.reset();
+
+  EXPECT_NE(kSendQueueFull, queue.enqueue(NEC, 1, kNECBits));
+  EXPECT_NE(kSendQueueFull, queue.enqueue(NEC, 2, kNECBits));
+  EXPECT_EQ(kSendQueueFull, queue.enqueue(NEC, 3, kNECBits));
+  EXPECT_EQ(kSendQueueFull, queue.enqueue(NEC, 4, kNECBits, kNoRepeat, NULL,
+                                          true));  // No priority lane.
+  EXPECT_EQ(2, queue.getStats().dropped);
+
+  // A NEC message doesn't fit in 16 entries, so it is sent the blocking way,
+  // not handed to the backend.
+  EXPECT_TRUE(queue.handle());
+  EXPECT_EQ(0, backend.plays);
+  EXPECT_NE("", irsend.low_level_sequence);
+  EXPECT_EQ(1, queue.getStats().sent);
+}
+
+TEST(TestIRsendQueue, GapsAreNotWaitedFor) {
+  IRsendLowLevelTest irsend(4);
+  IRsendQueue queue(&irsend);
+  irsend.begin();
+  irsend.reset();
+  callbacks = 0;
+
+  // Without a backend, the message itself is sent by handle().
+  queue.enqueue(NEC, 0x807F40BF, kNECBits, kNoRepeat, recordCallback);
+  queue.enqueue(NEC, 0x807F40BF, kNECBits, kNoRepeat, recordCallback);
+  EXPECT_TRUE(queue.handle());
+  ASSERT_EQ(1, callbacks);
+  EXPECT_TRUE(callback_results[0]);
+  std::string first = irsend.low_level_sequence;
+  EXPECT_NE("", first);
+
+  // We have to wait out the gap, but handle() doesn't block.
+  irsend.reset();
+  EXPECT_FALSE(queue.handle());
+  EXPECT_FALSE(queue.idle());
+  EXPECT_EQ("", irsend.low_level_sequence);
+  IRtimer::add(kDefaultMessageGap);
+  EXPECT_TRUE(queue.handle());
+  EXPECT_EQ(first, irsend.low_level_sequence);
+  EXPECT_EQ(2, callbacks);
+
+  // It is the same as a normal send, except without the trailing gap.
+  IRsendLowLevelTest direct(4);
+  direct.begin();
+  direct.reset();
+  direct.sendNEC(0x807F40BF);
+  EXPECT_LT(first.size(), direct.low_level_sequence.size());
+  EXPECT_EQ(first, direct.low_level_sequence.substr(0, first.size()));
+}
+
+TEST(TestIRsendQueue, Failures) {
+  IRsendLowLevelTest irsend(4);
+  IRsendQueue queue(&irsend);
+  callbacks = 0;
+
+  uint16_t id = queue.enqueue(UNKNOWN, 0x1234, 16, kNoRepeat, recordCallback);
+  EXPECT_NE(kSendQueueFull, id);
+  EXPECT_TRUE(queue.handle());
+  ASSERT_EQ(1, callbacks);
+  EXPECT_EQ(id, callback_ids[0]);
+  EXPECT_FALSE(callback_results[0]);
+  EXPECT_EQ(1, queue.getStats().failed);
+  EXPECT_EQ(0, queue.getStats().sent);
+}
+
+TEST(TestIRsendQueue, AcJobs) {
+  IRsendLowLevelTest irsend(4);
+  IRac ac(4);
+  IRsendQueue queue(&irsend, &ac);
+  callbacks = 0;
+
+  uint16_t id = queue.enqueueAc(acState(COOLIX), NULL, recordCallback);
+  uint16_t bad = queue.enqueueAc(acState(UNKNOWN), NULL, recordCallback);
+  EXPECT_EQ(0, callbacks);
+  EXPECT_TRUE(queue.handle());
+  EXPECT_TRUE(queue.handle());
+  ASSERT_EQ(2, callbacks);
+  EXPECT_EQ(id, callback_ids[0]);
+  EXPECT_TRUE(callback_results[0]);
+  EXPECT_EQ(bad, callback_ids[1]);
+  EXPECT_FALSE(callback_results[1]);
+}
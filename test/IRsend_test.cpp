@@ -232,6 +232,44 @@ TEST(TestSendRaw, NoTrailingGap) {
   EXPECT_EQ(kNECBits, irsend.capture.bits);
 }
 
+// sendRaw() from an iterator should be the same as from an array.
+TEST(TestSendRaw, Iterator) {
+  IRsendTest irsend(4);
+  IRrecv irrecv(4);
+  irsend.begin();
+
+  uint16_t rawData[7] = {9000, 4500, 650, 550, 650, 1650, 600};
+  irsend.reset();
+  irsend.sendRaw(rawData, 7, 38);
+  std::string expected = irsend.outputStr();
+  irsend.reset();
+  IRrawIterator raw(rawData, 7);
+  EXPECT_EQ(7, raw.length());
+  irsend.sendRaw(&raw, 38);
+  EXPECT_EQ(expected, irsend.outputStr());
+  irsend.reset();
+  irsend.sendRaw(&raw, 38);  // It is rewound for us.
+  EXPECT_EQ(expected, irsend.outputStr());
+
+  // Replay a capture, including a period too big for a sendRaw() array.
+  irsend.reset();
+  irsend.sendNEC(0xC3E0E0E8);
+  irsend.makeDecodeResult();
+  irsend.capture.rawbuf[2] = 40000;  // i.e. 80000us
+  IRsendTest replay(4);
+  replay.begin();
+  replay.reset();
+  uint16_t *array = resultToRawArray(&irsend.capture);
+  replay.sendRaw(array, getCorrectedRawLength(&irsend.capture), 38);
+  delete[] array;
+  expected = replay.outputStr();
+  EXPECT_EQ("f38000d50m8960s65535m0s14465m560s1680", expected.substr(0, 37));
+  replay.reset();
+  raw = resultToRawIterator(&irsend.capture);
+  replay.sendRaw(&raw, 38);
+  EXPECT_EQ(expected, replay.outputStr());
+}
+
 TEST(TestLowLevelSend, MarkFrequencyModulationAt38kHz) {
   IRsendLowLevelTest irsend(0);
 
@@ -313,6 +351,46 @@ TEST(TestLowLevelSend, MarkFrequencyModulationAt40kHz) {
   EXPECT_EQ("[On]1000usecs[Off]", irsend.low_level_sequence);
 }
 
+TEST(TestLowLevelSend, CarrierCache) {
+  IRsendLowLevelTest irsend(0);
+  irsend.begin();
+
+  irsend.enableIROut(38000, 50);
+  EXPECT_EQ(1, irsend.carrierMisses());
+  irsend.enableIROut(38, 50);  // Same carrier, just in kHz.
+  irsend.enableIROut(38000);
+  EXPECT_EQ(1, irsend.carrierMisses());
+  irsend.enableIROut(38000, 33);
+  irsend.enableIROut(36700);
+  EXPECT_EQ(3, irsend.carrierMisses());
+  // A cached carrier gives the same result as a freshly calculated one.
+  irsend.enableIROut(38000, 33);
+  irsend.reset();
+  EXPECT_EQ(5, irsend.mark(100));
+  EXPECT_EQ(
+      "[On]6usecs[Off]15usecs[On]6usecs[Off]15usecs[On]6usecs[Off]15usecs"
+      "[On]6usecs[Off]15usecs[On]6usecs[Off]10usecs",
+      irsend.low_level_sequence);
+  EXPECT_EQ(3, irsend.carrierMisses());
+  // The oldest entry is replaced when it's full.
+  irsend.enableIROut(40000);
+  EXPECT_EQ(4, irsend.carrierMisses());
+  irsend.enableIROut(38000, 50);
+  EXPECT_EQ(5, irsend.carrierMisses());
+  // Changing the period offset means it has to be recalculated.
+  irsend.reset();
+  EXPECT_EQ(0, irsend.calibrate(38000));  // No offset in the unit tests.
+  EXPECT_EQ(6, irsend.carrierMisses());
+  irsend.enableIROut(38000, 50);  // Same as calibrate() used.
+  EXPECT_EQ(6, irsend.carrierMisses());
+  irsend.reset();
+  EXPECT_EQ(4, irsend.mark(100));
+  EXPECT_EQ(
+      "[On]13usecs[Off]13usecs[On]13usecs[Off]13usecs[On]13usecs[Off]13usecs"
+      "[On]13usecs[Off]9usecs",
+      irsend.low_level_sequence);
+}
+
 TEST(TestLowLevelSend, MarkNoModulation) {
   IRsendLowLevelTest irsend(0, false, false);
 
@@ -786,3 +864,133 @@ TEST(TestSend, defaultBits) {
     }
   }
 }
+
+// A backend that just remembers what it was asked to play.
+class IRsendRecordingBackend : public IRsendBackend {
+ public:
+  const ir_pulse_train_t *train = NULL;
+  uint16_t plays = 0;
+  bool playing = false;
+
+  bool play(const ir_pulse_train_t *t) {
+    train = t;
+    plays++;
+    playing = true;
+    return true;
+  }
+  bool busy() { return playing; }
+};
+
+TEST(TestSendRender, RenderThenPlayViaBackend) {
+  IRsend irsend(4);
+  IRsendTest expected(4);
+  IRsendTest player(4);
+  IRsendRecordingBackend backend;
+  uint16_t buffer[1000];
+  irsend.begin();
+  expected.begin();
+  player.begin();
+
+  EXPECT_EQ(NULL, irsend.getBackend());
+  irsend.setBackend(&backend);
+  EXPECT_EQ(&backend, irsend.getBackend());
+  EXPECT_FALSE(irsend.busy());
+  EXPECT_FALSE(irsend.endRender());  // Not rendering yet.
+
+  EXPECT_TRUE(irsend.beginRender(buffer, 1000));
+  EXPECT_TRUE(irsend.isRendering());
+  irsend.sendNEC(0x807F40BF);
+  EXPECT_EQ(0, backend.plays);  // Nothing is played until the end.
+  EXPECT_TRUE(irsend.endRender());
+  EXPECT_FALSE(irsend.isRendering());
+  EXPECT_EQ(1, backend.plays);
+  ASSERT_NE(nullptr, backend.train);
+  EXPECT_EQ(buffer, backend.train->durations);
+  EXPECT_EQ(68, backend.train->length);  // Hdr + 32 bits + footer + gap.
+  EXPECT_EQ(38000, backend.train->frequency);
+  EXPECT_EQ(33, backend.train->dutycycle);
+  EXPECT_FALSE(backend.train->overflow);
+
+  // It should be identical to sending it directly.
+  expected.sendNEC(0x807F40BF);
+  player.playPulseTrain(backend.train);
+  EXPECT_EQ(expected.outputStr(), player.outputStr());
+
+  // Can't start another while the backend is still playing.
+  EXPECT_TRUE(irsend.busy());
+  EXPECT_FALSE(irsend.beginRender(buffer, 1000));
+  EXPECT_FALSE(irsend.isRendering());
+  backend.playing = false;
+  EXPECT_TRUE(irsend.beginRender(buffer, 1000));
+  // Multi-frame protocols render into a single pulse train.
+  uint8_t state[kDaikinStateLength] = {0};
+  irsend.sendDaikin(state);
+  EXPECT_TRUE(irsend.endRender());
+  EXPECT_EQ(2, backend.plays);
+  expected.sendDaikin(state);
+  player.playPulseTrain(backend.train);
+  EXPECT_EQ(expected.outputStr(), player.outputStr());
+}
+
+TEST(TestSendRender, RenderWithoutBackendPlaysSynchronously) {
+  IRsendLowLevelTest irsend(4);
+  IRsendLowLevelTest expected(4);
+  uint16_t buffer[10];
+  irsend.begin();
+  expected.begin();
+  irsend.reset();
+  expected.reset();
+
+  EXPECT_TRUE(irsend.beginRender(buffer, 10));
+  irsend.enableIROut(38000, 100);
+  irsend.mark(1000);
+  irsend.space(2000);
+  irsend.mark(3000);
+  EXPECT_EQ("", irsend.low_level_sequence);  // Nothing sent yet.
+  EXPECT_TRUE(irsend.endRender());
+
+  expected.enableIROut(38000, 100);
+  expected.mark(1000);
+  expected.space(2000);
+  expected.mark(3000);
+  EXPECT_EQ(expected.low_level_sequence, irsend.low_level_sequence);
+  EXPECT_EQ("[On]1000usecs[Off][Off]2000usecs[On]3000usecs[Off]",
+            irsend.low_level_sequence);
+}
+
+TEST(TestSendRender, RenderMergesAndSplitsPulses) {
+  IRsend irsend(4);
+  IRsendRecordingBackend backend;
+  uint16_t buffer[10];
+  irsend.setBackend(&backend);
+
+  // Leading space, merged marks & spaces, and a space too big for 16 bits.
+  EXPECT_TRUE(irsend.beginRender(buffer, 10));
+  irsend.space(10);
+  irsend.mark(20);
+  irsend.mark(30);
+  irsend.space(100000);
+  irsend.mark(0);  // Ignored.
+  irsend.space(5);
+  EXPECT_TRUE(irsend.endRender());
+  ASSERT_EQ(6, backend.train->length);
+  EXPECT_EQ(0, buffer[0]);
+  EXPECT_EQ(10, buffer[1]);
+  EXPECT_EQ(50, buffer[2]);
+  EXPECT_EQ(UINT16_MAX, buffer[3]);
+  EXPECT_EQ(0, buffer[4]);
+  EXPECT_EQ(100000 - UINT16_MAX + 5, buffer[5]);
+}
+
+TEST(TestSendRender, RenderOverflow) {
+  IRsend irsend(4);
+  IRsendRecordingBackend backend;
+  uint16_t buffer[4];
+  irsend.setBackend(&backend);
+
+  EXPECT_TRUE(irsend.beginRender(buffer, 4));
+  irsend.sendNEC(0x807F40BF);
+  EXPECT_FALSE(irsend.endRender());  // Too big to fit.
+  EXPECT_EQ(0, backend.plays);
+  EXPECT_FALSE(irsend.isRendering());
+}
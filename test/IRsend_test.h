@@ -138,6 +138,9 @@ class IRsendLowLevelTest : public IRsend {
 
   void reset() { low_level_sequence = ""; }
 
+  // Nr. of times enableIROut() had to calculate a carrier's on & off times.
+  uint16_t carrierMisses() { return _carrier_misses; }
+
  protected:
   void _delayMicroseconds(uint32_t usec) {
     _IRtimer_unittest_now += usec;
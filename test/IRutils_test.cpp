@@ -2,6 +2,8 @@
 
 #include "IRutils.h"
 #include <stdint.h>
+#include <string.h>
+#include <algorithm>
 #include "IRrecv.h"
 #include "IRrecv_test.h"
 #include "IRsend.h"
@@ -94,6 +96,22 @@ TEST(TestUint64ToString, SillyBases) {
   EXPECT_EQ("9IX", uint64ToString(12345, 36));     // But we *can* do base-36.
 }
 
+TEST(TestUint64ToString, Buffer) {
+  char buf[kUint64StringSize];
+  EXPECT_EQ(20, uint64ToString(UINT64_MAX, buf, sizeof(buf)));
+  EXPECT_STREQ("18446744073709551615", buf);
+  EXPECT_EQ(64, uint64ToString(UINT64_MAX, buf, sizeof(buf), 2));
+  EXPECT_EQ(uint64ToString(UINT64_MAX, 2), buf);
+  EXPECT_EQ(12, uint64ToString(0xfeeddeadbeef, buf, sizeof(buf), 16));
+  EXPECT_STREQ("FEEDDEADBEEF", buf);
+  EXPECT_EQ(1, uint64ToString(0, buf, sizeof(buf)));
+  EXPECT_STREQ("0", buf);
+  // Too small a buffer is truncated, but we are told how big it should be.
+  EXPECT_EQ(5, uint64ToString(12345, buf, 4));
+  EXPECT_STREQ("123", buf);
+  EXPECT_EQ(5, uint64ToString(12345, NULL, 0));
+}
+
 TEST(TestGetCorrectedRawLength, NoLargeValues) {
   IRsendTest irsend(0);
   IRrecv irrecv(1);
@@ -333,6 +351,67 @@ TEST(TestResultToHumanReadableBasic, ComplexCodes) {
       resultToHumanReadableBasic(&irsend.capture));
 }
 
+TEST(TestResultToBuffer, SameAsString) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  char buf[4096];
+
+  uint8_t state[kToshibaACStateLength] = {0xF2, 0x0D, 0x03, 0xFC, 0x01,
+                                          0x00, 0x00, 0x00, 0x01};
+  irsend.reset();
+  irsend.sendToshibaAC(state);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(resultToSourceCode(&irsend.capture).length(),
+            resultToSourceCode(&irsend.capture, buf, sizeof(buf)));
+  EXPECT_EQ(resultToSourceCode(&irsend.capture), buf);
+  EXPECT_EQ(resultToTimingInfo(&irsend.capture).length(),
+            resultToTimingInfo(&irsend.capture, buf, sizeof(buf)));
+  EXPECT_EQ(resultToTimingInfo(&irsend.capture), buf);
+  EXPECT_EQ(18, resultToHexidecimal(&irsend.capture, buf, sizeof(buf)));
+  EXPECT_STREQ("F20D03FC0100000001", buf);
+  EXPECT_EQ(64, resultToHumanReadableBasic(&irsend.capture, buf, sizeof(buf)));
+  EXPECT_STREQ(
+      "Encoding  : TOSHIBA_AC\n"
+      "Code      : F20D03FC0100000001 (72 bits)\n", buf);
+
+  // Large values are split up the same way too.
+  irsend.reset();
+  uint16_t rawData[5] = {10, 20, 30, 40, 50};
+  irsend.sendRaw(rawData, 5, 38000);
+  irsend.space(200000);
+  irsend.mark(60);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(resultToSourceCode(&irsend.capture).length(),
+            resultToSourceCode(&irsend.capture, buf, sizeof(buf)));
+  EXPECT_EQ(resultToSourceCode(&irsend.capture), buf);
+}
+
+TEST(TestResultToBuffer, Truncation) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  irsend.reset();
+  irsend.sendNEC(irsend.encodeNEC(0x10, 0x20));
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+
+  // A NULL buffer tells us how big it needs to be.
+  const size_t length = resultToTimingInfo(&irsend.capture, NULL, 0);
+  EXPECT_EQ(resultToTimingInfo(&irsend.capture).length(), length);
+  char buf[64];
+  memset(buf, 'X', sizeof(buf));
+  EXPECT_EQ(length, resultToTimingInfo(&irsend.capture, buf, 20));
+  EXPECT_STREQ("Raw Timing[68]:\n   ", buf);  // 19 chars & a NUL.
+  EXPECT_EQ('X', buf[20]);  // Nothing is written past the end.
+  EXPECT_EQ(length, resultToTimingInfo(&irsend.capture, buf, 1));
+  EXPECT_STREQ("", buf);
+  EXPECT_EQ(46, resultToHumanReadableBasic(&irsend.capture, buf, 5));
+  EXPECT_STREQ("Enco", buf);
+}
+
 TEST(TestInvertBits, Normal) {
   ASSERT_EQ(0xAAAA5555AAAA5555, invertBits(0x5555AAAA5555AAAA, 64));
   ASSERT_EQ(0xAAAA5555, invertBits(0x5555AAAA, 32));
@@ -397,10 +476,185 @@ TEST(TestCountBits, Integer) {
   ASSERT_EQ(0, countBits(data, 64, false));
 }
 
+// Bit/byte at a time versions of the checksum kernels, to check the optimised
+// ones against.
+namespace reference {
+uint64_t reverseBits(uint64_t input, uint16_t nbits) {
+  if (nbits <= 1) return input;
+  nbits = std::min(nbits, (uint16_t)64);
+  uint64_t output = 0;
+  for (uint16_t i = 0; i < nbits; i++) {
+    output <<= 1;
+    output |= (input & 1);
+    input >>= 1;
+  }
+  return (nbits == 64) ? output : (input << nbits) | output;
+}
+
+uint16_t countBits(const uint64_t data, const uint8_t length, const bool ones,
+                   const uint16_t init) {
+  uint16_t count = init;
+  uint8_t bitsSoFar = length;
+  for (uint64_t remainder = data; remainder && bitsSoFar;
+       remainder >>= 1, bitsSoFar--)
+    if (remainder & 1) count++;
+  return (ones || length == 0) ? count : length - count;
+}
+
+uint16_t countBits(const uint8_t *start, const uint16_t length,
+                   const bool ones, const uint16_t init) {
+  uint16_t count = init;
+  for (uint16_t i = 0; i < length; i++)
+    count += countBits(start[i], 8, true, 0);
+  return (ones || length == 0) ? count : (length * 8) - count;
+}
+
+uint8_t sumBytes(const uint8_t *start, const uint16_t length,
+                 const uint8_t init) {
+  uint8_t sum = init;
+  for (uint16_t i = 0; i < length; i++) sum += start[i];
+  return sum;
+}
+
+uint8_t xorBytes(const uint8_t *start, const uint16_t length,
+                 const uint8_t init) {
+  uint8_t sum = init;
+  for (uint16_t i = 0; i < length; i++) sum ^= start[i];
+  return sum;
+}
+
+uint8_t sumNibbles(const uint64_t data, const uint8_t count,
+                   const uint8_t init, const bool nibbleonly) {
+  uint8_t sum = init;
+  uint64_t copy = data;
+  for (uint8_t i = 0; i < std::min(count, (uint8_t)16); i++, copy >>= 4)
+    sum += copy & 0xF;
+  return nibbleonly ? sum & 0xF : sum;
+}
+}  // namespace reference
+
+// A repeatable stream of pseudo-random values.
+uint64_t nextRandom(uint64_t *seed) {
+  *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *seed ^ (*seed >> 29);
+}
+
+TEST(ReverseBitsTest, SameAsBitByBit) {
+  // Every 16 bit value, for every nr. of bits to 16 (& a bit beyond).
+  for (uint32_t value = 0; value <= UINT16_MAX; value++)
+    for (uint16_t nbits = 0; nbits <= 18; nbits++)
+      ASSERT_EQ(reference::reverseBits(value, nbits),
+                reverseBits(value, nbits)) << value << ", " << nbits;
+  // A lot of 64 bit values, for every nr. of bits.
+  uint64_t seed = 1;
+  for (uint32_t i = 0; i < 10000; i++) {
+    const uint64_t value = nextRandom(&seed);
+    for (uint16_t nbits = 0; nbits <= 66; nbits++)
+      ASSERT_EQ(reference::reverseBits(value, nbits),
+                reverseBits(value, nbits)) << value << ", " << nbits;
+  }
+}
+
+TEST(TestCountBits, SameAsBitByBit) {
+  for (uint32_t value = 0; value <= UINT16_MAX; value++) {
+    const uint8_t bytes[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+    for (uint8_t length = 0; length <= 2; length++) {
+      ASSERT_EQ(reference::countBits(bytes, length, true, 0),
+                countBits(bytes, length, true));
+      ASSERT_EQ(reference::countBits(bytes, length, false, 7),
+                countBits(bytes, length, false, 7));
+    }
+    for (uint8_t length = 0; length <= 17; length++)
+      ASSERT_EQ(reference::countBits(value, length, false, 3),
+                countBits((uint64_t)value, length, false, 3));
+  }
+  uint64_t seed = 2;
+  for (uint32_t i = 0; i < 10000; i++) {
+    const uint64_t value = nextRandom(&seed);
+    for (uint16_t length = 0; length <= 70; length++) {
+      ASSERT_EQ(reference::countBits(value, length, true, 0),
+                countBits(value, length));
+      ASSERT_EQ(reference::countBits(value, length, false, 1),
+                countBits(value, length, false, 1));
+    }
+  }
+}
+
+// Check a block kernel against its reference, for every length & alignment
+// of a block within `data`.
+#define EXPECT_SAME_OVER_BLOCKS(kernel, data, size)                         \
+  for (uint16_t offset = 0; offset < 4; offset++)                           \
+    for (uint16_t length = 0; length + offset <= size; length++)            \
+      for (uint16_t init = 0; init <= 0xFF; init += 0x55)                   \
+        ASSERT_EQ(reference::kernel(data + offset, length, init),           \
+                  kernel(data + offset, length, init))                      \
+            << #kernel << ": offset " << offset << ", length " << length    \
+            << ", init " << init;
+
+TEST(TestChecksumKernels, SameAsByteByByte) {
+  // Long enough to need every partial sum to be folded a few times.
+  const uint16_t kSize = 1100;
+  uint8_t data[kSize];
+  uint64_t seed = 3;
+  for (uint16_t i = 0; i < kSize; i++) data[i] = nextRandom(&seed);
+  EXPECT_SAME_OVER_BLOCKS(sumBytes, data, kSize);
+  EXPECT_SAME_OVER_BLOCKS(xorBytes, data, kSize);
+  for (uint16_t offset = 0; offset < 4; offset++)
+    for (uint16_t length = 0; length + offset <= kSize; length++) {
+      ASSERT_EQ(reference::countBits(data + offset, length, true, 0),
+                countBits(data + offset, length));
+      ASSERT_EQ(reference::countBits(data + offset, length, false, 0),
+                countBits(data + offset, length, false));
+    }
+  // The worst case for carries between the lanes.
+  memset(data, 0xFF, kSize);
+  EXPECT_SAME_OVER_BLOCKS(sumBytes, data, kSize);
+}
+
+TEST(TestSumNibbles, Integer) {
+  EXPECT_EQ(0, sumNibbles((uint64_t)0));
+  EXPECT_EQ(0xA, sumNibbles(0x1234, 4));  // 10
+  EXPECT_EQ(10, sumNibbles(0x1234, 4, 0, false));
+  EXPECT_EQ(9, sumNibbles(0x1234, 3, 0, false));
+  EXPECT_EQ(11, sumNibbles(0x1234, 4, 1, false));
+  EXPECT_EQ(240, sumNibbles(0xFFFFFFFFFFFFFFFF, 16, 0, false));
+  EXPECT_EQ(240, sumNibbles(0xFFFFFFFFFFFFFFFF, 20, 0, false));
+  EXPECT_EQ(0, sumNibbles(0xFFFFFFFFFFFFFFFF));  // 240 & 0xF
+
+  uint64_t seed = 4;
+  for (uint32_t i = 0; i < 10000; i++) {
+    const uint64_t value = nextRandom(&seed);
+    for (uint8_t count = 0; count <= 17; count++) {
+      ASSERT_EQ(reference::sumNibbles(value, count, 5, true),
+                sumNibbles(value, count, 5, true));
+      ASSERT_EQ(reference::sumNibbles(value, count, 250, false),
+                sumNibbles(value, count, 250, false));
+    }
+  }
+}
+
 TEST(TestStrToDecodeType, strToDecodeType) {
   EXPECT_EQ(decode_type_t::NEC, strToDecodeType("NEC"));
   EXPECT_EQ(decode_type_t::KELVINATOR, strToDecodeType("KELVINATOR"));
   EXPECT_EQ(decode_type_t::UNKNOWN, strToDecodeType("foo"));
+  // Case doesn't matter.
+  EXPECT_EQ(decode_type_t::MITSUBISHI_HEAVY_88,
+            strToDecodeType("Mitsubishi_Heavy_88"));
+  EXPECT_EQ(decode_type_t::NEC_LIKE, strToDecodeType("nec (non-strict)"));
+  // Both of the names NEC_LIKE has ever been known by.
+  EXPECT_EQ(decode_type_t::NEC_LIKE, strToDecodeType("NEC (non-strict)"));
+  EXPECT_EQ(decode_type_t::NEC_LIKE, strToDecodeType("NEC_LIKE"));
+  EXPECT_EQ(decode_type_t::NEC_LIKE, strToDecodeType("nec_like"));
+  EXPECT_EQ(decode_type_t::UNUSED, strToDecodeType("unused"));
+  EXPECT_EQ(decode_type_t::UNKNOWN, strToDecodeType("UNKNOWN"));
+  EXPECT_EQ(decode_type_t::UNKNOWN, strToDecodeType(""));
+  EXPECT_EQ(decode_type_t::UNKNOWN, strToDecodeType("NEC "));
+  // Numbers.
+  EXPECT_EQ(decode_type_t::NEC, strToDecodeType("3"));
+  EXPECT_EQ(decode_type_t::NEOCLIMA, strToDecodeType("66"));
+  EXPECT_EQ(decode_type_t::UNKNOWN, strToDecodeType("0"));
+  EXPECT_EQ(decode_type_t::UNKNOWN, strToDecodeType("-1"));
+  EXPECT_EQ(decode_type_t::UNKNOWN, strToDecodeType("999"));
 }
 
 TEST(TestUtils, htmlEscape) {
@@ -492,6 +746,213 @@ TEST(TestResultToRawArray, LargeValues) {
   if (result != NULL) delete[] result;
 }
 
+TEST(TestResultToRawIterator, SameAsRawArray) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  uint16_t test_data[9] = {10, 20, 30, 40, 50, 60, 70, 80, 90};
+  irsend.begin();
+  irsend.reset();
+  irsend.sendRaw(test_data, 9, 38000);
+  irsend.makeDecodeResult();
+  irrecv.decode(&irsend.capture);
+  irsend.capture.rawbuf[3] = 60000;  // Needs splitting up.
+  irsend.capture.rawbuf[4] = 0;
+  uint16_t expected[11] = {10, 20, 65535, 0, 54465, 0, 50, 60, 70, 80, 90};
+  IRrawIterator raw = resultToRawIterator(&irsend.capture);
+  ASSERT_EQ(11, raw.length());
+  ASSERT_EQ(11, getCorrectedRawLength(&irsend.capture));
+  uint16_t *array = resultToRawArray(&irsend.capture);
+  EXPECT_STATE_EQ(expected, array, 11);
+  if (array != NULL) delete[] array;
+  uint16_t result[11];
+  uint16_t count = 0;
+  uint16_t usecs;
+  while (count < 11 && raw.next(&result[count])) count++;
+  EXPECT_EQ(11, count);
+  EXPECT_FALSE(raw.next(&usecs));
+  EXPECT_STATE_EQ(expected, result, 11);
+  // It can be used again.
+  raw.rewind();
+  ASSERT_TRUE(raw.next(&usecs));
+  EXPECT_EQ(10, usecs);
+  // An empty capture.
+  irsend.capture.rawlen = 0;
+  raw = resultToRawIterator(&irsend.capture);
+  EXPECT_EQ(0, raw.length());
+  EXPECT_FALSE(raw.next(&usecs));
+}
+
+TEST(TestCompressCapture, RoundTrip) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  irsend.reset();
+  irsend.sendNEC(0x807F40BF);
+  irsend.makeDecodeResult();
+  ASSERT_EQ(69, irsend.capture.rawlen);
+  uint8_t buf[200];
+  // 2 mark & 4 space symbols, & their code lengths. 1 bit for each of the
+  // 34 marks. 1 bit for the 16 zero spaces, 2 bits for the 16 one spaces, &
+  // 3 bits each for the header space & the gap. No jitter, as they are exact.
+  const uint16_t size = compressCapture(&irsend.capture, buf, sizeof(buf));
+  EXPECT_EQ(kCaptureHeaderSize + 2 * (2 + 4) + 3 +
+            (34 + 16 * 1 + 16 * 2 + 2 * 3 + 7) / 8, size);
+  EXPECT_EQ(2, buf[0]);
+  EXPECT_EQ(4, buf[1]);
+  EXPECT_EQ(68, decompressCapture(buf, size, NULL, 0));
+  uint16_t ticks[68];
+  ASSERT_EQ(68, decompressCapture(buf, size, ticks, 68));
+  for (uint16_t i = 0; i < 68; i++)
+    EXPECT_EQ(irsend.capture.rawbuf[i + 1], ticks[i]) << "Entry " << i;
+  // It can be sent & decoded again.
+  irsend.reset();
+  IRrawIterator raw(ticks, 68, kRawTick);
+  irsend.sendRaw(&raw, 38000);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(NEC, irsend.capture.decode_type);
+  EXPECT_EQ(0x807F40BF, irsend.capture.value);
+}
+
+TEST(TestCompressCapture, Tolerance) {
+  IRsendTest irsend(0);
+  IRrecv irrecv(1);
+  irsend.begin();
+  irsend.reset();
+  // A noisy NEC message. i.e. As captured from a real remote.
+  irsend.mark(9040);
+  irsend.space(4430);
+  for (uint8_t i = 0; i < 32; i++) {
+    irsend.mark(540 + (i * 7) % 60);
+    irsend.space(((0xA55A33CC >> i) & 1) ? 1660 + i % 50 : 540 + i % 45);
+  }
+  irsend.mark(580);
+  irsend.space(40000);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  ASSERT_EQ(NEC, irsend.capture.decode_type);
+  const uint64_t value = irsend.capture.value;
+  irsend.makeDecodeResult();
+  uint16_t original[kRawBuf];
+  for (uint16_t i = 1; i < irsend.capture.rawlen; i++)
+    original[i - 1] = irsend.capture.rawbuf[i];
+  const uint16_t entries = irsend.capture.rawlen - 1;
+
+  uint8_t buf[200];
+  uint16_t ticks[kRawBuf];
+  // By default, every duration is kept exactly as it was. Only the jitter
+  // of each from its symbol is stored, so it is still smaller.
+  uint16_t lossless = compressCapture(&irsend.capture, buf, sizeof(buf));
+  ASSERT_LT(0, lossless);
+  EXPECT_GT(entries * sizeof(uint16_t) * 2 / 3, lossless);
+  EXPECT_EQ(kCaptureJitter, buf[0] & kCaptureJitter);
+  EXPECT_GT(kCaptureMaxSymbols / 2, buf[0] & ~kCaptureJitter);
+  ASSERT_EQ(entries, decompressCapture(buf, lossless, ticks, kRawBuf));
+  for (uint16_t i = 0; i < entries; i++)
+    EXPECT_EQ(original[i], ticks[i]) << "Entry " << i;
+  // Jitter that is cut short.
+  EXPECT_EQ(0, decompressCapture(buf, lossless - 1, ticks, kRawBuf));
+
+  // With a tolerance, it is much smaller, but stays within it. i.e. Between
+  // -10% & +11.1% of each duration.
+  uint16_t size = compressCapture(&irsend.capture, buf, sizeof(buf),
+                                  kCaptureTolerance);
+  ASSERT_LT(0, size);
+  EXPECT_LT(size, lossless);
+  EXPECT_GT(entries * sizeof(uint16_t) / 4, size);
+  EXPECT_GE(3, buf[0]);
+  EXPECT_GE(4, buf[1]);
+  ASSERT_EQ(entries, decompressCapture(buf, size, ticks, kRawBuf));
+  for (uint16_t i = 0; i < entries; i++) {
+    EXPECT_LE(original[i] * (100 - kCaptureTolerance), ticks[i] * 100U);
+    EXPECT_GE(original[i] * 100U, ticks[i] * (100 - kCaptureTolerance));
+  }
+  irsend.reset();
+  IRrawIterator raw(ticks, entries, kRawTick);
+  irsend.sendRaw(&raw, 38000);
+  irsend.makeDecodeResult();
+  ASSERT_TRUE(irrecv.decode(&irsend.capture));
+  EXPECT_EQ(NEC, irsend.capture.decode_type);
+  EXPECT_EQ(value, irsend.capture.value);
+}
+
+TEST(TestCompressCapture, Failures) {
+  IRsendTest irsend(0);
+  irsend.begin();
+  uint8_t buf[300];
+  uint16_t ticks[kRawBuf];
+  // Nothing captured.
+  irsend.reset();
+  irsend.makeDecodeResult();
+  irsend.capture.rawlen = 1;
+  EXPECT_EQ(kCaptureHeaderSize,
+            compressCapture(&irsend.capture, buf, sizeof(buf)));
+  EXPECT_EQ(0, decompressCapture(buf, kCaptureHeaderSize, ticks, kRawBuf));
+  // As many different marks as there are symbols.
+  irsend.reset();
+  for (uint16_t i = 0; i < kCaptureMaxSymbols; i++) {
+    irsend.mark(1000 + i * 600);
+    irsend.space(500);
+  }
+  irsend.makeDecodeResult();
+  uint16_t size = compressCapture(&irsend.capture, buf, sizeof(buf));
+  ASSERT_LT(0, size);
+  EXPECT_EQ(kCaptureMaxSymbols, buf[0]);
+  // Doesn't fit.
+  EXPECT_EQ(0, compressCapture(&irsend.capture, buf, size - 1));
+  EXPECT_EQ(0, compressCapture(&irsend.capture, NULL, 0));
+  // Truncated, or too big for the output.
+  const uint16_t entries = irsend.capture.rawlen - 1;
+  EXPECT_EQ(entries, decompressCapture(buf, size, ticks, entries));
+  EXPECT_EQ(0, decompressCapture(buf, size - 1, ticks, kRawBuf));
+  EXPECT_EQ(0, decompressCapture(buf, size, ticks, entries - 1));
+  EXPECT_EQ(0, decompressCapture(NULL, size, ticks, kRawBuf));
+  // Corrupt.
+  buf[0] = kCaptureMaxSymbols + 1;
+  EXPECT_EQ(0, decompressCapture(buf, size, ticks, kRawBuf));
+  buf[0] = kCaptureMaxSymbols;
+  const uint16_t lengths = kCaptureHeaderSize + 2 * (kCaptureMaxSymbols + 1);
+  buf[lengths] &= 0xF0;  // No code for the first mark.
+  EXPECT_EQ(0, decompressCapture(buf, size, ticks, kRawBuf));
+  buf[lengths] |= 0x01;  // Too many short codes.
+  EXPECT_EQ(0, decompressCapture(buf, size, ticks, kRawBuf));
+}
+
+TEST(TestCompressCapture, Literals) {
+  IRsendTest irsend(0);
+  irsend.begin();
+  irsend.reset();
+  // Many more different marks & spaces than there are symbols for. Each is
+  // 4% longer than the last, so they aren't clustered together.
+  uint32_t mark = 500;
+  for (uint16_t i = 0; i < 3 * kCaptureMaxSymbols; i++) {
+    irsend.mark(mark);
+    irsend.space(i % 2 ? 500 : mark + 300);
+    mark += mark / 25 + 1;
+  }
+  irsend.makeDecodeResult();
+  const uint16_t entries = irsend.capture.rawlen - 1;
+  uint8_t buf[600];
+  uint16_t ticks[6 * kCaptureMaxSymbols];
+  uint16_t size = compressCapture(&irsend.capture, buf, sizeof(buf));
+  ASSERT_LT(0, size);
+  EXPECT_EQ(kCaptureMaxSymbols, buf[0]);
+  EXPECT_EQ(kCaptureMaxSymbols, buf[1]);
+  // The longest 31 have their own symbols, & the rest are literals. So they
+  // are all kept exactly.
+  EXPECT_EQ(0, buf[kCaptureHeaderSize + 2 * (kCaptureMaxSymbols - 1)]);
+  ASSERT_EQ(entries, decompressCapture(buf, size, ticks, entries));
+  for (uint16_t i = 0; i < entries; i++)
+    EXPECT_EQ(irsend.capture.rawbuf[i + 1], ticks[i]) << "Entry " << i;
+  // A literal that is cut short.
+  EXPECT_EQ(0, decompressCapture(buf, size - 2, ticks, entries));
+  // A tolerance needs fewer symbols, & no literals.
+  size = compressCapture(&irsend.capture, buf, sizeof(buf), 20);
+  ASSERT_LT(0, size);
+  EXPECT_GT(kCaptureMaxSymbols, buf[0]);
+  ASSERT_EQ(entries, decompressCapture(buf, size, ticks, entries));
+}
+
 TEST(TestUtils, TypeStringConversionRangeTests) {
   ASSERT_EQ("UNKNOWN", typeToString((decode_type_t)(kLastDecodeType + 1)));
   ASSERT_EQ("UNKNOWN", typeToString(decode_type_t::UNKNOWN));
@@ -503,3 +964,19 @@ TEST(TestUtils, TypeStringConversionRangeTests) {
         " doesn't decode from a string correctly";
   }
 }
+
+TEST(TestUtils, TypeToName) {
+  EXPECT_STREQ("UNKNOWN", typeToName(decode_type_t::UNKNOWN));
+  EXPECT_STREQ("UNKNOWN", typeToName((decode_type_t)(kLastDecodeType + 1)));
+  EXPECT_STREQ("NEC", typeToName(decode_type_t::NEC));
+  EXPECT_STREQ("NEC (non-strict)", typeToName(decode_type_t::NEC_LIKE));
+  EXPECT_EQ("NEC (Repeat)", typeToString(decode_type_t::NEC, true));
+  for (int i = 0; i <= kLastDecodeType; i++) {
+    EXPECT_EQ(typeToString((decode_type_t)i), typeToName((decode_type_t)i));
+    EXPECT_GT(kProtocolNameSize, strlen(typeToName((decode_type_t)i)));
+    // Every name must be findable. i.e. kSortedProtocols[] is in order.
+    EXPECT_EQ(i, strToDecodeType(typeToName((decode_type_t)i))) <<
+        "Protocol " << typeToName((decode_type_t)i) <<
+        " is missing or out of order in kSortedProtocols[]";
+  }
+}
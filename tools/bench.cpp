@@ -0,0 +1,88 @@
+// Common code for the host benchmark tools.
+// Copyright 2019 David Conran
+
+#include "bench.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <new>
+
+uint64_t bench_allocations = 0;
+
+// Count every heap allocation made by the program.
+void *operator new(size_t size) {
+  bench_allocations++;
+  void *ptr = malloc(size);
+  if (ptr == NULL) throw std::bad_alloc();
+  return ptr;
+}
+
+void *operator new[](size_t size) {
+  bench_allocations++;
+  void *ptr = malloc(size);
+  if (ptr == NULL) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+// Get the nr. of iterations from the command line. i.e. `tool [iterations]`
+//
+// Args:
+//   argc, argv: The arguments the benchmark was run with.
+//   iterations: Ptr to where to store the nr. Left as is if not given.
+// Returns:
+//   A boolean indicating if the arguments were valid. If not, the usage has
+//   already been reported.
+bool benchIterations(const int argc, char * const argv[],
+                     uint32_t *iterations) {
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+    return false;
+  }
+  if (argc == 2) {
+    errno = 0;
+    uint32_t value = strtoul(argv[1], NULL, 10);
+    if (errno || !value) {
+      std::cerr << "Invalid nr. of iterations: " << argv[1] << std::endl;
+      return false;
+    }
+    *iterations = value;
+  }
+  return true;
+}
+
+// Start timing a section of a benchmark.
+bench_timer_t benchStart(void) {
+  bench_timer_t timer;
+  timer.allocations = bench_allocations;
+  timer.start = bench_clock::now();
+  return timer;
+}
+
+// Nr. of nanoseconds since a section of a benchmark started.
+uint64_t nsSince(const bench_timer_t timer) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      bench_clock::now() - timer.start).count();
+}
+
+// Average nr. of nanoseconds per call since a section started.
+double nsPerCall(const bench_timer_t timer, const uint64_t calls) {
+  return static_cast<double>(nsSince(timer)) / calls;
+}
+
+// Average nr. of heap allocations per call since a section started.
+double allocsPerCall(const bench_timer_t timer, const uint64_t calls) {
+  return static_cast<double>(bench_allocations - timer.allocations) / calls;
+}
+
+// Print the header line of the CSV output.
+void csvHeader(const char * const columns[], const uint8_t length) {
+  for (uint8_t i = 0; i < length; i++)
+    printf(i ? ",%s" : "%s", columns[i]);
+  printf("\n");
+}
@@ -0,0 +1,32 @@
+// Common code for the host benchmark tools. e.g. decode_bench, name_bench etc.
+// Copyright 2019 David Conran
+//
+// Linking with bench.o counts every heap allocation the program makes, so a
+// benchmark can report allocations per call as well as the time per call.
+
+#ifndef TOOLS_BENCH_H_
+#define TOOLS_BENCH_H_
+
+#include <stdint.h>
+#include <chrono>  // NOLINT(build/c++11)
+
+typedef std::chrono::steady_clock bench_clock;
+
+// Nr. of heap allocations (new & new[]) made so far.
+extern uint64_t bench_allocations;
+
+// Where a timed section of a benchmark started.
+typedef struct {
+  bench_clock::time_point start;
+  uint64_t allocations;
+} bench_timer_t;
+
+bool benchIterations(const int argc, char * const argv[],
+                     uint32_t *iterations);
+bench_timer_t benchStart(void);
+uint64_t nsSince(const bench_timer_t timer);
+double nsPerCall(const bench_timer_t timer, const uint64_t calls);
+double allocsPerCall(const bench_timer_t timer, const uint64_t calls);
+void csvHeader(const char * const columns[], const uint8_t length);
+
+#endif  // TOOLS_BENCH_H_
@@ -0,0 +1,195 @@
+// Quick and dirty tool to measure how well captures compress.
+// Copyright 2019 David Conran
+//
+// Finds every `uint16_t name[...] = {...};` raw capture in the given files
+// (e.g. The output of IRrecvDumpV2, or the unit tests), and compresses each
+// one with compressCapture(). Checks it decodes the same after being
+// decompressed, & prints the results as CSV, followed by a summary on stderr.
+// e.g. ./capture_compress ../test/*_test.cpp > compress.csv
+//
+// Columns:
+//   source:        The file & line the capture starts on.
+//   entries:       Nr. of durations in the capture.
+//   raw_bytes:     Size of the capture as a uint16_t array.
+//   bytes:         Size of the compressed capture.
+//   ratio:         raw_bytes / bytes.
+//   mark_symbols:  Nr. of different marks after clustering.
+//   space_symbols: Nr. of different spaces after clustering.
+//   decoded:       What decode() reported the original capture as.
+//   same:          1 if it decodes the same after decompression.
+//
+// Usage: capture_compress [-tolerance <percent>] <file> [<file> ...]
+//   The tolerance defaults to 0. i.e. Lossless. kCaptureTolerance is a good
+//   one if it can be lossy.
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "IRrecv.h"
+#include "IRsend.h"
+#include "IRsend_test.h"
+#include "IRutils.h"
+
+typedef struct {
+  uint32_t captures;
+  uint32_t failed;
+  uint32_t different;
+  uint64_t raw_bytes;
+  uint64_t bytes;
+} totals_t;
+
+// Everything we compare to see if a capture decodes the same.
+bool sameDecode(const decode_results *a, const decode_results *b) {
+  if (a->decode_type != b->decode_type || a->bits != b->bits ||
+      a->repeat != b->repeat)
+    return false;
+  if (hasACState(a->decode_type))
+    return !memcmp(a->state, b->state, a->bits / 8);
+  return a->value == b->value && a->address == b->address &&
+      a->command == b->command;
+}
+
+// They're big, so only have one of each.
+static IRsendTest irsend(0);
+static IRrecv irrecv(1);
+
+void processCapture(const std::string &source,
+                    std::vector<uint16_t> *usecs,
+                    const uint8_t tolerance, totals_t *totals) {
+  irsend.reset();
+  irsend.sendRaw(usecs->data(), usecs->size(), 38);
+  irsend.makeDecodeResult();
+  irrecv.decode(&irsend.capture);
+  const decode_results original = irsend.capture;
+
+  irsend.makeDecodeResult();
+  const uint16_t entries = irsend.capture.rawlen - 1;
+  uint8_t buf[kCaptureHeaderSize + 6 * kCaptureMaxSymbols + kStateSizeMax +
+              RAW_BUF * 2];
+  uint16_t size = compressCapture(&irsend.capture, buf, sizeof(buf),
+                                  tolerance);
+  totals->captures++;
+  if (!size) {
+    std::cerr << source << ": Can't be compressed." << std::endl;
+    totals->failed++;
+    return;
+  }
+  uint16_t ticks[RAW_BUF];
+  bool same = false;
+  if (decompressCapture(buf, size, ticks, RAW_BUF) == entries) {
+    irsend.reset();
+    IRrawIterator raw(ticks, entries, kRawTick);
+    irsend.sendRaw(&raw, 38);
+    irsend.makeDecodeResult();
+    irrecv.decode(&irsend.capture);
+    same = sameDecode(&original, &irsend.capture);
+  }
+  if (!same) totals->different++;
+  totals->raw_bytes += entries * sizeof(uint16_t);
+  totals->bytes += size;
+  printf("%s,%" PRIu16 ",%u,%" PRIu16 ",%.2f,%u,%u,%s,%d\n",
+         source.c_str(), entries, (unsigned)(entries * sizeof(uint16_t)),
+         size, (double)entries * sizeof(uint16_t) / size,
+         buf[0] & ~kCaptureJitter, buf[1],
+         typeToString(original.decode_type, original.repeat).c_str(), same);
+}
+
+// Find & process every raw capture in a file.
+// Returns: true if the file could be read, otherwise false.
+bool processFile(const char *filename, const uint8_t tolerance,
+                 totals_t *totals) {
+  std::ifstream in(filename);
+  if (!in) return false;
+  std::string line;
+  std::string source;
+  std::vector<uint16_t> usecs;
+  bool in_capture = false;
+  for (uint32_t nr = 1; std::getline(in, line); nr++) {
+    line = line.substr(0, line.find("//"));  // Ignore any comments.
+    size_t pos = 0;
+    if (!in_capture) {
+      size_t decl = line.find("uint16_t ");
+      if (decl == std::string::npos) continue;
+      pos = line.find('{', decl);
+      if (pos == std::string::npos ||
+          line.find('[', decl) == std::string::npos) continue;
+      pos++;
+      in_capture = true;
+      usecs.clear();
+      source = std::string(filename) + ":" + std::to_string(nr);
+    }
+    size_t end = line.find('}', pos);
+    std::stringstream values(line.substr(pos, end == std::string::npos ?
+                                         std::string::npos : end - pos));
+    std::string value;
+    while (in_capture && std::getline(values, value, ',')) {
+      value.erase(0, value.find_first_not_of(" \t\r"));
+      value.erase(value.find_last_not_of(" \t\r") + 1);
+      if (value.empty()) continue;
+      char *last;
+      errno = 0;
+      uint64_t usec = strtoull(value.c_str(), &last, 10);
+      if (errno || *last != '\0' || usec > UINT16_MAX)
+        in_capture = false;  // Not a raw capture. e.g. Hex, or a variable.
+      else
+        usecs.push_back(usec);
+    }
+    if (in_capture && end != std::string::npos) {
+      in_capture = false;
+      // Skip anything too short or long to be a real capture.
+      if (usecs.size() >= 8 && usecs.size() < RAW_BUF - 1)
+        processCapture(source, &usecs, tolerance, totals);
+    }
+  }
+  return true;
+}
+
+void usage_error(char *name) {
+  std::cerr << "Usage: " << name << " [-tolerance <percent>] <file> "
+            "[<file> ...]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  uint8_t tolerance = 0;
+  int first = 1;
+  if (argc > 2 && !strcmp(argv[1], "-tolerance")) {
+    errno = 0;
+    char *end;
+    uint64_t percent = strtoull(argv[2], &end, 10);
+    if (errno || *end != '\0' || percent > 100) {
+      usage_error(argv[0]);
+      return 1;
+    }
+    tolerance = percent;
+    first = 3;
+  }
+  if (first >= argc) {
+    usage_error(argv[0]);
+    return 1;
+  }
+
+  irsend.begin();
+  totals_t totals = {0, 0, 0, 0, 0};
+  printf("source,entries,raw_bytes,bytes,ratio,mark_symbols,space_symbols,"
+         "decoded,same\n");
+  for (int i = first; i < argc; i++)
+    if (!processFile(argv[i], tolerance, &totals)) {
+      std::cerr << "Can't open " << argv[i] << std::endl;
+      return 1;
+    }
+  std::cerr << totals.captures << " captures. " << totals.failed
+            << " couldn't be compressed. " << totals.different
+            << " decoded differently." << std::endl;
+  if (totals.bytes)
+    fprintf(stderr, "%" PRIu64 " bytes -> %" PRIu64 " bytes. Ratio: %.2f\n",
+            totals.raw_bytes, totals.bytes,
+            (double)totals.raw_bytes / totals.bytes);
+  return 0;
+}
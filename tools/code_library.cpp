@@ -0,0 +1,205 @@
+// Quick and dirty tool to build & inspect IR code libraries.
+// Copyright 2019 David Conran
+//
+// Converts a text dump of codes into a binary IRcodeLibrary, which can then
+// be put on SPIFFS, or compiled into flash, and sent with no parsing or heap
+// use on the device. See src/IRcodeLibrary.h.
+//
+// The text dump has one code per line:
+//   <type> <id> [<name>] <code>
+// where:
+//   type: RAW, GC or PRONTO.
+//   id:   A unique number. 0 - 65535.
+//   name: Optional. May contain spaces. Must be shorter than 24 characters.
+//   code: Comma separated values. The same as IRMQTTServer accepts. i.e.
+//     RAW:    <freq>,<mark>,<space>,... in uSeconds.
+//     GC:     [1:1,1,]<freq>,<repeats>,<offset>,<mark>,<space>,...
+//     PRONTO: [R<repeats>,]<hex>,<hex>,...
+// Blank lines & lines starting with '#' are ignored.
+// e.g.
+//   GC 1 TV Power 38000,1,1,342,172,21,22,21,21,21,65,...
+//   PRONTO 2 DVD R2,0000,0067,0000,0015,0060,0018,...
+//
+// Usage:
+//   code_library build <text_dump> <library.bin>
+//   code_library list <library.bin>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "IRcodeLibrary.h"
+
+// Convert a comma separated list of numbers.
+// Returns: true if they were all valid, false if not.
+bool parseValues(const std::string &str, const int base,
+                 std::vector<uint16_t> *values) {
+  std::stringstream stream(str);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    char *end;
+    errno = 0;
+    uint64_t value = strtoull(item.c_str(), &end, base);
+    if (errno || end == item.c_str() || *end != '\0' || value > UINT16_MAX)
+      return false;
+    values->push_back(value);
+  }
+  return !values->empty();
+}
+
+// Add one line of a text dump to the library.
+// Returns: An error message, or "" if it was added.
+std::string addLine(const std::string &line, IRcodeLibraryBuilder *builder) {
+  std::stringstream stream(line);
+  std::string type, id_str, code;
+  stream >> type >> id_str;
+  size_t last_space = line.find_last_of(" \t");
+  if (type.empty() || id_str.empty() || last_space == std::string::npos)
+    return "Not enough fields";
+  code = line.substr(last_space + 1);
+  // The name is whatever is between the id & the code.
+  size_t name_start = line.find(id_str) + id_str.size();
+  std::string name;
+  if (name_start < last_space) {
+    name = line.substr(name_start, last_space - name_start);
+    name.erase(0, name.find_first_not_of(" \t"));
+    name.erase(name.find_last_not_of(" \t") + 1);
+  }
+  char *end;
+  errno = 0;
+  uint64_t id = strtoull(id_str.c_str(), &end, 10);
+  if (errno || *end != '\0' || id > UINT16_MAX) return "Invalid id";
+  if (name.size() >= kCodeLibNameSize) return "Name is too long";
+
+  std::vector<uint16_t> values;
+  bool added = false;
+  if (!strcasecmp(type.c_str(), "RAW")) {
+    if (!parseValues(code, 10, &values) || values.size() < 2)
+      return "Invalid raw code";
+    added = builder->addRaw(id, name.c_str(), &values[1], values.size() - 1,
+                            values[0]);
+  } else if (!strcasecmp(type.c_str(), "GC")) {
+    if (code.compare(0, 6, "1:1,1,") == 0) code = code.substr(6);
+    if (!parseValues(code, 10, &values)) return "Invalid GC code";
+    added = builder->addGC(id, name.c_str(), &values[0], values.size());
+  } else if (!strcasecmp(type.c_str(), "PRONTO")) {
+    uint16_t repeats = 0;
+    if (code[0] == 'R' || code[0] == 'r') {
+      size_t comma = code.find(',');
+      repeats = atoi(code.substr(1, comma).c_str());
+      code = comma == std::string::npos ? "" : code.substr(comma + 1);
+    }
+    if (!parseValues(code, 16, &values)) return "Invalid Pronto code";
+    added = builder->addPronto(id, name.c_str(), &values[0], values.size(),
+                               repeats);
+  } else {
+    return "Unknown code type";
+  }
+  return added ? "" : "Rejected. e.g. A duplicate id or name, or a bad code";
+}
+
+int build(const char *input, const char *output) {
+  std::ifstream in(input);
+  if (!in) {
+    std::cerr << "Can't open " << input << std::endl;
+    return 1;
+  }
+  std::vector<std::string> lines;
+  size_t text_size = 0;
+  for (std::string line; std::getline(in, line); ) {
+    text_size += line.size() + 1;
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') {
+      lines.push_back("");
+      continue;
+    }
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    lines.push_back(line.substr(start));
+  }
+  // Plenty of room. No value can take more than 10 bytes.
+  std::vector<uint8_t> buffer(kCodeLibHeaderSize +
+                              lines.size() * (kCodeLibEntrySize + 2) +
+                              text_size * 10);
+  IRcodeLibraryBuilder builder(buffer.data(), buffer.size(), lines.size());
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (lines[i].empty()) continue;
+    std::string error = addLine(lines[i], &builder);
+    if (!error.empty()) {
+      std::cerr << input << ":" << i + 1 << ": " << error << std::endl;
+      return 1;
+    }
+  }
+  uint32_t size = builder.finish();
+  FILE *out = fopen(output, "wb");
+  if (size == 0 || out == NULL || fwrite(buffer.data(), size, 1, out) != 1) {
+    std::cerr << "Can't write " << output << std::endl;
+    if (out != NULL) fclose(out);
+    return 1;
+  }
+  fclose(out);
+  std::cerr << builder.count() << " codes: " << text_size
+            << " bytes of text -> " << size << " bytes." << std::endl;
+  return 0;
+}
+
+int list(const char *input) {
+  int fd = open(input, O_RDONLY);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) || info.st_size == 0) {
+    std::cerr << "Can't open " << input << std::endl;
+    if (fd >= 0) close(fd);
+    return 1;
+  }
+  // Use it straight from a memory-mapped file.
+  void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    std::cerr << "Can't map " << input << std::endl;
+    return 1;
+  }
+  IRcodeMemory source(static_cast<const uint8_t *>(mapped), info.st_size);
+  IRcodeLibrary library(&source);
+  int result = 0;
+  if (library.begin()) {
+    printf("id,name,frequency,durations,intro,repeats,bytes\n");
+    ir_code_entry_t entry;
+    for (uint16_t i = 0; i < library.count(); i++) {
+      if (!library.getEntry(i, &entry)) {
+        std::cerr << "Bad entry: " << i << std::endl;
+        result = 1;
+        break;
+      }
+      printf("%" PRIu16 ",\"%s\",%" PRIu32 ",%" PRIu16 ",%" PRIu16 ",%" PRIu16
+             ",%" PRIu32 "\n", entry.id, entry.name, entry.frequency,
+             entry.length, entry.intro, entry.repeats, entry.size);
+    }
+  } else {
+    std::cerr << input << " isn't a valid code library." << std::endl;
+    result = 1;
+  }
+  munmap(mapped, info.st_size);
+  return result;
+}
+
+void usage_error(char *name) {
+  std::cerr << "Usage: " << name << " build <text_dump> <library.bin>"
+            << std::endl
+            << "Usage: " << name << " list <library.bin>" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc == 4 && !strcmp(argv[1], "build")) return build(argv[2], argv[3]);
+  if (argc == 3 && !strcmp(argv[1], "list")) return list(argv[2]);
+  usage_error(argv[0]);
+  return 1;
+}
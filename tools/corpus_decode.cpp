@@ -0,0 +1,343 @@
+// Quick and dirty tool to (re)decode a large corpus of captures in parallel.
+// Copyright 2019 David Conran
+//
+// Reads captures, one per line, from a file (or stdin) & decodes them on
+// several threads at once. Each thread has its own IRsend & IRrecv, so they
+// don't share any decoding state. The result of each capture is printed as
+// CSV, in the same order as the input. Per-protocol totals & the throughput
+// are printed on stderr at the end.
+//
+// Input formats:
+//   raw:<mark>,<space>,<mark>,...   Durations in uSeconds.
+//   gc:[1:1,1,]<freq>,<repeats>,<offset>,<mark>,<space>,...   GlobalCache.
+//   pronto:<hex> <hex> ...          Pronto hex. Commas may be used instead.
+//   pulse <usecs>                   LIRC mode2. One duration per line. The
+//   space <usecs>                   capture ends at a space over 20ms, or at
+//                                   any other kind of line.
+// Blank lines & lines starting with '#' are ignored.
+//
+// Columns:
+//   line:     The line nr. the capture starts on.
+//   format:   raw, gc, pronto, mode2, or "error" if it couldn't be parsed.
+//   protocol: What decode() reported it as.
+//   bits:     Nr. of bits decoded.
+//   repeat:   1 if it was a repeat code.
+//   value:    The decoded value, or state, in hex.
+//   address:  The decoded address, in hex. (Not for A/C state protocols)
+//   command:  The decoded command, in hex. (Not for A/C state protocols)
+//
+// Usage: corpus_decode [-j <threads>] [<file>]
+
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>  // NOLINT(build/c++11)
+#include <chrono>  // NOLINT(build/c++11)
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+#include "IRrecv.h"
+#include "IRsend.h"
+#include "IRsend_test.h"
+#include "IRutils.h"
+
+const uint16_t kMaxCodeLength = 10000;
+// Nr. of captures read in before they are handed out to the threads.
+const uint32_t kBatchSize = 50000;
+// mode2 spaces longer than this (in uSeconds) end a capture.
+const uint32_t kMode2Gap = 20000;
+const uint16_t kNrOfTypes = kLastDecodeType + 2;  // Incl. UNKNOWN (-1).
+
+enum capture_format_t { kFormatRaw = 0, kFormatGC, kFormatPronto,
+                        kFormatMode2 };
+const char *kFormatNames[] = {"raw", "gc", "pronto", "mode2"};
+
+typedef struct {
+  uint32_t line;
+  capture_format_t format;
+  std::string data;  // The values, separated by commas or whitespace.
+  std::string result;  // The CSV line for it, once decoded.
+} capture_t;
+
+// Convert a list of numbers separated by commas and/or whitespace.
+// Returns: The nr. of numbers, or 0 if any weren't valid.
+uint16_t parseValues(const std::string &data, const int base,
+                     uint16_t *values) {
+  uint16_t count = 0;
+  const char *ptr = data.c_str();
+  while (*ptr) {
+    if (*ptr == ',' || isspace(*ptr)) {
+      ptr++;
+      continue;
+    }
+    if (count >= kMaxCodeLength) return 0;
+    char *end;
+    errno = 0;
+    uint64_t value = strtoull(ptr, &end, base);
+    if (errno || end == ptr || (*end && *end != ',' && !isspace(*end)))
+      return 0;
+    values[count++] = std::min(value, (uint64_t)UINT16_MAX);
+    ptr = end;
+  }
+  return count;
+}
+
+// Everything a thread needs to decode captures.
+class Decoder {
+ public:
+  Decoder(void) : irsend(0), irrecv(1) {
+    irsend.begin();
+    for (uint16_t i = 0; i < kNrOfTypes; i++) counts[i] = 0;
+  }
+
+  // Decode a capture, and store the CSV line for it.
+  void decode(capture_t *capture) {
+    // Clear the previous output, but quickly. i.e. Not via reset().
+    irsend.last = 0;
+    irsend.output[0] = 0;
+    uint16_t length = 0;
+    switch (capture->format) {
+      case kFormatRaw:
+        length = parseValues(capture->data, 10, values);
+        if (length) irsend.sendRaw(values, length, 38);
+        break;
+      case kFormatGC:
+        if (capture->data.compare(0, 6, "1:1,1,") == 0)
+          capture->data.erase(0, 6);
+        length = parseValues(capture->data, 10, values);
+        if (length) irsend.sendGC(values, length);
+        break;
+      case kFormatPronto:
+        length = parseValues(capture->data, 16, values);
+        if (length) irsend.sendPronto(values, length);
+        break;
+      case kFormatMode2:  // Marks & spaces. Always starts with a mark.
+        length = parseValues(capture->data, 10, values);
+        for (uint16_t i = 0; i < length; i++)
+          if (i % 2)
+            irsend.space(values[i]);
+          else
+            irsend.mark(values[i]);
+        break;
+    }
+    char line[24];
+    snprintf(line, sizeof(line), "%" PRIu32 ",", capture->line);
+    capture->result = line;
+    if (!length) {
+      capture->result += "error,,,,,,";
+      return;
+    }
+    makeCapture();
+    irrecv.decodeCapture(&irsend.capture);
+    const decode_results *results = &irsend.capture;
+    counts[results->decode_type + 1]++;
+    capture->result += kFormatNames[capture->format];
+    capture->result += ',';
+    capture->result += typeToName(results->decode_type);
+    capture->result += ',' + uint64ToString(results->bits) + ',' +
+        (results->repeat ? '1' : '0') + ",0x";
+    if (hasACState(results->decode_type)) {
+      for (uint16_t i = 0; i < results->bits / 8; i++) {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02X", results->state[i]);
+        capture->result += hex;
+      }
+      capture->result += ",,";
+    } else {
+      capture->result += uint64ToString(results->value, 16) + ",0x" +
+          uint64ToString(results->address, 16) + ",0x" +
+          uint64ToString(results->command, 16);
+    }
+  }
+
+  uint64_t counts[kNrOfTypes];  // Nr. of captures decoded as each protocol.
+
+ private:
+  IRsendTest irsend;
+  IRrecv irrecv;
+  uint16_t values[kMaxCodeLength];
+
+  // The same as IRsendTest::makeDecodeResult(), but only copies as much of
+  // the output as was used.
+  void makeCapture(void) {
+    decode_results *capture = &irsend.capture;
+    capture->decode_type = UNKNOWN;
+    capture->bits = 0;
+    capture->rawlen = irsend.last + 2;
+    capture->overflow = false;
+    capture->repeat = false;
+    capture->value = 0;
+    capture->address = 0;
+    capture->command = 0;
+    capture->rawbuf = irsend.rawbuf;
+    irsend.rawbuf[0] = 0;
+    for (uint16_t i = 0; i <= irsend.last && i < RAW_BUF - 1; i++)
+      irsend.rawbuf[i + 1] = std::min(irsend.output[i] / kRawTick,
+                                      (uint32_t)UINT16_MAX);
+  }
+};
+
+// Decode the captures in a batch, until there are none left.
+void worker(Decoder *decoder, std::vector<capture_t> *batch,
+            std::atomic<uint32_t> *next) {
+  for (uint32_t i = (*next)++; i < batch->size(); i = (*next)++)
+    decoder->decode(&(*batch)[i]);
+}
+
+// Decodes a batch of captures on every thread, so the next batch can be read
+// in at the same time.
+class BatchRunner {
+ public:
+  explicit BatchRunner(std::vector<Decoder *> *decoders)
+      : total(0), _decoders(decoders), _batch(NULL) {}
+
+  // Start decoding a batch, once the previous one has finished.
+  void start(std::vector<capture_t> *batch) {
+    finish();
+    _batch = batch;
+    _next = 0;
+    for (size_t t = 0; t < _decoders->size(); t++)
+      _threads.push_back(std::thread(worker, (*_decoders)[t], batch, &_next));
+  }
+
+  // Wait for the batch being decoded to finish, then print & empty it.
+  void finish(void) {
+    for (size_t t = 0; t < _threads.size(); t++) _threads[t].join();
+    _threads.clear();
+    if (_batch == NULL) return;
+    for (size_t i = 0; i < _batch->size(); i++)
+      printf("%s\n", (*_batch)[i].result.c_str());
+    total += _batch->size();
+    _batch->clear();
+    _batch = NULL;
+  }
+
+  uint64_t total;  // Nr. of captures decoded so far.
+
+ private:
+  std::vector<Decoder *> *_decoders;
+  std::vector<capture_t> *_batch;
+  std::atomic<uint32_t> _next;
+  std::vector<std::thread> _threads;
+};
+
+void usage_error(char *name) {
+  std::cerr << "Usage: " << name << " [-j <threads>] [<file>]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t nr_threads = std::max(std::thread::hardware_concurrency(), 1U);
+  int arg = 1;
+  if (argc > 2 && !strcmp(argv[arg], "-j")) {
+    errno = 0;
+    char *end;
+    nr_threads = strtoul(argv[arg + 1], &end, 10);
+    if (errno || *end != '\0' || !nr_threads) {
+      usage_error(argv[0]);
+      return 1;
+    }
+    arg += 2;
+  }
+  if (argc - arg > 1) {
+    usage_error(argv[0]);
+    return 1;
+  }
+  std::ifstream file;
+  if (arg < argc) {
+    file.open(argv[arg]);
+    if (!file) {
+      std::cerr << "Can't open " << argv[arg] << std::endl;
+      return 1;
+    }
+  }
+  std::istream &in = (arg < argc) ? file : std::cin;
+
+  std::vector<Decoder *> decoders;
+  for (uint32_t t = 0; t < nr_threads; t++) decoders.push_back(new Decoder());
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  printf("line,format,protocol,bits,repeat,value,address,command\n");
+  BatchRunner runner(&decoders);
+  // One batch is read in while the other is being decoded.
+  std::vector<capture_t> batches[2];
+  uint8_t filling = 0;
+  capture_t mode2;  // A mode2 capture being collected. Empty if none.
+  mode2.line = 0;
+  std::string text;
+  for (uint32_t nr = 1; std::getline(in, text); nr++) {
+    if (!text.empty() && text[text.size() - 1] == '\r')
+      text.erase(text.size() - 1);
+    std::string type;
+    uint32_t usecs = 0;
+    std::istringstream fields(text);
+    fields >> type >> usecs;
+    bool pulse = type == "pulse";
+    if (pulse || type == "space") {
+      if (mode2.line == 0 && pulse) {  // Start a new capture.
+        mode2.line = nr;
+        mode2.format = kFormatMode2;
+        mode2.data.clear();
+      }
+      if (mode2.line) {  // Leading spaces are skipped.
+        if (!mode2.data.empty()) mode2.data += ',';
+        mode2.data += std::to_string(std::min(usecs, (uint32_t)UINT16_MAX));
+      }
+      if (pulse || usecs <= kMode2Gap) continue;
+    }
+    if (mode2.line) {  // Anything else ends a mode2 capture.
+      batches[filling].push_back(mode2);
+      mode2.line = 0;
+    }
+    capture_t capture;
+    capture.line = nr;
+    size_t colon = text.find(':');
+    std::string prefix = text.substr(0, colon);
+    if (prefix == "raw")
+      capture.format = kFormatRaw;
+    else if (prefix == "gc")
+      capture.format = kFormatGC;
+    else if (prefix == "pronto")
+      capture.format = kFormatPronto;
+    else  // Not a capture. e.g. A blank line or a comment.
+      colon = std::string::npos;
+    if (colon != std::string::npos) {
+      capture.data = text.substr(colon + 1);
+      batches[filling].push_back(capture);
+    } else if (!text.empty() && text[0] != '#' && type != "space") {
+      std::cerr << "Line " << nr << ": Unknown format." << std::endl;
+    }
+    if (batches[filling].size() >= kBatchSize) {
+      runner.start(&batches[filling]);
+      filling ^= 1;
+    }
+  }
+  if (mode2.line) batches[filling].push_back(mode2);
+  runner.start(&batches[filling]);
+  runner.finish();
+  double secs = std::chrono::duration_cast<std::chrono::duration<double>>(
+      std::chrono::steady_clock::now() - start).count();
+
+  // Per-protocol totals.
+  uint64_t counts[kNrOfTypes] = {0};
+  for (uint32_t t = 0; t < nr_threads; t++) {
+    for (uint16_t i = 0; i < kNrOfTypes; i++)
+      counts[i] += decoders[t]->counts[i];
+    delete decoders[t];
+  }
+  for (uint16_t i = 0; i < kNrOfTypes; i++)
+    if (counts[i])
+      fprintf(stderr, "%s,%" PRIu64 "\n", typeToName((decode_type_t)(i - 1)),
+              counts[i]);
+  fprintf(stderr, "%" PRIu64 " captures in %.2fs (%.0f per second) using %"
+          PRIu32 " threads.\n", runner.total, secs,
+          secs ? runner.total / secs : 0.0, nr_threads);
+  return 0;
+}
@@ -0,0 +1,267 @@
+// Quick and dirty tool to benchmark IRsend & IRrecv::decode() on the host.
+// Copyright 2019 David Conran
+//
+// Synthesises a message for every protocol we can send, plus some noise &
+// UNKNOWN messages, then times how long it takes to encode (send) each of them
+// and to decode() them. It also counts any heap allocations decode() makes.
+// The results are printed as CSV, one line per message, so they can be
+// compared between releases. e.g. with `make bench > bench.csv`
+//
+// Columns:
+//   message:          What was sent. A protocol name, NOISE, or UNKNOWN.
+//   decoded:          What decode() reported it as.
+//   roundtrip:        1 if decode() reported the protocol that was sent.
+//   rawlen:           Nr. of entries in the capture buffer.
+//   iterations:       Nr. of times it was decoded.
+//   ns_per_frame:     Average nr. of nanoseconds per decode().
+//   frames_per_sec:   Nr. of decode()s of it that could be done per second.
+//   allocs_per_frame: Average nr. of heap allocations per decode().
+//   send_ns:          Average nr. of nanoseconds to encode (send) it.
+//
+// Usage: decode_bench [iterations]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "IRrecv.h"
+#include "IRsend.h"
+#include "IRsend_test.h"
+#include "IRutils.h"
+#include "ir_Argo.h"
+#include "ir_Coolix.h"
+#include "ir_Daikin.h"
+#include "ir_Electra.h"
+#include "ir_Fujitsu.h"
+#include "ir_Goodweather.h"
+#include "ir_Gree.h"
+#include "ir_Haier.h"
+#include "ir_Hitachi.h"
+#include "ir_Kelvinator.h"
+#include "ir_Midea.h"
+#include "ir_Mitsubishi.h"
+#include "ir_MitsubishiHeavy.h"
+#include "ir_Neoclima.h"
+#include "ir_Panasonic.h"
+#include "ir_Samsung.h"
+#include "ir_Sharp.h"
+#include "ir_Tcl.h"
+#include "ir_Teco.h"
+#include "ir_Toshiba.h"
+#include "ir_Trotec.h"
+#include "ir_Vestel.h"
+#include "ir_Whirlpool.h"
+#include "bench.h"
+
+const uint32_t kDefaultIterations = 20000;
+const uint16_t kSendIterations = 200;
+const char * const kColumns[] = {
+    "message", "decoded", "roundtrip", "rawlen", "iterations", "ns_per_frame",
+    "frames_per_sec", "allocs_per_frame", "send_ns"};
+
+// Values to try for simple (non-state) protocols. Many decoders check the
+// data makes sense (e.g. inverted bytes), so we try these in turn until one
+// is decoded as the protocol it was sent as.
+const uint64_t kCandidates[] = {
+    0x807F40BF, 0xE0E09966, 0x4B4AE51, 0xC2B8, 0x240, 0x175, 0x2278,
+    0x2468DCB56A9, 0x659A05FAF50AC53A, 0x12345678ABCD,
+    0x0, 0x1, 0x123456, 0x5A5A5A5A5A5A5A5A, 0xFFFFFFFFFFFFFFFF};
+
+// Copy the state of an A/C object into an array.
+template <typename AC>
+uint16_t copyState(AC *ac, uint8_t *state, const uint16_t length) {
+  uint8_t *raw = ac->getRaw();
+  for (uint16_t i = 0; i < length; i++) state[i] = raw[i];
+  return length;
+}
+
+// Get a valid (i.e. Correct checksums etc.) state for an A/C protocol.
+// Returns: The nr. of bytes in the state, or 0 if we don't know how.
+uint16_t makeState(const decode_type_t protocol, uint8_t *state) {
+  switch (protocol) {
+    case ARGO: { IRArgoAC ac(0); ac.setPower(true);
+      return copyState(&ac, state, kArgoStateLength); }
+    case DAIKIN: { IRDaikinESP ac(0);
+      return copyState(&ac, state, kDaikinStateLength); }
+    case DAIKIN2: { IRDaikin2 ac(0);
+      return copyState(&ac, state, kDaikin2StateLength); }
+    case DAIKIN160: { IRDaikin160 ac(0);
+      return copyState(&ac, state, kDaikin160StateLength); }
+    case DAIKIN216: { IRDaikin216 ac(0);
+      return copyState(&ac, state, kDaikin216StateLength); }
+    case ELECTRA_AC: { IRElectraAc ac(0);
+      return copyState(&ac, state, kElectraAcStateLength); }
+    case FUJITSU_AC: { IRFujitsuAC ac(0);
+      return copyState(&ac, state, ac.getStateLength()); }
+    case GREE: { IRGreeAC ac(0);
+      return copyState(&ac, state, kGreeStateLength); }
+    case HAIER_AC: { IRHaierAC ac(0);
+      return copyState(&ac, state, kHaierACStateLength); }
+    case HAIER_AC_YRW02: { IRHaierACYRW02 ac(0);
+      return copyState(&ac, state, kHaierACYRW02StateLength); }
+    case HITACHI_AC: { IRHitachiAc ac(0);
+      return copyState(&ac, state, kHitachiAcStateLength); }
+    case KELVINATOR: { IRKelvinatorAC ac(0);
+      return copyState(&ac, state, kKelvinatorStateLength); }
+    case MITSUBISHI_AC: { IRMitsubishiAC ac(0);
+      return copyState(&ac, state, kMitsubishiACStateLength); }
+    case MITSUBISHI_HEAVY_88: { IRMitsubishiHeavy88Ac ac(0);
+      return copyState(&ac, state, kMitsubishiHeavy88StateLength); }
+    case MITSUBISHI_HEAVY_152: { IRMitsubishiHeavy152Ac ac(0);
+      return copyState(&ac, state, kMitsubishiHeavy152StateLength); }
+    case NEOCLIMA: { IRNeoclimaAc ac(0);
+      return copyState(&ac, state, kNeoclimaStateLength); }
+    case PANASONIC_AC: { IRPanasonicAc ac(0);
+      return copyState(&ac, state, kPanasonicAcStateLength); }
+    case SAMSUNG_AC: { IRSamsungAc ac(0);
+      return copyState(&ac, state, kSamsungAcStateLength); }
+    case SHARP_AC: { IRSharpAc ac(0);
+      return copyState(&ac, state, kSharpAcStateLength); }
+    case TCL112AC: { IRTcl112Ac ac(0);
+      return copyState(&ac, state, kTcl112AcStateLength); }
+    case TOSHIBA_AC: { IRToshibaAC ac(0);
+      return copyState(&ac, state, kToshibaACStateLength); }
+    case TROTEC: { IRTrotecESP ac(0);
+      return copyState(&ac, state, kTrotecStateLength); }
+    case WHIRLPOOL_AC: { IRWhirlpoolAc ac(0);
+      return copyState(&ac, state, kWhirlpoolAcStateLength); }
+    case MWM: {  // No A/C class, so use a known good message.
+      const uint8_t mwm[] = {0x96, 0x19, 0x10, 0x24, 0x0A,
+                             0x6B, 0x20, 0x03, 0x82};
+      for (uint16_t i = 0; i < sizeof(mwm); i++) state[i] = mwm[i];
+      return sizeof(mwm);
+    }
+    default:
+      return 0;
+  }
+}
+
+// Get a valid value for a simple protocol that has an A/C class.
+// Returns: true if we know how, otherwise false.
+bool makeValue(const decode_type_t protocol, uint64_t *value) {
+  switch (protocol) {
+    case COOLIX: { IRCoolixAC ac(0); *value = ac.getRaw(); return true; }
+    case GOODWEATHER: {
+      IRGoodweatherAc ac(0); *value = ac.getRaw(); return true; }
+    case MIDEA: { IRMideaAC ac(0); *value = ac.getRaw(); return true; }
+    case TECO: { IRTecoAc ac(0); *value = ac.getRaw(); return true; }
+    case VESTEL_AC: { IRVestelAc ac(0); *value = ac.getRaw(); return true; }
+    default:
+      return false;
+  }
+}
+
+// Everything we need to (re)send a message.
+typedef struct {
+  decode_type_t protocol;
+  bool use_state;
+  uint64_t value;
+  uint16_t nbits;
+  uint8_t state[kStateSizeMax];
+  uint16_t nbytes;
+} message_t;
+
+// Clear the output of a previous send, but quickly. i.e. Not via reset().
+void clearOutput(IRsendTest *irsend) {
+  irsend->last = 0;
+  irsend->output[0] = 0;
+}
+
+bool sendMessage(IRsendTest *irsend, const message_t *msg) {
+  clearOutput(irsend);
+  if (msg->use_state)
+    return irsend->send(msg->protocol, msg->state, msg->nbytes);
+  return irsend->send(msg->protocol, msg->value, msg->nbits);
+}
+
+// Create a message no protocol should match.
+// Args:
+//   noise: true for random short pulses, false for a structured message.
+void makeJunk(IRsendTest *irsend, const bool noise) {
+  irsend->reset();
+  srand(42);  // Make it the same every time.
+  for (uint8_t i = 0; i < 40; i++) {
+    if (noise) {
+      irsend->mark(50 + rand() % 400);  // NOLINT(runtime/threadsafe_fn)
+      irsend->space(50 + rand() % 400);  // NOLINT(runtime/threadsafe_fn)
+    } else {
+      irsend->mark(1234 + i * 37);
+      irsend->space(2345 - i * 41);
+    }
+  }
+  irsend->mark(500);
+  irsend->space(100000);
+  irsend->makeDecodeResult();
+}
+
+// Time decode() on what is in the capture buffer, & print a CSV line for it.
+void benchDecode(IRsendTest *irsend, IRrecv *irrecv, const String name,
+                 const decode_type_t sent, const uint32_t iterations,
+                 const uint64_t send_ns) {
+  irrecv->decode(&irsend->capture);
+  decode_type_t decoded = irsend->capture.decode_type;
+  bench_timer_t timer = benchStart();
+  for (uint32_t i = 0; i < iterations; i++) irrecv->decode(&irsend->capture);
+  const uint64_t nanosecs = nsSince(timer);
+  const double allocs = allocsPerCall(timer, iterations);
+  printf("%s,%s,%d,%u,%u,%.1f,%.0f,%.3f,%" PRIu64 "\n",
+         name.c_str(), typeToString(decoded).c_str(), decoded == sent,
+         irsend->capture.rawlen, iterations, (double)nanosecs / iterations,
+         nanosecs ? iterations * 1e9 / nanosecs : 0.0, allocs, send_ns);
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t iterations = kDefaultIterations;
+  if (!benchIterations(argc, argv, &iterations)) return 1;
+
+  IRsendTest irsend(4);
+  IRrecv irrecv(4);
+  irsend.begin();
+
+  csvHeader(kColumns, sizeof(kColumns) / sizeof(kColumns[0]));
+  for (int16_t i = UNUSED + 1; i <= kLastDecodeType; i++) {
+    message_t msg;
+    msg.protocol = (decode_type_t)i;
+    msg.use_state = hasACState(msg.protocol);
+    msg.value = 0;
+    msg.nbits = IRsend::defaultBits(msg.protocol);
+    msg.nbytes = 0;
+    if (msg.use_state) {
+      msg.nbytes = makeState(msg.protocol, msg.state);
+      if (!msg.nbytes) {  // No A/C class, so use a simple pattern instead.
+        msg.nbytes = msg.nbits / 8;
+        for (uint16_t b = 0; b < msg.nbytes; b++) msg.state[b] = b * 17;
+      }
+    }
+    irsend.reset();
+    if (!sendMessage(&irsend, &msg)) continue;  // We can't send it.
+    if (!msg.use_state) {
+      // Find a value that decodes as the protocol we sent.
+      uint64_t mask = (msg.nbits >= 64) ? UINT64_MAX
+                                        : ((1ULL << msg.nbits) - 1);
+      bool have_value = makeValue(msg.protocol, &msg.value);
+      for (uint8_t c = 0; !have_value &&
+           c < sizeof(kCandidates) / sizeof(kCandidates[0]); c++) {
+        msg.value = kCandidates[c] & mask;
+        irsend.reset();
+        sendMessage(&irsend, &msg);
+        irsend.makeDecodeResult();
+        have_value = irrecv.decode(&irsend.capture) &&
+            irsend.capture.decode_type == msg.protocol;
+      }
+      if (!have_value) msg.value = kCandidates[0] & mask;
+    }
+    // Time how long it takes to encode it.
+    bench_timer_t timer = benchStart();
+    for (uint16_t s = 0; s < kSendIterations; s++) sendMessage(&irsend, &msg);
+    uint64_t send_ns = nsSince(timer) / kSendIterations;
+    irsend.makeDecodeResult();
+    benchDecode(&irsend, &irrecv, typeToString(msg.protocol), msg.protocol,
+                iterations, send_ns);
+  }
+  makeJunk(&irsend, true);
+  benchDecode(&irsend, &irrecv, "NOISE", UNKNOWN, iterations, 0);
+  makeJunk(&irsend, false);
+  benchDecode(&irsend, &irrecv, "UNKNOWN", UNKNOWN, iterations, 0);
+  return 0;
+}
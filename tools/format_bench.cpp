@@ -0,0 +1,125 @@
+// Quick and dirty tool to benchmark the result formatters on the host.
+// Copyright 2019 David Conran
+//
+// Builds a large (1024 entry) capture, plus a decoded A/C message, then times
+// the String & caller supplied buffer versions of each resultTo*() formatter,
+// and counts the heap allocations each makes. The results are printed as CSV.
+// e.g. with `make bench > bench.csv`
+//
+// Columns:
+//   formatter:       Which resultTo*() routine.
+//   api:             "String" or "buffer".
+//   message:         What was formatted. CAPTURE (UNKNOWN) or a protocol name.
+//   rawlen:          Nr. of entries in the capture buffer.
+//   chars:           Length of the text produced.
+//   iterations:      Nr. of times it was formatted.
+//   ns_per_call:     Average nr. of nanoseconds per call.
+//   allocs_per_call: Average nr. of heap allocations per call.
+//
+// Usage: format_bench [iterations]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string>
+#include "IRrecv.h"
+#include "IRsend.h"
+#include "IRsend_test.h"
+#include "IRutils.h"
+#include "ir_Daikin.h"
+#include "bench.h"
+
+const uint32_t kDefaultIterations = 2000;
+const uint16_t kCaptureLength = 1024;
+// Big enough for the source code of a full capture.
+const size_t kTextBufferSize = 16 * 1024;
+const char * const kColumns[] = {
+    "formatter", "api", "message", "rawlen", "chars", "iterations",
+    "ns_per_call", "allocs_per_call"};
+
+typedef String (*string_formatter_t)(const decode_results * const);
+typedef size_t (*buffer_formatter_t)(const decode_results * const, char *,
+                                     const size_t);
+
+typedef struct {
+  const char *name;
+  string_formatter_t to_string;
+  buffer_formatter_t to_buffer;
+} formatter_t;
+
+const formatter_t kFormatters[] = {
+    {"resultToSourceCode", resultToSourceCode, resultToSourceCode},
+    {"resultToTimingInfo", resultToTimingInfo, resultToTimingInfo},
+    {"resultToHumanReadableBasic", resultToHumanReadableBasic,
+     resultToHumanReadableBasic},
+    {"resultToHexidecimal", resultToHexidecimal, resultToHexidecimal},
+};
+
+// Stop the compiler optimising away work we don't otherwise use.
+static volatile size_t sink = 0;
+
+// Time a formatter & print a line of CSV for it.
+void benchFormat(const formatter_t *formatter, const bool use_buffer,
+                 const decode_results *results, const char *message,
+                 const uint32_t iterations) {
+  static char buffer[kTextBufferSize];
+  size_t chars = 0;
+  bench_timer_t timer = benchStart();
+  for (uint32_t i = 0; i < iterations; i++) {
+    if (use_buffer) {
+      chars = formatter->to_buffer(results, buffer, kTextBufferSize);
+    } else {
+      String text = formatter->to_string(results);
+      chars = text.length();
+    }
+    sink += chars;
+  }
+  const double ns = nsPerCall(timer, iterations);
+  printf("%s,%s,%s,%" PRIu16 ",%zu,%" PRIu32 ",%.1f,%.2f\n", formatter->name,
+         use_buffer ? "buffer" : "String", message, results->rawlen, chars,
+         iterations, ns, allocsPerCall(timer, iterations));
+}
+
+void benchAll(const decode_results *results, const char *message,
+              const uint32_t iterations) {
+  for (uint8_t f = 0; f < sizeof(kFormatters) / sizeof(kFormatters[0]); f++) {
+    benchFormat(&kFormatters[f], false, results, message, iterations);
+    benchFormat(&kFormatters[f], true, results, message, iterations);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t iterations = kDefaultIterations;
+  if (!benchIterations(argc, argv, &iterations)) return 1;
+
+  csvHeader(kColumns, sizeof(kColumns) / sizeof(kColumns[0]));
+
+  // A long capture nothing decodes. i.e. What a user pastes into an issue.
+  volatile uint16_t rawbuf[kCaptureLength];
+  decode_results capture;
+  capture.rawbuf = rawbuf;
+  capture.rawlen = kCaptureLength;
+  capture.overflow = false;
+  capture.decode_type = UNKNOWN;
+  capture.value = 0x1234ABCD;
+  capture.address = 0;
+  capture.command = 0;
+  capture.bits = 32;
+  capture.repeat = false;
+  rawbuf[0] = 0;
+  for (uint16_t i = 1; i < kCaptureLength; i++)  // A varied mix of lengths.
+    rawbuf[i] = (i & 1) ? 10 + (i * 7) % 20 : 10 + (i * 13) % 90;
+  benchAll(&capture, "CAPTURE", iterations);
+
+  // A decoded A/C message, so the state formatting is exercised too.
+  IRsendTest irsend(4);
+  IRrecv irrecv(4);
+  irsend.begin();
+  irsend.reset();
+  IRDaikinESP ac(0);
+  irsend.sendDaikin(ac.getRaw());
+  irsend.makeDecodeResult();
+  if (irrecv.decode(&irsend.capture))
+    benchAll(&irsend.capture, typeToString(irsend.capture.decode_type).c_str(),
+             iterations);
+  return 0;
+}
@@ -0,0 +1,324 @@
+// Quick and dirty host stand-in for an IRGCServer running on an ESP.
+// Copyright 2019 David Conran
+//
+// Serves the Global Cache iTach protocol on a local TCP socket, with the same
+// IRGCServer code the sketches use. Nothing is really sent. The IR LED time
+// each message would have taken is just added up, or optionally waited for.
+// e.g.
+//   ./gc_server -port 4998 &
+//   printf 'sendir,1:1,1,38000,1,1,342,171,21,1500\r' | nc -q1 localhost 4998
+//
+// The benchmark mode starts a server, & several clients which each pipeline
+// a batch of sendir's at it. It reports the throughput, & the latency from
+// each command being written to its completeir being read back.
+//
+// Usage:
+//   gc_server [-realtime] [-port <port>]
+//   gc_server [-realtime] -bench <clients> <commands per client>
+//
+//   -realtime: Wait for as long as each message would take to send.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>  // NOLINT(build/c++11)
+#include <chrono>  // NOLINT(build/c++11)
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+#include "IRGCServer.h"
+#include "IRsend.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+// Nr. of bytes a client can have buffered, that the server hasn't taken yet.
+const size_t kMaxPending = 4096;
+// A Samsung TV power toggle.
+const char *kBenchCode = "38000,1,1,170,170,20,63,20,63,20,63,20,20,20,20,20,"
+    "20,20,20,20,20,20,63,20,63,20,63,20,20,20,20,20,20,20,20,20,20,20,20,20,"
+    "63,20,20,20,20,20,20,20,20,20,20,20,20,20,63,20,20,20,63,20,63,20,63,20,"
+    "63,20,63,20,63,20,1798";
+
+// Adds up how long the IR LED would have been busy, instead of sending.
+class IRsendCounter : public IRsend {
+ public:
+  uint64_t usecs = 0;
+
+  IRsendCounter() : IRsend(0) {}
+  uint16_t mark(uint16_t usec) {
+    usecs += usec;
+    return 1;
+  }
+  void space(uint32_t usec) { usecs += usec; }
+};
+
+static int reply_fds[kGcServerConnections];
+
+void writeAll(const int fd, const char *data, size_t length) {
+  while (length) {
+    ssize_t written = send(fd, data, length, MSG_NOSIGNAL);
+    if (written <= 0) return;  // The client has gone. We'll notice later.
+    data += written;
+    length -= written;
+  }
+}
+
+void sendReply(const uint8_t connection, const char *reply) {
+  writeAll(reply_fds[connection], reply, strlen(reply));
+}
+
+typedef struct {
+  int fd;
+  uint8_t connection;
+  std::string pending;  // Data the server hasn't taken yet.
+} client_t;
+
+// Run a server on an already listening socket, until told to stop.
+void serve(const int listener, const bool realtime,
+           const std::atomic<bool> *stop) {
+  IRsendCounter irsend;
+  IRGCServer server(&irsend, sendReply);
+  std::vector<client_t> clients;
+  irsend.begin();
+  while (!stop->load()) {
+    std::vector<struct pollfd> fds;
+    fds.push_back({listener, POLLIN, 0});
+    // Only wait for the network if there is nothing else to do.
+    int timeout = server.idle() ? 100 : 0;
+    for (const client_t &client : clients) {
+      fds.push_back({client.fd,
+                     (int16_t)(client.pending.size() < kMaxPending ? POLLIN
+                                                                   : 0), 0});
+      if (!client.pending.empty()) timeout = 0;
+    }
+    if (poll(fds.data(), fds.size(), timeout) < 0) break;
+    // fds[] has an entry per client, after the listener's.
+    for (size_t i = 0, polled = 1; i < clients.size(); polled++) {
+      client_t *client = &clients[i];
+      if (fds[polled].revents & (POLLIN | POLLHUP | POLLERR)) {
+        char buf[kMaxPending];
+        ssize_t got = read(client->fd, buf,
+                           kMaxPending - client->pending.size());
+        if (got <= 0) {  // Gone.
+          server.disconnect(client->connection);
+          close(client->fd);
+          clients.erase(clients.begin() + i);
+          continue;
+        }
+        client->pending.append(buf, got);
+      }
+      if (!client->pending.empty())
+        client->pending.erase(0, server.receive(client->connection,
+                                                client->pending.data(),
+                                                client->pending.size()));
+      i++;
+    }
+    if (fds[0].revents & POLLIN) {
+      int fd = accept(listener, NULL, NULL);
+      uint8_t connection = fd < 0 ? kGcServerNoConnection : server.connect();
+      if (connection == kGcServerNoConnection) {
+        if (fd >= 0) close(fd);  // Too many.
+      } else {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        reply_fds[connection] = fd;
+        clients.push_back({fd, connection, ""});
+      }
+    }
+    uint64_t before = irsend.usecs;
+    server.handle();
+    if (realtime && irsend.usecs > before)
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(irsend.usecs - before));
+  }
+  for (const client_t &client : clients) close(client.fd);
+  gc_server_stats_t stats = server.getStats();
+  std::cerr << stats.commands << " commands. " << stats.sent << " sent. "
+            << stats.stopped << " stopped. " << stats.errors << " errors. "
+            << stats.refused << " connections refused. Max. queue depth: "
+            << (unsigned)stats.max_depth << ". IR LED busy for "
+            << irsend.usecs / 1000 << "ms." << std::endl;
+}
+
+// Returns: A socket listening on localhost, or -1.
+int listenOn(const uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (fd < 0 ||
+      bind(fd, reinterpret_cast<struct sockaddr *>(&address),
+           sizeof(address)) ||
+      listen(fd, kGcServerConnections * 2)) {
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Returns: The port a socket is listening on.
+uint16_t portOf(const int fd) {
+  struct sockaddr_in address;
+  socklen_t length = sizeof(address);
+  getsockname(fd, reinterpret_cast<struct sockaddr *>(&address), &length);
+  return ntohs(address.sin_port);
+}
+
+// Pipeline a batch of sendir's, & time how long each takes to complete.
+//
+// Args:
+//   port: Where the server is.
+//   commands: How many to send.
+//   latencies: Where to store each one's latency. (uSeconds)
+// Returns:
+//   true if every one completed.
+bool benchClient(const uint16_t port, const uint32_t commands,
+                 std::vector<uint32_t> *latencies) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&address),
+              sizeof(address))) {
+    close(fd);
+    return false;
+  }
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  std::vector<bench_clock::time_point> written(commands);
+  // Write them all, as fast as possible, while reading the replies.
+  std::thread writer([fd, commands, &written]() {
+    for (uint32_t id = 0; id < commands; id++) {
+      std::string line = "sendir,1:1," + std::to_string(id % 65536) + "," +
+          kBenchCode + "\r";
+      written[id] = bench_clock::now();
+      writeAll(fd, line.data(), line.size());
+    }
+  });
+  uint32_t completed = 0;
+  std::string replies;
+  char buf[1024];
+  while (completed < commands) {
+    ssize_t got = read(fd, buf, sizeof(buf));
+    if (got <= 0) break;
+    bench_clock::time_point now = bench_clock::now();
+    replies.append(buf, got);
+    size_t end;
+    while ((end = replies.find('\r')) != std::string::npos) {
+      std::string reply = replies.substr(0, end);
+      replies.erase(0, end + 1);
+      if (reply.compare(0, 15, "completeir,1:1,") != 0) {
+        std::cerr << "Unexpected reply: " << reply << std::endl;
+        continue;
+      }
+      // They complete in order, so the ids just wrap around.
+      latencies->push_back(std::chrono::duration_cast<
+          std::chrono::microseconds>(now - written[completed]).count());
+      completed++;
+    }
+  }
+  writer.join();
+  close(fd);
+  return completed == commands;
+}
+
+int bench(const uint8_t nr_clients, const uint32_t commands,
+          const bool realtime) {
+  int listener = listenOn(0);
+  if (listener < 0) {
+    std::cerr << "Can't listen on localhost." << std::endl;
+    return 1;
+  }
+  std::atomic<bool> stop(false);
+  std::thread server(serve, listener, realtime, &stop);
+  std::vector<std::vector<uint32_t>> latencies(nr_clients);
+  std::vector<std::thread> clients;
+  std::atomic<uint8_t> failed(0);
+  bench_clock::time_point start = bench_clock::now();
+  for (uint8_t i = 0; i < nr_clients; i++)
+    clients.push_back(std::thread([&, i]() {
+      if (!benchClient(portOf(listener), commands, &latencies[i])) failed++;
+    }));
+  for (std::thread &client : clients) client.join();
+  double secs = std::chrono::duration<double>(bench_clock::now() -
+                                              start).count();
+  stop = true;
+  server.join();
+  close(listener);
+
+  std::vector<uint32_t> all;
+  for (const std::vector<uint32_t> &client : latencies)
+    all.insert(all.end(), client.begin(), client.end());
+  std::sort(all.begin(), all.end());
+  printf("clients,commands,seconds,commands_per_sec,p50_usecs,p99_usecs,"
+         "max_usecs\n");
+  printf("%u,%zu,%.3f,%.0f,%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n",
+         nr_clients, all.size(), secs, all.size() / secs,
+         all.empty() ? 0 : all[all.size() / 2],
+         all.empty() ? 0 : all[all.size() * 99 / 100],
+         all.empty() ? 0 : all.back());
+  if (failed) {
+    std::cerr << (unsigned)failed << " clients didn't get all their replies."
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+void usage_error(char *name) {
+  std::cerr << "Usage: " << name << " [-realtime] [-port <port>]" << std::endl
+            << "Usage: " << name
+            << " [-realtime] -bench <clients> <commands per client>"
+            << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  int arg = 1;
+  bool realtime = false;
+  if (arg < argc && !strcmp(argv[arg], "-realtime")) {
+    realtime = true;
+    arg++;
+  }
+  if (arg + 3 == argc && !strcmp(argv[arg], "-bench")) {
+    int clients = atoi(argv[arg + 1]);
+    int commands = atoi(argv[arg + 2]);
+    if (clients < 1 || clients > kGcServerConnections || commands < 1) {
+      std::cerr << "Between 1 & " << (unsigned)kGcServerConnections
+                << " clients, & at least 1 command each." << std::endl;
+      return 1;
+    }
+    return bench(clients, commands, realtime);
+  }
+  uint16_t port = kGcServerPort;
+  if (arg + 2 == argc && !strcmp(argv[arg], "-port")) {
+    port = atoi(argv[arg + 1]);
+  } else if (arg != argc) {
+    usage_error(argv[0]);
+    return 1;
+  }
+  int listener = listenOn(port);
+  if (listener < 0) {
+    std::cerr << "Can't listen on localhost:" << port << std::endl;
+    return 1;
+  }
+  std::cerr << "Listening on localhost:" << port << std::endl;
+  std::atomic<bool> stop(false);
+  serve(listener, realtime, &stop);
+  return 0;
+}
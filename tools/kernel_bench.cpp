@@ -0,0 +1,126 @@
+// Quick and dirty tool to benchmark the bit & checksum kernels on the host.
+// Copyright 2019 David Conran
+//
+// Times reverseBits(), countBits(), sumBytes() & xorBytes() against simple
+// bit/byte at a time versions of them (i.e. How they used to be written), over
+// sizes typical of IR messages & A/C states. The results are printed as CSV.
+// e.g. with `make bench > bench.csv`
+//
+// Columns:
+//   kernel:          What was timed.
+//   size:            Nr. of bits (reverseBits, countBits of an integer) or bytes
+//                    it was given.
+//   calls:           Nr. of calls made to each version.
+//   ns_per_simple:   Average nr. of nanoseconds per call of the simple version.
+//   ns_per_call:     Average nr. of nanoseconds per call of the library's.
+//   speedup:         How many times faster the library's version is.
+//
+// Usage: kernel_bench [iterations]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "IRutils.h"
+#include "bench.h"
+
+const uint32_t kDefaultIterations = 2000000;
+const uint16_t kMaxBytes = 64;
+const char * const kColumns[] = {
+    "kernel", "size", "calls", "ns_per_simple", "ns_per_call", "speedup"};
+
+// Stop the compiler optimising away work we don't otherwise use.
+static volatile uint64_t sink = 0;
+
+static uint8_t data[kMaxBytes + 4];
+
+// The simple versions. Bit or byte at a time. Like the library's, they aren't
+// inlined, so the calls cost the same.
+#define NOINLINE __attribute__((noinline))
+
+NOINLINE
+uint64_t simpleReverseBits(uint64_t input, uint16_t nbits) {
+  uint64_t output = 0;
+  for (uint16_t i = 0; i < nbits; i++) {
+    output <<= 1;
+    output |= (input & 1);
+    input >>= 1;
+  }
+  return (nbits >= 64) ? output : (input << nbits) | output;
+}
+
+NOINLINE
+uint16_t simpleCountBits(const uint64_t data, const uint8_t length) {
+  uint16_t count = 0;
+  uint8_t bitsSoFar = length;
+  for (uint64_t remainder = data; remainder && bitsSoFar;
+       remainder >>= 1, bitsSoFar--)
+    if (remainder & 1) count++;
+  return count;
+}
+
+NOINLINE
+uint16_t simpleCountBits(const uint8_t *start, const uint16_t length) {
+  uint16_t count = 0;
+  for (uint16_t i = 0; i < length; i++)
+    for (uint8_t currentbyte = start[i]; currentbyte; currentbyte >>= 1)
+      if (currentbyte & 1) count++;
+  return count;
+}
+
+NOINLINE
+uint8_t simpleSumBytes(const uint8_t *start, const uint16_t length) {
+  uint8_t sum = 0;
+  for (uint16_t i = 0; i < length; i++) sum += start[i];
+  return sum;
+}
+
+NOINLINE
+uint8_t simpleXorBytes(const uint8_t *start, const uint16_t length) {
+  uint8_t sum = 0;
+  for (uint16_t i = 0; i < length; i++) sum ^= start[i];
+  return sum;
+}
+
+void report(const char *kernel, const uint16_t size, const uint32_t calls,
+            const double simple, const double optimised) {
+  printf("%s,%" PRIu16 ",%" PRIu32 ",%.2f,%.2f,%.2f\n", kernel, size, calls,
+         simple, optimised, simple / optimised);
+}
+
+// Time a simple version of a kernel & the library's, with the same arguments.
+#define BENCH(kernel, size, simple_call, call)                              \
+  {                                                                         \
+    bench_timer_t timer = benchStart();                                     \
+    for (uint32_t n = 0; n < iterations; n++) sink += simple_call;          \
+    const double simple = nsPerCall(timer, iterations);                     \
+    timer = benchStart();                                                   \
+    for (uint32_t n = 0; n < iterations; n++) sink += call;                 \
+    report(kernel, size, iterations, simple, nsPerCall(timer, iterations)); \
+  }
+
+int main(int argc, char *argv[]) {
+  uint32_t iterations = kDefaultIterations;
+  if (!benchIterations(argc, argv, &iterations)) return 1;
+  for (uint16_t i = 0; i < kMaxBytes + 4; i++) data[i] = i * 37 + 11;
+
+  csvHeader(kColumns, sizeof(kColumns) / sizeof(kColumns[0]));
+  const uint16_t kBits[] = {8, 16, 32, 48, 64};
+  for (const uint16_t bits : kBits) {
+    BENCH("reverseBits", bits, simpleReverseBits(n, bits),
+          reverseBits(n, bits));
+    BENCH("countBits(uint64_t)", bits,
+          simpleCountBits((uint64_t)n << 32 | n, bits),
+          countBits((uint64_t)n << 32 | n, bits));
+  }
+  // e.g. Kelvinator blocks, Daikin sections, & the longest A/C states.
+  const uint16_t kBytes[] = {4, 8, 13, 19, 35, 64};
+  // Every alignment gets a turn.
+  for (const uint16_t bytes : kBytes) {
+    BENCH("countBits(bytes)", bytes, simpleCountBits(data + (n & 3), bytes),
+          countBits(data + (n & 3), bytes));
+    BENCH("sumBytes", bytes, simpleSumBytes(data + (n & 3), bytes),
+          sumBytes(data + (n & 3), bytes));
+    BENCH("xorBytes", bytes, simpleXorBytes(data + (n & 3), bytes),
+          xorBytes(data + (n & 3), bytes));
+  }
+  return 0;
+}
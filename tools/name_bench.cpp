@@ -0,0 +1,81 @@
+// Quick and dirty tool to benchmark protocol name lookups on the host.
+// Copyright 2019 David Conran
+//
+// Times typeToString(), typeToName() & strToDecodeType() over every protocol
+// name (as written, in lower case, and as a number), and counts any heap
+// allocations they make. The results are printed as CSV.
+// e.g. with `make bench > bench.csv`
+//
+// Columns:
+//   function:        What was timed.
+//   input:           What it was given. "enum", "name", "lowercase", "number".
+//   lookups:         Nr. of calls made. (iterations * nr. of protocols)
+//   ns_per_lookup:   Average nr. of nanoseconds per call.
+//   allocs_per_call: Average nr. of heap allocations per call.
+//
+// Usage: name_bench [iterations]
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "IRremoteESP8266.h"
+#include "IRutils.h"
+#include "bench.h"
+
+const uint32_t kDefaultIterations = 20000;
+const uint16_t kNrOfProtocols = kLastDecodeType + 1;
+const char * const kColumns[] = {
+    "function", "input", "lookups", "ns_per_lookup", "allocs_per_call"};
+
+// Stop the compiler optimising away work we don't otherwise use.
+static volatile uint32_t sink = 0;
+
+// The inputs for strToDecodeType(). Built before any timing starts.
+static char inputs[3][kNrOfProtocols][kProtocolNameSize];
+const char *kInputKinds[3] = {"name", "lowercase", "number"};
+
+void report(const bench_timer_t timer, const char *function,
+            const char *input, const uint32_t iterations) {
+  const uint64_t lookups = (uint64_t)iterations * kNrOfProtocols;
+  const double ns = nsPerCall(timer, lookups);
+  printf("%s,%s,%" PRIu64 ",%.1f,%.2f\n", function, input, lookups, ns,
+         allocsPerCall(timer, lookups));
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t iterations = kDefaultIterations;
+  if (!benchIterations(argc, argv, &iterations)) return 1;
+
+  for (uint16_t i = 0; i < kNrOfProtocols; i++) {
+    const char *name = typeToName((decode_type_t)i);
+    strncpy(inputs[0][i], name, kProtocolNameSize);
+    for (uint8_t c = 0; c < kProtocolNameSize; c++)
+      inputs[1][i][c] = tolower(inputs[0][i][c]);
+    snprintf(inputs[2][i], kProtocolNameSize, "%" PRIu16, i);
+  }
+
+  csvHeader(kColumns, sizeof(kColumns) / sizeof(kColumns[0]));
+
+  bench_timer_t timer = benchStart();
+  for (uint32_t n = 0; n < iterations; n++)
+    for (uint16_t i = 0; i < kNrOfProtocols; i++)
+      sink += typeToString((decode_type_t)i).length();
+  report(timer, "typeToString", "enum", iterations);
+
+  timer = benchStart();
+  for (uint32_t n = 0; n < iterations; n++)
+    for (uint16_t i = 0; i < kNrOfProtocols; i++)
+      sink += typeToName((decode_type_t)i)[0];
+  report(timer, "typeToName", "enum", iterations);
+
+  for (uint8_t kind = 0; kind < 3; kind++) {
+    timer = benchStart();
+    for (uint32_t n = 0; n < iterations; n++)
+      for (uint16_t i = 0; i < kNrOfProtocols; i++)
+        sink += strToDecodeType(inputs[kind][i]);
+    report(timer, "strToDecodeType", kInputKinds[kind], iterations);
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+// Quick and dirty tool to benchmark A/C message to common state conversion.
+// Copyright 2019 David Conran
+//
+// For every protocol IRAcUtils::decodeToState() understands, times converting
+// a message with it (a new vendor object per message), and with an IRAcDecoder
+// (one kept object, reset per message). It also counts any heap allocations
+// they make. The results are printed as CSV. e.g. with `make bench > bench.csv`
+//
+// Note: On the host, every vendor object holds an IRsendTest instead of an
+//       IRsend. That makes creating one a lot dearer than it is on an ESP, so
+//       the `new_object_ns` column is pessimistic.
+//
+// Columns:
+//   protocol:         The A/C protocol.
+//   conversions:      Nr. of messages converted by each method.
+//   new_object_ns:    Average nr. of nanoseconds per IRAcUtils::decodeToState().
+//   kept_object_ns:   Average nr. of nanoseconds per IRAcDecoder conversion.
+//   allocs_per_call:  Average nr. of heap allocations per conversion. (Both)
+//
+// Usage: state_bench [iterations]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "IRac.h"
+#include "IRrecv.h"
+#include "IRsend.h"
+#include "IRutils.h"
+#include "bench.h"
+
+const uint32_t kDefaultIterations = 2000;
+const char * const kColumns[] = {
+    "protocol", "conversions", "new_object_ns", "kept_object_ns",
+    "allocs_per_call"};
+
+// Stop the compiler optimising away work we don't otherwise use.
+static volatile float sink = 0;
+
+// Fill in a (pseudo random) message of a given type.
+void makeMessage(const decode_type_t protocol, uint64_t *seed,
+                 decode_results *decode) {
+  decode->decode_type = protocol;
+  decode->bits = IRsend::defaultBits(protocol);
+  for (uint16_t i = 0; i < kStateSizeMax; i++) {
+    *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    decode->state[i] = *seed >> 56;
+  }
+  if (!hasACState(protocol)) {
+    decode->value = *seed ^ (*seed >> 29);
+    if (decode->bits < 64) decode->value &= (1ULL << decode->bits) - 1;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t iterations = kDefaultIterations;
+  if (!benchIterations(argc, argv, &iterations)) return 1;
+
+  csvHeader(kColumns, sizeof(kColumns) / sizeof(kColumns[0]));
+  IRAcDecoder decoder;
+  stdAc::state_t state;
+  uint64_t seed = 1;
+  for (uint16_t type = 0; type <= kLastDecodeType; type++) {
+    const decode_type_t protocol = (decode_type_t)type;
+    decode_results decode;
+    makeMessage(protocol, &seed, &decode);
+    if (!IRAcUtils::decodeToState(&decode, &state)) continue;  // Not an A/C.
+
+    const bench_timer_t both = benchStart();
+    bench_timer_t timer = both;
+    for (uint32_t n = 0; n < iterations; n++) {
+      IRAcUtils::decodeToState(&decode, &state);
+      sink += state.degrees;
+    }
+    const double new_object = nsPerCall(timer, iterations);
+    timer = benchStart();
+    for (uint32_t n = 0; n < iterations; n++) {
+      decoder.decodeToState(&decode, &state);
+      sink += state.degrees;
+    }
+    const double kept_object = nsPerCall(timer, iterations);
+    const double allocs = allocsPerCall(both, 2 * iterations);
+    printf("%s,%" PRIu32 ",%.1f,%.1f,%.2f\n", typeToString(protocol).c_str(),
+           iterations, new_object, kept_object, allocs);
+  }
+  return 0;
+}